@@ -38,6 +38,10 @@ extern "C" {
  * Values greater than 0 are specific non-error return codes
  */
 typedef enum {
+	/** The rate limit of a shadow update queue does not allow an update yet, the fields stay queued */
+			SHADOW_UPDATE_RATE_LIMITED = 8,
+	/** Returned by aws_iot_shadow_report when no field changed beyond its deadband, nothing was published */
+			SHADOW_NOTHING_TO_REPORT = 7,
 	/** Returned when the Network physical layer is connected */
 			NETWORK_PHYSICAL_LAYER_CONNECTED = 6,
 	/** Returned when the Network is manually disconnected */
@@ -151,6 +155,20 @@ typedef enum {
 			MUTEX_UNLOCK_ERROR = -48,
 	/** Mutex destroy failed */
 			MUTEX_DESTROY_ERROR = -49,
+	/** The maximum number of QoS1 messages are already waiting for a PUBACK */
+			MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR = -50,
+	/** Memory for an MQTT read or write buffer could not be allocated */
+			MQTT_BUFFER_ALLOCATION_ERROR = -51,
+	/** All client slots of the event loop are in use */
+			MQTT_REACTOR_FULL_ERROR = -52,
+	/** The event loop could not register or wait on a socket */
+			MQTT_REACTOR_POLL_ERROR = -53,
+	/** A non-blocking network operation has to wait until the socket is readable */
+			NETWORK_SSL_WANT_READ = -54,
+	/** A non-blocking network operation has to wait until the socket is writable */
+			NETWORK_SSL_WANT_WRITE = -55,
+	/** A shadow update queue is full and its rate limit does not allow sending it yet */
+			SHADOW_UPDATE_QUEUE_FULL_ERROR = -56,
 } IoT_Error_t;
 
 #ifdef __cplusplus
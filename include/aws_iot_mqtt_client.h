@@ -56,6 +56,7 @@ extern "C" {
 /* Platform specific implementation header files */
 #include "network_interface.h"
 #include "timer_interface.h"
+#include "aws_iot_timer_wheel.h"
 
 #ifdef _ENABLE_THREAD_SUPPORT_
 #include "threads_interface.h"
@@ -90,8 +91,36 @@ typedef struct {
 	uint16_t id;		///< Message sequence identifier.  Handled automatically by the MQTT client.
 	void *payload;		///< Pointer to MQTT message payload (bytes).
 	size_t payloadLen;	///< Length of MQTT payload.
+	size_t payloadOffset;	///< Incoming messages only. Position of payload in the whole message, 0 unless the message is streamed
+	size_t totalPayloadLen;	///< Incoming messages only. Length of the whole message payload, equal to payloadLen unless the message is streamed
 } IoT_Publish_Message_Params;
 
+/**
+ * @brief Size of the buffer of a publish prepared by aws_iot_mqtt_prepare_publish
+ *
+ * Fixed header, up to 4 remaining length bytes, topic with its length prefix and packet id.
+ */
+#define AWS_IOT_MQTT_PREPARED_PUBLISH_LEN(topicNameLen) ((size_t) (topicNameLen) + 9)
+
+/**
+ * @brief Publish Header Type
+ *
+ * Publish header prepared once by aws_iot_mqtt_init_publish_header for repeated publishes
+ * to the same topic. Only the remaining length, packet id and payload are serialized per message.
+ * The topic name is referenced, not copied, and must stay valid as long as the header is used.
+ * A header prepared by aws_iot_mqtt_prepare_publish also holds the serialized packet header,
+ * the remaining length and packet id are patched in place for every message.
+ *
+ */
+typedef struct {
+	const char *pTopicName;		///< Topic the messages are published to
+	uint16_t topicNameLen;		///< Length of the topic name
+	QoS qos;					///< Quality of Service of the messages
+	unsigned char fixedHeader;	///< Fixed header byte with the QoS and retained flag, dup flag clear
+	uint32_t variableHeaderLen;	///< Length of the topic with its length prefix and of the packet id
+	unsigned char *pSerialized;	///< Serialized packet header of a prepared publish, NULL if serialized per message
+} IoT_Publish_Header;
+
 /**
  * @brief MQTT Version Type
  *
@@ -155,6 +184,25 @@ extern const IoT_Client_Connect_Params iotClientConnectParamsDefault;
  */
 typedef void (*iot_disconnect_handler)(AWS_IoT_Client *, void *);
 
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+/**
+ * @brief Buffer Allocation Function Pointer
+ *
+ * Defining a TYPE for the function that provides the MQTT read and write buffers.
+ * Returns NULL if the memory is not available.
+ *
+ */
+typedef void *(*pBufferAllocate_t)(size_t size, void *pAllocatorData);
+
+/**
+ * @brief Buffer Release Function Pointer
+ *
+ * Defining a TYPE for the function that takes back a buffer, size is the size it was allocated with.
+ *
+ */
+typedef void (*pBufferFree_t)(void *pBuffer, size_t size, void *pAllocatorData);
+#endif
+
 /**
  * @brief MQTT Initialization Parameters
  *
@@ -178,15 +226,66 @@ typedef struct {
 #ifdef _ENABLE_THREAD_SUPPORT_
 	bool isBlockOnThreadLockEnabled;		///< Timeout for Thread blocking calls. Set to 0 to block until lock is obtained. In milliseconds
 #endif
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	pBufferAllocate_t pBufferAllocate;		///< Provides the read and write buffers. NULL to use the buffer pool shared by all clients
+	pBufferFree_t pBufferFree;			///< Takes back buffers from pBufferAllocate. NULL to use the shared buffer pool
+	void *pBufferAllocatorData;			///< Data to pass as argument to the buffer allocation functions
+#endif
 } IoT_Client_Init_Params;
 extern const IoT_Client_Init_Params iotClientInitParamsDefault;
 
-#ifdef _ENABLE_THREAD_SUPPORT_
+#if defined(_ENABLE_THREAD_SUPPORT_) && defined(_ENABLE_DYNAMIC_BUFFERS_)
+#define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL, false, NULL, NULL, NULL }
+#elif defined(_ENABLE_THREAD_SUPPORT_)
 #define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL, false }
+#elif defined(_ENABLE_DYNAMIC_BUFFERS_)
+#define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL, NULL, NULL, NULL }
 #else
 #define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL }
 #endif
 
+/**
+ * @brief MQTT Buffer Usage
+ *
+ * Defining a type for the memory used by the read and write buffers of a client.
+ * Without _ENABLE_DYNAMIC_BUFFERS_ the buffers have a fixed size and the peak equals the current size.
+ *
+ */
+typedef struct {
+	size_t readBufSize;		///< Current size of the read buffer in bytes
+	size_t writeBufSize;		///< Current size of the write buffer in bytes
+	size_t peakReadBufSize;		///< Largest size the read buffer had since the client was initialized
+	size_t peakWriteBufSize;	///< Largest size the write buffer had since the client was initialized
+} IoT_Buffer_Usage;
+
+/**
+ * @brief MQTT Connection Statistics
+ *
+ * Defining a type for how long reconnects after a network error take and what the TLS handshakes cost.
+ *
+ */
+typedef struct {
+	uint32_t reconnectCount;		///< Number of times the client was connected again after a network error
+	uint32_t lastReconnectLatencyMs;	///< Time from detecting the last network error to being connected again
+	uint32_t maxReconnectLatencyMs;		///< Longest reconnect latency since the client was initialized
+	TLSHandshakeStats handshake;		///< Handshake statistics of the network layer, zero if it does not keep them
+} IoT_Connection_Stats;
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+/**
+ * @brief MQTT Buffer Pool Usage
+ *
+ * Defining a type for the memory held by the buffer pool shared by all clients.
+ *
+ */
+typedef struct {
+	size_t bytesInUse;		///< Bytes of buffers currently handed out to clients
+	size_t bytesHeld;		///< Bytes held by the pool, in use or kept for reuse
+	size_t peakBytesInUse;		///< Largest value bytesInUse reached
+	size_t peakBytesHeld;		///< Largest value bytesHeld reached
+} IoT_Buffer_Pool_Usage;
+#endif
+
 /**
  * @brief MQTT Client State Type
  *
@@ -233,8 +332,66 @@ typedef struct _MessageHandlers {
 	QoS qos;
 	pApplicationHandler_t pApplicationHandler;
 	void *pApplicationHandlerData;
+	uint16_t topicTrieNode;     /* Topic trie node this handler is attached to */
+	uint16_t topicTrieNextHandler; /* Next handler attached to the same node */
+	bool isPayloadStreamingEnabled; /* Messages larger than the read buffer are delivered in chunks */
 } MessageHandlers;   /* Message handlers are indexed by subscription topic */
 
+/** Marks an empty topic trie link */
+#define AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE 0xFFFF
+/** Number of slots in the topic trie lookup index, kept at half load */
+#define AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE (2 * AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES)
+
+/**
+ * @brief Topic Trie Node
+ *
+ * One level of the subscribed topic filters. Children are found through the
+ * lookup index in ClientData keyed by parent node and level text, except the
+ * single level wildcard child which is linked directly. Multi level wildcard
+ * subscriptions are attached to the node they follow.
+ *
+ */
+typedef struct _TopicTrieNode {
+	const char *pLevel;        /* Level text, points into a subscribed topic filter */
+	uint16_t levelLen;
+	uint32_t hash;             /* Hash of parent and level text */
+	uint16_t parent;
+	uint16_t plusChild;        /* '+' child, also links free nodes */
+	uint16_t refCount;         /* Children plus attached handlers */
+	uint16_t firstHandler;     /* Handlers whose filter ends at this node */
+	uint16_t firstHashHandler; /* Handlers whose filter is this node followed by '#' */
+} TopicTrieNode;
+
+/**
+ * @brief Publish Completion Callback Function Pointer
+ *
+ * Defining a TYPE for definition of publish completion callback function pointers.
+ * Used to report the outcome of a QoS1 message sent with aws_iot_mqtt_publish_async
+ *
+ * @param pClient Reference to the IoT Client
+ * @param packetId Packet identifier the message was sent with
+ * @param result SUCCESS if the PUBACK was received, MQTT_REQUEST_TIMEOUT_ERROR if it did not arrive
+ *        within the command timeout, NETWORK_DISCONNECTED_ERROR if the connection was lost first
+ * @param pClientData Data passed to aws_iot_mqtt_publish_async
+ */
+typedef void (*pPublishCompleteHandler_t)(AWS_IoT_Client *pClient, uint16_t packetId, IoT_Error_t result,
+										  void *pClientData);
+
+/**
+ * @brief MQTT In-flight Publish
+ *
+ * Defining a type for QoS1 messages that were sent without waiting for the PUBACK.
+ * Entries are keyed by packet id, a packet id of 0 marks a free entry
+ *
+ */
+typedef struct _InflightPublish {
+	uint16_t packetId;
+	IoT_Timer_Wheel_Entry ackTimer;
+	bool isExpired;  ///< Listed in expiredInflightIndex, cleared when the list is handled
+	pPublishCompleteHandler_t pCompleteHandler;
+	void *pCompleteHandlerData;
+} InflightPublish;
+
 /**
  * @brief MQTT Client Status
  *
@@ -246,6 +403,8 @@ typedef struct _ClientStatus {
 	ClientState clientState;
 	bool isPingOutstanding;
 	bool isAutoReconnectEnabled;
+	bool isNetworkConnectInProgress;
+	bool isReconnectLatencyTimed;
 } ClientStatus;
 
 /**
@@ -263,6 +422,9 @@ typedef struct _ClientData {
 	uint16_t keepAliveInterval;
 	uint32_t currentReconnectWaitInterval;
 	uint32_t counterNetworkDisconnected;
+	uint32_t counterReconnected;
+	uint32_t lastReconnectLatencyMs;
+	uint32_t maxReconnectLatencyMs;
 
 	/* The below values are initialized with the
 	 * lengths of the TX/RX buffers and never modified
@@ -270,21 +432,50 @@ typedef struct _ClientData {
 	size_t writeBufSize;
 	size_t readBufSize;
 
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* Sizes above start at AWS_IOT_MQTT_TX_BUF_LEN and AWS_IOT_MQTT_RX_BUF_LEN and grow
+	 * for large packets, up to AWS_IOT_MQTT_TX_BUF_MAX_LEN and AWS_IOT_MQTT_RX_BUF_MAX_LEN */
+	unsigned char *writeBuf;
+	unsigned char *readBuf;
+	size_t peakWriteBufSize;
+	size_t peakReadBufSize;
+	pBufferAllocate_t pBufferAllocate;
+	pBufferFree_t pBufferFree;
+	void *pBufferAllocatorData;
+#else
 	unsigned char writeBuf[AWS_IOT_MQTT_TX_BUF_LEN];
 	unsigned char readBuf[AWS_IOT_MQTT_RX_BUF_LEN];
+#endif
+
+	/* readBuf also stages received data. The last packet handed out
+	 * sits at the start of the buffer, followed by any bytes that
+	 * arrived with it and have not been framed yet */
+	size_t readBufDataLen;
+	size_t readBufPacketLen;
 
 #ifdef _ENABLE_THREAD_SUPPORT_
 	bool isBlockOnThreadLockEnabled;
 	IoT_Mutex_t state_change_mutex;
 	IoT_Mutex_t tls_read_mutex;
 	IoT_Mutex_t tls_write_mutex;
+	IoT_Mutex_t timer_wheel_mutex;
 #endif
 
 	IoT_Client_Connect_Params options;
 
 	MessageHandlers messageHandlers[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	/* Topic filters of messageHandlers split by level, node 0 is the root */
+	TopicTrieNode topicTrieNodes[AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES];
+	uint16_t topicTrieIndex[AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE];
+	uint16_t topicTrieFreeNode;
+	uint16_t topicTrieFreeCount;
 	iot_disconnect_handler disconnectHandler;
 
+	InflightPublish inflightPublishes[AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES];
+	uint16_t inflightPublishCount;
+	uint16_t expiredInflightIndex[AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES];  ///< Entries whose ackTimer expired
+	uint16_t expiredInflightCount;
+
 	void *disconnectHandlerData;
 } ClientData;
 
@@ -294,13 +485,19 @@ typedef struct _ClientData {
  * Defining a type for MQTT Client
  *
  */
+struct _ShadowClient;
+
 struct _Client {
-	Timer pingTimer;
-	Timer reconnectDelayTimer;
+	/* Keepalive, reconnect, in-flight publish and shadow acknowledgement deadlines */
+	IoT_Timer_Wheel timerWheel;
+	IoT_Timer_Wheel_Entry pingTimer;
+	IoT_Timer_Wheel_Entry reconnectDelayTimer;
+	Timer reconnectLatencyTimer;
 
 	ClientStatus clientStatus;
 	ClientData clientData;
 	Network networkStack;
+	struct _ShadowClient *pShadowClient;	///< Thing Shadow session using the client, set by aws_iot_shadow_init
 };
 
 /**
@@ -411,6 +608,114 @@ uint32_t aws_iot_mqtt_get_network_disconnected_count(AWS_IoT_Client *pClient);
  */
 void aws_iot_mqtt_reset_network_disconnected_count(AWS_IoT_Client *pClient);
 
+/**
+ * @brief Get the memory used by the read and write buffers
+ *
+ * Called to get the current and the peak size of the buffers of the client.
+ * The current size is the steady state, the buffers return to their initial size once a large packet is handled.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pUsage Filled with the buffer sizes
+ *
+ * @return IoT_Error_t Type defining successful/failed API call
+ */
+IoT_Error_t aws_iot_mqtt_get_buffer_usage(AWS_IoT_Client *pClient, IoT_Buffer_Usage *pUsage);
+
+/**
+ * @brief Get the reconnect latency and TLS handshake statistics
+ *
+ * Called to get how long reconnects after a network error took and how much CPU time the
+ * TLS handshakes used, including how many of them resumed the previous session.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pStats Filled with the statistics
+ *
+ * @return IoT_Error_t Type defining successful/failed API call
+ */
+IoT_Error_t aws_iot_mqtt_get_connection_stats(AWS_IoT_Client *pClient, IoT_Connection_Stats *pStats);
+
+/**
+ * @brief Start a deadline on the timer wheel of the client
+ *
+ * Keepalive, reconnect, in-flight publish and shadow acknowledgement deadlines are all kept
+ * on one timer wheel per client, so a yield finds the ones that passed without checking each.
+ * The entry must have been initialized with aws_iot_timer_wheel_init_entry. A running deadline
+ * is replaced.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pEntry Deadline to start
+ * @param timeout_ms Milliseconds until the deadline
+ */
+void aws_iot_mqtt_timer_start(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry, uint32_t timeout_ms);
+
+/**
+ * @brief Stop a deadline on the timer wheel of the client, its handler is not called
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pEntry Deadline to stop
+ */
+void aws_iot_mqtt_timer_stop(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry);
+
+/**
+ * @brief Check whether a deadline passed, a deadline that is not running counts as passed
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pEntry Deadline to check
+ *
+ * @return true if the deadline passed
+ */
+bool aws_iot_mqtt_timer_has_expired(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry);
+
+/**
+ * @brief Time left until a deadline
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pEntry Deadline to check
+ *
+ * @return Milliseconds left, 0 if the deadline passed
+ */
+uint32_t aws_iot_mqtt_timer_left_ms(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry);
+
+/**
+ * @brief Expire the deadlines that passed and call their handlers
+ *
+ * Called from every yield. Handlers are called with the timer wheel locked and must not start
+ * or stop deadlines of the same client.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return Number of deadlines that expired
+ */
+uint32_t aws_iot_mqtt_run_timers(AWS_IoT_Client *pClient);
+
+/**
+ * @brief Time until the next deadline of the client may pass
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return Milliseconds until the next deadline, 0 if one passed, UINT32_MAX if none is running
+ */
+uint32_t aws_iot_mqtt_get_next_timer_ms(AWS_IoT_Client *pClient);
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+/**
+ * @brief Get the memory held by the shared buffer pool
+ *
+ * Called to get the memory the buffer pool holds for all clients that use it.
+ *
+ * @param pUsage Filled with the pool usage
+ */
+void aws_iot_mqtt_get_buffer_pool_usage(IoT_Buffer_Pool_Usage *pUsage);
+
+/**
+ * @brief Release unused memory of the shared buffer pool
+ *
+ * Buffers returned by clients are kept for reuse. Called to give them back to the system,
+ * for example after a burst of large messages.
+ */
+void aws_iot_mqtt_buffer_pool_trim(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -91,6 +91,17 @@ typedef union {
 #endif
 } MQTTHeader;
 
+/**
+ * Fixed header byte of an MQTT packet (MQTT 3.1.1 - 2.2). Folds to a constant when the
+ * arguments are, serializers of a single packet type use it instead of init_header.
+ */
+#define MQTT_FIXED_HEADER_BYTE(type, qos, dup, retained) \
+	((unsigned char) (((unsigned int) (type) << 4) | ((1 == (dup)) ? 0x08u : 0x00u) | \
+					  ((QOS1 == (qos)) ? 0x02u : 0x00u) | ((1 == (retained)) ? 0x01u : 0x00u)))
+
+/* Largest remaining length four length bytes can encode (MQTT 3.1.1 - 2.2.3) */
+#define MQTT_MAX_REMAINING_LENGTH 268435455u
+
 IoT_Error_t aws_iot_mqtt_internal_init_header(MQTTHeader *pHeader, MessageTypes message_type,
 											  QoS qos, uint8_t dup, uint8_t retained);
 
@@ -99,6 +110,13 @@ IoT_Error_t aws_iot_mqtt_internal_serialize_ack(unsigned char *pTxBuf, size_t tx
 												uint32_t *pSerializedLen);
 IoT_Error_t aws_iot_mqtt_internal_deserialize_ack(unsigned char *, unsigned char *,
 												  uint16_t *, unsigned char *, size_t);
+IoT_Error_t aws_iot_mqtt_internal_serialize_publish_header(unsigned char *pTxBuf, size_t txBufLen,
+														   const IoT_Publish_Header *pHeader, uint8_t dup,
+														   uint16_t packetId, size_t payloadLen,
+														   uint32_t *pSerializedLen);
+unsigned char *aws_iot_mqtt_internal_patch_prepared_publish(const IoT_Publish_Header *pHeader, uint8_t dup,
+															uint16_t packetId, size_t payloadLen,
+															uint32_t *pSerializedLen);
 
 uint32_t aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(uint32_t rem_len);
 
@@ -114,8 +132,40 @@ void aws_iot_mqtt_internal_write_char(unsigned char **pptr, unsigned char c);
 void aws_iot_mqtt_internal_write_utf8_string(unsigned char **pptr, const char *string, uint16_t stringLen);
 
 IoT_Error_t aws_iot_mqtt_internal_send_packet(AWS_IoT_Client *pClient, size_t length, Timer *pTimer);
+IoT_Error_t aws_iot_mqtt_internal_send_packet_with_payload(AWS_IoT_Client *pClient, const unsigned char *pHeader,
+														   size_t headerLength,
+														   const unsigned char *pPayload, size_t payloadLen,
+														   Timer *pTimer);
 IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType);
 IoT_Error_t aws_iot_mqtt_internal_wait_for_read(AWS_IoT_Client *pClient, uint8_t packetType, Timer *pTimer);
+bool aws_iot_mqtt_internal_handle_inflight_puback(AWS_IoT_Client *pClient, uint16_t packetId);
+void aws_iot_mqtt_internal_inflight_publish_expired(IoT_Timer_Wheel_Entry *pEntry, void *pData);
+void aws_iot_mqtt_internal_expire_inflight_publishes(AWS_IoT_Client *pClient);
+void aws_iot_mqtt_internal_flush_inflight_publishes(AWS_IoT_Client *pClient, IoT_Error_t result);
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+IoT_Error_t aws_iot_mqtt_internal_init_buffers(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams);
+void aws_iot_mqtt_internal_free_buffers(AWS_IoT_Client *pClient);
+IoT_Error_t aws_iot_mqtt_internal_grow_read_buffer(AWS_IoT_Client *pClient, size_t minSize);
+IoT_Error_t aws_iot_mqtt_internal_grow_write_buffer(AWS_IoT_Client *pClient, size_t minSize);
+void aws_iot_mqtt_internal_shrink_read_buffer(AWS_IoT_Client *pClient);
+void aws_iot_mqtt_internal_shrink_write_buffer(AWS_IoT_Client *pClient);
+#endif
+
+/* Countdown of the timer started when a network error is detected. It runs far longer than any
+ * reconnect can take, the time used up on it when the client is connected again is the latency */
+#define AWS_IOT_MQTT_RECONNECT_LATENCY_TIMER_MS 0x7FFFFFFFu
+
+/* Number of words in a bit set with one bit per message handler */
+#define AWS_IOT_MQTT_HANDLER_BITSET_WORDS ((AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS + 31) / 32)
+
+void aws_iot_mqtt_internal_topic_trie_init(AWS_IoT_Client *pClient);
+bool aws_iot_mqtt_internal_topic_trie_has_room(AWS_IoT_Client *pClient, const char *pTopicFilter,
+											   uint16_t topicFilterLen);
+void aws_iot_mqtt_internal_topic_trie_insert(AWS_IoT_Client *pClient, uint16_t handlerIndex);
+void aws_iot_mqtt_internal_topic_trie_remove(AWS_IoT_Client *pClient, uint16_t handlerIndex);
+void aws_iot_mqtt_internal_topic_trie_match(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+											uint32_t *pMatchedHandlers);
 IoT_Error_t aws_iot_mqtt_internal_serialize_zero(unsigned char *pTxBuf, size_t txBufLen,
 												 MessageTypes packetType, size_t *pSerializedLength);
 IoT_Error_t aws_iot_mqtt_internal_deserialize_publish(uint8_t *dup, QoS *qos,
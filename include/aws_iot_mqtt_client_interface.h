@@ -62,6 +62,8 @@ extern "C" {
  * @brief MQTT Client Initialization Function
  *
  * Called to initialize the MQTT Client
+ * With _ENABLE_DYNAMIC_BUFFERS_ calling it again on an initialized client releases the buffers
+ * allocated by the earlier call.
  *
  * @param pClient Reference to the IoT Client
  * @param pInitParams Pointer to MQTT connection parameters
@@ -70,10 +72,25 @@ extern "C" {
  */
 IoT_Error_t aws_iot_mqtt_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams);
 
+/**
+ * @brief MQTT Client Release Function
+ *
+ * Called to release the resources of an MQTT Client that is no longer used, after it was disconnected.
+ * Frees the read and write buffers with _ENABLE_DYNAMIC_BUFFERS_ and the mutexes with _ENABLE_THREAD_SUPPORT_.
+ * The client has to be initialized again before it can be used.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return IoT_Error_t Type defining successful/failed API call
+ */
+IoT_Error_t aws_iot_mqtt_free(AWS_IoT_Client *pClient);
+
 /**
  * @brief MQTT Connection Function
  *
- * Called to establish an MQTT connection with the AWS IoT Service
+ * Called to establish an MQTT connection with the AWS IoT Service.
+ * With a non-blocking network layer NETWORK_SSL_WANT_READ or NETWORK_SSL_WANT_WRITE is returned
+ * while the TLS handshake waits for the socket. Call again once the socket is ready to resume it.
  *
  * @param pClient Reference to the IoT Client
  * @param pConnectParams Pointer to MQTT connection parameters
@@ -100,6 +117,88 @@ IoT_Error_t aws_iot_mqtt_connect(AWS_IoT_Client *pClient, IoT_Client_Connect_Par
 IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								 IoT_Publish_Message_Params *pParams);
 
+/**
+ * @brief Publish an MQTT message on a topic without waiting for the PUBACK
+ *
+ * Called to publish an MQTT message on a topic.
+ * @note Call returns once the message was passed to the TLS layer. A QoS 1 message is then
+ * tracked by packet id until its PUBACK is read by yield, or any other call that reads from the
+ * network, at which point the completion handler is called. If no PUBACK arrives within the
+ * command timeout the handler is called with MQTT_REQUEST_TIMEOUT_ERROR. Up to
+ * AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES messages can be outstanding at any given time.
+ * For QoS 0 the handler is called with SUCCESS before this function returns.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters, the assigned packet id is stored in it
+ * @param pCompleteHandler Handler called once the outcome of the publish is known, can be NULL
+ * @param pCompleteHandlerData Data to be passed as argument to the completion handler
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+IoT_Error_t aws_iot_mqtt_publish_async(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+									   IoT_Publish_Message_Params *pParams, pPublishCompleteHandler_t pCompleteHandler,
+									   void *pCompleteHandlerData);
+
+/**
+ * @brief Prepare the header of messages published repeatedly to the same topic
+ *
+ * Computes the fixed header byte and the length of the variable header once, so that
+ * aws_iot_mqtt_publish_with_header only has to serialize the remaining length, packet id and payload.
+ *
+ * @param pHeader Publish header to prepare
+ * @param pTopicName Topic Name to publish to, must stay valid as long as the header is used
+ * @param topicNameLen Length of the topic name
+ * @param qos Quality of Service of the messages
+ * @param isRetained Retained flag of the messages
+ *
+ * @return An IoT Error Type defining successful/failed preparation
+ */
+IoT_Error_t aws_iot_mqtt_init_publish_header(IoT_Publish_Header *pHeader, const char *pTopicName,
+											 uint16_t topicNameLen, QoS qos, uint8_t isRetained);
+
+/**
+ * @brief Serialize the packet header of messages published repeatedly to the same topic
+ *
+ * Prepares the header like aws_iot_mqtt_init_publish_header and serializes the fixed header, the
+ * topic with its length prefix and room for the packet id into pBuffer. Publishing with the header
+ * then only patches the remaining length and packet id, and the network layer sends the buffer
+ * and the payload with a vectored write. The buffer belongs to the header until it is no longer used,
+ * a header must not be used by two publishes at the same time.
+ *
+ * @param pHeader Publish header to prepare
+ * @param pBuffer Buffer for the serialized packet header
+ * @param bufferLen Length of the buffer, at least AWS_IOT_MQTT_PREPARED_PUBLISH_LEN(topicNameLen)
+ * @param pTopicName Topic Name to publish to, must stay valid as long as the header is used
+ * @param topicNameLen Length of the topic name
+ * @param pParams Publish Message parameters the QoS and retained flag of the messages are taken from
+ *
+ * @return An IoT Error Type defining successful/failed preparation
+ */
+IoT_Error_t aws_iot_mqtt_prepare_publish(IoT_Publish_Header *pHeader, unsigned char *pBuffer, size_t bufferLen,
+										 const char *pTopicName, uint16_t topicNameLen,
+										 const IoT_Publish_Message_Params *pParams);
+
+/**
+ * @brief Publish an MQTT message with a prepared header
+ *
+ * Same as aws_iot_mqtt_publish, with the topic, QoS and retained flag taken from a header
+ * prepared by aws_iot_mqtt_init_publish_header or aws_iot_mqtt_prepare_publish.
+ * @note Call is blocking.  In the case of a QoS 0 message the function returns
+ * after the message was successfully passed to the TLS layer.  In the case of QoS 1
+ * the function returns after the receipt of the PUBACK control packet.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pHeader Prepared publish header
+ * @param pPayload Pointer to the message payload
+ * @param payloadLen Length of the message payload
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+IoT_Error_t aws_iot_mqtt_publish_with_header(AWS_IoT_Client *pClient, const IoT_Publish_Header *pHeader,
+											 void *pPayload, size_t payloadLen);
+
 /**
  * @brief Subscribe to an MQTT topic.
  *
@@ -118,6 +217,30 @@ IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName
 IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData);
 
+/**
+ * @brief Subscribe to an MQTT topic and receive large messages in chunks.
+ *
+ * Same as aws_iot_mqtt_subscribe, except for messages too large for the read buffer.
+ * Instead of being dropped, their payload is passed to the handler in successive chunks
+ * as it arrives. payloadOffset gives the position of each chunk in the message and
+ * totalPayloadLen the length of the whole payload, the last chunk ends at totalPayloadLen.
+ * Messages that fit in the read buffer are delivered in one call as usual. If the connection
+ * fails before the last chunk arrives it is closed, the handler gets no further chunks of that message.
+ * @note The handler is called while the message is being read from the network. It must not
+ * call functions that read from the network themselves: subscribe, unsubscribe, yield or QoS1 publish.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pApplicationHandler_t Reference to the handler function for this subscription
+ * @param pApplicationHandlerData Data to be passed as argument to the application handler callback
+ *
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+IoT_Error_t aws_iot_mqtt_subscribe_streaming(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+											 QoS qos, pApplicationHandler_t pApplicationHandler,
+											 void *pApplicationHandlerData);
+
 /**
  * @brief Subscribe to an MQTT topic.
  *
@@ -177,6 +300,33 @@ IoT_Error_t aws_iot_mqtt_disconnect(AWS_IoT_Client *pClient);
  */
 IoT_Error_t aws_iot_mqtt_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms);
 
+/**
+ * @brief Do the work that is due for the client without waiting
+ *
+ * Alternative to yield for event loops that drive many clients from one thread. Instead of
+ * waiting for data the loop waits on the sockets of all clients and calls this when the
+ * socket of a client is readable, or when the time returned by
+ * aws_iot_mqtt_get_service_timeout_ms has passed. Everything that has arrived is processed,
+ * keepalive, reconnect and in-flight publish timers are handled, then the call returns.
+ * A client driven this way must not be yielded at the same time.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param isReadable The socket of the client is readable, false if only timers are due
+ *
+ * @return An IoT Error Type defining successful/failed client processing, same as for yield.
+ */
+IoT_Error_t aws_iot_mqtt_service(AWS_IoT_Client *pClient, bool isReadable);
+
+/**
+ * @brief Time until the client has timer driven work to do
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return Milliseconds until aws_iot_mqtt_service should be called even if no data
+ *         arrives, 0 if it is due now, UINT32_MAX if there is nothing to wait for.
+ */
+uint32_t aws_iot_mqtt_get_service_timeout_ms(AWS_IoT_Client *pClient);
+
 /**
  * @brief MQTT Manual Re-Connection Function
  *
@@ -0,0 +1,127 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_reactor.h
+ * @brief Event loop that drives many MQTT clients from one thread
+ *
+ * Instead of one yield loop per client, the sockets of all clients are registered with
+ * epoll. A client is serviced when its socket is readable or when one of its timers
+ * (keepalive, reconnect, in-flight publish) is due, the thread sleeps otherwise.
+ * Only available on Linux, enabled with _ENABLE_EPOLL_REACTOR_.
+ */
+
+#include "aws_iot_config.h"
+
+#ifdef _ENABLE_EPOLL_REACTOR_
+#ifndef AWS_IOT_SDK_SRC_IOT_MQTT_REACTOR_H
+#define AWS_IOT_SDK_SRC_IOT_MQTT_REACTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_mqtt_client_interface.h"
+
+/**
+ * @brief Client slot of the event loop
+ *
+ * Storage for these is provided by the application, one per client the loop can hold.
+ */
+typedef struct {
+	AWS_IoT_Client *pClient;    ///< Client in this slot, NULL if the slot is free
+	int socket;                 ///< Socket registered with epoll for the client, -1 if none
+	IoT_Error_t lastRc;         ///< Result of the last aws_iot_mqtt_service call for the client
+} IoT_Reactor_Client;
+
+/**
+ * @brief Event loop driving many MQTT clients
+ */
+typedef struct {
+	int epollFd;                    ///< epoll instance the client sockets are registered with
+	IoT_Reactor_Client *pClients;   ///< Client slots, provided by the application
+	uint32_t maxClients;            ///< Number of client slots
+	uint32_t clientCount;           ///< Number of slots in use
+	Timer scanTimer;                ///< Next time the timers of all clients are checked
+	uint32_t wakeupCount;           ///< Number of times the loop woke up
+	uint32_t serviceCount;          ///< Number of times a client was serviced
+} IoT_Reactor;
+
+/**
+ * @brief Initialize an event loop
+ *
+ * @param pReactor Event loop to initialize
+ * @param pClients Client slots for the loop
+ * @param maxClients Number of client slots
+ *
+ * @return SUCCESS, or MQTT_REACTOR_POLL_ERROR if the epoll instance could not be created
+ */
+IoT_Error_t aws_iot_mqtt_reactor_init(IoT_Reactor *pReactor, IoT_Reactor_Client *pClients, uint32_t maxClients);
+
+/**
+ * @brief Add a client to the event loop
+ *
+ * The client is normally connected already. A client that is not, or is waiting to
+ * reconnect, is driven by its timers until it has a socket. From now on the client must
+ * not be yielded, the event loop does that work.
+ *
+ * @param pReactor Event loop
+ * @param pClient Client to add
+ *
+ * @return SUCCESS, MQTT_REACTOR_FULL_ERROR if all slots are in use or MQTT_REACTOR_POLL_ERROR
+ */
+IoT_Error_t aws_iot_mqtt_reactor_add(IoT_Reactor *pReactor, AWS_IoT_Client *pClient);
+
+/**
+ * @brief Remove a client from the event loop
+ *
+ * @param pReactor Event loop
+ * @param pClient Client to remove
+ *
+ * @return SUCCESS, or FAILURE if the client was not added to this loop
+ */
+IoT_Error_t aws_iot_mqtt_reactor_remove(IoT_Reactor *pReactor, AWS_IoT_Client *pClient);
+
+/**
+ * @brief Wait for and handle the work of all clients
+ *
+ * Sleeps until a client socket is readable, a client timer is due or the timeout passes,
+ * then services the clients that need it. Errors of individual clients are recorded in
+ * their slot and reported to their disconnect handler as usual, they do not stop the loop.
+ *
+ * @param pReactor Event loop
+ * @param timeout_ms Maximum time to wait for work
+ *
+ * @return SUCCESS, or MQTT_REACTOR_POLL_ERROR if waiting failed
+ */
+IoT_Error_t aws_iot_mqtt_reactor_run_once(IoT_Reactor *pReactor, uint32_t timeout_ms);
+
+/**
+ * @brief Release the resources of an event loop
+ *
+ * The clients themselves are left as they are.
+ *
+ * @param pReactor Event loop
+ *
+ * @return SUCCESS
+ */
+IoT_Error_t aws_iot_mqtt_reactor_destroy(IoT_Reactor *pReactor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AWS_IOT_SDK_SRC_IOT_MQTT_REACTOR_H */
+#endif /* _ENABLE_EPOLL_REACTOR_ */
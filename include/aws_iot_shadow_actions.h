@@ -22,10 +22,14 @@ extern "C" {
 
 #include "aws_iot_shadow_interface.h"
 
-IoT_Error_t aws_iot_shadow_internal_action(const char *pThingName, ShadowActions_t action,
+IoT_Error_t aws_iot_shadow_internal_action(AWS_IoT_Client *pClient, const char *pThingName, ShadowActions_t action,
 										   const char *pJsonDocumentToBeSent, fpActionCallback_t callback,
 										   void *pCallbackContext, uint32_t timeout_seconds, bool isSticky);
 
+IoT_Error_t aws_iot_shadow_internal_bulk_get(AWS_IoT_Client *pClient, const char *const *pThingNames,
+											 uint16_t thingCount, fpActionCallback_t callback, void *pCallbackContext,
+											 uint32_t timeout_seconds, uint16_t *pRequestedCount);
+
 #ifdef __cplusplus
 }
 #endif
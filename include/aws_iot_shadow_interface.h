@@ -37,9 +37,35 @@ extern "C" {
  *
  *
  */
+#include "jsmn.h"
 #include "aws_iot_mqtt_client_interface.h"
 #include "aws_iot_shadow_json_data.h"
 
+#ifndef SHADOW_SUBSCRIBE_SETTLING_TIME_MS
+#define SHADOW_SUBSCRIBE_SETTLING_TIME_MS 2000
+#endif
+
+#define MAX_TOPICS_AT_ANY_GIVEN_TIME 2*MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME
+
+/** Buckets of the delta key hash index, must be a power of two */
+#ifndef SHADOW_DELTA_KEY_HASH_BUCKETS
+#define SHADOW_DELTA_KEY_HASH_BUCKETS 128
+#endif
+
+/** Slots of the client token index of responses waited for, must be larger than MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME */
+#ifndef SHADOW_ACK_TOKEN_HASH_SLOTS
+#define SHADOW_ACK_TOKEN_HASH_SLOTS (2 * MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME)
+#endif
+
+/** Objects a dotted delta key path can descend into, "state.lights.kitchen" descends into two */
+#ifndef SHADOW_DELTA_MAX_PATH_DEPTH
+#define SHADOW_DELTA_MAX_PATH_DEPTH 8
+#endif
+
+typedef struct _ShadowClient ShadowClient;
+typedef struct _ShadowReportCache ShadowReportCache_t;
+typedef struct _ShadowUpdateQueue ShadowUpdateQueue_t;
+
 /*!
  * @brief Shadow Initialization parameters
  *
@@ -58,6 +84,7 @@ typedef struct {
 	bool enableAutoReconnect;        ///< Set to true to enable auto reconnect
 	iot_disconnect_handler disconnectHandler;    ///< Callback to be invoked upon connection loss.
 	void *disconnectHandlerData;			///< Data to pass as argument when disconnect handler is called
+	ShadowClient *pShadowClient;	///< State of this shadow session. NULL uses the default shadow client, of which there is one per process
 } ShadowInitParameters_t;
 
 /*!
@@ -75,6 +102,7 @@ typedef struct {
 	char *pMqttClientId; ///< Currently the Shadow uses MQTT to connect and it is important to ensure we have unique client id
 	uint16_t mqttClientIdLen; ///< Currently the Shadow uses MQTT to connect and it is important to ensure we have unique client id
 	pApplicationHandler_t deleteActionHandler;	///< Callback to be invoked when Thing shadow for this device is deleted
+	bool isAckSubscribeOnConnect; ///< Subscribe to the accepted and rejected topics of get and update for pMyThingName while connecting instead of on the first action. Takes four of the AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS
 } ShadowConnectParameters_t;
 
 /*!
@@ -122,6 +150,7 @@ IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParamet
  *
  * This function could be use in a separate thread waiting for the incoming messages, ensuring the connection is kept alive with the AWS Service.
  * It also ensures the expired requests of Shadow actions are cleared and Timeout callback is executed.
+ * Actions waiting for new accepted and rejected subscriptions to settle (SHADOW_SUBSCRIBE_SETTLING_TIME_MS) are published from here.
  * @note All callbacks ever used in the SDK will be executed in the context of this function.
  *
  * @param pClient	MQTT Client used as the protocol layer
@@ -176,16 +205,200 @@ typedef enum {
 typedef void (*fpActionCallback_t)(const char *pThingName, ShadowActions_t action, Shadow_Ack_Status_t status,
 								   const char *pReceivedJsonDocument, void *pContextData);
 
+/**
+ * @brief Response a shadow action waits for
+ */
+typedef struct {
+	char clientTokenID[MAX_SIZE_CLIENT_ID_WITH_SEQUENCE];
+	uint32_t clientTokenHash;     ///< hashJsonKey of clientTokenID
+	int16_t nextFree;             ///< Next record of the free list, -1 ends it
+	char thingName[MAX_SIZE_OF_THING_NAME];
+	ShadowActions_t action;
+	fpActionCallback_t callback;
+	void *pCallbackContext;
+	bool isFree;
+	bool isExpired;
+	bool isWildcardAck;           ///< Response arrives on the wildcard topic of bulk gets, no topics of its own
+	IoT_Timer_Wheel_Entry timer;
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	bool isPublishDeferred;
+	char deferredDocument[AWS_IOT_MQTT_TX_BUF_LEN];
+#endif
+} ToBeReceivedAckRecord_t;
+
+/**
+ * @brief Key registered on the delta topic
+ */
+typedef struct {
+	const char *pKey;
+	size_t keyLen;
+	uint32_t keyHash;             ///< hashJsonKey of pKey
+	int16_t nextInBucket;         ///< Next key in the same hash bucket, -1 ends the chain
+	void *pStruct;
+	jsonStructCallback_t callback;
+	bool isFree;
+	bool isPath;                  ///< pKey is a dotted path from the top-level object rather than a bare key
+} JsonTokenTable_t;
+
+/**
+ * @brief Keys registered on the delta topic, with a hash index built while they are registered
+ *
+ * Received deltas look up every key of the document in the index, so the cost of a delta does
+ * not grow with the number of registered keys.
+ */
+typedef struct {
+	JsonTokenTable_t entries[MAX_JSON_TOKEN_EXPECTED];
+	uint32_t count;
+	int16_t buckets[SHADOW_DELTA_KEY_HASH_BUCKETS];  ///< First key of every hash bucket, -1 if it is empty
+} DeltaKeyIndex_t;
+
+/**
+ * @brief Accepted or rejected topic subscribed to for shadow actions
+ */
+typedef struct {
+	char Topic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	uint8_t count;
+	bool isFree;
+	bool isSticky;
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	Timer settlingTimer;
+#endif
+} SubscriptionRecord_t;
+
+/**
+ * @brief Parser state for received shadow documents
+ *
+ * Parsing a document also finds the values of the keys the shadow looks up, so they are not
+ * searched for again afterwards.
+ */
+typedef struct {
+	jsmn_parser parser;
+	jsmntok_t tokens[MAX_JSON_TOKEN_EXPECTED];
+	int32_t versionIndex;         ///< Token holding the value of "version", -1 if there is none
+	int32_t clientTokenIndex;     ///< Token holding the value of "clientToken", -1 if there is none
+	uint32_t keyCount;            ///< Delta keys looked up by the last parse, the entries of its DeltaKeyIndex_t
+	int32_t keyValueIndex[MAX_JSON_TOKEN_EXPECTED];  ///< Token holding the value of each delta key, -1 if there is none
+} ShadowJsonParser_t;
+
+/**
+ * @brief State of one shadow session
+ *
+ * Every shadow session has its own ShadowClient, so sessions on different MQTT clients can run
+ * in parallel from different threads. Pass it in ShadowInitParameters_t.pShadowClient, the
+ * shadow functions find it through the MQTT client afterwards. It must stay valid as long as
+ * the MQTT client is used. The members are internal to the shadow.
+ */
+/**
+ * @brief Field of the reported state kept in a ShadowReportCache_t
+ */
+typedef struct {
+	jsonStruct_t *pStruct;        ///< Key, type and current value of the field
+	double deadband;              ///< A number is reported again once it moves further than this from the acknowledged value
+	bool isAcknowledged;          ///< The shadow service acknowledged a value for the field, filled in by the SDK
+	double acknowledgedNumber;    ///< Acknowledged number, 1 and 0 for true and false, filled in by the SDK
+	uint32_t acknowledgedHash;    ///< hashJsonKey of the acknowledged string or object text, filled in by the SDK
+} ShadowReportedField_t;
+
+/**
+ * @brief Reported state of a thing as last acknowledged by the shadow service
+ *
+ * The fields are kept up to date from every update/accepted and get/accepted document received for the thing, and
+ * forgotten on delete/accepted. Only fields that differ from it are sent by aws_iot_shadow_report.
+ */
+struct _ShadowReportCache {
+	const char *pThingName;            ///< Thing the reported state belongs to
+	ShadowReportedField_t *pFields;    ///< Fields of the reported state, owned by the caller
+	uint8_t fieldCount;                ///< Number of pFields
+	ShadowReportCache_t *pNext;        ///< Next cache of the same shadow client
+};
+
+/**
+ * @brief Field waiting in a ShadowUpdateQueue_t
+ */
+typedef struct {
+	jsonStruct_t *pStruct;    ///< Key, type and value of the field, the value is read when the update is sent
+	bool isDesired;           ///< Sent in the desired state instead of the reported state
+} ShadowQueuedField_t;
+
+/**
+ * @brief When the fields of a ShadowUpdateQueue_t are sent
+ *
+ * Updates are limited by a token bucket. Sending an update takes a token, a token is added every refillInterval_ms
+ * until the bucket holds burstSize tokens again.
+ */
+typedef struct {
+	uint32_t flushInterval_ms;     ///< Longest time the first queued field waits for others before the update is sent
+	uint8_t flushFieldCount;       ///< The update is sent without waiting once this many fields are queued, 0 when the queue is full
+	uint8_t burstSize;             ///< Updates that can be sent back to back, at least 1
+	uint32_t refillInterval_ms;    ///< Time after which one more update can be sent
+	fpActionCallback_t callback;   ///< Told about the response to every update sent, may be NULL
+	void *pContextData;            ///< Passed to callback
+	uint8_t timeout_seconds;       ///< Time the SDK waits for the response to an update
+	bool isPersistentSubscribe;    ///< Keep the subscriptions to update/accepted and update/rejected, see aws_iot_shadow_update
+} ShadowUpdateQueueParameters_t;
+
+/*!
+ * @brief At most one update a second, fields wait up to a second for others
+ *
+ * \relates ShadowUpdateQueueParameters_t
+ */
+extern const ShadowUpdateQueueParameters_t ShadowUpdateQueueParametersDefault;
+
+/**
+ * @brief Fields of a thing's shadow merged into one update and sent at a limited rate
+ *
+ * The members are internal to the shadow.
+ */
+struct _ShadowUpdateQueue {
+	const char *pThingName;                  ///< Thing the updates are sent to
+	ShadowUpdateQueueParameters_t params;
+	ShadowQueuedField_t *pFields;            ///< Queued fields, storage owned by the caller
+	uint8_t maxFieldCount;                   ///< Size of pFields
+	uint8_t fieldCount;                      ///< Number of queued fields
+	uint8_t tokens;                          ///< Updates that can be sent now
+	IoT_Timer_Wheel_Entry flushTimer;        ///< Runs from the first field queued until the update is sent
+	IoT_Timer_Wheel_Entry refillTimer;       ///< Runs until the bucket is full again
+	ShadowUpdateQueue_t *pNext;              ///< Next queue of the same shadow client
+};
+
+struct _ShadowClient {
+	AWS_IoT_Client *pMqttClient;
+	char myThingName[MAX_SIZE_OF_THING_NAME];
+	char mqttClientID[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES];  ///< Client id the client tokens of the session start with
+	uint32_t clientTokenNum;                                  ///< Sequence number of the next client token
+#ifdef _ENABLE_THREAD_SUPPORT_
+	IoT_Mutex_t clientTokenLock;                              ///< Held while a client token takes its sequence number
+#endif
+	char shadowDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	ToBeReceivedAckRecord_t ackWaitList[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
+	int16_t freeAckHead;                                             ///< First record of the free list, -1 if all are in use
+	int16_t ackTokenSlots[SHADOW_ACK_TOKEN_HASH_SLOTS];              ///< Records waiting for a response by client token hash, open addressing, -1 if empty
+	uint16_t expiredAckIndex[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];  ///< Records whose timer expired
+	uint16_t expiredAckCount;
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	uint8_t deferredPublishCount;
+#endif
+	SubscriptionRecord_t subscriptionList[MAX_TOPICS_AT_ANY_GIVEN_TIME];
+	DeltaKeyIndex_t deltaKeys;
+	bool isDeltaTopicSubscribed;
+	uint32_t jsonVersionNum;
+	bool isDiscardOldDeltaEnabled;
+	ShadowReportCache_t *pReportCaches;  ///< Caches updated from the accepted documents received
+	ShadowUpdateQueue_t *pUpdateQueues;  ///< Queues flushed from aws_iot_shadow_yield
+	char rxBuf[SHADOW_MAX_SIZE_OF_RX_BUFFER];  ///< Acks are copied here for the action callbacks, larger ones need _ENABLE_DYNAMIC_BUFFERS_
+	ShadowJsonParser_t jsonParser;
+};
+
 /**
  * @brief This function is the one used to perform an Update action to a Thing Name's Shadow.
  *
  * update is one of the most frequently used functionality by a device. In most cases the device may be just reporting few params to update the thing shadow in the cloud
  * Update Action if no callback or if the JSON document does not have a client token then will just publish the update and not track it.
  *
- * @note The update has to subscribe to two topics update/accepted and update/rejected. This function waits 2 seconds to ensure the subscriptions are registered before publishing the update message.
+ * @note The update has to subscribe to two topics update/accepted and update/rejected. With SHADOW_SUBSCRIBE_SETTLING_TIME_MS set the update message is published from \c aws_iot_shadow_yield() once the subscriptions had that time to take effect.
  * The following steps are performed on using this function:
  * 1. Subscribe to Shadow topics - $aws/things/{thingName}/shadow/update/accepted and $aws/things/{thingName}/shadow/update/rejected
- * 2. wait for 2 seconds for the subscription to take effect
+ * 2. wait for the SUBACKs, and for SHADOW_SUBSCRIBE_SETTLING_TIME_MS if it is set
  * 3. Publish on the update topic - $aws/things/{thingName}/shadow/update
  * 4. In the \c aws_iot_shadow_yield() function the response will be handled. In case of timeout or if the response is received, the subscription to shadow response topics are un-subscribed from.
  *    On the contrary if the persistent subscription is set to true then the un-subscribe will not be done. The topics will always be listened to.
@@ -220,6 +433,30 @@ IoT_Error_t aws_iot_shadow_update(AWS_IoT_Client *pClient, const char *pThingNam
 IoT_Error_t aws_iot_shadow_get(AWS_IoT_Client *pClient, const char *pThingName, fpActionCallback_t callback,
 							   void *pContextData, uint8_t timeout_seconds, bool isPersistentSubscribe);
 
+/**
+ * @brief Get the shadows of many things at once
+ *
+ * Meant for gateways restoring the state of their devices. Instead of subscribing to the get/accepted and get/rejected
+ * topics of every thing, the client subscribes once to $aws/things/+/shadow/get/+ and keeps that subscription until it
+ * connects again. The get requests are then published back to back without waiting for responses, and every response
+ * is given to the callback with the name of its thing.
+ *
+ * Every request waits for its response in one of the #MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME records. Once they are all in
+ * use the remaining things are not requested, request them again after responses arrived.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pThingNames Thing Names of the shadows to get
+ * @param thingCount Number of pThingNames
+ * @param callback Called once for every thing requested, with its response or SHADOW_ACK_TIMEOUT
+ * @param pContextData This is an extra parameter that could be passed along with the callback. It should be set to NULL if not used
+ * @param timeout_seconds It is the time the SDK will wait for the response to each request before declaring timeout on it
+ * @param pRequestedCount Set to the number of things requested, they are the first ones of pThingNames. May be NULL
+ * @return SUCCESS if every thing was requested, FAILURE if the records ran out, otherwise an IoT Error Type defining the failed subscription or publish
+ */
+IoT_Error_t aws_iot_shadow_get_many(AWS_IoT_Client *pClient, const char *const *pThingNames, uint16_t thingCount,
+									fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+									uint16_t *pRequestedCount);
+
 /**
  * @brief This function is the one used to perform an Delete action to a Thing Name's Shadow.
  *
@@ -237,20 +474,117 @@ IoT_Error_t aws_iot_shadow_get(AWS_IoT_Client *pClient, const char *pThingName,
 IoT_Error_t aws_iot_shadow_delete(AWS_IoT_Client *pClient, const char *pThingName, fpActionCallback_t callback,
 								  void *pContextData, uint8_t timeout_seconds, bool isPersistentSubscriptions);
 
+/**
+ * @brief Start keeping the acknowledged reported state of a thing
+ *
+ * The caller fills in pStruct and deadband of every field, the cache and the fields have to stay valid until the shadow
+ * client is initialized again. Nothing is known to be acknowledged at first, so the first report sends every field. A
+ * get of the thing's shadow loads the state the service holds instead.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pCache The cache to start
+ * @param pThingName Thing Name of the shadow the fields are reported to
+ * @param pFields The fields of the reported state
+ * @param fieldCount Number of pFields
+ * @return An IoT Error Type defining successful/failed initialization
+ */
+IoT_Error_t aws_iot_shadow_report_cache_init(AWS_IoT_Client *pClient, ShadowReportCache_t *pCache,
+											 const char *pThingName, ShadowReportedField_t *pFields,
+											 uint8_t fieldCount);
+
+/**
+ * @brief Update the reported state with the fields that changed since the last acknowledged state
+ *
+ * Numbers are sent once they moved further than their deadband from the acknowledged value, other fields once they
+ * differ from it. Floating point values are compared at the six decimals they are sent with. The cache takes the new
+ * values from the update/accepted response, so a report sent before that response arrives sends the same fields again.
+ * The response is tracked even without a callback.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pCache The reported state of the thing
+ * @param pJsonBuffer Buffer the update document is built in
+ * @param jsonBufferLen Size of pJsonBuffer
+ * @param callback This is the callback that will be used to inform the caller of the response from the AWS IoT Shadow service. Could be set to NULL if response is not important
+ * @param pContextData This is an extra parameter that could be passed along with the callback. It should be set to NULL if not used
+ * @param timeout_seconds It is the time the SDK will wait for the response on either accepted/rejected before declaring timeout on the action
+ * @param isPersistentSubscribe Keep the subscriptions to update/accepted and update/rejected, see aws_iot_shadow_update
+ * @return SHADOW_NOTHING_TO_REPORT when no field changed, otherwise an IoT Error Type defining successful/failed update action
+ */
+IoT_Error_t aws_iot_shadow_report(AWS_IoT_Client *pClient, ShadowReportCache_t *pCache, char *pJsonBuffer,
+								  size_t jsonBufferLen, fpActionCallback_t callback, void *pContextData,
+								  uint8_t timeout_seconds, bool isPersistentSubscribe);
+
+/**
+ * @brief Start merging updates of a thing's shadow
+ *
+ * Fields added with aws_iot_shadow_queue_reported and aws_iot_shadow_queue_desired are sent together in one update
+ * document once flushInterval_ms passed since the first of them was queued, or once flushFieldCount of them are queued,
+ * whichever comes first, and only while the rate limit allows. Updates are sent from \c aws_iot_shadow_yield(). The
+ * queue and the fields have to stay valid until the shadow client is initialized again.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pQueue The queue to start
+ * @param pThingName Thing Name of the shadow that is updated
+ * @param pFields Storage for the queued fields
+ * @param maxFieldCount Number of pFields, the most fields one update can hold
+ * @param pParams When updates are sent, ShadowUpdateQueueParametersDefault if NULL
+ * @return An IoT Error Type defining successful/failed initialization
+ */
+IoT_Error_t aws_iot_shadow_update_queue_init(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue,
+											 const char *pThingName, ShadowQueuedField_t *pFields,
+											 uint8_t maxFieldCount, const ShadowUpdateQueueParameters_t *pParams);
+
+/**
+ * @brief Queue a field of the reported state
+ *
+ * A field with the same key that is already queued is sent once. The value is read from pStruct->pData when the update
+ * is built, so it has to stay valid until then and the latest value is sent.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pQueue The queue
+ * @param pStruct The field to send
+ * @return SUCCESS or SHADOW_UPDATE_RATE_LIMITED once the field is queued, SHADOW_UPDATE_QUEUE_FULL_ERROR if the queue is full and cannot be sent yet, otherwise the error of sending the queued fields
+ */
+IoT_Error_t aws_iot_shadow_queue_reported(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue, jsonStruct_t *pStruct);
+
+/**
+ * @brief Queue a field of the desired state, see aws_iot_shadow_queue_reported
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pQueue The queue
+ * @param pStruct The field to send
+ * @return SUCCESS or SHADOW_UPDATE_RATE_LIMITED once the field is queued, SHADOW_UPDATE_QUEUE_FULL_ERROR if the queue is full and cannot be sent yet, otherwise the error of sending the queued fields
+ */
+IoT_Error_t aws_iot_shadow_queue_desired(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue, jsonStruct_t *pStruct);
+
+/**
+ * @brief Send the queued fields now instead of waiting for the flush interval
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pQueue The queue
+ * @return SHADOW_NOTHING_TO_REPORT if no field is queued, SHADOW_UPDATE_RATE_LIMITED if the fields stay queued until the rate limit allows, otherwise an IoT Error Type defining successful/failed update action
+ */
+IoT_Error_t aws_iot_shadow_update_queue_flush(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue);
+
 /**
  * @brief This function is used to listen on the delta topic of #AWS_IOT_MY_THING_NAME mentioned in the aws_iot_config.h file.
  *
  * Any time a delta is published the Json document will be delivered to the pStruct->cb. If you don't want the parsing done by the SDK then use the jsonStruct_t key set to "state". A good example of this is displayed in the sample_apps/shadow_console_echo.c
  *
+ * A plain pStruct->pKey matches the first key of that name at any depth of the document. A key containing dots is a path
+ * from the top-level object of the document, such as "state.lights.kitchen.brightness", and only matches that field.
+ * Paths do not descend into arrays and can descend into at most #SHADOW_DELTA_MAX_PATH_DEPTH objects.
+ *
  * @param pClient MQTT Client used as the protocol layer
  * @param pStruct The struct used to parse JSON value
- * @return An IoT Error Type defining successful/failed delta registering
+ * @return An IoT Error Type defining successful/failed delta registering, FAILURE if the key table is full or the path is too deep
  */
 IoT_Error_t aws_iot_shadow_register_delta(AWS_IoT_Client *pClient, jsonStruct_t *pStruct);
 
 /**
  * @brief Reset the last received version number to zero.
  * This will be useful if the Thing Shadow is deleted and would like to to reset the local version
+ * @note Applies to the default shadow client, see ShadowInitParameters_t.pShadowClient
  * @return no return values
  *
  */
@@ -262,6 +596,8 @@ void aws_iot_shadow_reset_last_received_version(void);
  * One exception to this version tracking is that, the SDK will ignore the version from update/accepted topic. Rest of the responses will be scanned to update the version number.
  * Accepting version change for update/accepted may cause version conflicts for delta message if the update message is received before the delta.
  *
+ * @note Applies to the default shadow client, see ShadowInitParameters_t.pShadowClient
+ *
  * @return version number of the last received response
  *
  */
@@ -271,14 +607,45 @@ uint32_t aws_iot_shadow_get_last_received_version(void);
  * @brief Enable the ignoring of delta messages with old version number
  *
  * As we use MQTT underneath, there could be more than 1 of the same message if we use QoS 0. To avoid getting called for the same message, this functionality should be enabled. All the old message will be ignored
+ * @note Applies to the default shadow client, see ShadowInitParameters_t.pShadowClient. Enabled by aws_iot_shadow_init
  */
 void aws_iot_shadow_enable_discard_old_delta_msgs(void);
 
 /**
  * @brief Disable the ignoring of delta messages with old version number
+ * @note Applies to the default shadow client, see ShadowInitParameters_t.pShadowClient
  */
 void aws_iot_shadow_disable_discard_old_delta_msgs(void);
 
+/**
+ * @brief Reset the last received version number of the shadow client used by an MQTT client
+ *
+ * Same as \c aws_iot_shadow_reset_last_received_version() for shadow sessions with their own ShadowClient.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ */
+void aws_iot_shadow_reset_client_last_received_version(AWS_IoT_Client *pClient);
+
+/**
+ * @brief Last received version of the shadow client used by an MQTT client
+ *
+ * Same as \c aws_iot_shadow_get_last_received_version() for shadow sessions with their own ShadowClient.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @return version number of the last received response
+ */
+uint32_t aws_iot_shadow_get_client_last_received_version(AWS_IoT_Client *pClient);
+
+/**
+ * @brief Enable or disable the ignoring of delta messages with old version number for the shadow client used by an MQTT client
+ *
+ * Same as \c aws_iot_shadow_enable_discard_old_delta_msgs() and \c aws_iot_shadow_disable_discard_old_delta_msgs() for shadow sessions with their own ShadowClient.
+ *
+ * @param pClient MQTT Client used as the protocol layer
+ * @param isDiscardEnabled true to ignore old delta messages
+ */
+void aws_iot_shadow_set_client_discard_old_delta_msgs(AWS_IoT_Client *pClient, bool isDiscardEnabled);
+
 /**
  * @brief This function is used to enable or disable autoreconnect
  *
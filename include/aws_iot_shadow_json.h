@@ -25,26 +25,52 @@ extern "C" {
 
 #include "aws_iot_error.h"
 #include "aws_iot_shadow_json_data.h"
+#include "aws_iot_shadow_interface.h"
 
-bool isJsonValidAndParse(const char *pJsonDocument, void *pJsonHandler, int32_t *pTokenCount);
+/* pJsonHandler is the ShadowJsonParser_t of the shadow client. Parsing a document finds the version, client token and
+ * delta key values once, the functions taking a pJsonHandler below read them from the document parsed last */
+bool isJsonValidAndParse(const char *pJsonDocument, size_t jsonDocumentLen, void *pJsonHandler, int32_t *pTokenCount);
 
-bool isJsonKeyMatchingAndUpdateValue(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount,
-									 jsonStruct_t *pDataStruct, uint32_t *pDataLength, int32_t *pDataPosition);
+bool isDeltaJsonValidAndParse(const char *pJsonDocument, size_t jsonDocumentLen, void *pJsonHandler,
+							  const DeltaKeyIndex_t *pDeltaKeys, int32_t *pTokenCount);
+
+uint32_t hashJsonKey(const char *pKey, size_t keyLen);
+
+/* 2^33, below it magnitude * 1e6 stays under 2^53, from it on a double is spaced wider than 2e-6 and reads back
+ * unchanged from its six decimals */
+#define SHADOW_JSON_MAX_MICROS_MAGNITUDE 8589934592.0
+
+/* Rounds a magnitude to a whole number of millionths exactly like "%f" does, false if it is not below
+ * SHADOW_JSON_MAX_MICROS_MAGNITUDE or is NaN */
+bool roundToMicros(double magnitude, uint64_t *pScaled);
+
+bool isDeltaKeyPresentAndUpdateValue(const char *pJsonDocument, void *pJsonHandler, uint32_t keyIndex,
+									  jsonStruct_t *pDataStruct, uint32_t *pDataLength, int32_t *pDataPosition);
 
 void aws_iot_shadow_internal_get_request_json(char *pJsonDocument);
 
 void aws_iot_shadow_internal_delete_request_json(char *pJsonDocument);
 
-void resetClientTokenSequenceNum(void);
+/* Get and delete request of a session, a document holding only its next client token */
+void aws_iot_shadow_internal_client_token_json(ShadowClient *pShadow, char *pJsonDocument);
+
+/* Client token of the session, its client id and the next number of its sequence */
+IoT_Error_t aws_iot_shadow_internal_fill_with_client_token(ShadowClient *pShadow, char *pBuffer, size_t bufferLen);
+
+
+bool isReceivedJsonValid(const char *pJsonDocument, void *pJsonHandler);
 
+/* Token following the value at valueIndex and everything nested in it */
+int32_t skipJsonValue(void *pJsonHandler, int32_t tokenCount, int32_t valueIndex);
 
-bool isReceivedJsonValid(const char *pJsonDocument);
+/* Token of the state.reported object of the document parsed last, -1 if there is none */
+int32_t findReportedStateObject(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount);
 
-void FillWithClientToken(char *pStringToUpdateClientToken);
+void FillWithClientToken(ShadowClient *pShadow, char *pStringToUpdateClientToken);
 
-bool extractClientToken(const char *pJsonDocumentToBeSent, char *pExtractedClientToken);
+bool extractClientToken(const char *pJsonDocumentToBeSent, void *pJsonHandler, char *pExtractedClientToken);
 
-bool extractVersionNumber(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount, uint32_t *pVersionNumber);
+bool extractVersionNumber(const char *pJsonDocument, void *pJsonHandler, uint32_t *pVersionNumber);
 
 #ifdef __cplusplus
 }
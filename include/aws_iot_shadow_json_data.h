@@ -26,6 +26,8 @@ extern "C" {
  */
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "aws_iot_error.h"
 
 /**
@@ -120,6 +122,8 @@ IoT_Error_t aws_iot_shadow_add_desired(char *pJsonDocument, size_t maxSizeOfJson
  * @brief Finalize the JSON document with Shadow expected client Token.
  *
  * This function will automatically increment the client token every time this function is called.
+ * The client token is the one of the shadow session initialized without a ShadowClient of its own, documents of other
+ * sessions are finalized by a ShadowJsonBuilder_t whose pShadowClient is set.
  *
  * @note Ensure the size of the Buffer is enough to hold the entire JSON Document. If the finalized section is not invoked then the JSON doucment will not be valid
  *
@@ -134,6 +138,7 @@ IoT_Error_t aws_iot_finalize_json_document(char *pJsonDocument, size_t maxSizeOf
  * @brief Fill the given buffer with client token for tracking the Repsonse.
  *
  * This function will add the AWS_IOT_MQTT_CLIENT_ID with a sequence number. Every time this function is used the sequence number gets incremented
+ * The client id and sequence are the ones of the shadow session initialized without a ShadowClient of its own.
  *
  *
  * @param pBufferToBeUpdatedWithClientToken buffer to be updated with the client token string
@@ -143,6 +148,107 @@ IoT_Error_t aws_iot_finalize_json_document(char *pJsonDocument, size_t maxSizeOf
 
 IoT_Error_t aws_iot_fill_with_client_token(char *pBufferToBeUpdatedWithClientToken, size_t maxSizeOfJsonDocument);
 
+/** Objects and arrays a ShadowJsonBuilder_t can have open at once, including the top-level and "state" objects */
+#ifndef SHADOW_JSON_BUILDER_MAX_DEPTH
+#define SHADOW_JSON_BUILDER_MAX_DEPTH 8
+#endif
+
+/**
+ * @brief Shadow JSON document being built
+ *
+ * The builder keeps its write cursor and open objects, so adding a field only writes that field. The buffer holds a
+ * null terminated string after every call. The first error is kept and every later call returns it without writing.
+ */
+typedef struct {
+	char *pBuffer;                                   ///< Buffer the document is written to
+	size_t bufferLen;                                ///< Size of pBuffer
+	size_t length;                                   ///< Characters written so far, the write cursor
+	uint8_t depth;                                   ///< Objects and arrays open
+	char closing[SHADOW_JSON_BUILDER_MAX_DEPTH];     ///< Character closing each open object or array
+	bool hasValue[SHADOW_JSON_BUILDER_MAX_DEPTH];    ///< Whether each open object or array holds a value already
+	IoT_Error_t status;                              ///< First error hit while building
+	struct _ShadowClient *pShadowClient;             ///< Session whose client token finalize adds, the default one if NULL
+} ShadowJsonBuilder_t;
+
+/**
+ * @brief Start a Shadow JSON document in the given buffer
+ *
+ * Writes {"state":{ and leaves the state object open for aws_iot_shadow_json_builder_begin_object("reported") and
+ * aws_iot_shadow_json_builder_begin_object("desired"). Always finish with aws_iot_shadow_json_builder_finalize.
+ *
+ * @param pBuilder The builder to initialize
+ * @param pBuffer The JSON Document filled in this char buffer
+ * @param bufferLen Size of pBuffer
+ * @return An IoT Error Type defining if the buffer was null or too small
+ */
+IoT_Error_t aws_iot_shadow_json_builder_init(ShadowJsonBuilder_t *pBuilder, char *pBuffer, size_t bufferLen);
+
+/**
+ * @brief Open an object, as the value of pKey in an object or as an element of an array
+ *
+ * @param pBuilder The builder
+ * @param pKey Key of the object, ignored in arrays
+ * @return An IoT Error Type, SHADOW_JSON_ERROR if more than #SHADOW_JSON_BUILDER_MAX_DEPTH would be open
+ */
+IoT_Error_t aws_iot_shadow_json_builder_begin_object(ShadowJsonBuilder_t *pBuilder, const char *pKey);
+
+/**
+ * @brief Close the object opened last
+ *
+ * @param pBuilder The builder
+ * @return An IoT Error Type, SHADOW_JSON_ERROR if the innermost open value is not an object
+ */
+IoT_Error_t aws_iot_shadow_json_builder_end_object(ShadowJsonBuilder_t *pBuilder);
+
+/**
+ * @brief Open an array, as the value of pKey in an object or as an element of an array
+ *
+ * @param pBuilder The builder
+ * @param pKey Key of the array, ignored in arrays
+ * @return An IoT Error Type, SHADOW_JSON_ERROR if more than #SHADOW_JSON_BUILDER_MAX_DEPTH would be open
+ */
+IoT_Error_t aws_iot_shadow_json_builder_begin_array(ShadowJsonBuilder_t *pBuilder, const char *pKey);
+
+/**
+ * @brief Close the array opened last
+ *
+ * @param pBuilder The builder
+ * @return An IoT Error Type, SHADOW_JSON_ERROR if the innermost open value is not an array
+ */
+IoT_Error_t aws_iot_shadow_json_builder_end_array(ShadowJsonBuilder_t *pBuilder);
+
+/**
+ * @brief Add a value, as the value of pKey in an object or as an element of an array
+ *
+ * Numbers are formatted without snprintf. Floating point values are written with six decimals like "%f".
+ * SHADOW_JSON_STRING values are quoted as they are and SHADOW_JSON_OBJECT values are copied as JSON text.
+ *
+ * @param pBuilder The builder
+ * @param pKey Key of the value, ignored in arrays
+ * @param type Type of the value pointed to by pData
+ * @param pData The value
+ * @return An IoT Error Type defining if a value was null or the buffer was too small
+ */
+IoT_Error_t aws_iot_shadow_json_builder_add_value(ShadowJsonBuilder_t *pBuilder, const char *pKey,
+												  JsonPrimitiveType type, const void *pData);
+
+/**
+ * @brief Add the key and value of a jsonStruct_t
+ *
+ * @param pBuilder The builder
+ * @param pStruct Key, type and value to add
+ * @return An IoT Error Type defining if a value was null or the buffer was too small
+ */
+IoT_Error_t aws_iot_shadow_json_builder_add(ShadowJsonBuilder_t *pBuilder, const jsonStruct_t *pStruct);
+
+/**
+ * @brief Close every object still open below "state" and add the client token, see aws_iot_finalize_json_document
+ *
+ * @param pBuilder The builder
+ * @return An IoT Error Type, the first error hit while building the document if there was one
+ */
+IoT_Error_t aws_iot_shadow_json_builder_finalize(ShadowJsonBuilder_t *pBuilder);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,27 +26,31 @@ extern "C" {
 #include "aws_iot_config.h"
 
 
-extern uint32_t shadowJsonVersionNum;
-extern bool shadowDiscardOldDeltaFlag;
-
-extern char myThingName[MAX_SIZE_OF_THING_NAME];
-extern uint16_t myThingNameLen;
-extern char mqttClientID[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES];
-extern uint16_t mqttClientIDLen;
-
-void initializeRecords(AWS_IoT_Client *pClient);
-bool isSubscriptionPresent(const char *pThingName, ShadowActions_t action);
-IoT_Error_t subscribeToShadowActionAcks(const char *pThingName, ShadowActions_t action, bool isSticky);
-void incrementSubscriptionCnt(const char *pThingName, ShadowActions_t action, bool isSticky);
-
-IoT_Error_t publishToShadowAction(const char *pThingName, ShadowActions_t action, const char *pJsonDocumentToBeSent);
-void addToAckWaitList(uint8_t indexAckWaitList, const char *pThingName, ShadowActions_t action,
-					  const char *pExtractedClientToken, fpActionCallback_t callback, void *pCallbackContext,
-					  uint32_t timeout_seconds);
-bool getNextFreeIndexOfAckWaitList(uint8_t *pIndex);
-void HandleExpiredResponseCallbacks(void);
-void initDeltaTokens(void);
-IoT_Error_t registerJsonTokenOnDelta(jsonStruct_t *pStruct);
+ShadowClient *getShadowClient(AWS_IoT_Client *pClient);
+ShadowClient *getDefaultShadowClient(void);
+
+void initializeRecords(ShadowClient *pShadow, AWS_IoT_Client *pClient);
+bool isSubscriptionPresent(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action);
+IoT_Error_t subscribeToShadowActionAcks(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action,
+										bool isSticky);
+IoT_Error_t subscribeToBulkGetAcks(ShadowClient *pShadow);
+void incrementSubscriptionCnt(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action, bool isSticky);
+bool isSubscriptionSettled(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action);
+
+IoT_Error_t publishToShadowAction(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action,
+								  const char *pJsonDocumentToBeSent);
+void addToAckWaitList(ShadowClient *pShadow, uint16_t indexAckWaitList, const char *pThingName,
+					  ShadowActions_t action, const char *pExtractedClientToken, fpActionCallback_t callback,
+					  void *pCallbackContext, uint32_t timeout_seconds, const char *pDeferredDocument,
+					  bool isWildcardAck);
+bool getNextFreeIndexOfAckWaitList(ShadowClient *pShadow, uint16_t *pIndex);
+void releaseAckWaitListIndex(ShadowClient *pShadow, uint16_t indexAckWaitList);
+void PublishDeferredActions(ShadowClient *pShadow);
+void HandleExpiredResponseCallbacks(ShadowClient *pShadow);
+void initDeltaTokens(ShadowClient *pShadow);
+IoT_Error_t registerJsonTokenOnDelta(ShadowClient *pShadow, jsonStruct_t *pStruct);
+void registerReportCache(ShadowClient *pShadow, ShadowReportCache_t *pCache);
+void registerUpdateQueue(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue);
 
 #ifdef __cplusplus
 }
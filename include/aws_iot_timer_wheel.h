@@ -0,0 +1,194 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_timer_wheel.h
+ * @brief Hierarchical timer wheel holding the deadlines of one client
+ *
+ * Deadlines are kept in millisecond slots on four levels of 64 slots each. A deadline is
+ * placed on the lowest level whose range covers it and moves down a level each time the
+ * slots below it have turned once, so scheduling, cancelling and expiring an entry cost
+ * O(1) no matter how many entries are scheduled. The time until the next deadline is found
+ * from per level occupancy bitmaps without looking at the entries.
+ *
+ * Time is measured with a platform Timer, no clock access is needed beyond the timer interface.
+ * The wheel does no locking, the MQTT client serializes access to its wheel.
+ */
+
+#ifndef AWS_IOT_SDK_SRC_TIMER_WHEEL_H_
+#define AWS_IOT_SDK_SRC_TIMER_WHEEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timer_interface.h"
+
+#define AWS_IOT_TIMER_WHEEL_LEVELS 4
+#define AWS_IOT_TIMER_WHEEL_SLOT_BITS 6
+#define AWS_IOT_TIMER_WHEEL_SLOTS (1u << AWS_IOT_TIMER_WHEEL_SLOT_BITS)
+
+/** Longest timeout an entry can be scheduled with, longer ones are shortened to it */
+#define AWS_IOT_TIMER_WHEEL_MAX_TIMEOUT_MS 0x7FFFFFFFu
+
+typedef struct _IoT_Timer_Wheel_Entry IoT_Timer_Wheel_Entry;
+
+/**
+ * @brief Timer wheel expiry handler
+ *
+ * Called from aws_iot_timer_wheel_run for an entry whose deadline passed. The entry is no longer
+ * scheduled when the handler runs and may be scheduled again from it. Handlers should only
+ * record the expiry, the work it causes is done by the owner of the entry afterwards.
+ *
+ * @param pEntry Entry that expired
+ * @param pHandlerData Data given to aws_iot_timer_wheel_init_entry
+ */
+typedef void (*pTimerWheelHandler_t)(IoT_Timer_Wheel_Entry *pEntry, void *pHandlerData);
+
+/**
+ * @brief Deadline on a timer wheel
+ *
+ * Storage is provided by the owner of the deadline, usually as part of a larger struct.
+ */
+struct _IoT_Timer_Wheel_Entry {
+	IoT_Timer_Wheel_Entry *pNext;
+	IoT_Timer_Wheel_Entry *pPrev;
+	uint32_t expiryMs;              ///< Deadline in milliseconds of wheel time
+	uint32_t wheelGeneration;       ///< Generation of the wheel the entry is scheduled on, 0 if not scheduled
+	uint8_t level;                  ///< Wheel level of the slot holding the entry
+	uint8_t slot;                   ///< Slot holding the entry
+	pTimerWheelHandler_t pHandler;  ///< Called when the deadline passes, may be NULL
+	void *pHandlerData;             ///< Passed to pHandler
+};
+
+/**
+ * @brief Timer wheel
+ */
+typedef struct {
+	IoT_Timer_Wheel_Entry *pSlots[AWS_IOT_TIMER_WHEEL_LEVELS][AWS_IOT_TIMER_WHEEL_SLOTS];
+	uint64_t occupiedSlots[AWS_IOT_TIMER_WHEEL_LEVELS];  ///< Bit per slot that holds entries
+	IoT_Timer_Wheel_Entry *pDue;        ///< Entries scheduled for a tick that was already expired
+	IoT_Timer_Wheel_Entry *pExpiring;   ///< Entries taken out of their slot whose handler has not run yet
+	Timer epochTimer;                   ///< Counts down while wheel time advances
+	uint32_t epochLeftMs;               ///< Time left on epochTimer when wheel time was last updated
+	uint32_t nowMs;                     ///< Wheel time in milliseconds, wraps around
+	uint32_t currentTick;               ///< Next millisecond whose slot has not been expired
+	uint32_t entryCount;                ///< Number of scheduled entries
+	uint32_t generation;                ///< Changed by every aws_iot_timer_wheel_init of this wheel, 0 is never used
+} IoT_Timer_Wheel;
+
+/**
+ * @brief Initialize a timer wheel
+ *
+ * Entries scheduled before a wheel is initialized again count as not scheduled afterwards.
+ *
+ * @param pWheel Timer wheel to initialize
+ */
+void aws_iot_timer_wheel_init(IoT_Timer_Wheel *pWheel);
+
+/**
+ * @brief Initialize an entry before it is first scheduled
+ *
+ * Must not be called for an entry that is scheduled.
+ *
+ * @param pEntry Entry to initialize
+ * @param pHandler Handler called when the deadline passes, NULL if the owner checks the entry itself
+ * @param pHandlerData Passed to pHandler
+ */
+void aws_iot_timer_wheel_init_entry(IoT_Timer_Wheel_Entry *pEntry, pTimerWheelHandler_t pHandler, void *pHandlerData);
+
+/**
+ * @brief Schedule an entry to expire after a timeout, replacing its current deadline if it has one
+ *
+ * @param pWheel Timer wheel
+ * @param pEntry Entry to schedule
+ * @param timeout_ms Milliseconds from now, at most AWS_IOT_TIMER_WHEEL_MAX_TIMEOUT_MS
+ */
+void aws_iot_timer_wheel_schedule(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntry, uint32_t timeout_ms);
+
+/**
+ * @brief Remove an entry from the wheel, nothing happens if it is not scheduled
+ *
+ * @param pWheel Timer wheel
+ * @param pEntry Entry to cancel
+ */
+void aws_iot_timer_wheel_cancel(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntry);
+
+/**
+ * @brief Check whether an entry is scheduled on the wheel
+ *
+ * An entry stays scheduled past its deadline until aws_iot_timer_wheel_run expires it.
+ *
+ * @param pWheel Timer wheel
+ * @param pEntry Entry to check
+ *
+ * @return true if the entry is scheduled
+ */
+bool aws_iot_timer_wheel_is_scheduled(const IoT_Timer_Wheel *pWheel, const IoT_Timer_Wheel_Entry *pEntry);
+
+/**
+ * @brief Check whether the deadline of an entry has passed
+ *
+ * Works like has_timer_expired, an entry that is not scheduled counts as expired.
+ *
+ * @param pWheel Timer wheel
+ * @param pEntry Entry to check
+ *
+ * @return true if the entry is not scheduled or its deadline has passed
+ */
+bool aws_iot_timer_wheel_has_expired(IoT_Timer_Wheel *pWheel, const IoT_Timer_Wheel_Entry *pEntry);
+
+/**
+ * @brief Time left until the deadline of an entry
+ *
+ * @param pWheel Timer wheel
+ * @param pEntry Entry to check
+ *
+ * @return Milliseconds until the deadline, 0 if it passed or the entry is not scheduled
+ */
+uint32_t aws_iot_timer_wheel_left_ms(IoT_Timer_Wheel *pWheel, const IoT_Timer_Wheel_Entry *pEntry);
+
+/**
+ * @brief Expire every entry whose deadline has passed
+ *
+ * Expired entries are removed from the wheel before their handler is called.
+ *
+ * @param pWheel Timer wheel
+ *
+ * @return Number of entries that expired
+ */
+uint32_t aws_iot_timer_wheel_run(IoT_Timer_Wheel *pWheel);
+
+/**
+ * @brief Time until aws_iot_timer_wheel_run has work to do
+ *
+ * Exact for deadlines less than 64 ms away. Further deadlines are rounded down to the point
+ * where their slot moves down a level, so a caller sleeping until then may wake once or twice
+ * early for a distant deadline, but never late.
+ *
+ * @param pWheel Timer wheel
+ *
+ * @return Milliseconds until the next run is due, 0 if it is due now, UINT32_MAX if nothing is scheduled
+ */
+uint32_t aws_iot_timer_wheel_get_next_timeout_ms(IoT_Timer_Wheel *pWheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AWS_IOT_SDK_SRC_TIMER_WHEEL_H_ */
@@ -57,6 +57,30 @@ typedef struct {
 	bool ServerVerificationFlag;        ///< Boolean.  True = perform server certificate hostname validation.  False = skip validation \b NOT recommended.
 } TLSConnectParams;
 
+/**
+ * @brief Network Write Vector
+ *
+ * Defines a type for one of the buffers passed to a vectored write. The buffers
+ * are sent back to back as if they were one contiguous buffer.
+ */
+typedef struct {
+	const unsigned char *pBuffer;            ///< Pointer to the bytes to write
+	size_t len;                              ///< Number of bytes to write from pBuffer
+} NetworkIoVec;
+
+/**
+ * @brief TLS Handshake Statistics
+ *
+ * Defines a type for the handshake statistics kept by the network layer.
+ * An implementation that does not track them leaves them at zero.
+ */
+typedef struct {
+	uint32_t handshakeCount;                 ///< Number of completed TLS handshakes
+	uint32_t resumedHandshakeCount;          ///< Number of completed handshakes that resumed the previous session
+	uint32_t lastHandshakeCpuTimeUs;         ///< CPU time the last completed handshake took, in microseconds
+	uint64_t totalHandshakeCpuTimeUs;        ///< CPU time all completed handshakes took, in microseconds
+} TLSHandshakeStats;
+
 /**
  * @brief Network Structure
  *
@@ -67,12 +91,16 @@ struct Network {
 
 	IoT_Error_t (*read)(Network *, unsigned char *, size_t, Timer *, size_t *);    ///< Function pointer pointing to the network function to read from the network
 	IoT_Error_t (*write)(Network *, unsigned char *, size_t, Timer *, size_t *);    ///< Function pointer pointing to the network function to write to the network
+	IoT_Error_t (*writev)(Network *, const NetworkIoVec *, size_t, Timer *, size_t *);    ///< Function pointer pointing to the network function to write several buffers to the network. Can be NULL, the MQTT client then copies into one buffer and uses write
 	IoT_Error_t (*disconnect)(Network *);    ///< Function pointer pointing to the network function to disconnect from the network
 	IoT_Error_t (*isConnected)(Network *);    ///< Function pointer pointing to the network function to check if TLS is connected
 	IoT_Error_t (*destroy)(Network *);        ///< Function pointer pointing to the network function to destroy the network object
+	IoT_Error_t (*getSocket)(Network *, int *);    ///< Function pointer pointing to the network function to get the socket descriptor, used by event loops to wait for incoming data. Can be NULL
+	IoT_Error_t (*release)(Network *);        ///< Function pointer pointing to the network function to release what is kept between connections, such as a saved TLS session. Can be NULL
 
 	TLSConnectParams tlsConnectParams;        ///< TLSConnect params structure containing the common connection parameters
 	TLSDataParams tlsDataParams;            ///< TLSData params structure containing the connection data parameters that are specific to the library being used
+	TLSHandshakeStats handshakeStats;        ///< Handshake statistics kept by the network implementation
 };
 
 /**
@@ -101,6 +129,8 @@ IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation, char *pDevice
  * @brief Create a TLS socket and open the connection
  *
  * Creates an open socket connection including TLS handshake.
+ * A non-blocking implementation returns NETWORK_SSL_WANT_READ or NETWORK_SSL_WANT_WRITE when the
+ * handshake has to wait for the socket, the next call resumes the handshake where it stopped.
  *
  * @param pNetwork - Pointer to a Network struct defining the network interface.
  * @param TLSParams - TLSConnectParams defines the properties of the TLS connection.
@@ -120,18 +150,54 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *TLSParams);
  */
 IoT_Error_t iot_tls_write(Network *, unsigned char *, size_t, Timer *, size_t *);
 
+/**
+ * @brief Write several buffers to the network socket
+ *
+ * Sends the buffers in order as one stream of bytes, without the caller having to
+ * copy them into a single buffer first. Used by the MQTT client to send the publish
+ * header and the application payload from where they are.
+ *
+ * @param Network - Pointer to a Network struct defining the network interface.
+ * @param NetworkIoVec pointer - array of buffers to write to socket
+ * @param size_t - number of buffers in the array
+ * @param Timer * - operation timer
+ * @param size_t - pointer to store the total number of bytes written
+ * @return IoT_Error_t - successful write or TLS error code
+ */
+IoT_Error_t iot_tls_writev(Network *, const NetworkIoVec *, size_t, Timer *, size_t *);
+
 /**
  * @brief Read bytes from the network socket
  *
  * @param Network - Pointer to a Network struct defining the network interface.
+ * Reads up to the requested number of bytes. The call returns as soon as some data is
+ * available instead of waiting for the full length, the MQTT client buffers partial reads
+ * and frames packets itself. NETWORK_SSL_NOTHING_TO_READ is returned if no data arrived
+ * before the timer expired. A non-blocking implementation returns NETWORK_SSL_WANT_READ,
+ * or NETWORK_SSL_WANT_WRITE while TLS needs to send, instead. The MQTT client then keeps
+ * a partially received packet and completes it on a later read.
+ *
  * @param unsigned char pointer - pointer to buffer where read bytes should be copied
- * @param size_t - number of bytes to read
+ * @param size_t - maximum number of bytes to read
  * @param Timer * - operation timer
  * @param size_t - pointer to store number of bytes read
  * @return IoT_Error_t - successful read or TLS error code
  */
 IoT_Error_t iot_tls_read(Network *, unsigned char *, size_t, Timer *, size_t *);
 
+/**
+ * @brief Get the descriptor of the network socket
+ *
+ * Used by event loops that wait on many connections at once, the descriptor becomes
+ * readable when data arrives. It changes when the connection is re-established and
+ * is -1 while there is no connection.
+ *
+ * @param Network - Pointer to a Network struct defining the network interface.
+ * @param int pointer - pointer to store the socket descriptor
+ * @return IoT_Error_t - successful lookup or TLS error code
+ */
+IoT_Error_t iot_tls_get_socket(Network *pNetwork, int *pSocket);
+
 /**
  * @brief Disconnect from network socket
  *
@@ -150,6 +216,17 @@ IoT_Error_t iot_tls_disconnect(Network *pNetwork);
  */
 IoT_Error_t iot_tls_destroy(Network *pNetwork);
 
+/**
+ * @brief Release what the TLS layer keeps between connections
+ *
+ * iot_tls_destroy ends one connection but may keep state that speeds up the next one,
+ * such as the session to resume. This frees it, called when the client is no longer used.
+ *
+ * @param Network - Pointer to a Network struct defining the network interface
+ * @return IoT_Error_t - successful cleanup or TLS error code
+ */
+IoT_Error_t iot_tls_release(Network *pNetwork);
+
 /**
  * @brief Check if TLS layer is still connected
  *
@@ -98,6 +98,23 @@ uint32_t left_ms(Timer *);
  */
 void init_timer(Timer *);
 
+/**
+ * @brief Read the clock once for a batch of timer checks
+ *
+ * Until the matching end_timer_batch call, timers checked or started by the calling thread
+ * use the time read here instead of reading the clock each time. Meant for loops that check
+ * the timers of many clients or requests in one pass. Nothing that waits on a timer, a network
+ * read or write for example, may run inside a batch, the time would not move on for it.
+ * Batches can be nested, only the outermost one reads the clock.
+ * A platform can implement this as a no-op.
+ */
+void begin_timer_batch(void);
+
+/**
+ * @brief End a batch of timer checks started with begin_timer_batch
+ */
+void end_timer_batch(void);
+
 #ifdef __cplusplus
 }
 #endif
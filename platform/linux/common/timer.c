@@ -16,6 +16,9 @@
 /**
  * @file timer.c
  * @brief Linux implementation of the timer interface.
+ *
+ * Timers run on CLOCK_MONOTONIC, so setting the system time or NTP corrections
+ * do not make them expire early or late.
  */
 
 #ifdef __cplusplus
@@ -29,44 +32,79 @@ extern "C" {
 
 #include "timer_platform.h"
 
+/* The coarse clock is cheaper to read but only advances every few milliseconds */
+#ifdef _ENABLE_COARSE_TIMER_
+#define TIMER_CLOCK_ID CLOCK_MONOTONIC_COARSE
+#else
+#define TIMER_CLOCK_ID CLOCK_MONOTONIC
+#endif
+
+static __thread struct timespec batchNow;
+static __thread uint32_t batchDepth = 0;
+
+static void _timer_get_now(struct timespec *pNow) {
+	if(0 < batchDepth) {
+		*pNow = batchNow;
+	} else {
+		clock_gettime(TIMER_CLOCK_ID, pNow);
+	}
+}
+
+static int64_t _timer_left_ns(Timer *timer) {
+	struct timespec now;
+	_timer_get_now(&now);
+	return ((int64_t) (timer->end_time.tv_sec - now.tv_sec) * 1000000000LL)
+		   + (int64_t) (timer->end_time.tv_nsec - now.tv_nsec);
+}
+
+static void _timer_start(Timer *timer, uint32_t timeout_sec, uint32_t timeout_ms) {
+	struct timespec now;
+	_timer_get_now(&now);
+	timer->end_time.tv_sec = now.tv_sec + (time_t) timeout_sec + (time_t) (timeout_ms / 1000);
+	timer->end_time.tv_nsec = now.tv_nsec + (long) ((timeout_ms % 1000) * 1000000);
+	if(timer->end_time.tv_nsec >= 1000000000L) {
+		timer->end_time.tv_sec++;
+		timer->end_time.tv_nsec -= 1000000000L;
+	}
+}
+
 bool has_timer_expired(Timer *timer) {
-	struct timeval now, res;
-	gettimeofday(&now, NULL);
-	timersub(&timer->end_time, &now, &res);
-	return res.tv_sec < 0 || (res.tv_sec == 0 && res.tv_usec <= 0);
+	return _timer_left_ns(timer) <= 0;
 }
 
 void countdown_ms(Timer *timer, uint32_t timeout) {
-	struct timeval now;
-#ifdef __cplusplus
-	struct timeval interval = {timeout / 1000, static_cast<int>((timeout % 1000) * 1000)};
-#else
-	struct timeval interval = {timeout / 1000, (int)((timeout % 1000) * 1000)};
-#endif
-	gettimeofday(&now, NULL);
-	timeradd(&now, &interval, &timer->end_time);
+	_timer_start(timer, 0, timeout);
 }
 
 uint32_t left_ms(Timer *timer) {
-	struct timeval now, res;
+	int64_t left_ns = _timer_left_ns(timer);
 	uint32_t result_ms = 0;
-	gettimeofday(&now, NULL);
-	timersub(&timer->end_time, &now, &res);
-	if(res.tv_sec >= 0) {
-		result_ms = (uint32_t) (res.tv_sec * 1000 + res.tv_usec / 1000);
+	if(left_ns > 0) {
+		result_ms = (uint32_t) (left_ns / 1000000);
 	}
 	return result_ms;
 }
 
 void countdown_sec(Timer *timer, uint32_t timeout) {
-	struct timeval now;
-	struct timeval interval = {timeout, 0};
-	gettimeofday(&now, NULL);
-	timeradd(&now, &interval, &timer->end_time);
+	_timer_start(timer, timeout, 0);
 }
 
 void init_timer(Timer *timer) {
-	timer->end_time = (struct timeval) {0, 0};
+	timer->end_time.tv_sec = 0;
+	timer->end_time.tv_nsec = 0;
+}
+
+void begin_timer_batch(void) {
+	if(0 == batchDepth) {
+		clock_gettime(TIMER_CLOCK_ID, &batchNow);
+	}
+	batchDepth++;
+}
+
+void end_timer_batch(void) {
+	if(0 < batchDepth) {
+		batchDepth--;
+	}
 }
 
 #ifdef __cplusplus
@@ -23,15 +23,18 @@ extern "C" {
 /**
  * @file timer_platform.h
  */
+#include <time.h>
 #include <sys/time.h>
 #include <sys/select.h>
 #include "timer_interface.h"
 
 /**
  * definition of the Timer struct. Platform specific
+ *
+ * The end time is on the monotonic clock, wall clock steps do not move it.
  */
 struct Timer {
-	struct timeval end_time;
+	struct timespec end_time;
 };
 
 #ifdef __cplusplus
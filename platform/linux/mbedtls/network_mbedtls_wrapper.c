@@ -19,6 +19,11 @@ extern "C" {
 
 #include <stdbool.h>
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
 #include <timer_platform.h>
 #include <network_interface.h>
 
@@ -27,16 +32,325 @@ extern "C" {
 #include "network_interface.h"
 #include "network_platform.h"
 
+#ifdef _ENABLE_THREAD_SUPPORT_
+#include "threads_interface.h"
+#endif
+
 /* This is the value used for ssl read timeout */
 #define IOT_SSL_READ_TIMEOUT 10
 
+/* Buffers shorter than this are joined with the start of the next buffer in a vectored write */
+#define IOT_SSL_WRITEV_COALESCE_LEN 256
+
+/*
+ * Waits until the socket is ready for what mbedTLS asked for with ret, at most until the timer expires.
+ * Returns SUCCESS once it is ready, NETWORK_SSL_WANT_READ or NETWORK_SSL_WANT_WRITE if the timer expired
+ * first and NETWORK_SSL_UNKNOWN_ERROR if poll fails or the descriptor is not open.
+ */
+static IoT_Error_t _iot_tls_wait_for_socket(TLSDataParams *tlsDataParams, int ret, Timer *timer) {
+	struct pollfd pfd;
+	uint32_t wait_ms;
+	int pollRet;
+
+	pfd.fd = tlsDataParams->server_fd.fd;
+	pfd.events = (MBEDTLS_ERR_SSL_WANT_WRITE == ret) ? POLLOUT : POLLIN;
+
+	do {
+		wait_ms = left_ms(timer);
+		if(0 == wait_ms) {
+			return (MBEDTLS_ERR_SSL_WANT_WRITE == ret) ? NETWORK_SSL_WANT_WRITE : NETWORK_SSL_WANT_READ;
+		}
+		pfd.revents = 0;
+		pollRet = poll(&pfd, 1, (int) wait_ms);
+	} while(pollRet < 0 && EINTR == errno);
+
+	if(pollRet < 0 || 0 != (pfd.revents & POLLNVAL)) {
+		IOT_ERROR(" poll on the TLS socket failed, errno %d revents 0x%x\n", (pollRet < 0) ? errno : 0,
+				  (unsigned int) pfd.revents);
+		return NETWORK_SSL_UNKNOWN_ERROR;
+	}
+	if(0 == pollRet) {
+		return (MBEDTLS_ERR_SSL_WANT_WRITE == ret) ? NETWORK_SSL_WANT_WRITE : NETWORK_SSL_WANT_READ;
+	}
+
+	return SUCCESS;
+}
+
+typedef enum {
+	TLS_CREDENTIAL_ROOT_CA,
+	TLS_CREDENTIAL_DEVICE_CERT
+} TLSCredentialType;
+
+/*
+ * Entry of the credential store. Every certificate file is parsed once and shared by all connections
+ * using it. When the file changes on disk the next connect parses it again into a new entry,
+ * the old one is marked stale and freed once the last connection using it is destroyed.
+ * Private keys are not shared, signing with one updates its blinding values, so every Network
+ * parses its own (see _iot_tls_load_device_key).
+ */
+struct _TLSCredential {
+	struct _TLSCredential *pNext;
+	char *pPath;
+	TLSCredentialType type;
+	mbedtls_x509_crt crt;
+	struct stat fileStat;
+	uint32_t refCount;
+	bool isStale;
+};
+
+static TLSCredential *pCredentialStore = NULL;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+static IoT_Mutex_t credentialStoreMutex;
+static bool isCredentialStoreMutexInitialized = false;
+#endif
+
+static void _iot_tls_credential_store_lock(void) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_lock(&credentialStoreMutex);
+#endif
+}
+
+static void _iot_tls_credential_store_unlock(void) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_unlock(&credentialStoreMutex);
+#endif
+}
+
+static bool _iot_tls_is_file_unchanged(const struct stat *pParsedStat, const struct stat *pFileStat) {
+	return pParsedStat->st_dev == pFileStat->st_dev && pParsedStat->st_ino == pFileStat->st_ino
+		   && pParsedStat->st_size == pFileStat->st_size
+		   && pParsedStat->st_mtim.tv_sec == pFileStat->st_mtim.tv_sec
+		   && pParsedStat->st_mtim.tv_nsec == pFileStat->st_mtim.tv_nsec;
+}
+
+/* Called with the store locked */
+static void _iot_tls_free_credential(TLSCredential *pCredential) {
+	TLSCredential **ppLink = &pCredentialStore;
+
+	while(NULL != *ppLink && pCredential != *ppLink) {
+		ppLink = &((*ppLink)->pNext);
+	}
+	if(NULL != *ppLink) {
+		*ppLink = pCredential->pNext;
+	}
+
+	mbedtls_x509_crt_free(&(pCredential->crt));
+	free(pCredential->pPath);
+	free(pCredential);
+}
+
+/* Called with the store locked */
+static IoT_Error_t _iot_tls_parse_credential(TLSCredential *pCredential) {
+	int ret;
+
+	switch(pCredential->type) {
+		case TLS_CREDENTIAL_ROOT_CA:
+			IOT_DEBUG("  . Loading the CA root certificate ...");
+			ret = mbedtls_x509_crt_parse_file(&(pCredential->crt), pCredential->pPath);
+			if(ret < 0) {
+				IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing root cert\n\n", -ret);
+				return NETWORK_X509_ROOT_CRT_PARSE_ERROR;
+			}
+			IOT_DEBUG(" ok (%d skipped)\n", ret);
+			break;
+		case TLS_CREDENTIAL_DEVICE_CERT:
+		default:
+			IOT_DEBUG("  . Loading the client cert. ...");
+			ret = mbedtls_x509_crt_parse_file(&(pCredential->crt), pCredential->pPath);
+			if(ret != 0) {
+				IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing device cert\n\n", -ret);
+				return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+			}
+			IOT_DEBUG(" ok\n");
+			break;
+	}
+
+	return SUCCESS;
+}
+
+static IoT_Error_t _iot_tls_credential_error(TLSCredentialType type) {
+	switch(type) {
+		case TLS_CREDENTIAL_ROOT_CA:
+			return NETWORK_X509_ROOT_CRT_PARSE_ERROR;
+		case TLS_CREDENTIAL_DEVICE_CERT:
+		default:
+			return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+	}
+}
+
+/*
+ * Get the parsed credential for a file from the store, parsing it only if this is the
+ * first use or the file changed since it was parsed
+ */
+static IoT_Error_t _iot_tls_acquire_credential(const char *pPath, TLSCredentialType type,
+											   TLSCredential **ppCredential) {
+	TLSCredential *pCredential;
+	struct stat fileStat;
+	IoT_Error_t rc;
+
+	*ppCredential = NULL;
+
+	if(NULL == pPath || 0 != stat(pPath, &fileStat)) {
+		IOT_ERROR("Could not access credential file %s\n", (NULL == pPath) ? "(null)" : pPath);
+		return _iot_tls_credential_error(type);
+	}
+
+	_iot_tls_credential_store_lock();
+
+	for(pCredential = pCredentialStore; NULL != pCredential; pCredential = pCredential->pNext) {
+		if(!pCredential->isStale && type == pCredential->type && 0 == strcmp(pPath, pCredential->pPath)) {
+			break;
+		}
+	}
+
+	if(NULL != pCredential && !_iot_tls_is_file_unchanged(&(pCredential->fileStat), &fileStat)) {
+		IOT_DEBUG("  . %s changed, loading it again\n", pPath);
+		pCredential->isStale = true;
+		if(0 == pCredential->refCount) {
+			_iot_tls_free_credential(pCredential);
+		}
+		pCredential = NULL;
+	}
+
+	if(NULL == pCredential) {
+		pCredential = (TLSCredential *) calloc(1, sizeof(TLSCredential));
+		if(NULL != pCredential) {
+			pCredential->pPath = strdup(pPath);
+		}
+		if(NULL == pCredential || NULL == pCredential->pPath) {
+			free(pCredential);
+			_iot_tls_credential_store_unlock();
+			return _iot_tls_credential_error(type);
+		}
+
+		pCredential->type = type;
+		mbedtls_x509_crt_init(&(pCredential->crt));
+		pCredential->fileStat = fileStat;
+
+		rc = _iot_tls_parse_credential(pCredential);
+		if(SUCCESS != rc) {
+			/* not linked into the store yet */
+			mbedtls_x509_crt_free(&(pCredential->crt));
+			free(pCredential->pPath);
+			free(pCredential);
+			_iot_tls_credential_store_unlock();
+			return rc;
+		}
+
+		pCredential->pNext = pCredentialStore;
+		pCredentialStore = pCredential;
+	}
+
+	pCredential->refCount++;
+	*ppCredential = pCredential;
+
+	_iot_tls_credential_store_unlock();
+
+	return SUCCESS;
+}
+
+static void _iot_tls_release_credential(TLSCredential **ppCredential) {
+	TLSCredential *pCredential = *ppCredential;
+
+	if(NULL == pCredential) {
+		return;
+	}
+
+	_iot_tls_credential_store_lock();
+	pCredential->refCount--;
+	/* the current version of a file stays parsed for the next connect */
+	if(0 == pCredential->refCount && pCredential->isStale) {
+		_iot_tls_free_credential(pCredential);
+	}
+	_iot_tls_credential_store_unlock();
+
+	*ppCredential = NULL;
+}
+
+static void _iot_tls_release_credentials(TLSDataParams *tlsDataParams) {
+	_iot_tls_release_credential(&(tlsDataParams->pRootCA));
+	_iot_tls_release_credential(&(tlsDataParams->pDeviceCert));
+}
+
+/*
+ * Parse the private key of this Network, again only if the file changed since the last connect.
+ * Kept per Network because the RSA blinding values in the context are updated by every handshake.
+ */
+static IoT_Error_t _iot_tls_load_device_key(Network *pNetwork) {
+	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
+	const char *pPath = pNetwork->tlsConnectParams.pDevicePrivateKeyLocation;
+	struct stat fileStat;
+	int ret;
+
+	if(NULL == pPath || 0 != stat(pPath, &fileStat)) {
+		IOT_ERROR("Could not access credential file %s\n", (NULL == pPath) ? "(null)" : pPath);
+		return NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
+	}
+
+	if(tlsDataParams->isDeviceKeyParsed && _iot_tls_is_file_unchanged(&(tlsDataParams->deviceKeyStat), &fileStat)) {
+		return SUCCESS;
+	}
+
+	mbedtls_pk_free(&(tlsDataParams->deviceKey));
+	mbedtls_pk_init(&(tlsDataParams->deviceKey));
+	tlsDataParams->isDeviceKeyParsed = false;
+
+	IOT_DEBUG("  . Loading the client key ...");
+	ret = mbedtls_pk_parse_keyfile(&(tlsDataParams->deviceKey), pPath, "");
+	if(ret != 0) {
+		IOT_ERROR(" failed\n  !  mbedtls_pk_parse_key returned -0x%x while parsing private key\n\n", -ret);
+		IOT_DEBUG(" path : %s ", pPath);
+		mbedtls_pk_free(&(tlsDataParams->deviceKey));
+		mbedtls_pk_init(&(tlsDataParams->deviceKey));
+		return NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
+	}
+	IOT_DEBUG(" ok\n");
+
+	tlsDataParams->deviceKeyStat = fileStat;
+	tlsDataParams->isDeviceKeyParsed = true;
+
+	return SUCCESS;
+}
+
+/*
+ * CPU time used by the calling thread in microseconds. Time spent waiting for the
+ * socket is not included, so this measures the cost of the handshake crypto.
+ */
+static uint64_t _iot_tls_get_cpu_time_us(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return ((uint64_t) now.tv_sec * 1000000ULL) + ((uint64_t) now.tv_nsec / 1000ULL);
+}
+
+/*
+ * Keep the session of a completed handshake so the next connect can resume it
+ * instead of doing the full handshake again
+ */
+static void _iot_tls_save_session(TLSDataParams *tlsDataParams) {
+	mbedtls_ssl_session_free(&(tlsDataParams->savedSession));
+	mbedtls_ssl_session_init(&(tlsDataParams->savedSession));
+	tlsDataParams->isSessionSaved =
+			(0 == mbedtls_ssl_get_session(&(tlsDataParams->ssl), &(tlsDataParams->savedSession)));
+}
+
+static void _iot_tls_forget_session(TLSDataParams *tlsDataParams) {
+	mbedtls_ssl_session_free(&(tlsDataParams->savedSession));
+	mbedtls_ssl_session_init(&(tlsDataParams->savedSession));
+	tlsDataParams->isSessionSaved = false;
+}
+
 /*
  * This is a function to do further verification if needed on the cert received
  */
 
 static int _iot_tls_verify_cert(void *data, mbedtls_x509_crt *crt, int depth, uint32_t *flags) {
 	char buf[1024];
-	((void) data);
+	TLSDataParams *tlsDataParams = (TLSDataParams *) data;
+
+	/* Only a full handshake sends the server certificate, a resumed one skips this */
+	tlsDataParams->isFullHandshake = true;
 
 	IOT_DEBUG("\nVerify requested for (Depth %d):\n", depth);
 	mbedtls_x509_crt_info(buf, sizeof(buf) - 1, "", crt);
@@ -73,11 +387,34 @@ IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation, char *pDevice
 	pNetwork->connect = iot_tls_connect;
 	pNetwork->read = iot_tls_read;
 	pNetwork->write = iot_tls_write;
+	pNetwork->writev = iot_tls_writev;
 	pNetwork->disconnect = iot_tls_disconnect;
 	pNetwork->isConnected = iot_tls_is_connected;
 	pNetwork->destroy = iot_tls_destroy;
+	pNetwork->getSocket = iot_tls_get_socket;
+	pNetwork->release = iot_tls_release;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	/* Clients are expected to be initialized from one thread, the store mutex is created by the first */
+	if(!isCredentialStoreMutexInitialized) {
+		IoT_Error_t rc = aws_iot_thread_mutex_init(&credentialStoreMutex);
+		if(SUCCESS != rc) {
+			return rc;
+		}
+		isCredentialStoreMutexInitialized = true;
+	}
+#endif
 
 	pNetwork->tlsDataParams.flags = 0;
+	pNetwork->tlsDataParams.pRootCA = NULL;
+	pNetwork->tlsDataParams.pDeviceCert = NULL;
+	mbedtls_pk_init(&(pNetwork->tlsDataParams.deviceKey));
+	pNetwork->tlsDataParams.isDeviceKeyParsed = false;
+	pNetwork->tlsDataParams.isRngSeeded = false;
+	pNetwork->tlsDataParams.server_fd.fd = -1;
+	pNetwork->tlsDataParams.isHandshakeInProgress = false;
+	mbedtls_ssl_session_init(&(pNetwork->tlsDataParams.savedSession));
+	pNetwork->tlsDataParams.isSessionSaved = false;
 
 	return SUCCESS;
 }
@@ -87,20 +424,123 @@ IoT_Error_t iot_tls_is_connected(Network *pNetwork) {
 	return NETWORK_PHYSICAL_LAYER_CONNECTED;
 }
 
+/*
+ * Runs the TLS handshake on a connected socket and verifies the server.
+ * With _ENABLE_NONBLOCKING_TLS_ it does not wait for the socket, it returns NETWORK_SSL_WANT_READ or
+ * NETWORK_SSL_WANT_WRITE as soon as mbedTLS would block. The connect timeout counts from the call that
+ * started the handshake, NETWORK_SSL_CONNECT_TIMEOUT_ERROR is returned once it is used up.
+ */
+static IoT_Error_t _iot_tls_handshake(Network *pNetwork) {
+	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
+	char vrfy_buf[512];
+	uint64_t cpuStart;
+	int ret;
+#ifdef IOT_DEBUG
+	unsigned char buf[MBEDTLS_SSL_MAX_CONTENT_LEN + 1];
+#endif
+
+	IOT_DEBUG("  . Performing the SSL/TLS handshake...");
+	cpuStart = _iot_tls_get_cpu_time_us();
+
+	while((ret = mbedtls_ssl_handshake(&(tlsDataParams->ssl))) != 0) {
+		if(ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+			tlsDataParams->isHandshakeInProgress = false;
+			/* start over with a full handshake next time */
+			_iot_tls_forget_session(tlsDataParams);
+			IOT_ERROR(" failed\n  ! mbedtls_ssl_handshake returned -0x%x\n", -ret);
+			if(ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+				IOT_ERROR("    Unable to verify the server's certificate. "
+							  "Either it is invalid,\n"
+							  "    or you didn't set ca_file or ca_path "
+							  "to an appropriate value.\n"
+							  "    Alternatively, you may want to use "
+							  "auth_mode=optional for testing purposes.\n");
+			}
+			return SSL_CONNECTION_ERROR;
+		}
+#ifdef _ENABLE_NONBLOCKING_TLS_
+		tlsDataParams->handshakeCpuTimeUs += _iot_tls_get_cpu_time_us() - cpuStart;
+		if(has_timer_expired(&(tlsDataParams->handshakeTimer))) {
+			tlsDataParams->isHandshakeInProgress = false;
+			_iot_tls_forget_session(tlsDataParams);
+			IOT_ERROR(" failed\n  ! TLS handshake not done within the connect timeout\n");
+			return NETWORK_SSL_CONNECT_TIMEOUT_ERROR;
+		}
+		/* the state stays in the SSL context, the next call resumes once the socket is ready */
+		tlsDataParams->isHandshakeInProgress = true;
+		return (MBEDTLS_ERR_SSL_WANT_WRITE == ret) ? NETWORK_SSL_WANT_WRITE : NETWORK_SSL_WANT_READ;
+#endif
+	}
+	tlsDataParams->isHandshakeInProgress = false;
+	tlsDataParams->handshakeCpuTimeUs += _iot_tls_get_cpu_time_us() - cpuStart;
+
+	IOT_DEBUG(" ok\n    [ Protocol is %s ]\n    [ Ciphersuite is %s ]\n", mbedtls_ssl_get_version(&(tlsDataParams->ssl)),
+		  mbedtls_ssl_get_ciphersuite(&(tlsDataParams->ssl)));
+	if((ret = mbedtls_ssl_get_record_expansion(&(tlsDataParams->ssl))) >= 0) {
+		IOT_DEBUG("    [ Record expansion is %d ]\n", ret);
+	} else {
+		IOT_DEBUG("    [ Record expansion is unknown (compression) ]\n");
+	}
+
+	IOT_DEBUG("  . Verifying peer X.509 certificate...");
+
+	if(pNetwork->tlsConnectParams.ServerVerificationFlag == true) {
+		if((tlsDataParams->flags = mbedtls_ssl_get_verify_result(&(tlsDataParams->ssl))) != 0) {
+			IOT_ERROR(" failed\n");
+			mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", tlsDataParams->flags);
+			IOT_ERROR("%s\n", vrfy_buf);
+			ret = SSL_CONNECTION_ERROR;
+		} else {
+			IOT_DEBUG(" ok\n");
+			ret = SUCCESS;
+		}
+	} else {
+		IOT_DEBUG(" Server Verification skipped\n");
+		ret = SUCCESS;
+	}
+
+	if(SUCCESS == ret) {
+		pNetwork->handshakeStats.handshakeCount++;
+		if(!tlsDataParams->isFullHandshake) {
+			IOT_DEBUG("  . Resumed the previous session\n");
+			pNetwork->handshakeStats.resumedHandshakeCount++;
+		}
+		pNetwork->handshakeStats.lastHandshakeCpuTimeUs = (uint32_t) tlsDataParams->handshakeCpuTimeUs;
+		pNetwork->handshakeStats.totalHandshakeCpuTimeUs += tlsDataParams->handshakeCpuTimeUs;
+		_iot_tls_save_session(tlsDataParams);
+	} else {
+		_iot_tls_forget_session(tlsDataParams);
+	}
+
+#ifdef IOT_DEBUG
+	if (mbedtls_ssl_get_peer_cert(&(tlsDataParams->ssl)) != NULL) {
+		IOT_DEBUG("  . Peer certificate information    ...\n");
+		mbedtls_x509_crt_info((char *) buf, sizeof(buf) - 1, "      ", mbedtls_ssl_get_peer_cert(&(tlsDataParams->ssl)));
+		IOT_DEBUG("%s\n", buf);
+	}
+#endif
+
+	mbedtls_ssl_conf_read_timeout(&(tlsDataParams->conf), IOT_SSL_READ_TIMEOUT);
+
+	return (IoT_Error_t) ret;
+}
+
 IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	int ret = 0;
 	const char *pers = "aws_iot_tls_wrapper";
 	TLSDataParams *tlsDataParams = NULL;
 	char portBuffer[6];
-	char vrfy_buf[512];
-#ifdef IOT_DEBUG
-	unsigned char buf[MBEDTLS_SSL_MAX_CONTENT_LEN + 1];
-#endif
+	IoT_Error_t rc;
 
 	if(NULL == pNetwork) {
 		return NULL_VALUE_ERROR;
 	}
 
+	if(pNetwork->tlsDataParams.isHandshakeInProgress) {
+		/* the socket is ready now, resume the handshake of the previous call */
+		return _iot_tls_handshake(pNetwork);
+	}
+
 	if(NULL != params) {
 		_iot_tls_set_connect_params(pNetwork, params->pRootCALocation, params->pDeviceCertLocation,
 									params->pDevicePrivateKeyLocation, params->pDestinationURL,
@@ -112,41 +552,38 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	mbedtls_net_init(&(tlsDataParams->server_fd));
 	mbedtls_ssl_init(&(tlsDataParams->ssl));
 	mbedtls_ssl_config_init(&(tlsDataParams->conf));
-	mbedtls_ctr_drbg_init(&(tlsDataParams->ctr_drbg));
-	mbedtls_x509_crt_init(&(tlsDataParams->cacert));
-	mbedtls_x509_crt_init(&(tlsDataParams->clicert));
-	mbedtls_pk_init(&(tlsDataParams->pkey));
 
-	IOT_DEBUG("\n  . Seeding the random number generator...");
-	mbedtls_entropy_init(&(tlsDataParams->entropy));
-	if((ret = mbedtls_ctr_drbg_seed(&(tlsDataParams->ctr_drbg), mbedtls_entropy_func, &(tlsDataParams->entropy),
-									(const unsigned char *) pers, strlen(pers))) != 0) {
-		IOT_ERROR(" failed\n  ! mbedtls_ctr_drbg_seed returned -0x%x\n", -ret);
-		return NETWORK_MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+	/* The generator is seeded once and kept for reconnects, iot_tls_release frees it */
+	if(!tlsDataParams->isRngSeeded) {
+		IOT_DEBUG("\n  . Seeding the random number generator...");
+		mbedtls_ctr_drbg_init(&(tlsDataParams->ctr_drbg));
+		mbedtls_entropy_init(&(tlsDataParams->entropy));
+		if((ret = mbedtls_ctr_drbg_seed(&(tlsDataParams->ctr_drbg), mbedtls_entropy_func, &(tlsDataParams->entropy),
+										(const unsigned char *) pers, strlen(pers))) != 0) {
+			IOT_ERROR(" failed\n  ! mbedtls_ctr_drbg_seed returned -0x%x\n", -ret);
+			mbedtls_ctr_drbg_free(&(tlsDataParams->ctr_drbg));
+			mbedtls_entropy_free(&(tlsDataParams->entropy));
+			return NETWORK_MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+		}
+		tlsDataParams->isRngSeeded = true;
 	}
 
-	IOT_DEBUG("  . Loading the CA root certificate ...");
-	ret = mbedtls_x509_crt_parse_file(&(tlsDataParams->cacert), pNetwork->tlsConnectParams.pRootCALocation);
-	if(ret < 0) {
-		IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing root cert\n\n", -ret);
-		return NETWORK_X509_ROOT_CRT_PARSE_ERROR;
+	/* Certificates are parsed once per process and shared, see _iot_tls_acquire_credential */
+	_iot_tls_release_credentials(tlsDataParams);
+	rc = _iot_tls_acquire_credential(pNetwork->tlsConnectParams.pRootCALocation, TLS_CREDENTIAL_ROOT_CA,
+									 &(tlsDataParams->pRootCA));
+	if(SUCCESS == rc) {
+		rc = _iot_tls_acquire_credential(pNetwork->tlsConnectParams.pDeviceCertLocation, TLS_CREDENTIAL_DEVICE_CERT,
+										 &(tlsDataParams->pDeviceCert));
 	}
-	IOT_DEBUG(" ok (%d skipped)\n", ret);
-
-	IOT_DEBUG("  . Loading the client cert. and key...");
-	ret = mbedtls_x509_crt_parse_file(&(tlsDataParams->clicert), pNetwork->tlsConnectParams.pDeviceCertLocation);
-	if(ret != 0) {
-		IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing device cert\n\n", -ret);
-		return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+	if(SUCCESS == rc) {
+		rc = _iot_tls_load_device_key(pNetwork);
 	}
-
-	ret = mbedtls_pk_parse_keyfile(&(tlsDataParams->pkey), pNetwork->tlsConnectParams.pDevicePrivateKeyLocation, "");
-	if(ret != 0) {
-		IOT_ERROR(" failed\n  !  mbedtls_pk_parse_key returned -0x%x while parsing private key\n\n", -ret);
-		IOT_DEBUG(" path : %s ", pNetwork->tlsConnectParams.pDevicePrivateKeyLocation);
-		return NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
+	if(SUCCESS != rc) {
+		_iot_tls_release_credentials(tlsDataParams);
+		return rc;
 	}
-	IOT_DEBUG(" ok\n");
+
 	snprintf(portBuffer, 6, "%d", pNetwork->tlsConnectParams.DestinationPort);
 	IOT_DEBUG("  . Connecting to %s/%s...", pNetwork->tlsConnectParams.pDestinationURL, portBuffer);
 	if((ret = mbedtls_net_connect(&(tlsDataParams->server_fd), pNetwork->tlsConnectParams.pDestinationURL,
@@ -163,7 +600,11 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 		};
 	}
 
+#ifdef _ENABLE_NONBLOCKING_TLS_
+	ret = mbedtls_net_set_nonblock(&(tlsDataParams->server_fd));
+#else
 	ret = mbedtls_net_set_block(&(tlsDataParams->server_fd));
+#endif
 	if(ret != 0) {
 		IOT_ERROR(" failed\n  ! net_set_(non)block() returned -0x%x\n\n", -ret);
 		return SSL_CONNECTION_ERROR;
@@ -176,7 +617,7 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 		return SSL_CONNECTION_ERROR;
 	}
 
-	mbedtls_ssl_conf_verify(&(tlsDataParams->conf), _iot_tls_verify_cert, NULL);
+	mbedtls_ssl_conf_verify(&(tlsDataParams->conf), _iot_tls_verify_cert, tlsDataParams);
 	if(pNetwork->tlsConnectParams.ServerVerificationFlag == true) {
 		mbedtls_ssl_conf_authmode(&(tlsDataParams->conf), MBEDTLS_SSL_VERIFY_REQUIRED);
 	} else {
@@ -184,9 +625,9 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	}
 	mbedtls_ssl_conf_rng(&(tlsDataParams->conf), mbedtls_ctr_drbg_random, &(tlsDataParams->ctr_drbg));
 
-	mbedtls_ssl_conf_ca_chain(&(tlsDataParams->conf), &(tlsDataParams->cacert), NULL);
-	if((ret = mbedtls_ssl_conf_own_cert(&(tlsDataParams->conf), &(tlsDataParams->clicert), &(tlsDataParams->pkey))) !=
-	   0) {
+	mbedtls_ssl_conf_ca_chain(&(tlsDataParams->conf), &(tlsDataParams->pRootCA->crt), NULL);
+	if((ret = mbedtls_ssl_conf_own_cert(&(tlsDataParams->conf), &(tlsDataParams->pDeviceCert->crt),
+										&(tlsDataParams->deviceKey))) != 0) {
 		IOT_ERROR(" failed\n  ! mbedtls_ssl_conf_own_cert returned %d\n\n", ret);
 		return SSL_CONNECTION_ERROR;
 	}
@@ -201,70 +642,34 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 		IOT_ERROR(" failed\n  ! mbedtls_ssl_set_hostname returned %d\n\n", ret);
 		return SSL_CONNECTION_ERROR;
 	}
+	/* Offer the session of the last connection, the server falls back to a full handshake if it has dropped it */
+	if(tlsDataParams->isSessionSaved && (ret = mbedtls_ssl_set_session(&(tlsDataParams->ssl),
+																	   &(tlsDataParams->savedSession))) != 0) {
+		IOT_DEBUG(" mbedtls_ssl_set_session returned -0x%x, doing a full handshake\n", -ret);
+	}
+	tlsDataParams->isFullHandshake = false;
+	tlsDataParams->handshakeCpuTimeUs = 0;
+	init_timer(&(tlsDataParams->handshakeTimer));
+	countdown_ms(&(tlsDataParams->handshakeTimer), pNetwork->tlsConnectParams.timeout_ms);
 	IOT_DEBUG("\n\nSSL state connect : %d ", tlsDataParams->ssl.state);
+#ifdef _ENABLE_NONBLOCKING_TLS_
+	/* mbedTLS reports a would-block socket with WANT_READ/WANT_WRITE, waiting is done in this file */
+	mbedtls_ssl_set_bio(&(tlsDataParams->ssl), &(tlsDataParams->server_fd), mbedtls_net_send, mbedtls_net_recv,
+						NULL);
+#else
 	mbedtls_ssl_set_bio(&(tlsDataParams->ssl), &(tlsDataParams->server_fd), mbedtls_net_send, NULL,
 						mbedtls_net_recv_timeout);
-	IOT_DEBUG(" ok\n");
-
-	IOT_DEBUG("\n\nSSL state connect : %d ", tlsDataParams->ssl.state);
-	IOT_DEBUG("  . Performing the SSL/TLS handshake...");
-	while((ret = mbedtls_ssl_handshake(&(tlsDataParams->ssl))) != 0) {
-		if(ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-			IOT_ERROR(" failed\n  ! mbedtls_ssl_handshake returned -0x%x\n", -ret);
-			if(ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
-				IOT_ERROR("    Unable to verify the server's certificate. "
-							  "Either it is invalid,\n"
-							  "    or you didn't set ca_file or ca_path "
-							  "to an appropriate value.\n"
-							  "    Alternatively, you may want to use "
-							  "auth_mode=optional for testing purposes.\n");
-			}
-			return SSL_CONNECTION_ERROR;
-		}
-	}
-
-	IOT_DEBUG(" ok\n    [ Protocol is %s ]\n    [ Ciphersuite is %s ]\n", mbedtls_ssl_get_version(&(tlsDataParams->ssl)),
-		  mbedtls_ssl_get_ciphersuite(&(tlsDataParams->ssl)));
-	if((ret = mbedtls_ssl_get_record_expansion(&(tlsDataParams->ssl))) >= 0) {
-		IOT_DEBUG("    [ Record expansion is %d ]\n", ret);
-	} else {
-		IOT_DEBUG("    [ Record expansion is unknown (compression) ]\n");
-	}
-
-	IOT_DEBUG("  . Verifying peer X.509 certificate...");
-
-	if(pNetwork->tlsConnectParams.ServerVerificationFlag == true) {
-		if((tlsDataParams->flags = mbedtls_ssl_get_verify_result(&(tlsDataParams->ssl))) != 0) {
-			IOT_ERROR(" failed\n");
-			mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", tlsDataParams->flags);
-			IOT_ERROR("%s\n", vrfy_buf);
-			ret = SSL_CONNECTION_ERROR;
-		} else {
-			IOT_DEBUG(" ok\n");
-			ret = SUCCESS;
-		}
-	} else {
-		IOT_DEBUG(" Server Verification skipped\n");
-		ret = SUCCESS;
-	}
-
-#ifdef IOT_DEBUG
-	if (mbedtls_ssl_get_peer_cert(&(tlsDataParams->ssl)) != NULL) {
-		IOT_DEBUG("  . Peer certificate information    ...\n");
-		mbedtls_x509_crt_info((char *) buf, sizeof(buf) - 1, "      ", mbedtls_ssl_get_peer_cert(&(tlsDataParams->ssl)));
-		IOT_DEBUG("%s\n", buf);
-	}
 #endif
+	IOT_DEBUG(" ok\n");
 
-	mbedtls_ssl_conf_read_timeout(&(tlsDataParams->conf), IOT_SSL_READ_TIMEOUT);
-
-	return (IoT_Error_t) ret;
+	return _iot_tls_handshake(pNetwork);
 }
 
 IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len, Timer *timer, size_t *written_len) {
 	size_t written_so_far;
 	bool isErrorFlag = false;
 	int frags, ret;
+	IoT_Error_t waitRc;
 	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
 
 	for(written_so_far = 0, frags = 0;
@@ -278,6 +683,16 @@ IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len, Ti
 				isErrorFlag = true;
 				break;
 			}
+			/* Sleep until the socket can take more instead of retrying right away. A packet that
+			 * was started has to be finished, so writes wait even in non-blocking mode */
+			waitRc = _iot_tls_wait_for_socket(tlsDataParams, ret, timer);
+			if(NETWORK_SSL_UNKNOWN_ERROR == waitRc) {
+				isErrorFlag = true;
+				break;
+			} else if(SUCCESS != waitRc) {
+				ret = 0;
+				break;
+			}
 		}
 		if(isErrorFlag) {
 			break;
@@ -295,10 +710,55 @@ IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len, Ti
 	return SUCCESS;
 }
 
+IoT_Error_t iot_tls_writev(Network *pNetwork, const NetworkIoVec *pIoVec, size_t ioVecCount, Timer *timer,
+						   size_t *written_len) {
+	unsigned char coalesceBuf[IOT_SSL_WRITEV_COALESCE_LEN];
+	size_t coalescedLen = 0, offset, copyLen, chunkWritten, i;
+	IoT_Error_t rc = SUCCESS;
+
+	*written_len = 0;
+
+	for(i = 0; i < ioVecCount && SUCCESS == rc; i++) {
+		offset = 0;
+
+		/* A short buffer, such as the MQTT fixed header and topic, would go out as a TLS record of its own.
+		 * Join it with the start of the next buffer so they share one record. */
+		if(0 < coalescedLen || pIoVec[i].len < sizeof(coalesceBuf)) {
+			copyLen = sizeof(coalesceBuf) - coalescedLen;
+			if(copyLen > pIoVec[i].len) {
+				copyLen = pIoVec[i].len;
+			}
+			memcpy(coalesceBuf + coalescedLen, pIoVec[i].pBuffer, copyLen);
+			coalescedLen += copyLen;
+			offset = copyLen;
+
+			if(coalescedLen < sizeof(coalesceBuf) && i + 1 < ioVecCount) {
+				continue;
+			}
+
+			rc = iot_tls_write(pNetwork, coalesceBuf, coalescedLen, timer, &chunkWritten);
+			*written_len += chunkWritten;
+			coalescedLen = 0;
+		}
+
+		/* The rest of the buffer is encrypted into TLS records straight from the caller's memory */
+		if(SUCCESS == rc && offset < pIoVec[i].len) {
+			rc = iot_tls_write(pNetwork, (unsigned char *) pIoVec[i].pBuffer + offset, pIoVec[i].len - offset, timer,
+							   &chunkWritten);
+			*written_len += chunkWritten;
+		}
+	}
+
+	return rc;
+}
+
 IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len, Timer *timer, size_t *read_len) {
 	mbedtls_ssl_context *ssl = &(pNetwork->tlsDataParams.ssl);
 	size_t rxLen = 0;
-	int ret;
+	int ret = 0;
+#ifdef _ENABLE_NONBLOCKING_TLS_
+	IoT_Error_t waitRc;
+#endif
 
 	while (len > 0) {
 		// This read will timeout after IOT_SSL_READ_TIMEOUT if there's no data to be read
@@ -307,8 +767,21 @@ IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len, Tim
 			rxLen += ret;
 			pMsg += ret;
 			len -= ret;
+			// Hand back what has been decrypted so far instead of waiting for the next record,
+			// the MQTT layer frames packets out of whatever is returned
+			if (0 == mbedtls_ssl_get_bytes_avail(ssl)) {
+				break;
+			}
 		} else if (ret == 0 || (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_TIMEOUT)) {
 			return NETWORK_SSL_READ_ERROR;
+#ifdef _ENABLE_NONBLOCKING_TLS_
+		} else if (SUCCESS != (waitRc = _iot_tls_wait_for_socket(&(pNetwork->tlsDataParams), ret, timer))) {
+			// Sleeps in poll for what is left of the timer, an expired timer makes this a plain non-blocking read
+			if (NETWORK_SSL_UNKNOWN_ERROR == waitRc) {
+				return NETWORK_SSL_READ_ERROR;
+			}
+			break;
+#endif
 		}
 
 		// Evaluate timeout after the read to make sure read is done at least once
@@ -317,24 +790,33 @@ IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len, Tim
 		}
 	}
 
-	if (len == 0) {
+	if (rxLen > 0) {
 		*read_len = rxLen;
 		return SUCCESS;
 	}
 
-	if (rxLen == 0) {
-		return NETWORK_SSL_NOTHING_TO_READ;
-	} else {
-		return NETWORK_SSL_READ_TIMEOUT_ERROR;
+#ifdef _ENABLE_NONBLOCKING_TLS_
+	// A pending renegotiation can make TLS wait for the socket to take data before reading on
+	if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+		return NETWORK_SSL_WANT_WRITE;
 	}
+	return NETWORK_SSL_WANT_READ;
+#else
+	return NETWORK_SSL_NOTHING_TO_READ;
+#endif
 }
 
 IoT_Error_t iot_tls_disconnect(Network *pNetwork) {
 	mbedtls_ssl_context *ssl = &(pNetwork->tlsDataParams.ssl);
+	Timer timer;
 	int ret = 0;
+
+	init_timer(&timer);
+	countdown_ms(&timer, pNetwork->tlsConnectParams.timeout_ms);
 	do {
 		ret = mbedtls_ssl_close_notify(ssl);
-	} while(ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+	} while(ret == MBEDTLS_ERR_SSL_WANT_WRITE &&
+			SUCCESS == _iot_tls_wait_for_socket(&(pNetwork->tlsDataParams), ret, &timer));
 
 	/* All other negative return values indicate connection needs to be reset.
 	 * No further action required since this is disconnect call */
@@ -342,18 +824,48 @@ IoT_Error_t iot_tls_disconnect(Network *pNetwork) {
 	return SUCCESS;
 }
 
+IoT_Error_t iot_tls_get_socket(Network *pNetwork, int *pSocket) {
+	if(NULL == pNetwork || NULL == pSocket) {
+		return NULL_VALUE_ERROR;
+	}
+
+	/* mbedtls_net_init and mbedtls_net_free leave -1 here while there is no connection */
+	*pSocket = pNetwork->tlsDataParams.server_fd.fd;
+
+	return SUCCESS;
+}
+
+IoT_Error_t iot_tls_release(Network *pNetwork) {
+	if(NULL == pNetwork) {
+		return NULL_VALUE_ERROR;
+	}
+
+	_iot_tls_forget_session(&(pNetwork->tlsDataParams));
+
+	if(pNetwork->tlsDataParams.isRngSeeded) {
+		mbedtls_ctr_drbg_free(&(pNetwork->tlsDataParams.ctr_drbg));
+		mbedtls_entropy_free(&(pNetwork->tlsDataParams.entropy));
+		pNetwork->tlsDataParams.isRngSeeded = false;
+	}
+
+	mbedtls_pk_free(&(pNetwork->tlsDataParams.deviceKey));
+	mbedtls_pk_init(&(pNetwork->tlsDataParams.deviceKey));
+	pNetwork->tlsDataParams.isDeviceKeyParsed = false;
+
+	return SUCCESS;
+}
+
 IoT_Error_t iot_tls_destroy(Network *pNetwork) {
 	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
 
+	/* savedSession, the seeded generator and the parsed key outlive the connection for the reconnect,
+	 * iot_tls_release frees them. The shared certificates stay in the store */
 	mbedtls_net_free(&(tlsDataParams->server_fd));
+	tlsDataParams->isHandshakeInProgress = false;
 
-	mbedtls_x509_crt_free(&(tlsDataParams->clicert));
-	mbedtls_x509_crt_free(&(tlsDataParams->cacert));
-	mbedtls_pk_free(&(tlsDataParams->pkey));
 	mbedtls_ssl_free(&(tlsDataParams->ssl));
 	mbedtls_ssl_config_free(&(tlsDataParams->conf));
-	mbedtls_ctr_drbg_free(&(tlsDataParams->ctr_drbg));
-	mbedtls_entropy_free(&(tlsDataParams->entropy));
+	_iot_tls_release_credentials(tlsDataParams);
 
 	return SUCCESS;
 }
@@ -15,6 +15,8 @@
 
 #ifndef IOTSDKC_NETWORK_MBEDTLS_PLATFORM_H_H
 
+#include <sys/stat.h>
+
 #include "mbedtls/config.h"
 
 #include "mbedtls/platform.h"
@@ -32,6 +34,13 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Parsed root CA or device certificate
+ *
+ * Entries of the process-wide credential store, shared by all connections that use the same file.
+ */
+typedef struct _TLSCredential TLSCredential;
+
 /**
  * @brief TLS Connection Parameters
  *
@@ -44,10 +53,19 @@ typedef struct _TLSDataParams {
 	mbedtls_ssl_context ssl;
 	mbedtls_ssl_config conf;
 	uint32_t flags;
-	mbedtls_x509_crt cacert;
-	mbedtls_x509_crt clicert;
-	mbedtls_pk_context pkey;
+	TLSCredential *pRootCA;
+	TLSCredential *pDeviceCert;
+	mbedtls_pk_context deviceKey;
+	struct stat deviceKeyStat;
+	bool isDeviceKeyParsed;
+	bool isRngSeeded;
 	mbedtls_net_context server_fd;
+	bool isHandshakeInProgress;
+	Timer handshakeTimer;
+	bool isFullHandshake;
+	uint64_t handshakeCpuTimeUs;
+	mbedtls_ssl_session savedSession;
+	bool isSessionSaved;
 }TLSDataParams;
 
 #define IOTSDKC_NETWORK_MBEDTLS_PLATFORM_H_H
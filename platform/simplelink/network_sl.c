@@ -44,9 +44,12 @@ IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation,
     pNetwork->connect = iot_tls_connect;
     pNetwork->read = iot_tls_read;
     pNetwork->write = iot_tls_write;
+    pNetwork->writev = iot_tls_writev;
     pNetwork->disconnect = iot_tls_disconnect;
     pNetwork->isConnected = iot_tls_is_connected;
     pNetwork->destroy = iot_tls_destroy;
+    pNetwork->getSocket = iot_tls_get_socket;
+    pNetwork->release = NULL;    // nothing is kept between connections
 
     pNetwork->tlsDataParams.ssock = NULL;
 
@@ -221,6 +224,33 @@ IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len,
     return NETWORK_SSL_WRITE_ERROR;
 }
 
+IoT_Error_t iot_tls_writev(Network *pNetwork, const NetworkIoVec *pIoVec,
+            size_t ioVecCount, Timer *timer, size_t *numbytes)
+{
+    IoT_Error_t rc = SUCCESS;
+    size_t i, sent, bytes;
+
+    if (pIoVec == NULL || numbytes == NULL) {
+        return NULL_VALUE_ERROR;
+    }
+
+    *numbytes = 0;
+
+    // The socket is secured by the network processor, each buffer is sent as is
+    for (i = 0; i < ioVecCount && rc == SUCCESS; i++) {
+        sent = 0;
+        while (sent < pIoVec[i].len && rc == SUCCESS) {
+            bytes = 0;
+            rc = iot_tls_write(pNetwork, (unsigned char *)pIoVec[i].pBuffer + sent,
+                    pIoVec[i].len - sent, timer, &bytes);
+            sent += bytes;
+        }
+        *numbytes += sent;
+    }
+
+    return rc;
+}
+
 IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len,
         Timer *timer, size_t *numbytes)
 {
@@ -273,6 +303,17 @@ IoT_Error_t iot_tls_disconnect(Network *pNetwork)
     return SUCCESS;
 }
 
+IoT_Error_t iot_tls_get_socket(Network *pNetwork, int *pSocket)
+{
+    if (pNetwork == NULL || pSocket == NULL) {
+        return (NULL_VALUE_ERROR);
+    }
+
+    *pSocket = (pNetwork->tlsDataParams.ssock == NULL) ? -1 : pNetwork->tlsDataParams.ssock;
+
+    return SUCCESS;
+}
+
 IoT_Error_t iot_tls_destroy(Network *pNetwork)
 {
     if (pNetwork == NULL) {
@@ -282,9 +323,12 @@ IoT_Error_t iot_tls_destroy(Network *pNetwork)
     pNetwork->connect = NULL;
     pNetwork->read = NULL;
     pNetwork->write = NULL;
+    pNetwork->writev = NULL;
     pNetwork->disconnect = NULL;
     pNetwork->isConnected = NULL;
     pNetwork->destroy = NULL;
+    pNetwork->getSocket = NULL;
+    pNetwork->release = NULL;
 
     return SUCCESS;
 }
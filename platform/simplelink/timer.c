@@ -79,3 +79,12 @@ void init_timer(Timer *timer)
     timer->start_ms = 0;
     timer->length_ms = 0;
 }
+
+void begin_timer_batch(void)
+{
+    // The RTC is read directly, there is nothing to cache
+}
+
+void end_timer_batch(void)
+{
+}
@@ -28,8 +28,9 @@ extern "C" {
 
 #include "aws_iot_json_utils.h"
 
-#include <stdio.h>
+#include <float.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef __cplusplus
@@ -42,6 +43,201 @@ extern "C" {
 
 #include "aws_iot_log.h"
 
+/* Longest number text handed to strtod, longer tokens are rejected */
+#define JSON_PRIMITIVE_BUF_LEN 64
+
+/* Largest power of ten a double holds exactly */
+#define JSON_MAX_EXACT_POWER_OF_TEN 22
+
+/* Largest integer every smaller integer of which a double holds exactly, 2^53 */
+#define JSON_MAX_EXACT_DOUBLE_MANTISSA 9007199254740992ull
+
+/* Significant digits that fit in the 64 bit mantissa accumulator */
+#define JSON_MAX_MANTISSA_DIGITS 19
+
+static const double powersOfTen[JSON_MAX_EXACT_POWER_OF_TEN + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* strtod needs a string, so numbers it parses are copied out of the document, which need not be
+ * null terminated */
+static bool copyPrimitiveToken(char *pBuf, const char *jsonString, jsmntok_t *token) {
+	size_t len = (size_t) (token->end - token->start);
+
+	if(len >= JSON_PRIMITIVE_BUF_LEN) {
+		return false;
+	}
+	memcpy(pBuf, jsonString + token->start, len);
+	pBuf[len] = '\0';
+	return true;
+}
+
+static bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+/* Every character up to pEnd has to be a decimal digit, there has to be one at least and the value may not exceed max */
+static bool parseDecimalDigits(const char *pStart, const char *pEnd, uint32_t max, uint32_t *pValue) {
+	uint32_t value = 0;
+	uint32_t digit;
+
+	if(pStart >= pEnd) {
+		return false;
+	}
+
+	for(; pStart < pEnd; pStart++) {
+		if(!isDigit(*pStart)) {
+			return false;
+		}
+		digit = (uint32_t) (*pStart - '0');
+		if(value > (max - digit) / 10) {
+			return false;
+		}
+		value = value * 10 + digit;
+	}
+
+	*pValue = value;
+	return true;
+}
+
+static bool parseUnsignedToken(const char *jsonString, jsmntok_t *token, uint32_t max, uint32_t *pValue) {
+	return parseDecimalDigits(jsonString + token->start, jsonString + token->end, max, pValue);
+}
+
+/* min is given as a magnitude, INT32_MIN does not have a positive int32_t counterpart */
+static bool parseSignedToken(const char *jsonString, jsmntok_t *token, uint32_t minMagnitude, uint32_t max,
+							 int32_t *pValue) {
+	const char *pStart = jsonString + token->start;
+	bool isNegative = (token->end > token->start) && ('-' == *pStart);
+	uint32_t magnitude;
+
+	if(isNegative) {
+		pStart++;
+	}
+	if(!parseDecimalDigits(pStart, jsonString + token->end, isNegative ? minMagnitude : max, &magnitude)) {
+		return false;
+	}
+
+	if(isNegative && 0 != magnitude) {
+		*pValue = -(int32_t) (magnitude - 1) - 1;
+	} else {
+		*pValue = (int32_t) magnitude;
+	}
+	return true;
+}
+
+/**
+ * Numbers with at most 19 significant digits, a mantissa below 2^53 and a power of ten a double holds exactly are
+ * correctly rounded by one multiplication or division. The rest, which shadow documents rarely hold, are validated
+ * here and left to strtod.
+ */
+static bool parseDoubleToken(const char *jsonString, jsmntok_t *token, double *pValue) {
+	const char *p = jsonString + token->start;
+	const char *pEnd = jsonString + token->end;
+	char numBuf[JSON_PRIMITIVE_BUF_LEN];
+	char *pParsedEnd;
+	uint64_t mantissa = 0;
+	uint32_t mantissaDigits = 0;
+	uint32_t integerDigits = 0;
+	uint32_t fractionDigits = 0;
+	int32_t exponent = 0;
+	int32_t explicitExponent = 0;
+	bool isNegative = false;
+	bool isExponentNegative = false;
+	bool isExact = true;
+	double value;
+
+	if(p < pEnd && '-' == *p) {
+		isNegative = true;
+		p++;
+	}
+
+	for(; p < pEnd && isDigit(*p); p++, integerDigits++) {
+		if(0 == mantissa && '0' == *p) {
+			continue;
+		}
+		if(mantissaDigits < JSON_MAX_MANTISSA_DIGITS) {
+			mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+			mantissaDigits++;
+		} else {
+			/* Left to strtod, which sees every digit */
+			isExact = false;
+		}
+	}
+	if(0 == integerDigits) {
+		return false;
+	}
+
+	if(p < pEnd && '.' == *p) {
+		for(p++; p < pEnd && isDigit(*p); p++, fractionDigits++) {
+			if(0 == mantissa && '0' == *p) {
+				exponent--;
+				continue;
+			}
+			if(mantissaDigits < JSON_MAX_MANTISSA_DIGITS) {
+				mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+				mantissaDigits++;
+				exponent--;
+			} else {
+				isExact = false;
+			}
+		}
+		if(0 == fractionDigits) {
+			return false;
+		}
+	}
+
+	if(p < pEnd && ('e' == *p || 'E' == *p)) {
+		p++;
+		if(p < pEnd && ('-' == *p || '+' == *p)) {
+			isExponentNegative = ('-' == *p);
+			p++;
+		}
+		if(p >= pEnd) {
+			return false;
+		}
+		for(; p < pEnd && isDigit(*p); p++) {
+			if(explicitExponent < 100000) {
+				explicitExponent = explicitExponent * 10 + (*p - '0');
+			}
+		}
+		exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+	}
+
+	if(p != pEnd) {
+		return false;
+	}
+
+	if(0 == mantissa) {
+		*pValue = isNegative ? -0.0 : 0.0;
+		return true;
+	}
+
+	if(isExact && mantissa <= JSON_MAX_EXACT_DOUBLE_MANTISSA && exponent >= -JSON_MAX_EXACT_POWER_OF_TEN
+	   && exponent <= JSON_MAX_EXACT_POWER_OF_TEN) {
+		value = (double) mantissa;
+		if(exponent < 0) {
+			value /= powersOfTen[-exponent];
+		} else {
+			value *= powersOfTen[exponent];
+		}
+		*pValue = isNegative ? -value : value;
+		return true;
+	}
+
+	if(!copyPrimitiveToken(numBuf, jsonString, token)) {
+		return false;
+	}
+	value = strtod(numBuf, &pParsedEnd);
+	if(pParsedEnd != numBuf + (token->end - token->start) || value > DBL_MAX || value < -DBL_MAX) {
+		return false;
+	}
+
+	*pValue = value;
+	return true;
+}
+
 int8_t jsoneq(const char *json, jsmntok_t *tok, const char *s) {
 	if(tok->type == JSMN_STRING) {
 		if((int) strlen(s) == tok->end - tok->start) {
@@ -59,7 +255,7 @@ IoT_Error_t parseUnsignedInteger32Value(uint32_t *i, const char *jsonString, jsm
 		return JSON_PARSE_ERROR;
 	}
 
-	if(('-' == (char) (jsonString[token->start])) || (1 != sscanf(jsonString + token->start, "%" SCNu32, i))) {
+	if(!parseUnsignedToken(jsonString, token, UINT32_MAX, i)) {
 		IOT_WARN("Token was not an unsigned integer.");
 		return JSON_PARSE_ERROR;
 	}
@@ -68,30 +264,36 @@ IoT_Error_t parseUnsignedInteger32Value(uint32_t *i, const char *jsonString, jsm
 }
 
 IoT_Error_t parseUnsignedInteger16Value(uint16_t *i, const char *jsonString, jsmntok_t *token) {
+	uint32_t value;
+
 	if(token->type != JSMN_PRIMITIVE) {
 		IOT_WARN("Token was not an integer");
 		return JSON_PARSE_ERROR;
 	}
 
-	if(('-' == (char) (jsonString[token->start])) || (1 != sscanf(jsonString + token->start, "%" SCNu16, i))) {
+	if(!parseUnsignedToken(jsonString, token, UINT16_MAX, &value)) {
 		IOT_WARN("Token was not an unsigned integer.");
 		return JSON_PARSE_ERROR;
 	}
 
+	*i = (uint16_t) value;
 	return SUCCESS;
 }
 
 IoT_Error_t parseUnsignedInteger8Value(uint8_t *i, const char *jsonString, jsmntok_t *token) {
+	uint32_t value;
+
 	if(token->type != JSMN_PRIMITIVE) {
 		IOT_WARN("Token was not an integer");
 		return JSON_PARSE_ERROR;
 	}
 
-	if(('-' == (char) (jsonString[token->start])) || (1 != sscanf(jsonString + token->start, "%" SCNu8, i))) {
+	if(!parseUnsignedToken(jsonString, token, UINT8_MAX, &value)) {
 		IOT_WARN("Token was not an unsigned integer.");
 		return JSON_PARSE_ERROR;
 	}
 
+	*i = (uint8_t) value;
 	return SUCCESS;
 }
 
@@ -101,7 +303,7 @@ IoT_Error_t parseInteger32Value(int32_t *i, const char *jsonString, jsmntok_t *t
 		return JSON_PARSE_ERROR;
 	}
 
-	if(1 != sscanf(jsonString + token->start, "%" SCNi32, i)) {
+	if(!parseSignedToken(jsonString, token, (uint32_t) INT32_MAX + 1, INT32_MAX, i)) {
 		IOT_WARN("Token was not an integer.");
 		return JSON_PARSE_ERROR;
 	}
@@ -110,44 +312,53 @@ IoT_Error_t parseInteger32Value(int32_t *i, const char *jsonString, jsmntok_t *t
 }
 
 IoT_Error_t parseInteger16Value(int16_t *i, const char *jsonString, jsmntok_t *token) {
+	int32_t value;
+
 	if(token->type != JSMN_PRIMITIVE) {
 		IOT_WARN("Token was not an integer");
 		return JSON_PARSE_ERROR;
 	}
 
-	if(1 != sscanf(jsonString + token->start, "%" SCNi16, i)) {
+	if(!parseSignedToken(jsonString, token, (uint32_t) INT16_MAX + 1, INT16_MAX, &value)) {
 		IOT_WARN("Token was not an integer.");
 		return JSON_PARSE_ERROR;
 	}
 
+	*i = (int16_t) value;
 	return SUCCESS;
 }
 
 IoT_Error_t parseInteger8Value(int8_t *i, const char *jsonString, jsmntok_t *token) {
+	int32_t value;
+
 	if(token->type != JSMN_PRIMITIVE) {
 		IOT_WARN("Token was not an integer");
 		return JSON_PARSE_ERROR;
 	}
 
-	if(1 != sscanf(jsonString + token->start, "%" SCNi8, i)) {
+	if(!parseSignedToken(jsonString, token, (uint32_t) INT8_MAX + 1, INT8_MAX, &value)) {
 		IOT_WARN("Token was not an integer.");
 		return JSON_PARSE_ERROR;
 	}
 
+	*i = (int8_t) value;
 	return SUCCESS;
 }
 
 IoT_Error_t parseFloatValue(float *f, const char *jsonString, jsmntok_t *token) {
+	double value;
+
 	if(token->type != JSMN_PRIMITIVE) {
 		IOT_WARN("Token was not a float.");
 		return JSON_PARSE_ERROR;
 	}
 
-	if(1 != sscanf(jsonString + token->start, "%f", f)) {
+	if(!parseDoubleToken(jsonString, token, &value) || value > FLT_MAX || value < -FLT_MAX) {
 		IOT_WARN("Token was not a float.");
 		return JSON_PARSE_ERROR;
 	}
 
+	*f = (float) value;
 	return SUCCESS;
 }
 
@@ -157,7 +368,7 @@ IoT_Error_t parseDoubleValue(double *d, const char *jsonString, jsmntok_t *token
 		return JSON_PARSE_ERROR;
 	}
 
-	if(1 != sscanf(jsonString + token->start, "%lf", d)) {
+	if(!parseDoubleToken(jsonString, token, d)) {
 		IOT_WARN("Token was not a double.");
 		return JSON_PARSE_ERROR;
 	}
@@ -41,6 +41,7 @@ extern "C" {
 
 #include "aws_iot_log.h"
 #include "aws_iot_mqtt_client_interface.h"
+#include "aws_iot_mqtt_client_common_internal.h"
 
 #ifdef _ENABLE_THREAD_SUPPORT_
 #include "threads_interface.h"
@@ -170,13 +171,39 @@ IoT_Error_t aws_iot_mqtt_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *p
 		pClient->clientData.messageHandlers[i].pApplicationHandler = NULL;
 		pClient->clientData.messageHandlers[i].pApplicationHandlerData = NULL;
 		pClient->clientData.messageHandlers[i].qos = QOS0;
+		pClient->clientData.messageHandlers[i].topicTrieNode = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+		pClient->clientData.messageHandlers[i].topicTrieNextHandler = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+		pClient->clientData.messageHandlers[i].isPayloadStreamingEnabled = false;
 	}
+	aws_iot_mqtt_internal_topic_trie_init(pClient);
+
+	aws_iot_timer_wheel_init(&(pClient->timerWheel));
+	aws_iot_timer_wheel_init_entry(&(pClient->pingTimer), NULL, NULL);
+	aws_iot_timer_wheel_init_entry(&(pClient->reconnectDelayTimer), NULL, NULL);
+
+	for(i = 0; i < AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES; ++i) {
+		pClient->clientData.inflightPublishes[i].packetId = 0;
+		pClient->clientData.inflightPublishes[i].pCompleteHandler = NULL;
+		pClient->clientData.inflightPublishes[i].pCompleteHandlerData = NULL;
+		pClient->clientData.inflightPublishes[i].isExpired = false;
+		aws_iot_timer_wheel_init_entry(&(pClient->clientData.inflightPublishes[i].ackTimer),
+									   aws_iot_mqtt_internal_inflight_publish_expired, pClient);
+	}
+	pClient->clientData.inflightPublishCount = 0;
+	pClient->clientData.expiredInflightCount = 0;
 
 	pClient->clientData.packetTimeoutMs = pInitParams->mqttPacketTimeout_ms;
 	pClient->clientData.commandTimeoutMs = pInitParams->mqttCommandTimeout_ms;
+#ifndef _ENABLE_DYNAMIC_BUFFERS_
 	pClient->clientData.writeBufSize = AWS_IOT_MQTT_TX_BUF_LEN;
 	pClient->clientData.readBufSize = AWS_IOT_MQTT_RX_BUF_LEN;
+#endif
+	pClient->clientData.readBufDataLen = 0;
+	pClient->clientData.readBufPacketLen = 0;
 	pClient->clientData.counterNetworkDisconnected = 0;
+	pClient->clientData.counterReconnected = 0;
+	pClient->clientData.lastReconnectLatencyMs = 0;
+	pClient->clientData.maxReconnectLatencyMs = 0;
 	pClient->clientData.disconnectHandler = pInitParams->disconnectHandler;
 	pClient->clientData.disconnectHandlerData = pInitParams->disconnectHandlerData;
 	pClient->clientData.nextPacketId = 1;
@@ -201,33 +228,155 @@ IoT_Error_t aws_iot_mqtt_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *p
 	if(SUCCESS != rc) {
 		IOT_FUNC_EXIT_RC(rc);
 	}
+	rc = aws_iot_thread_mutex_init(&(pClient->clientData.timer_wheel_mutex));
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+#endif
+
+	/* Allocated last, so only the network initialization below can fail while the buffers are held */
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	rc = aws_iot_mqtt_internal_init_buffers(pClient, pInitParams);
+	if(SUCCESS != rc) {
+		pClient->clientStatus.clientState = CLIENT_STATE_INVALID;
+		IOT_FUNC_EXIT_RC(rc);
+	}
 #endif
 
 	pClient->clientStatus.isPingOutstanding = 0;
 	pClient->clientStatus.isAutoReconnectEnabled = pInitParams->enableAutoReconnect;
+	pClient->clientStatus.isNetworkConnectInProgress = false;
+	pClient->clientStatus.isReconnectLatencyTimed = false;
+
+	/* Network implementations that do not keep handshake statistics leave them at zero */
+	memset(&(pClient->networkStack.handshakeStats), 0, sizeof(TLSHandshakeStats));
+	pClient->networkStack.release = NULL;
+	pClient->pShadowClient = NULL;
 
 	rc = iot_tls_init(&(pClient->networkStack), pInitParams->pRootCALocation, pInitParams->pDeviceCertLocation,
 					  pInitParams->pDevicePrivateKeyLocation, pInitParams->pHostURL, pInitParams->port,
 					  pInitParams->tlsHandshakeTimeout_ms, pInitParams->isSSLHostnameVerify);
 
 	if(SUCCESS != rc) {
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+		aws_iot_mqtt_internal_free_buffers(pClient);
+#endif
 		pClient->clientStatus.clientState = CLIENT_STATE_INVALID;
 		IOT_FUNC_EXIT_RC(rc);
 	}
 
-	init_timer(&(pClient->pingTimer));
-	init_timer(&(pClient->reconnectDelayTimer));
+	init_timer(&(pClient->reconnectLatencyTimer));
 
 	pClient->clientStatus.clientState = CLIENT_STATE_INITIALIZED;
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
+IoT_Error_t aws_iot_mqtt_free(AWS_IoT_Client *pClient) {
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(aws_iot_mqtt_is_client_connected(pClient)) {
+		IOT_FUNC_EXIT_RC(NETWORK_ALREADY_CONNECTED_ERROR);
+	}
+
+	if(NULL != pClient->networkStack.release) {
+		pClient->networkStack.release(&(pClient->networkStack));
+	}
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	aws_iot_mqtt_internal_free_buffers(pClient);
+#endif
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_destroy(&(pClient->clientData.state_change_mutex));
+	aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_read_mutex));
+	aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_write_mutex));
+	aws_iot_thread_mutex_destroy(&(pClient->clientData.timer_wheel_mutex));
+#endif
+
+	pClient->clientStatus.clientState = CLIENT_STATE_INVALID;
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
 uint16_t aws_iot_mqtt_get_next_packet_id(AWS_IoT_Client *pClient) {
 	return pClient->clientData.nextPacketId = (uint16_t) ((MAX_PACKET_ID == pClient->clientData.nextPacketId) ? 1 : (
 			pClient->clientData.nextPacketId + 1));
 }
 
+static void _aws_iot_mqtt_timer_wheel_lock(AWS_IoT_Client *pClient) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	/* Always blocks, the wheel is only held for a few operations on it */
+	aws_iot_thread_mutex_lock(&(pClient->clientData.timer_wheel_mutex));
+#else
+	IOT_UNUSED(pClient);
+#endif
+}
+
+static void _aws_iot_mqtt_timer_wheel_unlock(AWS_IoT_Client *pClient) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_unlock(&(pClient->clientData.timer_wheel_mutex));
+#else
+	IOT_UNUSED(pClient);
+#endif
+}
+
+void aws_iot_mqtt_timer_start(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry, uint32_t timeout_ms) {
+	_aws_iot_mqtt_timer_wheel_lock(pClient);
+	aws_iot_timer_wheel_schedule(&(pClient->timerWheel), pEntry, timeout_ms);
+	_aws_iot_mqtt_timer_wheel_unlock(pClient);
+}
+
+void aws_iot_mqtt_timer_stop(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry) {
+	_aws_iot_mqtt_timer_wheel_lock(pClient);
+	aws_iot_timer_wheel_cancel(&(pClient->timerWheel), pEntry);
+	_aws_iot_mqtt_timer_wheel_unlock(pClient);
+}
+
+bool aws_iot_mqtt_timer_has_expired(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry) {
+	bool expired;
+
+	_aws_iot_mqtt_timer_wheel_lock(pClient);
+	expired = aws_iot_timer_wheel_has_expired(&(pClient->timerWheel), pEntry);
+	_aws_iot_mqtt_timer_wheel_unlock(pClient);
+
+	return expired;
+}
+
+uint32_t aws_iot_mqtt_timer_left_ms(AWS_IoT_Client *pClient, IoT_Timer_Wheel_Entry *pEntry) {
+	uint32_t left;
+
+	_aws_iot_mqtt_timer_wheel_lock(pClient);
+	left = aws_iot_timer_wheel_left_ms(&(pClient->timerWheel), pEntry);
+	_aws_iot_mqtt_timer_wheel_unlock(pClient);
+
+	return left;
+}
+
+uint32_t aws_iot_mqtt_run_timers(AWS_IoT_Client *pClient) {
+	uint32_t expired;
+
+	_aws_iot_mqtt_timer_wheel_lock(pClient);
+	expired = aws_iot_timer_wheel_run(&(pClient->timerWheel));
+	_aws_iot_mqtt_timer_wheel_unlock(pClient);
+
+	return expired;
+}
+
+uint32_t aws_iot_mqtt_get_next_timer_ms(AWS_IoT_Client *pClient) {
+	uint32_t timeout_ms;
+
+	_aws_iot_mqtt_timer_wheel_lock(pClient);
+	timeout_ms = aws_iot_timer_wheel_get_next_timeout_ms(&(pClient->timerWheel));
+	_aws_iot_mqtt_timer_wheel_unlock(pClient);
+
+	return timeout_ms;
+}
+
 bool aws_iot_mqtt_is_client_connected(AWS_IoT_Client *pClient) {
 	bool isConnected;
 
@@ -304,6 +453,21 @@ void aws_iot_mqtt_reset_network_disconnected_count(AWS_IoT_Client *pClient) {
 	pClient->clientData.counterNetworkDisconnected = 0;
 }
 
+IoT_Error_t aws_iot_mqtt_get_connection_stats(AWS_IoT_Client *pClient, IoT_Connection_Stats *pStats) {
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pStats) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	pStats->reconnectCount = pClient->clientData.counterReconnected;
+	pStats->lastReconnectLatencyMs = pClient->clientData.lastReconnectLatencyMs;
+	pStats->maxReconnectLatencyMs = pClient->clientData.maxReconnectLatencyMs;
+	pStats->handshake = pClient->networkStack.handshakeStats;
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
 #ifdef __cplusplus
 }
 #endif
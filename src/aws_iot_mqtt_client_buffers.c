@@ -0,0 +1,388 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_buffers.c
+ * @brief MQTT client read and write buffer management
+ *
+ * With _ENABLE_DYNAMIC_BUFFERS_ the buffers are allocated when the client is initialized,
+ * grow when a packet does not fit and return to their initial size afterwards. Unless the
+ * application provides its own allocation functions they come from a pool shared by all
+ * clients, which keeps released buffers in power of two size classes for reuse.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+
+#include <stdlib.h>
+
+/* Size classes of the shared pool go from 64 bytes up to 2^(6 + BUFFER_POOL_NUM_CLASSES - 1) bytes */
+#define BUFFER_POOL_MIN_CLASS_SHIFT 6
+#define BUFFER_POOL_NUM_CLASSES 20
+
+typedef struct _BufferPoolBlock {
+	struct _BufferPoolBlock *pNext;
+} BufferPoolBlock;
+
+static BufferPoolBlock *pBufferPoolFreeBlocks[BUFFER_POOL_NUM_CLASSES];
+static IoT_Buffer_Pool_Usage bufferPoolUsage;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+static IoT_Mutex_t bufferPoolMutex;
+static bool isBufferPoolMutexInitialized = false;
+#endif
+
+static void _aws_iot_mqtt_buffer_pool_lock(void) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_lock(&bufferPoolMutex);
+#endif
+}
+
+static void _aws_iot_mqtt_buffer_pool_unlock(void) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_unlock(&bufferPoolMutex);
+#endif
+}
+
+/* Returns BUFFER_POOL_NUM_CLASSES if the size is larger than the largest class */
+static uint32_t _aws_iot_mqtt_buffer_pool_class(size_t size) {
+	uint32_t sizeClass = 0;
+
+	while(sizeClass < BUFFER_POOL_NUM_CLASSES && ((size_t) 1 << (sizeClass + BUFFER_POOL_MIN_CLASS_SHIFT)) < size) {
+		sizeClass++;
+	}
+
+	return sizeClass;
+}
+
+static void *_aws_iot_mqtt_buffer_pool_allocate(size_t size, void *pAllocatorData) {
+	uint32_t sizeClass = _aws_iot_mqtt_buffer_pool_class(size);
+	size_t classSize;
+	BufferPoolBlock *pBlock;
+
+	IOT_UNUSED(pAllocatorData);
+
+	if(BUFFER_POOL_NUM_CLASSES <= sizeClass) {
+		return NULL;
+	}
+	classSize = (size_t) 1 << (sizeClass + BUFFER_POOL_MIN_CLASS_SHIFT);
+
+	_aws_iot_mqtt_buffer_pool_lock();
+	pBlock = pBufferPoolFreeBlocks[sizeClass];
+	if(NULL != pBlock) {
+		pBufferPoolFreeBlocks[sizeClass] = pBlock->pNext;
+	} else {
+		pBlock = (BufferPoolBlock *) malloc(classSize);
+		if(NULL != pBlock) {
+			bufferPoolUsage.bytesHeld += classSize;
+			if(bufferPoolUsage.bytesHeld > bufferPoolUsage.peakBytesHeld) {
+				bufferPoolUsage.peakBytesHeld = bufferPoolUsage.bytesHeld;
+			}
+		}
+	}
+	if(NULL != pBlock) {
+		bufferPoolUsage.bytesInUse += classSize;
+		if(bufferPoolUsage.bytesInUse > bufferPoolUsage.peakBytesInUse) {
+			bufferPoolUsage.peakBytesInUse = bufferPoolUsage.bytesInUse;
+		}
+	}
+	_aws_iot_mqtt_buffer_pool_unlock();
+
+	return pBlock;
+}
+
+static void _aws_iot_mqtt_buffer_pool_free(void *pBuffer, size_t size, void *pAllocatorData) {
+	uint32_t sizeClass = _aws_iot_mqtt_buffer_pool_class(size);
+	BufferPoolBlock *pBlock = (BufferPoolBlock *) pBuffer;
+
+	IOT_UNUSED(pAllocatorData);
+
+	_aws_iot_mqtt_buffer_pool_lock();
+	pBlock->pNext = pBufferPoolFreeBlocks[sizeClass];
+	pBufferPoolFreeBlocks[sizeClass] = pBlock;
+	bufferPoolUsage.bytesInUse -= (size_t) 1 << (sizeClass + BUFFER_POOL_MIN_CLASS_SHIFT);
+	_aws_iot_mqtt_buffer_pool_unlock();
+}
+
+void aws_iot_mqtt_get_buffer_pool_usage(IoT_Buffer_Pool_Usage *pUsage) {
+	if(NULL == pUsage) {
+		return;
+	}
+
+	_aws_iot_mqtt_buffer_pool_lock();
+	*pUsage = bufferPoolUsage;
+	_aws_iot_mqtt_buffer_pool_unlock();
+}
+
+void aws_iot_mqtt_buffer_pool_trim(void) {
+	uint32_t sizeClass;
+	BufferPoolBlock *pBlock;
+
+	_aws_iot_mqtt_buffer_pool_lock();
+	for(sizeClass = 0; sizeClass < BUFFER_POOL_NUM_CLASSES; sizeClass++) {
+		while(NULL != pBufferPoolFreeBlocks[sizeClass]) {
+			pBlock = pBufferPoolFreeBlocks[sizeClass];
+			pBufferPoolFreeBlocks[sizeClass] = pBlock->pNext;
+			free(pBlock);
+			bufferPoolUsage.bytesHeld -= (size_t) 1 << (sizeClass + BUFFER_POOL_MIN_CLASS_SHIFT);
+		}
+	}
+	_aws_iot_mqtt_buffer_pool_unlock();
+}
+
+/* Smallest size reached by doubling currentSize that holds minSize, limited to maxSize */
+static size_t _aws_iot_mqtt_buffer_grow_size(size_t currentSize, size_t minSize, size_t maxSize) {
+	size_t newSize = currentSize;
+
+	while(newSize < minSize && newSize < maxSize) {
+		newSize *= 2;
+	}
+
+	return (newSize > maxSize) ? maxSize : newSize;
+}
+
+/* Replaces a buffer with one of newSize bytes, keeping the first keepLen bytes */
+static IoT_Error_t _aws_iot_mqtt_buffer_replace(AWS_IoT_Client *pClient, unsigned char **ppBuf, size_t *pBufSize,
+												size_t *pPeakBufSize, size_t newSize, size_t keepLen) {
+	unsigned char *pNewBuf;
+
+	pNewBuf = (unsigned char *) pClient->clientData.pBufferAllocate(newSize, pClient->clientData.pBufferAllocatorData);
+	if(NULL == pNewBuf) {
+		return MQTT_BUFFER_ALLOCATION_ERROR;
+	}
+
+	if(NULL != *ppBuf) {
+		if(0 < keepLen) {
+			memcpy(pNewBuf, *ppBuf, keepLen);
+		}
+		pClient->clientData.pBufferFree(*ppBuf, *pBufSize, pClient->clientData.pBufferAllocatorData);
+	}
+
+	*ppBuf = pNewBuf;
+	*pBufSize = newSize;
+	if(newSize > *pPeakBufSize) {
+		*pPeakBufSize = newSize;
+	}
+
+	return SUCCESS;
+}
+
+/* A client initialized before still holds the buffers of that call. A client that never was can hold
+ * anything, so its buffers are only released if it was given a free function it could have got here */
+static bool _aws_iot_mqtt_holds_buffers(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams) {
+	if(CLIENT_STATE_INITIALIZED > pClient->clientStatus.clientState ||
+	   CLIENT_STATE_PENDING_RECONNECT < pClient->clientStatus.clientState) {
+		return false;
+	}
+
+	return _aws_iot_mqtt_buffer_pool_free == pClient->clientData.pBufferFree ||
+		   (NULL != pInitParams->pBufferFree && pInitParams->pBufferFree == pClient->clientData.pBufferFree);
+}
+
+/**
+ * @brief Allocate the initial read and write buffers of a client
+ *
+ * Buffers of an earlier initialization of the client are released first.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pInitParams Initialization parameters with the allocation functions
+ *
+ * @return An IoT Error Type defining successful/failed allocation
+ */
+IoT_Error_t aws_iot_mqtt_internal_init_buffers(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams) {
+	IoT_Error_t rc;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	/* Clients are expected to be initialized from one thread, the pool mutex is created by the first */
+	if(!isBufferPoolMutexInitialized) {
+		rc = aws_iot_thread_mutex_init(&bufferPoolMutex);
+		if(SUCCESS != rc) {
+			return rc;
+		}
+		isBufferPoolMutexInitialized = true;
+	}
+#endif
+
+	if(_aws_iot_mqtt_holds_buffers(pClient, pInitParams)) {
+		aws_iot_mqtt_internal_free_buffers(pClient);
+	}
+
+	if(NULL != pInitParams->pBufferAllocate && NULL != pInitParams->pBufferFree) {
+		pClient->clientData.pBufferAllocate = pInitParams->pBufferAllocate;
+		pClient->clientData.pBufferFree = pInitParams->pBufferFree;
+		pClient->clientData.pBufferAllocatorData = pInitParams->pBufferAllocatorData;
+	} else {
+		pClient->clientData.pBufferAllocate = _aws_iot_mqtt_buffer_pool_allocate;
+		pClient->clientData.pBufferFree = _aws_iot_mqtt_buffer_pool_free;
+		pClient->clientData.pBufferAllocatorData = NULL;
+	}
+
+	pClient->clientData.writeBuf = NULL;
+	pClient->clientData.readBuf = NULL;
+	pClient->clientData.writeBufSize = 0;
+	pClient->clientData.readBufSize = 0;
+	pClient->clientData.peakWriteBufSize = 0;
+	pClient->clientData.peakReadBufSize = 0;
+
+	rc = _aws_iot_mqtt_buffer_replace(pClient, &(pClient->clientData.writeBuf), &(pClient->clientData.writeBufSize),
+									  &(pClient->clientData.peakWriteBufSize), AWS_IOT_MQTT_TX_BUF_LEN, 0);
+	if(SUCCESS != rc) {
+		return rc;
+	}
+
+	rc = _aws_iot_mqtt_buffer_replace(pClient, &(pClient->clientData.readBuf), &(pClient->clientData.readBufSize),
+									  &(pClient->clientData.peakReadBufSize), AWS_IOT_MQTT_RX_BUF_LEN, 0);
+	if(SUCCESS != rc) {
+		aws_iot_mqtt_internal_free_buffers(pClient);
+	}
+
+	return rc;
+}
+
+/**
+ * @brief Release the read and write buffers of a client
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_free_buffers(AWS_IoT_Client *pClient) {
+	if(NULL != pClient->clientData.writeBuf) {
+		pClient->clientData.pBufferFree(pClient->clientData.writeBuf, pClient->clientData.writeBufSize,
+										pClient->clientData.pBufferAllocatorData);
+		pClient->clientData.writeBuf = NULL;
+		pClient->clientData.writeBufSize = 0;
+	}
+
+	if(NULL != pClient->clientData.readBuf) {
+		pClient->clientData.pBufferFree(pClient->clientData.readBuf, pClient->clientData.readBufSize,
+										pClient->clientData.pBufferAllocatorData);
+		pClient->clientData.readBuf = NULL;
+		pClient->clientData.readBufSize = 0;
+	}
+}
+
+/**
+ * @brief Make the read buffer large enough for a packet
+ *
+ * Buffered data is kept.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param minSize Number of bytes the buffer has to hold
+ *
+ * @return MQTT_RX_BUFFER_TOO_SHORT_ERROR if minSize is above AWS_IOT_MQTT_RX_BUF_MAX_LEN
+ */
+IoT_Error_t aws_iot_mqtt_internal_grow_read_buffer(AWS_IoT_Client *pClient, size_t minSize) {
+	size_t newSize;
+
+	if(minSize <= pClient->clientData.readBufSize) {
+		return SUCCESS;
+	}
+
+	newSize = _aws_iot_mqtt_buffer_grow_size(pClient->clientData.readBufSize, minSize, AWS_IOT_MQTT_RX_BUF_MAX_LEN);
+	if(newSize < minSize) {
+		return MQTT_RX_BUFFER_TOO_SHORT_ERROR;
+	}
+
+	return _aws_iot_mqtt_buffer_replace(pClient, &(pClient->clientData.readBuf), &(pClient->clientData.readBufSize),
+										&(pClient->clientData.peakReadBufSize), newSize,
+										pClient->clientData.readBufDataLen);
+}
+
+/**
+ * @brief Make the write buffer large enough for a packet
+ *
+ * The buffer content is not kept.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param minSize Number of bytes the buffer has to hold
+ *
+ * @return MQTT_TX_BUFFER_TOO_SHORT_ERROR if minSize is above AWS_IOT_MQTT_TX_BUF_MAX_LEN
+ */
+IoT_Error_t aws_iot_mqtt_internal_grow_write_buffer(AWS_IoT_Client *pClient, size_t minSize) {
+	size_t newSize;
+
+	if(minSize <= pClient->clientData.writeBufSize) {
+		return SUCCESS;
+	}
+
+	newSize = _aws_iot_mqtt_buffer_grow_size(pClient->clientData.writeBufSize, minSize, AWS_IOT_MQTT_TX_BUF_MAX_LEN);
+	if(newSize < minSize) {
+		return MQTT_TX_BUFFER_TOO_SHORT_ERROR;
+	}
+
+	return _aws_iot_mqtt_buffer_replace(pClient, &(pClient->clientData.writeBuf), &(pClient->clientData.writeBufSize),
+										&(pClient->clientData.peakWriteBufSize), newSize, 0);
+}
+
+/**
+ * @brief Return a grown read buffer to its initial size
+ *
+ * The buffer is only shrunk once the data staged in it fits the initial size.
+ * Failing to allocate the smaller buffer is not an error, the larger one is kept.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_shrink_read_buffer(AWS_IoT_Client *pClient) {
+	if(AWS_IOT_MQTT_RX_BUF_LEN < pClient->clientData.readBufSize
+	   && AWS_IOT_MQTT_RX_BUF_LEN >= pClient->clientData.readBufDataLen) {
+		_aws_iot_mqtt_buffer_replace(pClient, &(pClient->clientData.readBuf), &(pClient->clientData.readBufSize),
+									 &(pClient->clientData.peakReadBufSize), AWS_IOT_MQTT_RX_BUF_LEN,
+									 pClient->clientData.readBufDataLen);
+	}
+}
+
+/**
+ * @brief Return a grown write buffer to its initial size
+ *
+ * Failing to allocate the smaller buffer is not an error, the larger one is kept.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_shrink_write_buffer(AWS_IoT_Client *pClient) {
+	if(AWS_IOT_MQTT_TX_BUF_LEN < pClient->clientData.writeBufSize) {
+		_aws_iot_mqtt_buffer_replace(pClient, &(pClient->clientData.writeBuf), &(pClient->clientData.writeBufSize),
+									 &(pClient->clientData.peakWriteBufSize), AWS_IOT_MQTT_TX_BUF_LEN, 0);
+	}
+}
+
+#endif /* _ENABLE_DYNAMIC_BUFFERS_ */
+
+IoT_Error_t aws_iot_mqtt_get_buffer_usage(AWS_IoT_Client *pClient, IoT_Buffer_Usage *pUsage) {
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pUsage) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	pUsage->readBufSize = pClient->clientData.readBufSize;
+	pUsage->writeBufSize = pClient->clientData.writeBufSize;
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	pUsage->peakReadBufSize = pClient->clientData.peakReadBufSize;
+	pUsage->peakWriteBufSize = pClient->clientData.peakWriteBufSize;
+#else
+	pUsage->peakReadBufSize = pClient->clientData.readBufSize;
+	pUsage->peakWriteBufSize = pClient->clientData.writeBufSize;
+#endif
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -47,6 +47,34 @@ extern "C" {
 /* Max length of packet header */
 #define MAX_NO_OF_REMAINING_LENGTH_BYTES 4
 
+/* Fixed header byte of every packet type for QoS0 and QoS1, indexed by MessageTypes. Type 0 is reserved */
+static const unsigned char fixedHeaderBytes[DISCONNECT + 1][2] = {
+	{0x00, 0x00},
+	{MQTT_FIXED_HEADER_BYTE(CONNECT, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(CONNECT, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(CONNACK, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(CONNACK, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(PUBLISH, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(PUBLISH, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(PUBACK, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(PUBACK, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(PUBREC, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(PUBREC, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(PUBREL, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(PUBREL, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(PUBCOMP, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(PUBCOMP, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(SUBSCRIBE, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(SUBSCRIBE, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(SUBACK, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(SUBACK, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(UNSUBSCRIBE, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(UNSUBSCRIBE, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(UNSUBACK, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(UNSUBACK, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(PINGREQ, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(PINGREQ, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(PINGRESP, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(PINGRESP, QOS1, 0, 0)},
+	{MQTT_FIXED_HEADER_BYTE(DISCONNECT, QOS0, 0, 0), MQTT_FIXED_HEADER_BYTE(DISCONNECT, QOS1, 0, 0)}
+};
+
+/**
+ * Number of bytes the remaining length field takes (MQTT 3.1.1 - 2.2.3)
+ * @param length the remaining length
+ * @return 1 to 4, the comparisons compile to flag reads rather than branches
+ */
+static size_t _aws_iot_mqtt_internal_remaining_length_size(uint32_t length) {
+	return (size_t) 1 + (length >= 128) + (length >= 16384) + (length >= 2097152);
+}
+
 /**
  * Encodes the message length according to the MQTT algorithm
  * @param buf the buffer into which the encoded data is written
@@ -54,21 +82,23 @@ extern "C" {
  * @return the number of bytes written to buffer
  */
 size_t aws_iot_mqtt_internal_write_len_to_buffer(unsigned char *buf, uint32_t length) {
-	size_t outLen = 0;
-	unsigned char encodedByte;
-
 	IOT_FUNC_ENTRY;
-	do {
-		encodedByte = (unsigned char) (length % 128);
-		length /= 128;
-		/* if there are more digits to encode, set the top bit of this digit */
-		if(length > 0) {
-			encodedByte |= 0x80;
-		}
-		buf[outLen++] = encodedByte;
-	} while(length > 0);
+	/* Unrolled, the continuation bit of each byte is set from a comparison rather than a division loop */
+	buf[0] = (unsigned char) ((length & 0x7F) | ((length >= 128) << 7));
+	if(length < 128) {
+		IOT_FUNC_EXIT_RC(1);
+	}
+	buf[1] = (unsigned char) (((length >> 7) & 0x7F) | ((length >= 16384) << 7));
+	if(length < 16384) {
+		IOT_FUNC_EXIT_RC(2);
+	}
+	buf[2] = (unsigned char) (((length >> 14) & 0x7F) | ((length >= 2097152) << 7));
+	if(length < 2097152) {
+		IOT_FUNC_EXIT_RC(3);
+	}
+	buf[3] = (unsigned char) (length >> 21);
 
-	IOT_FUNC_EXIT_RC(outLen);
+	IOT_FUNC_EXIT_RC(4);
 }
 
 /**
@@ -104,18 +134,8 @@ IoT_Error_t aws_iot_mqtt_internal_decode_remaining_length_from_buffer(unsigned c
 }
 
 uint32_t aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(uint32_t rem_len) {
-	rem_len += 1; /* header byte */
-	/* now remaining_length field (MQTT 3.1.1 - 2.2.3)*/
-	if(rem_len < 128) {
-		rem_len += 1;
-	} else if(rem_len < 16384) {
-		rem_len += 2;
-	} else if(rem_len < 2097152) {
-		rem_len += 3;
-	} else {
-		rem_len += 4;
-	}
-	return rem_len;
+	/* header byte and remaining_length field (MQTT 3.1.1 - 2.2.3)*/
+	return rem_len + 1 + (uint32_t) _aws_iot_mqtt_internal_remaining_length_size(rem_len);
 }
 
 /**
@@ -180,9 +200,8 @@ void aws_iot_mqtt_internal_write_utf8_string(unsigned char **pptr, const char *s
 
 /**
  * Initialize the MQTTHeader structure. Used to ensure that Header bits are
- * always initialized using the proper mappings. No Endianness issues here since
- * the individual fields are all less than a byte. Also generates no warnings since
- * all fields are initialized using hex constants
+ * always initialized using the proper mappings. The byte is looked up in a table
+ * by packet type and QoS, any QoS other than QOS1 is treated as QOS0.
  */
 IoT_Error_t aws_iot_mqtt_internal_init_header(MQTTHeader *pHeader, MessageTypes message_type,
 											  QoS qos, uint8_t dup, uint8_t retained) {
@@ -192,74 +211,14 @@ IoT_Error_t aws_iot_mqtt_internal_init_header(MQTTHeader *pHeader, MessageTypes
 		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	/* Set all bits to zero */
 	pHeader->byte = 0;
-	switch(message_type) {
-		case UNKNOWN:
-			/* Should never happen */
-			return FAILURE;
-		case CONNECT:
-			pHeader->bits.type = 0x01;
-			break;
-		case CONNACK:
-			pHeader->bits.type = 0x02;
-			break;
-		case PUBLISH:
-			pHeader->bits.type = 0x03;
-			break;
-		case PUBACK:
-			pHeader->bits.type = 0x04;
-			break;
-		case PUBREC:
-			pHeader->bits.type = 0x05;
-			break;
-		case PUBREL:
-			pHeader->bits.type = 0x06;
-			break;
-		case PUBCOMP:
-			pHeader->bits.type = 0x07;
-			break;
-		case SUBSCRIBE:
-			pHeader->bits.type = 0x08;
-			break;
-		case SUBACK:
-			pHeader->bits.type = 0x09;
-			break;
-		case UNSUBSCRIBE:
-			pHeader->bits.type = 0x0A;
-			break;
-		case UNSUBACK:
-			pHeader->bits.type = 0x0B;
-			break;
-		case PINGREQ:
-			pHeader->bits.type = 0x0C;
-			break;
-		case PINGRESP:
-			pHeader->bits.type = 0x0D;
-			break;
-		case DISCONNECT:
-			pHeader->bits.type = 0x0E;
-			break;
-		default:
-			/* Should never happen */
+	if(CONNECT > message_type || DISCONNECT < message_type) {
+		/* Should never happen */
 		IOT_FUNC_EXIT_RC(FAILURE);
 	}
 
-	pHeader->bits.dup = (1 == dup) ? 0x01 : 0x00;
-	switch(qos) {
-		case QOS0:
-			pHeader->bits.qos = 0x00;
-			break;
-		case QOS1:
-			pHeader->bits.qos = 0x01;
-			break;
-		default:
-			/* Using QOS0 as default */
-			pHeader->bits.qos = 0x00;
-			break;
-	}
-
-	pHeader->bits.retain = (1 == retained) ? 0x01 : 0x00;
+	pHeader->byte = (unsigned char) (fixedHeaderBytes[message_type][(QOS1 == qos) ? 1 : 0]
+									 | ((1 == dup) ? 0x08 : 0x00) | ((1 == retained) ? 0x01 : 0x00));
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
@@ -315,151 +274,480 @@ IoT_Error_t aws_iot_mqtt_internal_send_packet(AWS_IoT_Client *pClient, size_t le
 	IOT_FUNC_EXIT_RC(FAILURE);
 }
 
-static IoT_Error_t _aws_iot_mqtt_internal_decode_packet_remaining_len(AWS_IoT_Client *pClient,
-																	  size_t *rem_len, Timer *pTimer) {
+/**
+ * @brief Send a packet whose payload stays in the caller's buffer
+ *
+ * The first headerLength bytes of the packet are serialized in writeBuf or in the buffer of a
+ * prepared publish, the payload follows them on the wire without being copied into writeBuf.
+ * Needs a network layer with a vectored write.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pHeader Serialized packet header
+ * @param headerLength Number of bytes serialized in pHeader
+ * @param pPayload Payload sent after the header
+ * @param payloadLen Length of the payload
+ * @param pTimer Timer for the send operation
+ *
+ * @return An IoT Error Type defining successful/failed send
+ */
+IoT_Error_t aws_iot_mqtt_internal_send_packet_with_payload(AWS_IoT_Client *pClient, const unsigned char *pHeader,
+														   size_t headerLength, const unsigned char *pPayload,
+														   size_t payloadLen, Timer *pTimer) {
+	NetworkIoVec ioVec[2];
+	size_t ioVecIndex, sentLen, sent, length;
+	IoT_Error_t rc;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pHeader || NULL == pTimer || (NULL == pPayload && 0 < payloadLen)) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(NULL == pClient->networkStack.writev) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(pHeader == pClient->clientData.writeBuf && headerLength > pClient->clientData.writeBufSize) {
+		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+	}
+
+	ioVec[0].pBuffer = pHeader;
+	ioVec[0].len = headerLength;
+	ioVec[1].pBuffer = pPayload;
+	ioVec[1].len = payloadLen;
+	length = headerLength + payloadLen;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	rc = aws_iot_mqtt_client_lock_mutex(pClient, &(pClient->clientData.tls_write_mutex));
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+#endif
+
+	ioVecIndex = 0;
+	sent = 0;
+
+	while(sent < length && !has_timer_expired(pTimer)) {
+		sentLen = 0;
+		rc = pClient->networkStack.writev(&(pClient->networkStack), &ioVec[ioVecIndex], 2 - ioVecIndex, pTimer,
+										  &sentLen);
+		if(SUCCESS != rc) {
+			/* there was an error writing the data */
+			break;
+		}
+		sent += sentLen;
+
+		/* skip what was written, a partial write continues within the current buffer */
+		while(0 < sentLen && ioVecIndex < 2) {
+			if(sentLen >= ioVec[ioVecIndex].len) {
+				sentLen -= ioVec[ioVecIndex].len;
+				ioVecIndex++;
+			} else {
+				ioVec[ioVecIndex].pBuffer += sentLen;
+				ioVec[ioVecIndex].len -= sentLen;
+				sentLen = 0;
+			}
+		}
+	}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	rc = aws_iot_mqtt_client_unlock_mutex(pClient, &(pClient->clientData.tls_write_mutex));
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+#endif
+
+	if(sent == length) {
+		IOT_FUNC_EXIT_RC(SUCCESS);
+	}
+
+	IOT_FUNC_EXIT_RC(FAILURE);
+}
+
+/**
+ * @brief Decode the remaining length field from the receive buffer
+ *
+ * The field is decoded from bytes that are already buffered. If the field is not complete yet
+ * *pLenBytes is set to zero and more data has to be read before trying again.
+ *
+ * @param pBuf Pointer to the first byte of the remaining length field
+ * @param bufLen Number of buffered bytes available at pBuf
+ * @param rem_len Decoded remaining length
+ * @param pLenBytes Number of bytes the field occupies, zero if incomplete
+ *
+ * @return An IoT Error Type defining successful/failed decoding
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_decode_packet_remaining_len(const unsigned char *pBuf, size_t bufLen,
+																	  size_t *rem_len, size_t *pLenBytes) {
 	unsigned char encodedByte;
 	size_t multiplier, len;
-	IoT_Error_t rc;
 
 	IOT_FUNC_ENTRY;
 
 	multiplier = 1;
 	len = 0;
 	*rem_len = 0;
+	*pLenBytes = 0;
 
 	do {
-		if(++len > MAX_NO_OF_REMAINING_LENGTH_BYTES) {
+		if(len >= MAX_NO_OF_REMAINING_LENGTH_BYTES) {
 			/* bad data */
 			IOT_FUNC_EXIT_RC(MQTT_DECODE_REMAINING_LENGTH_ERROR);
 		}
 
-		rc = pClient->networkStack.read(&(pClient->networkStack), &encodedByte, 1, pTimer, &len);
-		if(SUCCESS != rc) {
-			IOT_FUNC_EXIT_RC(rc);
+		if(len >= bufLen) {
+			/* rest of the field has not arrived yet */
+			*rem_len = 0;
+			IOT_FUNC_EXIT_RC(SUCCESS);
 		}
 
+		encodedByte = pBuf[len++];
 		*rem_len += ((encodedByte & 127) * multiplier);
 		multiplier *= 128;
 	} while((encodedByte & 128) != 0);
 
-	IOT_FUNC_EXIT_RC(rc);
+	*pLenBytes = len;
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
-static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType) {
-	size_t len, rem_len, total_bytes_read, bytes_to_be_read, read_len;
+/**
+ * @brief Append received data to the receive buffer
+ *
+ * Asks the network layer for up to maxLen bytes in a single call. The network layer returns
+ * whatever is available, which may be several packets or only part of one.
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_fill_read_buffer(AWS_IoT_Client *pClient, size_t maxLen, Timer *pTimer) {
+	size_t read_len = 0;
 	IoT_Error_t rc;
-	MQTTHeader header = {0};
-	Timer packetTimer;
-	init_timer(&packetTimer);
-	countdown_ms(&packetTimer, pClient->clientData.packetTimeoutMs);
-
-	len = 0;
-	rem_len = 0;
-	total_bytes_read = 0;
-	bytes_to_be_read = 0;
-	read_len = 0;
 
-	rc = pClient->networkStack.read(&(pClient->networkStack), pClient->clientData.readBuf, 1, pTimer, &read_len);
-	/* 1. read the header byte.  This has the packet type in it */
-	if(NETWORK_SSL_NOTHING_TO_READ == rc) {
-		return MQTT_NOTHING_TO_READ;
-	} else if(SUCCESS != rc) {
+	rc = pClient->networkStack.read(&(pClient->networkStack),
+									pClient->clientData.readBuf + pClient->clientData.readBufDataLen, maxLen,
+									pTimer, &read_len);
+	if(SUCCESS != rc) {
 		return rc;
 	}
 
-	len = 1;
+	if(0 == read_len && has_timer_expired(pTimer)) {
+		return NETWORK_SSL_READ_TIMEOUT_ERROR;
+	}
 
-	/* Use the constant packet receive timeout, instead of the variable (remaining) pTimer time, to
-	 * determine packet receiving timeout. This is done so we don't prematurely time out packet receiving
-	 * if the remaining time in pTimer is too short.
-	 */
-	pTimer = &packetTimer;
+	pClient->clientData.readBufDataLen += read_len;
 
-	/* 2. read the remaining length.  This is variable in itself */
-	rc = _aws_iot_mqtt_internal_decode_packet_remaining_len(pClient, &rem_len, pTimer);
+	return SUCCESS;
+}
+
+/**
+ * @brief Discard the rest of a packet that does not fit in the receive buffer
+ *
+ * Reads and drops the remaining bytes of the packet without reading past its end, so the
+ * packet that follows it is not lost. The receive buffer is left empty.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param bytesRead Number of bytes of the packet already read
+ * @param packetLen Total length of the packet
+ * @param pTimer Timer for reading the rest of the packet
+ */
+static void _aws_iot_mqtt_internal_drain_packet(AWS_IoT_Client *pClient, size_t bytesRead, size_t packetLen,
+												Timer *pTimer) {
+	size_t bytesToBeRead;
+	IoT_Error_t rc = SUCCESS;
+	ClientData *pData = &(pClient->clientData);
+
+	while(bytesRead < packetLen && SUCCESS == rc) {
+		pData->readBufDataLen = 0;
+		bytesToBeRead = packetLen - bytesRead;
+		if(bytesToBeRead > pData->readBufSize) {
+			bytesToBeRead = pData->readBufSize;
+		}
+		rc = _aws_iot_mqtt_internal_fill_read_buffer(pClient, bytesToBeRead, pTimer);
+		bytesRead += pData->readBufDataLen;
+	}
+	pData->readBufDataLen = 0;
+}
+
+/**
+ * @brief Call the message handlers marked in a matched handler bitset
+ *
+ * Handlers are called in subscription table order, after the lookup, so
+ * a callback can subscribe or unsubscribe without disturbing the walk
+ */
+static void _aws_iot_mqtt_internal_call_handlers(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
+												 IoT_Publish_Message_Params *pMessageParams,
+												 const uint32_t *pMatchedHandlers) {
+	uint32_t itr, word;
+
+	for(word = 0; word < AWS_IOT_MQTT_HANDLER_BITSET_WORDS; ++word) {
+		if(0 == pMatchedHandlers[word]) {
+			continue;
+		}
+		for(itr = word * 32; itr < (word + 1) * 32 && itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++itr) {
+			if(0 != (pMatchedHandlers[word] & (((uint32_t) 1) << (itr % 32)))
+			   && NULL != pClient->clientData.messageHandlers[itr].topicName
+			   && NULL != pClient->clientData.messageHandlers[itr].pApplicationHandler) {
+				pClient->clientData.messageHandlers[itr].pApplicationHandler(pClient, pTopicName, topicNameLen,
+																			 pMessageParams,
+																			 pClient->clientData.messageHandlers[itr].pApplicationHandlerData);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Deliver a publish larger than the receive buffer to streaming subscribers
+ *
+ * The fixed and variable header stay at the start of the receive buffer while the payload is
+ * read into the rest of it, one buffer at a time. Each chunk is passed to the handlers that
+ * subscribed with aws_iot_mqtt_subscribe_streaming as soon as it arrives. Without such a
+ * handler, or if the topic alone does not fit, the packet is dropped as before.
+ *
+ * The packet is fully consumed here, including the PUBACK for QoS1, so on success the caller
+ * sees nothing to read. If reading stops part way the rest of the packet is still on the
+ * connection and the next packet can not be found, NETWORK_SSL_READ_ERROR makes yield close it.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param fixedHeaderLen Length of the fixed header, already in the receive buffer
+ * @param packetLen Total length of the packet
+ * @param pTimer Timer for reading the rest of the packet
+ *
+ * @return MQTT_NOTHING_TO_READ once the message was delivered, an IoT Error Type otherwise
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_stream_publish(AWS_IoT_Client *pClient, size_t fixedHeaderLen,
+														 size_t packetLen, Timer *pTimer) {
+	uint32_t matchedHandlers[AWS_IOT_MQTT_HANDLER_BITSET_WORDS];
+	uint32_t itr, word, hasStreamingHandler, len;
+	size_t varHeaderLen, bytesRead, maxLen;
+	unsigned char *curData;
+	char *topicName;
+	uint16_t topicNameLen;
+	MQTTHeader header = {0};
+	IoT_Publish_Message_Params msg;
+	ClientState clientState;
+	Timer ackTimer;
+	IoT_Error_t rc = SUCCESS;
+	ClientData *pData = &(pClient->clientData);
+
+	topicName = NULL;
+	topicNameLen = 0;
+	header.byte = pData->readBuf[0];
+
+	/* topic length first, then the rest of the variable header.  Everything buffered belongs to
+	 * this packet, and it is longer than the buffer, so reads are bounded by the buffer only */
+	varHeaderLen = fixedHeaderLen + 2;
+	while(SUCCESS == rc && pData->readBufDataLen < varHeaderLen) {
+		rc = _aws_iot_mqtt_internal_fill_read_buffer(pClient, pData->readBufSize - pData->readBufDataLen, pTimer);
+	}
+	if(SUCCESS == rc) {
+		curData = pData->readBuf + fixedHeaderLen;
+		topicNameLen = aws_iot_mqtt_internal_read_uint16_t(&curData);
+		topicName = (char *) curData;
+		varHeaderLen += topicNameLen + ((0 < header.bits.qos) ? 2 : 0);
+		/* leave room for at least one byte of payload */
+		if(varHeaderLen >= pData->readBufSize) {
+			_aws_iot_mqtt_internal_drain_packet(pClient, pData->readBufDataLen, packetLen, pTimer);
+			return MQTT_RX_BUFFER_TOO_SHORT_ERROR;
+		}
+	}
+	while(SUCCESS == rc && pData->readBufDataLen < varHeaderLen) {
+		rc = _aws_iot_mqtt_internal_fill_read_buffer(pClient, pData->readBufSize - pData->readBufDataLen, pTimer);
+	}
 	if(SUCCESS != rc) {
-		return rc;
+		IOT_ERROR("Streamed publish header incomplete, rc %d", rc);
+		pData->readBufDataLen = 0;
+		return NETWORK_SSL_READ_ERROR;
+	}
+
+	msg.id = 0;
+	if(0 < header.bits.qos) {
+		curData = pData->readBuf + varHeaderLen - 2;
+		msg.id = aws_iot_mqtt_internal_read_uint16_t(&curData);
 	}
 
-	/* if the buffer is too short then the message will be dropped silently */
-	if(rem_len >= pClient->clientData.readBufSize) {
-		bytes_to_be_read = pClient->clientData.readBufSize;
-		do {
-			rc = pClient->networkStack.read(&(pClient->networkStack), pClient->clientData.readBuf, bytes_to_be_read,
-											pTimer, &read_len);
-			if(SUCCESS == rc) {
-				total_bytes_read += read_len;
-				if((rem_len - total_bytes_read) >= pClient->clientData.readBufSize) {
-					bytes_to_be_read = pClient->clientData.readBufSize;
-				} else {
-					bytes_to_be_read = rem_len - total_bytes_read;
-				}
+	memset(matchedHandlers, 0, sizeof(matchedHandlers));
+	aws_iot_mqtt_internal_topic_trie_match(pClient, topicName, topicNameLen, matchedHandlers);
+	hasStreamingHandler = 0;
+	for(word = 0; word < AWS_IOT_MQTT_HANDLER_BITSET_WORDS; ++word) {
+		for(itr = word * 32; itr < (word + 1) * 32 && itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++itr) {
+			if(!pData->messageHandlers[itr].isPayloadStreamingEnabled) {
+				matchedHandlers[word] &= ~(((uint32_t) 1) << (itr % 32));
 			}
-		} while(total_bytes_read < rem_len && SUCCESS == rc);
+		}
+		hasStreamingHandler |= matchedHandlers[word];
+	}
+	if(0 == hasStreamingHandler) {
+		_aws_iot_mqtt_internal_drain_packet(pClient, pData->readBufDataLen, packetLen, pTimer);
 		return MQTT_RX_BUFFER_TOO_SHORT_ERROR;
 	}
 
-	/* put the original remaining length into the read buffer */
-	len += aws_iot_mqtt_internal_write_len_to_buffer(pClient->clientData.readBuf + 1, (uint32_t) rem_len);
+	msg.qos = (QoS) header.bits.qos;
+	msg.isRetained = (uint8_t) header.bits.retain;
+	msg.isDup = (uint8_t) header.bits.dup;
+	msg.payload = pData->readBuf + varHeaderLen;
+	msg.payloadOffset = 0;
+	msg.totalPayloadLen = packetLen - varHeaderLen;
 
-	/* 3. read the rest of the buffer using a callback to supply the rest of the data */
-	if(rem_len > 0) {
-		rc = pClient->networkStack.read(&(pClient->networkStack), pClient->clientData.readBuf + len, rem_len, pTimer,
-										&read_len);
-		if(SUCCESS != rc || read_len != rem_len) {
-			return FAILURE;
+	/* Yield can not be called while callbacks run, same as for a regular message */
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	(void) aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
+
+	bytesRead = pData->readBufDataLen;
+	while(SUCCESS == rc) {
+		msg.payloadLen = pData->readBufDataLen - varHeaderLen;
+		if(0 < msg.payloadLen) {
+			_aws_iot_mqtt_internal_call_handlers(pClient, topicName, topicNameLen, &msg, matchedHandlers);
+			msg.payloadOffset += msg.payloadLen;
+		}
+		if(bytesRead == packetLen) {
+			break;
+		}
+
+		pData->readBufDataLen = varHeaderLen;
+		maxLen = pData->readBufSize - varHeaderLen;
+		if(maxLen > packetLen - bytesRead) {
+			maxLen = packetLen - bytesRead;
 		}
+		rc = _aws_iot_mqtt_internal_fill_read_buffer(pClient, maxLen, pTimer);
+		bytesRead += pData->readBufDataLen - varHeaderLen;
 	}
 
-	header.byte = pClient->clientData.readBuf[0];
-	*pPacketType = header.bits.type;
+	(void) aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+	pData->readBufDataLen = 0;
+	pData->readBufPacketLen = 0;
+	if(SUCCESS != rc) {
+		IOT_ERROR("Streamed publish stopped after %u of %u payload bytes, rc %d", (unsigned int) msg.payloadOffset,
+				  (unsigned int) msg.totalPayloadLen, rc);
+		return NETWORK_SSL_READ_ERROR;
+	}
 
-	IOT_FUNC_EXIT_RC(rc);
+	if(QOS0 == msg.qos) {
+		return MQTT_NOTHING_TO_READ;
+	}
+
+	/* Message assumed to be QoS1 since we do not support QoS2 at this time.
+	 * The yield timer may have run out while the payload was read */
+	init_timer(&ackTimer);
+	countdown_ms(&ackTimer, pData->commandTimeoutMs);
+	len = 0;
+	rc = aws_iot_mqtt_internal_serialize_ack(pData->writeBuf, pData->writeBufSize, PUBACK, 0, msg.id, &len);
+	if(SUCCESS == rc) {
+		rc = aws_iot_mqtt_internal_send_packet(pClient, len, &ackTimer);
+	}
+
+	return (SUCCESS == rc) ? MQTT_NOTHING_TO_READ : rc;
 }
 
-// assume topic filter and name is in correct format
-// # can only be at end
-// + and # can only be next to separator
-static char _aws_iot_mqtt_internal_is_topic_matched(char *pTopicFilter, char *pTopicName, uint16_t topicNameLen) {
+/**
+ * @brief Check for the would-block codes of a non-blocking network layer
+ */
+static bool _aws_iot_mqtt_internal_is_would_block(IoT_Error_t rc) {
+	return NETWORK_SSL_WANT_READ == rc || NETWORK_SSL_WANT_WRITE == rc;
+}
 
-	char *curf, *curn, *curn_end;
+static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType) {
+	size_t rem_len, len_bytes, packet_len;
+	IoT_Error_t rc;
+	MQTTHeader header = {0};
+	ClientData *pData = &(pClient->clientData);
+	Timer packetTimer;
+	init_timer(&packetTimer);
+	countdown_ms(&packetTimer, pClient->clientData.packetTimeoutMs);
+
+	rem_len = 0;
+	len_bytes = 0;
 
-	if(NULL == pTopicFilter || NULL == pTopicName) {
-		return 0;
+	/* 1. release the packet handed out by the previous call, keep whatever arrived after it */
+	if(0 < pData->readBufPacketLen) {
+		pData->readBufDataLen -= pData->readBufPacketLen;
+		if(0 < pData->readBufDataLen) {
+			memmove(pData->readBuf, pData->readBuf + pData->readBufPacketLen, pData->readBufDataLen);
+		}
+		pData->readBufPacketLen = 0;
 	}
 
-	curf = pTopicFilter;
-	curn = pTopicName;
-	curn_end = curn + topicNameLen;
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* a large packet was handed out, go back to the initial buffer size */
+	aws_iot_mqtt_internal_shrink_read_buffer(pClient);
+#endif
 
-	while(*curf && (curn < curn_end)) {
-		if(*curn == '/' && *curf != '/') {
-			break;
+	/* 2. wait for the start of a packet, unless one is already buffered */
+	if(0 == pData->readBufDataLen) {
+		rc = _aws_iot_mqtt_internal_fill_read_buffer(pClient, pData->readBufSize, pTimer);
+		if(NETWORK_SSL_NOTHING_TO_READ == rc || _aws_iot_mqtt_internal_is_would_block(rc)
+		   || (SUCCESS == rc && 0 == pData->readBufDataLen)) {
+			return MQTT_NOTHING_TO_READ;
+		} else if(SUCCESS != rc) {
+			return rc;
 		}
-		if(*curf != '+' && *curf != '#' && *curf != *curn) {
-			break;
+	}
+
+	/* Use the constant packet receive timeout, instead of the variable (remaining) pTimer time, to
+	 * determine packet receiving timeout. This is done so we don't prematurely time out packet receiving
+	 * if the remaining time in pTimer is too short.
+	 */
+	pTimer = &packetTimer;
+
+	/* 3. decode the remaining length.  This is variable in itself */
+	do {
+		rc = _aws_iot_mqtt_internal_decode_packet_remaining_len(pData->readBuf + 1, pData->readBufDataLen - 1,
+																&rem_len, &len_bytes);
+		if(SUCCESS == rc && 0 == len_bytes) {
+			rc = _aws_iot_mqtt_internal_fill_read_buffer(pClient, pData->readBufSize - pData->readBufDataLen,
+														 pTimer);
+		}
+		if(_aws_iot_mqtt_internal_is_would_block(rc)) {
+			/* the partial packet stays buffered, the next call picks it up from here */
+			return MQTT_NOTHING_TO_READ;
+		} else if(SUCCESS != rc) {
+			pData->readBufDataLen = 0;
+			return rc;
 		}
-		if(*curf == '+') {
-			/* skip until we meet the next separator, or end of string */
-			char *nextpos = curn + 1;
-			while(nextpos < curn_end && *nextpos != '/')
-				nextpos = ++curn + 1;
-		} else if(*curf == '#') {
-			/* skip until end of string */
-			curn = curn_end - 1;
+	} while(0 == len_bytes);
+
+	packet_len = 1 + len_bytes + rem_len;
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* if the buffer cannot grow to AWS_IOT_MQTT_RX_BUF_MAX_LEN the packet is dropped below */
+	if(packet_len > pData->readBufSize) {
+		(void) aws_iot_mqtt_internal_grow_read_buffer(pClient, packet_len);
+	}
+#endif
+
+	/* if the buffer is too short then the message will be dropped silently,
+	 * unless it is a publish a streaming subscriber can take in chunks */
+	if(packet_len > pData->readBufSize) {
+		header.byte = pData->readBuf[0];
+		if(PUBLISH == header.bits.type) {
+			*pPacketType = 0;
+			return _aws_iot_mqtt_internal_stream_publish(pClient, 1 + len_bytes, packet_len, pTimer);
+		}
+		/* Everything buffered belongs to this packet */
+		_aws_iot_mqtt_internal_drain_packet(pClient, pData->readBufDataLen, packet_len, pTimer);
+		return MQTT_RX_BUFFER_TOO_SHORT_ERROR;
+	}
+
+	/* 4. read the rest of the packet, taking whatever follows it along */
+	while(pData->readBufDataLen < packet_len) {
+		rc = _aws_iot_mqtt_internal_fill_read_buffer(pClient, pData->readBufSize - pData->readBufDataLen, pTimer);
+		if(_aws_iot_mqtt_internal_is_would_block(rc)) {
+			return MQTT_NOTHING_TO_READ;
+		} else if(SUCCESS != rc) {
+			pData->readBufDataLen = 0;
+			return FAILURE;
 		}
+	}
 
-		curf++;
-		curn++;
-	};
+	pData->readBufPacketLen = packet_len;
+
+	header.byte = pData->readBuf[0];
+	*pPacketType = header.bits.type;
 
-	return (curn == curn_end) && (*curf == '\0');
+	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
 static IoT_Error_t _aws_iot_mqtt_internal_deliver_message(AWS_IoT_Client *pClient, char *pTopicName,
 														  uint16_t topicNameLen,
 														  IoT_Publish_Message_Params *pMessageParams) {
-	uint32_t itr;
+	uint32_t matchedHandlers[AWS_IOT_MQTT_HANDLER_BITSET_WORDS];
 	IoT_Error_t rc;
 	ClientState clientState;
 
@@ -475,22 +763,11 @@ static IoT_Error_t _aws_iot_mqtt_internal_deliver_message(AWS_IoT_Client *pClien
 	clientState = aws_iot_mqtt_get_client_state(pClient);
 	rc = aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
 
-	/* Find the right message handler - indexed by topic */
-	for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++itr) {
-		if(NULL != pClient->clientData.messageHandlers[itr].topicName) {
-			if(((topicNameLen == pClient->clientData.messageHandlers[itr].topicNameLen)
-				&&
-				(strncmp(pTopicName, (char *) pClient->clientData.messageHandlers[itr].topicName, topicNameLen) == 0))
-			   || _aws_iot_mqtt_internal_is_topic_matched((char *) pClient->clientData.messageHandlers[itr].topicName,
-														  pTopicName, topicNameLen)) {
-				if(NULL != pClient->clientData.messageHandlers[itr].pApplicationHandler) {
-					pClient->clientData.messageHandlers[itr].pApplicationHandler(pClient, pTopicName, topicNameLen,
-																				 pMessageParams,
-																				 pClient->clientData.messageHandlers[itr].pApplicationHandlerData);
-				}
-			}
-		}
-	}
+	/* Find the right message handlers - indexed by topic level */
+	memset(matchedHandlers, 0, sizeof(matchedHandlers));
+	aws_iot_mqtt_internal_topic_trie_match(pClient, pTopicName, topicNameLen, matchedHandlers);
+
+	_aws_iot_mqtt_internal_call_handlers(pClient, pTopicName, topicNameLen, pMessageParams, matchedHandlers);
 	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
 
 	IOT_FUNC_EXIT_RC(rc);
@@ -519,6 +796,9 @@ static IoT_Error_t _aws_iot_mqtt_internal_handle_publish(AWS_IoT_Client *pClient
 		IOT_FUNC_EXIT_RC(rc);
 	}
 
+	msg.payloadOffset = 0;
+	msg.totalPayloadLen = msg.payloadLen;
+
 	rc = _aws_iot_mqtt_internal_deliver_message(pClient, topicName, topicNameLen, &msg);
 	if(SUCCESS != rc) {
 		IOT_FUNC_EXIT_RC(rc);
@@ -545,6 +825,32 @@ static IoT_Error_t _aws_iot_mqtt_internal_handle_publish(AWS_IoT_Client *pClient
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
+static IoT_Error_t _aws_iot_mqtt_internal_handle_puback(AWS_IoT_Client *pClient, uint8_t *pPacketType) {
+	uint16_t packetId;
+	unsigned char dup, type;
+	IoT_Error_t rc;
+
+	IOT_FUNC_ENTRY;
+
+	if(0 == pClient->clientData.inflightPublishCount) {
+		/* SDK is blocking, the response will be forwarded to calling function to process */
+		IOT_FUNC_EXIT_RC(SUCCESS);
+	}
+
+	rc = aws_iot_mqtt_internal_deserialize_ack(&type, &dup, &packetId, pClient->clientData.readBuf,
+											   pClient->clientData.readBufSize);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	if(aws_iot_mqtt_internal_handle_inflight_puback(pClient, packetId)) {
+		/* Consumed by an async publish, don't let a blocking publish mistake it for its own PUBACK */
+		*pPacketType = 0;
+	}
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
 IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType) {
 	IoT_Error_t rc;
 
@@ -581,8 +887,11 @@ IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTi
 	}
 
 	switch(*pPacketType) {
+		case PUBACK: {
+			rc = _aws_iot_mqtt_internal_handle_puback(pClient, pPacketType);
+			break;
+		}
 		case CONNACK:
-		case PUBACK:
 		case SUBACK:
 		case UNSUBACK:
 			/* SDK is blocking, these responses will be forwarded to calling function to process */
@@ -597,7 +906,7 @@ IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTi
 			break;
 		case PINGRESP: {
 			pClient->clientStatus.isPingOutstanding = 0;
-			countdown_sec(&pClient->pingTimer, pClient->clientData.keepAliveInterval);
+			aws_iot_mqtt_timer_start(pClient, &(pClient->pingTimer), pClient->clientData.keepAliveInterval * 1000);
 			break;
 		}
 		default: {
@@ -649,7 +958,6 @@ IoT_Error_t aws_iot_mqtt_internal_wait_for_read(AWS_IoT_Client *pClient, uint8_t
   */
 IoT_Error_t aws_iot_mqtt_internal_serialize_zero(unsigned char *pTxBuf, size_t txBufLen, MessageTypes packetType,
 												 size_t *pSerializedLength) {
-	unsigned char *ptr;
 	IoT_Error_t rc;
 	MQTTHeader header = {0};
 
@@ -663,19 +971,14 @@ IoT_Error_t aws_iot_mqtt_internal_serialize_zero(unsigned char *pTxBuf, size_t t
 		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
 	}
 
-	ptr = pTxBuf;
-
 	rc = aws_iot_mqtt_internal_init_header(&header, packetType, QOS0, 0, 0);
 	if(SUCCESS != rc) {
 		IOT_FUNC_EXIT_RC(rc);
 	}
 
-	/* write header */
-	aws_iot_mqtt_internal_write_char(&ptr, header.byte);
-
-	/* write remaining length */
-	ptr += aws_iot_mqtt_internal_write_len_to_buffer(ptr, 0);
-	*pSerializedLength = (uint32_t) (ptr - pTxBuf);
+	pTxBuf[0] = header.byte; /* write header */
+	pTxBuf[1] = 0; /* write remaining length */
+	*pSerializedLength = 2;
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
@@ -152,8 +152,6 @@ static IoT_Error_t _aws_iot_mqtt_serialize_connect(unsigned char *pTxBuf, size_t
 												   size_t *pSerializedLen) {
 	unsigned char *ptr;
 	uint32_t len;
-	IoT_Error_t rc;
-	MQTTHeader header = {0};
 	MQTT_Connect_Header_Flags flags = {0};
 
 	IOT_FUNC_ENTRY;
@@ -178,12 +176,7 @@ static IoT_Error_t _aws_iot_mqtt_serialize_connect(unsigned char *pTxBuf, size_t
 		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
 	}
 
-	rc = aws_iot_mqtt_internal_init_header(&header, CONNECT, QOS0, 0, 0);
-	if(SUCCESS != rc) {
-		IOT_FUNC_EXIT_RC(rc);
-	}
-
-	aws_iot_mqtt_internal_write_char(&ptr, header.byte); /* write header */
+	aws_iot_mqtt_internal_write_char(&ptr, MQTT_FIXED_HEADER_BYTE(CONNECT, QOS0, 0, 0)); /* write header */
 
 	ptr += aws_iot_mqtt_internal_write_len_to_buffer(ptr, len); /* write remaining length */
 
@@ -397,6 +390,10 @@ static IoT_Error_t _aws_iot_mqtt_internal_connect(AWS_IoT_Client *pClient, IoT_C
 		IOT_FUNC_EXIT_RC(rc);
 	}
 
+	/* Discard anything left over from a previous connection */
+	pClient->clientData.readBufDataLen = 0;
+	pClient->clientData.readBufPacketLen = 0;
+
 	init_timer(&connect_timer);
 	countdown_ms(&connect_timer, pClient->clientData.commandTimeoutMs);
 
@@ -431,7 +428,7 @@ static IoT_Error_t _aws_iot_mqtt_internal_connect(AWS_IoT_Client *pClient, IoT_C
 	}
 
 	pClient->clientStatus.isPingOutstanding = false;
-	countdown_sec(&pClient->pingTimer, pClient->clientData.keepAliveInterval);
+	aws_iot_mqtt_timer_start(pClient, &(pClient->pingTimer), pClient->clientData.keepAliveInterval * 1000);
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
@@ -470,7 +467,12 @@ IoT_Error_t aws_iot_mqtt_connect(AWS_IoT_Client *pClient, IoT_Client_Connect_Par
 
 	rc = _aws_iot_mqtt_internal_connect(pClient, pConnectParams);
 
-	if(SUCCESS != rc) {
+	/* A non-blocking network layer keeps its half done handshake, the next connect call resumes it */
+	pClient->clientStatus.isNetworkConnectInProgress = (NETWORK_SSL_WANT_READ == rc || NETWORK_SSL_WANT_WRITE == rc);
+
+	if(pClient->clientStatus.isNetworkConnectInProgress) {
+		aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTING, CLIENT_STATE_DISCONNECTED_ERROR);
+	} else if(SUCCESS != rc) {
 		pClient->networkStack.disconnect(&(pClient->networkStack));
 		pClient->networkStack.destroy(&(pClient->networkStack));
 		aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTING, CLIENT_STATE_DISCONNECTED_ERROR);
@@ -526,6 +528,9 @@ IoT_Error_t _aws_iot_mqtt_internal_disconnect(AWS_IoT_Client *pClient) {
 		IOT_FUNC_EXIT_RC(FAILURE);
 	}
 
+	/* PUBACKs for messages still in flight can no longer arrive */
+	aws_iot_mqtt_internal_flush_inflight_publishes(pClient, NETWORK_DISCONNECTED_ERROR);
+
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
@@ -605,9 +610,23 @@ IoT_Error_t aws_iot_mqtt_attempt_reconnect(AWS_IoT_Client *pClient) {
 	/* If still disconnected handle disconnect */
 	if(CLIENT_STATE_CONNECTED_IDLE != aws_iot_mqtt_get_client_state(pClient)) {
 		aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_DISCONNECTED_ERROR, CLIENT_STATE_PENDING_RECONNECT);
+		if(pClient->clientStatus.isNetworkConnectInProgress) {
+			/* Let the caller know the handshake has to wait for the socket */
+			IOT_FUNC_EXIT_RC(rc);
+		}
 		IOT_FUNC_EXIT_RC(NETWORK_ATTEMPTING_RECONNECT);
 	}
 
+	if(pClient->clientStatus.isReconnectLatencyTimed) {
+		pClient->clientStatus.isReconnectLatencyTimed = false;
+		pClient->clientData.counterReconnected++;
+		pClient->clientData.lastReconnectLatencyMs =
+				AWS_IOT_MQTT_RECONNECT_LATENCY_TIMER_MS - left_ms(&(pClient->reconnectLatencyTimer));
+		if(pClient->clientData.lastReconnectLatencyMs > pClient->clientData.maxReconnectLatencyMs) {
+			pClient->clientData.maxReconnectLatencyMs = pClient->clientData.lastReconnectLatencyMs;
+		}
+	}
+
 	rc = aws_iot_mqtt_resubscribe(pClient);
 	if(SUCCESS != rc) {
 		IOT_FUNC_EXIT_RC(rc);
@@ -40,8 +40,13 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+
 #include "aws_iot_mqtt_client_common_internal.h"
 
+/* The variable header of a prepared publish follows room for the fixed header and the longest remaining length */
+#define PREPARED_PUBLISH_VARIABLE_HEADER_OFFSET 5
+
 /**
  * @param stringVar pointer to the String into which the data is to be read
  * @param stringLen pointer to variable which has the length of the string
@@ -69,69 +74,138 @@ static IoT_Error_t _aws_iot_mqtt_read_string_with_len(char **stringVar, uint16_t
 }
 
 /**
-  * Serializes the supplied publish data into the supplied buffer, ready for sending
-  * @param pTxBuf the buffer into which the packet will be serialized
+  * Serializes the fixed header, topic and packet id of a publish into the supplied buffer.
+  * The payload is not written, it follows the returned length on the wire.
+  * @param pTxBuf the buffer into which the packet header will be serialized
   * @param txBufLen the length in bytes of the supplied buffer
+  * @param pHeader IoT_Publish_Header - the prepared publish header with topic, QoS and retained flag
   * @param dup uint8_t - the MQTT dup flag
-  * @param qos QoS - the MQTT QoS value
-  * @param retained uint8_t - the MQTT retained flag
   * @param packetId uint16_t - the MQTT packet identifier
-  * @param pTopicName char * - the MQTT topic in the publish
-  * @param topicNameLen uint16_t - the length of the Topic Name
-  * @param pPayload byte buffer - the MQTT publish payload
   * @param payloadLen size_t - the length of the MQTT payload
-  * @param pSerializedLen uint32_t - pointer to the variable that stores serialized len
+  * @param pSerializedLen uint32_t - pointer to the variable that stores serialized header len
   *
   * @return An IoT Error Type defining successful/failed call
   */
-static IoT_Error_t _aws_iot_mqtt_internal_serialize_publish(unsigned char *pTxBuf, size_t txBufLen, uint8_t dup,
-															QoS qos, uint8_t retained, uint16_t packetId,
-															const char *pTopicName, uint16_t topicNameLen,
-															const unsigned char *pPayload, size_t payloadLen,
-															uint32_t *pSerializedLen) {
+IoT_Error_t aws_iot_mqtt_internal_serialize_publish_header(unsigned char *pTxBuf, size_t txBufLen,
+														   const IoT_Publish_Header *pHeader, uint8_t dup,
+														   uint16_t packetId, size_t payloadLen,
+														   uint32_t *pSerializedLen) {
 	unsigned char *ptr;
 	uint32_t rem_len;
-	IoT_Error_t rc;
-	MQTTHeader header = {0};
 
 	IOT_FUNC_ENTRY;
-	if(NULL == pTxBuf || NULL == pPayload || NULL == pSerializedLen) {
+	if(NULL == pTxBuf || NULL == pHeader || NULL == pSerializedLen) {
 		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
+	if(payloadLen > MQTT_MAX_REMAINING_LENGTH - pHeader->variableHeaderLen) {
+		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+	}
+
 	ptr = pTxBuf;
-	rem_len = 0;
+	rem_len = (uint32_t) (pHeader->variableHeaderLen + payloadLen);
+	if(aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(rem_len) - payloadLen > txBufLen) {
+		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+	}
+
+	/* write header and remaining length */
+	ptr[0] = (unsigned char) (pHeader->fixedHeader | ((1 == dup) ? 0x08 : 0x00));
+	ptr += 1 + aws_iot_mqtt_internal_write_len_to_buffer(ptr + 1, rem_len);
 
-	rem_len += (uint32_t) (topicNameLen + payloadLen + 2);
-	if(qos > 0) {
-		rem_len += 2; /* packetId */
+	/* topic and packet id are written in place rather than through the write_char helpers */
+	ptr[0] = (unsigned char) (pHeader->topicNameLen >> 8);
+	ptr[1] = (unsigned char) (pHeader->topicNameLen & 0xFF);
+	memcpy(ptr + 2, pHeader->pTopicName, pHeader->topicNameLen);
+	ptr += 2 + pHeader->topicNameLen;
+
+	if(QOS1 == pHeader->qos) {
+		ptr[0] = (unsigned char) (packetId >> 8);
+		ptr[1] = (unsigned char) (packetId & 0xFF);
+		ptr += 2;
 	}
-	if(aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(rem_len) > txBufLen) {
-		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+
+	*pSerializedLen = (uint32_t) (ptr - pTxBuf);
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+  * Serializes the supplied publish data into the supplied buffer, ready for sending
+  * @param pTxBuf the buffer into which the packet will be serialized
+  * @param txBufLen the length in bytes of the supplied buffer
+  * @param pHeader IoT_Publish_Header - the prepared publish header with topic, QoS and retained flag
+  * @param dup uint8_t - the MQTT dup flag
+  * @param packetId uint16_t - the MQTT packet identifier
+  * @param pPayload byte buffer - the MQTT publish payload
+  * @param payloadLen size_t - the length of the MQTT payload
+  * @param pSerializedLen uint32_t - pointer to the variable that stores serialized len
+  *
+  * @return An IoT Error Type defining successful/failed call
+  */
+static IoT_Error_t _aws_iot_mqtt_internal_serialize_publish(unsigned char *pTxBuf, size_t txBufLen,
+															const IoT_Publish_Header *pHeader, uint8_t dup,
+															uint16_t packetId, const unsigned char *pPayload,
+															size_t payloadLen, uint32_t *pSerializedLen) {
+	uint32_t headerLen = 0;
+	IoT_Error_t rc;
+
+	IOT_FUNC_ENTRY;
+	if(NULL == pTxBuf || NULL == pPayload || NULL == pSerializedLen) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	rc = aws_iot_mqtt_internal_init_header(&header, PUBLISH, qos, dup, retained);
+	rc = aws_iot_mqtt_internal_serialize_publish_header(pTxBuf, txBufLen, pHeader, dup, packetId, payloadLen,
+														&headerLen);
 	if(SUCCESS != rc) {
 		IOT_FUNC_EXIT_RC(rc);
 	}
-	aws_iot_mqtt_internal_write_char(&ptr, header.byte); /* write header */
-
-	ptr += aws_iot_mqtt_internal_write_len_to_buffer(ptr, rem_len); /* write remaining length */;
 
-	aws_iot_mqtt_internal_write_utf8_string(&ptr, pTopicName, topicNameLen);
-
-	if(qos > 0) {
-		aws_iot_mqtt_internal_write_uint_16(&ptr, packetId);
+	if(headerLen + payloadLen > txBufLen) {
+		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
 	}
 
-	memcpy(ptr, pPayload, payloadLen);
-	ptr += payloadLen;
+	memcpy(pTxBuf + headerLen, pPayload, payloadLen);
 
-	*pSerializedLen = (uint32_t) (ptr - pTxBuf);
+	*pSerializedLen = (uint32_t) (headerLen + payloadLen);
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+  * Patches the remaining length, dup flag and packet id of a publish prepared by aws_iot_mqtt_prepare_publish.
+  * The remaining length is written right before the serialized topic, the packet header starts
+  * wherever the fixed header ends up in front of it.
+  * @param pHeader IoT_Publish_Header - the prepared publish header with its serialized packet header
+  * @param dup uint8_t - the MQTT dup flag
+  * @param packetId uint16_t - the MQTT packet identifier
+  * @param payloadLen size_t - the length of the MQTT payload
+  * @param pSerializedLen uint32_t - pointer to the variable that stores serialized header len
+  *
+  * @return Start of the packet header in the buffer of the prepared publish
+  */
+unsigned char *aws_iot_mqtt_internal_patch_prepared_publish(const IoT_Publish_Header *pHeader, uint8_t dup,
+															uint16_t packetId, size_t payloadLen,
+															uint32_t *pSerializedLen) {
+	unsigned char *ptr;
+	uint32_t rem_len, fixedLen;
+
+	rem_len = (uint32_t) (pHeader->variableHeaderLen + payloadLen);
+	fixedLen = aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(rem_len) - rem_len;
+	ptr = pHeader->pSerialized + PREPARED_PUBLISH_VARIABLE_HEADER_OFFSET - fixedLen;
+
+	ptr[0] = (unsigned char) (pHeader->fixedHeader | ((1 == dup) ? 0x08 : 0x00));
+	aws_iot_mqtt_internal_write_len_to_buffer(ptr + 1, rem_len);
+
+	if(QOS1 == pHeader->qos) {
+		ptr = pHeader->pSerialized + PREPARED_PUBLISH_VARIABLE_HEADER_OFFSET + 2 + pHeader->topicNameLen;
+		ptr[0] = (unsigned char) (packetId >> 8);
+		ptr[1] = (unsigned char) (packetId & 0xFF);
+	}
+
+	*pSerializedLen = fixedLen + pHeader->variableHeaderLen;
+	return pHeader->pSerialized + PREPARED_PUBLISH_VARIABLE_HEADER_OFFSET - fixedLen;
+}
+
 /**
   * Serializes the ack packet into the supplied buffer.
   * @param pTxBuf the buffer into which the packet will be serialized
@@ -168,15 +242,91 @@ IoT_Error_t aws_iot_mqtt_internal_serialize_ack(unsigned char *pTxBuf, size_t tx
 	if(SUCCESS != rc) {
 		IOT_FUNC_EXIT_RC(rc);
 	}
-	aws_iot_mqtt_internal_write_char(&ptr, header.byte); /* write header */
-
-	ptr += aws_iot_mqtt_internal_write_len_to_buffer(ptr, 2); /* write remaining length */
-	aws_iot_mqtt_internal_write_uint_16(&ptr, packetId);
-	*pSerializedLen = (uint32_t) (ptr - pTxBuf);
+	ptr[0] = header.byte; /* write header */
+	ptr[1] = 2; /* write remaining length, always a single byte */
+	ptr[2] = (unsigned char) (packetId >> 8);
+	ptr[3] = (unsigned char) (packetId & 0xFF);
+	*pSerializedLen = 4;
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Serialize and send a publish packet
+ *
+ * If the network layer has a vectored write only the header and topic are serialized
+ * into writeBuf and the payload is sent from the application's buffer. A prepared publish
+ * sends its own serialized header instead. Otherwise the whole packet is copied into writeBuf.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pHeader Prepared publish header
+ * @param pParams Pointer to Publish Message parameters, with the packet id set for QoS1
+ * @param pTimer Timer for the send operation
+ *
+ * @return An IoT Error Type defining successful/failed send
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_send_publish(AWS_IoT_Client *pClient, const IoT_Publish_Header *pHeader,
+													   IoT_Publish_Message_Params *pParams, Timer *pTimer) {
+	const unsigned char *pPacketHeader;
+	uint32_t len = 0;
+	IoT_Error_t rc;
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	size_t packetLen;
+#endif
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pParams->payload) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	/* Checked before anything is serialized, a vectored write or prepared header never sees the whole length */
+	if(pParams->payloadLen > MQTT_MAX_REMAINING_LENGTH - pHeader->variableHeaderLen) {
+		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+	}
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	packetLen = aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(
+			(uint32_t) (pHeader->variableHeaderLen + pParams->payloadLen));
+
+	/* If the buffer cannot grow the serialization reports MQTT_TX_BUFFER_TOO_SHORT_ERROR.
+	 * send_packet needs the buffer to be larger than the packet. */
+	(void) aws_iot_mqtt_internal_grow_write_buffer(pClient, (NULL != pClient->networkStack.writev)
+															? packetLen - pParams->payloadLen : packetLen + 1);
+#endif
+
+	if(NULL != pClient->networkStack.writev && NULL != pHeader->pSerialized) {
+		/* prepared publish, the packet header is sent from its own buffer */
+		pPacketHeader = aws_iot_mqtt_internal_patch_prepared_publish(pHeader, 0, pParams->id, pParams->payloadLen,
+																	 &len);
+		rc = aws_iot_mqtt_internal_send_packet_with_payload(pClient, pPacketHeader, len,
+															(unsigned char *) pParams->payload,
+															pParams->payloadLen, pTimer);
+	} else if(NULL != pClient->networkStack.writev) {
+		rc = aws_iot_mqtt_internal_serialize_publish_header(pClient->clientData.writeBuf,
+															pClient->clientData.writeBufSize, pHeader, 0,
+															pParams->id, pParams->payloadLen, &len);
+		if(SUCCESS == rc) {
+			rc = aws_iot_mqtt_internal_send_packet_with_payload(pClient, pClient->clientData.writeBuf, len,
+																(unsigned char *) pParams->payload,
+																pParams->payloadLen, pTimer);
+		}
+	} else {
+		rc = _aws_iot_mqtt_internal_serialize_publish(pClient->clientData.writeBuf, pClient->clientData.writeBufSize,
+													  pHeader, 0, pParams->id, (unsigned char *) pParams->payload,
+													  pParams->payloadLen, &len);
+		if(SUCCESS == rc) {
+			rc = aws_iot_mqtt_internal_send_packet(pClient, len, pTimer);
+		}
+	}
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	aws_iot_mqtt_internal_shrink_write_buffer(pClient);
+#endif
+
+	IOT_FUNC_EXIT_RC(rc);
+}
+
 /**
  * @brief Publish an MQTT message on a topic
  *
@@ -184,20 +334,18 @@ IoT_Error_t aws_iot_mqtt_internal_serialize_ack(unsigned char *pTxBuf, size_t tx
  * @note Call is blocking.  In the case of a QoS 0 message the function returns
  * after the message was successfully passed to the TLS layer.  In the case of QoS 1
  * the function returns after the receipt of the PUBACK control packet.
- * This is the internal function which is called by the publish API to perform the operation.
+ * This is the internal function which is called by the publish APIs to perform the operation.
  * Not meant to be called directly as it doesn't do validations or client state changes
  *
  * @param pClient Reference to the IoT Client
- * @param pTopicName Topic Name to publish to
- * @param topicNameLen Length of the topic name
+ * @param pHeader Prepared publish header, with the same QoS as pParams
  * @param pParams Pointer to Publish Message parameters
  *
  * @return An IoT Error Type defining successful/failed publish
  */
-static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const char *pTopicName,
-												  uint16_t topicNameLen, IoT_Publish_Message_Params *pParams) {
+static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const IoT_Publish_Header *pHeader,
+												  IoT_Publish_Message_Params *pParams) {
 	Timer timer;
-	uint32_t len = 0;
 	uint16_t packet_id;
 	unsigned char dup, type;
 	IoT_Error_t rc;
@@ -211,16 +359,8 @@ static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const
 		pParams->id = aws_iot_mqtt_get_next_packet_id(pClient);
 	}
 
-	rc = _aws_iot_mqtt_internal_serialize_publish(pClient->clientData.writeBuf, pClient->clientData.writeBufSize, 0,
-												  pParams->qos, pParams->isRetained, pParams->id, pTopicName,
-												  topicNameLen, (unsigned char *) pParams->payload,
-												  pParams->payloadLen, &len);
-	if(SUCCESS != rc) {
-		IOT_FUNC_EXIT_RC(rc);
-	}
-
 	/* send the publish packet */
-	rc = aws_iot_mqtt_internal_send_packet(pClient, len, &timer);
+	rc = _aws_iot_mqtt_internal_send_publish(pClient, pHeader, pParams, &timer);
 	if(SUCCESS != rc) {
 		IOT_FUNC_EXIT_RC(rc);
 	}
@@ -242,6 +382,49 @@ static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Publish an MQTT message with a prepared header
+ *
+ * Checks the connection and client state and calls the internal publish above.
+ * It is also responsible for client state changes
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pHeader Prepared publish header, with the same QoS as pParams
+ * @param pParams Pointer to Publish Message parameters
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+static IoT_Error_t _aws_iot_mqtt_publish_in_state(AWS_IoT_Client *pClient, const IoT_Publish_Header *pHeader,
+												  IoT_Publish_Message_Params *pParams) {
+	IoT_Error_t rc, pubRc;
+	ClientState clientState;
+
+	IOT_FUNC_ENTRY;
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		IOT_FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
+	}
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if(CLIENT_STATE_CONNECTED_IDLE != clientState && CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN != clientState) {
+		IOT_FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
+	}
+
+	rc = aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	pubRc = _aws_iot_mqtt_internal_publish(pClient, pHeader, pParams);
+
+	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS, clientState);
+	if(SUCCESS == pubRc && SUCCESS != rc) {
+		pubRc = rc;
+	}
+
+	IOT_FUNC_EXIT_RC(pubRc);
+}
+
 /**
  * @brief Publish an MQTT message on a topic
  *
@@ -249,8 +432,7 @@ static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const
  * @note Call is blocking.  In the case of a QoS 0 message the function returns
  * after the message was successfully passed to the TLS layer.  In the case of QoS 1
  * the function returns after the receipt of the PUBACK control packet.
- * This is the outer function which does the validations and calls the internal publish above
- * to perform the actual operation. It is also responsible for client state changes
+ * This is the outer function which does the validations and prepares the header for the publish above.
  *
  * @param pClient Reference to the IoT Client
  * @param pTopicName Topic Name to publish to
@@ -261,6 +443,367 @@ static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const
  */
 IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								 IoT_Publish_Message_Params *pParams) {
+	IoT_Publish_Header header;
+	IoT_Error_t rc;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pTopicName || 0 == topicNameLen || NULL == pParams) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	rc = aws_iot_mqtt_init_publish_header(&header, pTopicName, topicNameLen, pParams->qos, pParams->isRetained);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	rc = _aws_iot_mqtt_publish_in_state(pClient, &header, pParams);
+
+	IOT_FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Prepare the header of messages published repeatedly to the same topic
+ *
+ * @param pHeader Publish header to prepare
+ * @param pTopicName Topic Name to publish to, must stay valid as long as the header is used
+ * @param topicNameLen Length of the topic name
+ * @param qos Quality of Service of the messages, anything but QOS1 is sent as QOS0
+ * @param isRetained Retained flag of the messages
+ *
+ * @return An IoT Error Type defining successful/failed preparation
+ */
+IoT_Error_t aws_iot_mqtt_init_publish_header(IoT_Publish_Header *pHeader, const char *pTopicName,
+											 uint16_t topicNameLen, QoS qos, uint8_t isRetained) {
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pHeader || NULL == pTopicName || 0 == topicNameLen) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	pHeader->pTopicName = pTopicName;
+	pHeader->topicNameLen = topicNameLen;
+	pHeader->qos = (QOS1 == qos) ? QOS1 : QOS0;
+	pHeader->fixedHeader = (QOS1 == qos) ? MQTT_FIXED_HEADER_BYTE(PUBLISH, QOS1, 0, isRetained)
+										 : MQTT_FIXED_HEADER_BYTE(PUBLISH, QOS0, 0, isRetained);
+	/* topic length prefix, topic and the packet id of QoS1 messages */
+	pHeader->variableHeaderLen = (uint32_t) topicNameLen + 2 + ((QOS1 == qos) ? 2 : 0);
+	pHeader->pSerialized = NULL;
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Serialize the packet header of messages published repeatedly to the same topic
+ *
+ * The topic with its length prefix is serialized once after room for the fixed header and the
+ * longest remaining length. Publishing with the header then patches the remaining length in
+ * front of it and the packet id after it.
+ *
+ * @param pHeader Publish header to prepare
+ * @param pBuffer Buffer for the serialized packet header
+ * @param bufferLen Length of the buffer, at least AWS_IOT_MQTT_PREPARED_PUBLISH_LEN(topicNameLen)
+ * @param pTopicName Topic Name to publish to, must stay valid as long as the header is used
+ * @param topicNameLen Length of the topic name
+ * @param pParams Publish Message parameters the QoS and retained flag of the messages are taken from
+ *
+ * @return An IoT Error Type defining successful/failed preparation
+ */
+IoT_Error_t aws_iot_mqtt_prepare_publish(IoT_Publish_Header *pHeader, unsigned char *pBuffer, size_t bufferLen,
+										 const char *pTopicName, uint16_t topicNameLen,
+										 const IoT_Publish_Message_Params *pParams) {
+	unsigned char *ptr;
+	IoT_Error_t rc;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pBuffer || NULL == pParams) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(AWS_IOT_MQTT_PREPARED_PUBLISH_LEN(topicNameLen) > bufferLen) {
+		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+	}
+
+	rc = aws_iot_mqtt_init_publish_header(pHeader, pTopicName, topicNameLen, pParams->qos, pParams->isRetained);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	ptr = pBuffer + PREPARED_PUBLISH_VARIABLE_HEADER_OFFSET;
+	aws_iot_mqtt_internal_write_utf8_string(&ptr, pTopicName, topicNameLen);
+	pHeader->pSerialized = pBuffer;
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Publish an MQTT message with a prepared header
+ *
+ * Called to publish an MQTT message with the topic, QoS and retained flag of a header prepared by
+ * aws_iot_mqtt_init_publish_header or aws_iot_mqtt_prepare_publish.
+ * @note Call is blocking.  In the case of a QoS 0 message the function returns
+ * after the message was successfully passed to the TLS layer.  In the case of QoS 1
+ * the function returns after the receipt of the PUBACK control packet.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pHeader Prepared publish header
+ * @param pPayload Pointer to the message payload
+ * @param payloadLen Length of the message payload
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+IoT_Error_t aws_iot_mqtt_publish_with_header(AWS_IoT_Client *pClient, const IoT_Publish_Header *pHeader,
+											 void *pPayload, size_t payloadLen) {
+	IoT_Publish_Message_Params params = {0};
+	IoT_Error_t rc;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pHeader || NULL == pPayload) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	params.qos = pHeader->qos;
+	params.payload = pPayload;
+	params.payloadLen = payloadLen;
+
+	rc = _aws_iot_mqtt_publish_in_state(pClient, pHeader, &params);
+
+	IOT_FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Find the in-flight entry for a packet id
+ *
+ * Entries are placed at packetId modulo the table size and probe forward on collision.
+ * Packet ids are handed out sequentially, so the home slot almost always matches.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param packetId Packet id to look for, 0 finds a free entry
+ * @param homeId Packet id whose slot the search starts from
+ *
+ * @return Index of the entry or -1 if not found
+ */
+static int32_t _aws_iot_mqtt_find_inflight_publish(AWS_IoT_Client *pClient, uint16_t packetId, uint16_t homeId) {
+	uint32_t i, index;
+
+	for(i = 0; i < AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES; ++i) {
+		index = (homeId + i) % AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES;
+		if(packetId == pClient->clientData.inflightPublishes[index].packetId) {
+			return (int32_t) index;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Remove an in-flight entry and report the result to its completion handler
+ *
+ * The entry is released before the handler runs so the handler can publish again.
+ */
+static void _aws_iot_mqtt_complete_inflight_publish(AWS_IoT_Client *pClient, uint32_t index, IoT_Error_t result) {
+	InflightPublish *pEntry = &(pClient->clientData.inflightPublishes[index]);
+	pPublishCompleteHandler_t pCompleteHandler = pEntry->pCompleteHandler;
+	void *pCompleteHandlerData = pEntry->pCompleteHandlerData;
+	uint16_t packetId = pEntry->packetId;
+
+	pEntry->packetId = 0;
+	pEntry->pCompleteHandler = NULL;
+	pEntry->pCompleteHandlerData = NULL;
+	aws_iot_mqtt_timer_stop(pClient, &(pEntry->ackTimer));
+	pClient->clientData.inflightPublishCount--;
+
+	if(NULL != pCompleteHandler) {
+		pCompleteHandler(pClient, packetId, result, pCompleteHandlerData);
+	}
+}
+
+/**
+ * @brief Complete the in-flight publish a PUBACK was received for
+ *
+ * @param pClient Reference to the IoT Client
+ * @param packetId Packet id carried by the PUBACK
+ *
+ * @return true if the packet id belonged to a message sent with aws_iot_mqtt_publish_async
+ */
+bool aws_iot_mqtt_internal_handle_inflight_puback(AWS_IoT_Client *pClient, uint16_t packetId) {
+	ClientState clientState;
+	int32_t index;
+
+	if(0 == pClient->clientData.inflightPublishCount || 0 == packetId) {
+		return false;
+	}
+
+	index = _aws_iot_mqtt_find_inflight_publish(pClient, packetId, packetId);
+	if(0 > index) {
+		return false;
+	}
+
+	/* Same as message callbacks, allow the handler to call into the client */
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
+	_aws_iot_mqtt_complete_inflight_publish(pClient, (uint32_t) index, SUCCESS);
+	aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+
+	return true;
+}
+
+/**
+ * @brief Timer wheel handler of the in-flight ackTimer, runs with the wheel locked
+ *
+ * Only lists the entry, aws_iot_mqtt_internal_expire_inflight_publishes fails it afterwards.
+ *
+ * @param pEntry ackTimer of the in-flight entry
+ * @param pData Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_inflight_publish_expired(IoT_Timer_Wheel_Entry *pEntry, void *pData) {
+	AWS_IoT_Client *pClient = (AWS_IoT_Client *) pData;
+	InflightPublish *pInflight = (InflightPublish *) ((char *) pEntry - offsetof(InflightPublish, ackTimer));
+
+	/* An entry waiting to be handled is checked again then, even if its timer was restarted */
+	if(!pInflight->isExpired) {
+		pInflight->isExpired = true;
+		pClient->clientData.expiredInflightIndex[pClient->clientData.expiredInflightCount++] =
+				(uint16_t) (pInflight - pClient->clientData.inflightPublishes);
+	}
+}
+
+/**
+ * @brief Fail in-flight publishes whose PUBACK did not arrive within the command timeout
+ *
+ * Handles the entries listed by the timer wheel since the last call, aws_iot_mqtt_run_timers has to run first.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_expire_inflight_publishes(AWS_IoT_Client *pClient) {
+	ClientState clientState;
+	InflightPublish *pInflight;
+	uint16_t i;
+
+	if(0 == pClient->clientData.expiredInflightCount) {
+		return;
+	}
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	while(0 < pClient->clientData.expiredInflightCount) {
+		i = pClient->clientData.expiredInflightIndex[--pClient->clientData.expiredInflightCount];
+		pInflight = &(pClient->clientData.inflightPublishes[i]);
+		pInflight->isExpired = false;
+		/* Completed or reused since it was listed */
+		if(0 == pInflight->packetId || !aws_iot_mqtt_timer_has_expired(pClient, &(pInflight->ackTimer))) {
+			continue;
+		}
+		IOT_WARN("No PUBACK received for packet id %u", (unsigned int) pInflight->packetId);
+		aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
+		_aws_iot_mqtt_complete_inflight_publish(pClient, i, MQTT_REQUEST_TIMEOUT_ERROR);
+		aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+	}
+}
+
+/**
+ * @brief Fail all in-flight publishes, used when the connection is closed
+ *
+ * @param pClient Reference to the IoT Client
+ * @param result Result reported to the completion handlers
+ */
+void aws_iot_mqtt_internal_flush_inflight_publishes(AWS_IoT_Client *pClient, IoT_Error_t result) {
+	uint32_t i;
+
+	for(i = 0; i < AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES && 0 < pClient->clientData.inflightPublishCount; ++i) {
+		if(0 != pClient->clientData.inflightPublishes[i].packetId) {
+			_aws_iot_mqtt_complete_inflight_publish(pClient, i, result);
+		}
+	}
+}
+
+/**
+ * @brief Publish an MQTT message on a topic without waiting for the PUBACK
+ *
+ * This is the internal function which is called by the publish async API to perform the operation.
+ * Not meant to be called directly as it doesn't do validations or client state changes
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters
+ * @param pCompleteHandler Handler called once the outcome of the publish is known
+ * @param pCompleteHandlerData Data to be passed as argument to the completion handler
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_publish_async(AWS_IoT_Client *pClient, const char *pTopicName,
+														uint16_t topicNameLen, IoT_Publish_Message_Params *pParams,
+														pPublishCompleteHandler_t pCompleteHandler,
+														void *pCompleteHandlerData) {
+	IoT_Publish_Header header;
+	Timer timer;
+	int32_t index = -1;
+	IoT_Error_t rc;
+
+	IOT_FUNC_ENTRY;
+
+	rc = aws_iot_mqtt_init_publish_header(&header, pTopicName, topicNameLen, pParams->qos, pParams->isRetained);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	init_timer(&timer);
+	countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
+
+	if(QOS1 == pParams->qos) {
+		/* Skip ids still waiting for a PUBACK after the packet id counter wrapped */
+		do {
+			pParams->id = aws_iot_mqtt_get_next_packet_id(pClient);
+		} while(0 <= _aws_iot_mqtt_find_inflight_publish(pClient, pParams->id, pParams->id));
+
+		index = _aws_iot_mqtt_find_inflight_publish(pClient, 0, pParams->id);
+		if(0 > index) {
+			IOT_FUNC_EXIT_RC(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR);
+		}
+	}
+
+	/* send the publish packet */
+	rc = _aws_iot_mqtt_internal_send_publish(pClient, &header, pParams, &timer);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	if(QOS1 == pParams->qos) {
+		pClient->clientData.inflightPublishes[index].packetId = pParams->id;
+		pClient->clientData.inflightPublishes[index].pCompleteHandler = pCompleteHandler;
+		pClient->clientData.inflightPublishes[index].pCompleteHandlerData = pCompleteHandlerData;
+		aws_iot_mqtt_timer_start(pClient, &(pClient->clientData.inflightPublishes[index].ackTimer),
+								 pClient->clientData.commandTimeoutMs);
+		pClient->clientData.inflightPublishCount++;
+	}
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Publish an MQTT message on a topic without waiting for the PUBACK
+ *
+ * Called to publish an MQTT message on a topic.
+ * @note Call returns after the message was successfully passed to the TLS layer.
+ * For QoS 1 the PUBACK is matched by packet id when it is read, and the completion
+ * handler is called with the result.
+ * This is the outer function which does the validations and calls the internal publish async above
+ * to perform the actual operation. It is also responsible for client state changes
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters
+ * @param pCompleteHandler Handler called once the outcome of the publish is known
+ * @param pCompleteHandlerData Data to be passed as argument to the completion handler
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+IoT_Error_t aws_iot_mqtt_publish_async(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+									   IoT_Publish_Message_Params *pParams, pPublishCompleteHandler_t pCompleteHandler,
+									   void *pCompleteHandlerData) {
 	IoT_Error_t rc, pubRc;
 	ClientState clientState;
 
@@ -274,6 +817,10 @@ IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName
 		IOT_FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
 	}
 
+	if(QOS1 == pParams->qos && AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES <= pClient->clientData.inflightPublishCount) {
+		IOT_FUNC_EXIT_RC(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR);
+	}
+
 	clientState = aws_iot_mqtt_get_client_state(pClient);
 	if(CLIENT_STATE_CONNECTED_IDLE != clientState && CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN != clientState) {
 		IOT_FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
@@ -284,13 +831,19 @@ IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName
 		IOT_FUNC_EXIT_RC(rc);
 	}
 
-	pubRc = _aws_iot_mqtt_internal_publish(pClient, pTopicName, topicNameLen, pParams);
+	pubRc = _aws_iot_mqtt_internal_publish_async(pClient, pTopicName, topicNameLen, pParams, pCompleteHandler,
+												 pCompleteHandlerData);
 
 	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS, clientState);
 	if(SUCCESS == pubRc && SUCCESS != rc) {
 		pubRc = rc;
 	}
 
+	/* Nothing to wait for with QoS0, the message is complete once it is sent */
+	if(SUCCESS == pubRc && QOS0 == pParams->qos && NULL != pCompleteHandler) {
+		pCompleteHandler(pClient, 0, SUCCESS, pCompleteHandlerData);
+	}
+
 	IOT_FUNC_EXIT_RC(pubRc);
 }
 
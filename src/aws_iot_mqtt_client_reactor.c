@@ -0,0 +1,278 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_reactor.c
+ * @brief Event loop that drives many MQTT clients from one thread
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_config.h"
+
+#ifdef _ENABLE_EPOLL_REACTOR_
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "aws_iot_log.h"
+#include "aws_iot_mqtt_client_reactor.h"
+
+/**
+ * @brief Keep the epoll registration in line with the current socket of a client
+ *
+ * The socket changes when the client reconnects. A reconnect can also get the same
+ * descriptor number back after epoll dropped the closed one, so registration is
+ * redone whenever isForced is set.
+ */
+static void _aws_iot_mqtt_reactor_sync_socket(IoT_Reactor *pReactor, uint32_t index, bool isForced) {
+	IoT_Reactor_Client *pEntry = &(pReactor->pClients[index]);
+	Network *pNetwork = &(pEntry->pClient->networkStack);
+	struct epoll_event event;
+	int socket = -1;
+
+	if(NULL == pNetwork->getSocket || SUCCESS != pNetwork->getSocket(pNetwork, &socket)) {
+		socket = -1;
+	}
+
+	if(socket == pEntry->socket && !isForced) {
+		return;
+	}
+
+	if(0 <= pEntry->socket) {
+		/* fails harmlessly if the descriptor was closed, epoll dropped it then */
+		(void) epoll_ctl(pReactor->epollFd, EPOLL_CTL_DEL, pEntry->socket, NULL);
+		pEntry->socket = -1;
+	}
+
+	if(0 <= socket) {
+		event.events = EPOLLIN;
+		event.data.u32 = index;
+		if(0 != epoll_ctl(pReactor->epollFd, EPOLL_CTL_ADD, socket, &event)) {
+			IOT_ERROR("Could not register socket %d with the event loop, errno %d", socket, errno);
+			pEntry->lastRc = MQTT_REACTOR_POLL_ERROR;
+			return;
+		}
+		pEntry->socket = socket;
+	}
+}
+
+/**
+ * @brief Bring the next timer check forward if the client needs it earlier
+ */
+static void _aws_iot_mqtt_reactor_schedule(IoT_Reactor *pReactor, uint32_t timeout_ms) {
+	if(timeout_ms < left_ms(&(pReactor->scanTimer))) {
+		countdown_ms(&(pReactor->scanTimer), timeout_ms);
+	}
+}
+
+/**
+ * @brief Service one client and work out when it needs attention again
+ */
+static void _aws_iot_mqtt_reactor_service(IoT_Reactor *pReactor, uint32_t index, bool isReadable) {
+	IoT_Reactor_Client *pEntry = &(pReactor->pClients[index]);
+	uint32_t timeout_ms;
+
+	pEntry->lastRc = aws_iot_mqtt_service(pEntry->pClient, isReadable);
+	pReactor->serviceCount++;
+
+	_aws_iot_mqtt_reactor_sync_socket(pReactor, index, SUCCESS != pEntry->lastRc);
+
+	timeout_ms = aws_iot_mqtt_get_service_timeout_ms(pEntry->pClient);
+	if(MQTT_CLIENT_NOT_IDLE_ERROR == pEntry->lastRc && 0 == timeout_ms) {
+		/* another thread is using the client, retry shortly instead of spinning */
+		timeout_ms = 1;
+	}
+	_aws_iot_mqtt_reactor_schedule(pReactor, timeout_ms);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_init(IoT_Reactor *pReactor, IoT_Reactor_Client *pClients, uint32_t maxClients) {
+	uint32_t i;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pReactor || NULL == pClients || 0 == maxClients) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	pReactor->epollFd = epoll_create1(0);
+	if(0 > pReactor->epollFd) {
+		IOT_ERROR("Could not create the event loop epoll instance, errno %d", errno);
+		IOT_FUNC_EXIT_RC(MQTT_REACTOR_POLL_ERROR);
+	}
+
+	for(i = 0; i < maxClients; i++) {
+		pClients[i].pClient = NULL;
+		pClients[i].socket = -1;
+		pClients[i].lastRc = SUCCESS;
+	}
+
+	pReactor->pClients = pClients;
+	pReactor->maxClients = maxClients;
+	pReactor->clientCount = 0;
+	pReactor->wakeupCount = 0;
+	pReactor->serviceCount = 0;
+	init_timer(&(pReactor->scanTimer));
+	countdown_ms(&(pReactor->scanTimer), AWS_IOT_MQTT_REACTOR_MAX_SCAN_INTERVAL_MS);
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_add(IoT_Reactor *pReactor, AWS_IoT_Client *pClient) {
+	uint32_t i;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pReactor || NULL == pClient) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(pReactor->clientCount >= pReactor->maxClients) {
+		IOT_FUNC_EXIT_RC(MQTT_REACTOR_FULL_ERROR);
+	}
+
+	for(i = 0; i < pReactor->maxClients; i++) {
+		if(NULL == pReactor->pClients[i].pClient) {
+			break;
+		}
+	}
+
+	pReactor->pClients[i].pClient = pClient;
+	pReactor->pClients[i].socket = -1;
+	pReactor->pClients[i].lastRc = SUCCESS;
+
+	_aws_iot_mqtt_reactor_sync_socket(pReactor, i, true);
+	if(MQTT_REACTOR_POLL_ERROR == pReactor->pClients[i].lastRc) {
+		pReactor->pClients[i].pClient = NULL;
+		IOT_FUNC_EXIT_RC(MQTT_REACTOR_POLL_ERROR);
+	}
+
+	pReactor->clientCount++;
+	_aws_iot_mqtt_reactor_schedule(pReactor, aws_iot_mqtt_get_service_timeout_ms(pClient));
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_remove(IoT_Reactor *pReactor, AWS_IoT_Client *pClient) {
+	uint32_t i;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pReactor || NULL == pClient) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	for(i = 0; i < pReactor->maxClients; i++) {
+		if(pClient == pReactor->pClients[i].pClient) {
+			if(0 <= pReactor->pClients[i].socket) {
+				(void) epoll_ctl(pReactor->epollFd, EPOLL_CTL_DEL, pReactor->pClients[i].socket, NULL);
+			}
+			pReactor->pClients[i].pClient = NULL;
+			pReactor->pClients[i].socket = -1;
+			pReactor->clientCount--;
+			IOT_FUNC_EXIT_RC(SUCCESS);
+		}
+	}
+
+	IOT_FUNC_EXIT_RC(FAILURE);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_run_once(IoT_Reactor *pReactor, uint32_t timeout_ms) {
+	struct epoll_event events[AWS_IOT_MQTT_REACTOR_MAX_EVENTS];
+	uint32_t wait_ms, clientTimeout_ms, index, i;
+	int eventCount, e;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pReactor) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	/* never sleeps past AWS_IOT_MQTT_REACTOR_MAX_SCAN_INTERVAL_MS, so the cast is safe */
+	wait_ms = left_ms(&(pReactor->scanTimer));
+	if(wait_ms > timeout_ms) {
+		wait_ms = timeout_ms;
+	}
+
+	eventCount = epoll_wait(pReactor->epollFd, events, AWS_IOT_MQTT_REACTOR_MAX_EVENTS, (int) wait_ms);
+	if(0 > eventCount) {
+		if(EINTR != errno) {
+			IOT_ERROR("Event loop wait failed, errno %d", errno);
+			IOT_FUNC_EXIT_RC(MQTT_REACTOR_POLL_ERROR);
+		}
+		eventCount = 0;
+	}
+	pReactor->wakeupCount++;
+
+	for(e = 0; e < eventCount; e++) {
+		index = events[e].data.u32;
+		/* a callback may have removed the client since the wait returned */
+		if(index < pReactor->maxClients && NULL != pReactor->pClients[index].pClient) {
+			_aws_iot_mqtt_reactor_service(pReactor, index, true);
+		}
+	}
+
+	/* Timers are checked all at once, only when the earliest one is due or after
+	 * AWS_IOT_MQTT_REACTOR_MAX_SCAN_INTERVAL_MS. Timers started outside the loop,
+	 * an async publish from another thread for example, are picked up this way.
+	 * The clock is read once for the scan, servicing a client does network I/O
+	 * so the batch is closed around it */
+	if(has_timer_expired(&(pReactor->scanTimer))) {
+		begin_timer_batch();
+		countdown_ms(&(pReactor->scanTimer), AWS_IOT_MQTT_REACTOR_MAX_SCAN_INTERVAL_MS);
+		for(i = 0; i < pReactor->maxClients; i++) {
+			if(NULL == pReactor->pClients[i].pClient) {
+				continue;
+			}
+			clientTimeout_ms = aws_iot_mqtt_get_service_timeout_ms(pReactor->pClients[i].pClient);
+			if(0 == clientTimeout_ms) {
+				end_timer_batch();
+				_aws_iot_mqtt_reactor_service(pReactor, i, false);
+				begin_timer_batch();
+			} else {
+				_aws_iot_mqtt_reactor_sync_socket(pReactor, i, false);
+				_aws_iot_mqtt_reactor_schedule(pReactor, clientTimeout_ms);
+			}
+		}
+		end_timer_batch();
+	}
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_destroy(IoT_Reactor *pReactor) {
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pReactor) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(0 <= pReactor->epollFd) {
+		close(pReactor->epollFd);
+		pReactor->epollFd = -1;
+	}
+	pReactor->clientCount = 0;
+
+	IOT_FUNC_EXIT_RC(SUCCESS);
+}
+
+#endif /* _ENABLE_EPOLL_REACTOR_ */
+
+#ifdef __cplusplus
+}
+#endif
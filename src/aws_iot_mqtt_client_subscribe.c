@@ -61,8 +61,6 @@ static IoT_Error_t _aws_iot_mqtt_serialize_subscribe(unsigned char *pTxBuf, size
 													 QoS *pRequestedQoSs, uint32_t *pSerializedLen) {
 	unsigned char *ptr;
 	uint32_t itr, rem_len;
-	IoT_Error_t rc;
-	MQTTHeader header = {0};
 
 	IOT_FUNC_ENTRY;
 	if(NULL == pTxBuf || NULL == pSerializedLen) {
@@ -80,12 +78,8 @@ static IoT_Error_t _aws_iot_mqtt_serialize_subscribe(unsigned char *pTxBuf, size
 		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
 	}
 
-	rc = aws_iot_mqtt_internal_init_header(&header, SUBSCRIBE, QOS1, dup, 0);
-	if(SUCCESS != rc) {
-		IOT_FUNC_EXIT_RC(rc);
-	}
 	/* write header */
-	aws_iot_mqtt_internal_write_char(&ptr, header.byte);
+	aws_iot_mqtt_internal_write_char(&ptr, MQTT_FIXED_HEADER_BYTE(SUBSCRIBE, QOS1, dup, 0));
 
 	/* write remaining length */
 	ptr += aws_iot_mqtt_internal_write_len_to_buffer(ptr, rem_len);
@@ -197,13 +191,15 @@ static uint32_t _aws_iot_mqtt_get_free_message_handler_index(AWS_IoT_Client *pCl
  * @param pTopicName Topic Name to publish to
  * @param topicNameLen Length of the topic name
  * @param pApplicationHandler_t Reference to the handler function for this subscription
+ * @param isPayloadStreamingEnabled Deliver messages larger than the read buffer in chunks
  *
  * @return An IoT Error Type defining successful/failed subscription
  */
 static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, const char *pTopicName,
 													uint16_t topicNameLen, QoS qos,
 													pApplicationHandler_t pApplicationHandler,
-													void *pApplicationHandlerData) {
+													void *pApplicationHandlerData,
+													bool isPayloadStreamingEnabled) {
 	uint16_t txPacketId, rxPacketId;
 	uint32_t serializedLen, indexOfFreeMessageHandler, count;
 	IoT_Error_t rc;
@@ -226,7 +222,8 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
 	}
 
 	indexOfFreeMessageHandler = _aws_iot_mqtt_get_free_message_handler_index(pClient);
-	if(AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS <= indexOfFreeMessageHandler) {
+	if(AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS <= indexOfFreeMessageHandler
+	   || !aws_iot_mqtt_internal_topic_trie_has_room(pClient, pTopicName, topicNameLen)) {
 		IOT_FUNC_EXIT_RC(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR);
 	}
 
@@ -265,6 +262,9 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].pApplicationHandlerData =
 			pApplicationHandlerData;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].qos = qos;
+	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].isPayloadStreamingEnabled =
+			isPayloadStreamingEnabled;
+	aws_iot_mqtt_internal_topic_trie_insert(pClient, (uint16_t) indexOfFreeMessageHandler);
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
@@ -282,11 +282,13 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
  * @param pTopicName Topic Name to publish to
  * @param topicNameLen Length of the topic name
  * @param pApplicationHandler_t Reference to the handler function for this subscription
+ * @param isPayloadStreamingEnabled Deliver messages larger than the read buffer in chunks
  *
  * @return An IoT Error Type defining successful/failed subscription
  */
-IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
-								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData) {
+static IoT_Error_t _aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+										   QoS qos, pApplicationHandler_t pApplicationHandler,
+										   void *pApplicationHandlerData, bool isPayloadStreamingEnabled) {
 	ClientState clientState;
 	IoT_Error_t rc, subRc;
 
@@ -311,7 +313,7 @@ IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicNa
 	}
 
 	subRc = _aws_iot_mqtt_internal_subscribe(pClient, pTopicName, topicNameLen, qos,
-											 pApplicationHandler, pApplicationHandlerData);
+											 pApplicationHandler, pApplicationHandlerData, isPayloadStreamingEnabled);
 
 	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS, clientState);
 	if(SUCCESS == subRc && SUCCESS != rc) {
@@ -321,6 +323,19 @@ IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicNa
 	IOT_FUNC_EXIT_RC(subRc);
 }
 
+IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData) {
+	return _aws_iot_mqtt_subscribe(pClient, pTopicName, topicNameLen, qos, pApplicationHandler,
+								   pApplicationHandlerData, false);
+}
+
+IoT_Error_t aws_iot_mqtt_subscribe_streaming(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+											 QoS qos, pApplicationHandler_t pApplicationHandler,
+											 void *pApplicationHandlerData) {
+	return _aws_iot_mqtt_subscribe(pClient, pTopicName, topicNameLen, qos, pApplicationHandler,
+								   pApplicationHandlerData, true);
+}
+
 /**
  * @brief Subscribe to an MQTT topic.
  *
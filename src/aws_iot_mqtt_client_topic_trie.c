@@ -0,0 +1,442 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_topic_trie.c
+ * @brief MQTT client subscription lookup by topic level
+ *
+ * Subscribed topic filters are split into levels and stored as a tree of
+ * nodes, so matching an incoming topic costs one index lookup per topic level
+ * plus one branch per '+' subscription on the path, independent of the number
+ * of subscriptions. Nodes come from a fixed pool in ClientData and point into
+ * the topic filter strings the application passed to subscribe.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#define TOPIC_TRIE_ROOT 0
+
+static uint32_t _aws_iot_mqtt_topic_trie_hash(uint16_t parent, const char *pLevel, uint16_t levelLen) {
+	/* FNV-1a over the parent index followed by the level text */
+	uint32_t hash = 2166136261u;
+	uint16_t i;
+
+	hash = (hash ^ (parent & 0xFF)) * 16777619u;
+	hash = (hash ^ (parent >> 8)) * 16777619u;
+	for(i = 0; i < levelLen; i++) {
+		hash = (hash ^ (unsigned char) pLevel[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+/* Returns the length of the level starting at pLevel */
+static uint16_t _aws_iot_mqtt_topic_trie_level_len(const char *pLevel, uint16_t remainingLen) {
+	uint16_t len = 0;
+
+	while(len < remainingLen && '/' != pLevel[len]) {
+		len++;
+	}
+
+	return len;
+}
+
+/* Topic filters are also used as C strings, so a filter ends at a NUL within its length */
+static uint16_t _aws_iot_mqtt_topic_trie_filter_len(const char *pTopicFilter, uint16_t topicFilterLen) {
+	uint16_t len = 0;
+
+	while(len < topicFilterLen && '\0' != pTopicFilter[len]) {
+		len++;
+	}
+
+	return len;
+}
+
+static bool _aws_iot_mqtt_topic_trie_is_hash_filter(const char *pTopicFilter, uint16_t topicFilterLen) {
+	if(1 == topicFilterLen) {
+		return '#' == pTopicFilter[0];
+	}
+
+	return 2 <= topicFilterLen && '#' == pTopicFilter[topicFilterLen - 1] && '/' == pTopicFilter[topicFilterLen - 2];
+}
+
+static uint16_t _aws_iot_mqtt_topic_trie_find_child(AWS_IoT_Client *pClient, uint16_t parent, const char *pLevel,
+													uint16_t levelLen) {
+	uint32_t hash, slot, i;
+	uint16_t nodeIndex;
+	TopicTrieNode *pNode;
+
+	hash = _aws_iot_mqtt_topic_trie_hash(parent, pLevel, levelLen);
+	slot = hash % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+
+	for(i = 0; i < AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE; i++) {
+		nodeIndex = pClient->clientData.topicTrieIndex[slot];
+		if(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE == nodeIndex) {
+			break;
+		}
+
+		pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+		if(hash == pNode->hash && parent == pNode->parent && levelLen == pNode->levelLen
+		   && 0 == memcmp(pNode->pLevel, pLevel, levelLen)) {
+			return nodeIndex;
+		}
+
+		slot = (slot + 1) % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+	}
+
+	return AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+}
+
+static void _aws_iot_mqtt_topic_trie_index_add(AWS_IoT_Client *pClient, uint16_t nodeIndex) {
+	uint32_t slot = pClient->clientData.topicTrieNodes[nodeIndex].hash % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+
+	/* The index has twice as many slots as there are nodes, a free slot always exists */
+	while(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE != pClient->clientData.topicTrieIndex[slot]) {
+		slot = (slot + 1) % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+	}
+
+	pClient->clientData.topicTrieIndex[slot] = nodeIndex;
+}
+
+static void _aws_iot_mqtt_topic_trie_index_remove(AWS_IoT_Client *pClient, uint16_t nodeIndex) {
+	uint32_t slot, next, home;
+	uint16_t *pIndex = pClient->clientData.topicTrieIndex;
+
+	slot = pClient->clientData.topicTrieNodes[nodeIndex].hash % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+	while(nodeIndex != pIndex[slot]) {
+		slot = (slot + 1) % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+	}
+	pIndex[slot] = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+
+	/* Shift following entries back so lookups never stop early at the freed slot */
+	next = (slot + 1) % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+	while(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE != pIndex[next]) {
+		home = pClient->clientData.topicTrieNodes[pIndex[next]].hash % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+		if((slot < next) ? (home <= slot || home > next) : (home <= slot && home > next)) {
+			pIndex[slot] = pIndex[next];
+			pIndex[next] = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+			slot = next;
+		}
+		next = (next + 1) % AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE;
+	}
+}
+
+static uint16_t _aws_iot_mqtt_topic_trie_alloc_node(AWS_IoT_Client *pClient, uint16_t parent, const char *pLevel,
+													uint16_t levelLen) {
+	uint16_t nodeIndex = pClient->clientData.topicTrieFreeNode;
+	TopicTrieNode *pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+
+	pClient->clientData.topicTrieFreeNode = pNode->plusChild;
+	pClient->clientData.topicTrieFreeCount--;
+
+	pNode->pLevel = pLevel;
+	pNode->levelLen = levelLen;
+	pNode->hash = _aws_iot_mqtt_topic_trie_hash(parent, pLevel, levelLen);
+	pNode->parent = parent;
+	pNode->plusChild = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pNode->refCount = 0;
+	pNode->firstHandler = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pNode->firstHashHandler = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pClient->clientData.topicTrieNodes[parent].refCount++;
+
+	return nodeIndex;
+}
+
+/* Releases nodes that no longer lead to a subscription, starting at nodeIndex and moving up */
+static void _aws_iot_mqtt_topic_trie_release_nodes(AWS_IoT_Client *pClient, uint16_t nodeIndex) {
+	TopicTrieNode *pNode;
+	uint16_t parent;
+
+	while(TOPIC_TRIE_ROOT != nodeIndex && 0 == pClient->clientData.topicTrieNodes[nodeIndex].refCount) {
+		pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+		parent = pNode->parent;
+
+		if(nodeIndex == pClient->clientData.topicTrieNodes[parent].plusChild) {
+			pClient->clientData.topicTrieNodes[parent].plusChild = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+		} else {
+			_aws_iot_mqtt_topic_trie_index_remove(pClient, nodeIndex);
+		}
+
+		pNode->pLevel = NULL;
+		pNode->plusChild = pClient->clientData.topicTrieFreeNode;
+		pClient->clientData.topicTrieFreeNode = nodeIndex;
+		pClient->clientData.topicTrieFreeCount++;
+
+		pClient->clientData.topicTrieNodes[parent].refCount--;
+		nodeIndex = parent;
+	}
+}
+
+static bool _aws_iot_mqtt_topic_trie_is_on_path(AWS_IoT_Client *pClient, uint16_t handlerIndex, uint16_t nodeIndex) {
+	uint16_t pathNode = pClient->clientData.messageHandlers[handlerIndex].topicTrieNode;
+
+	while(TOPIC_TRIE_ROOT != pathNode) {
+		if(nodeIndex == pathNode) {
+			return true;
+		}
+		pathNode = pClient->clientData.topicTrieNodes[pathNode].parent;
+	}
+
+	return false;
+}
+
+/* Points nodes that still borrow their level text from a removed topic filter at another filter through them */
+static void _aws_iot_mqtt_topic_trie_rebind_levels(AWS_IoT_Client *pClient, uint16_t nodeIndex,
+												   uint16_t removedHandlerIndex) {
+	const char *pRemovedFilter = pClient->clientData.messageHandlers[removedHandlerIndex].topicName;
+	uint16_t removedFilterLen = pClient->clientData.messageHandlers[removedHandlerIndex].topicNameLen;
+	TopicTrieNode *pNode;
+	uint32_t itr;
+
+	while(TOPIC_TRIE_ROOT != nodeIndex) {
+		pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+		if(pNode->pLevel >= pRemovedFilter && pNode->pLevel < pRemovedFilter + removedFilterLen) {
+			for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++itr) {
+				if(itr != removedHandlerIndex && NULL != pClient->clientData.messageHandlers[itr].topicName
+				   && _aws_iot_mqtt_topic_trie_is_on_path(pClient, (uint16_t) itr, nodeIndex)) {
+					/* Both filters share every level up to this node, so the offset is the same */
+					pNode->pLevel = pClient->clientData.messageHandlers[itr].topicName
+									+ (pNode->pLevel - pRemovedFilter);
+					break;
+				}
+			}
+		}
+		nodeIndex = pNode->parent;
+	}
+}
+
+static void _aws_iot_mqtt_topic_trie_mark_handlers(AWS_IoT_Client *pClient, uint16_t handlerIndex,
+												   uint32_t *pMatchedHandlers) {
+	while(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE != handlerIndex) {
+		pMatchedHandlers[handlerIndex / 32] |= ((uint32_t) 1) << (handlerIndex % 32);
+		handlerIndex = pClient->clientData.messageHandlers[handlerIndex].topicTrieNextHandler;
+	}
+}
+
+static void _aws_iot_mqtt_topic_trie_match_from(AWS_IoT_Client *pClient, uint16_t nodeIndex, const char *pTopicName,
+												uint32_t pos, uint16_t topicNameLen, uint32_t *pMatchedHandlers) {
+	TopicTrieNode *pNode;
+	uint16_t levelLen;
+
+	while(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE != nodeIndex) {
+		pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+
+		/* '#' matches the remaining levels, including none */
+		_aws_iot_mqtt_topic_trie_mark_handlers(pClient, pNode->firstHashHandler, pMatchedHandlers);
+
+		if(pos > topicNameLen) {
+			/* All levels of the topic consumed */
+			_aws_iot_mqtt_topic_trie_mark_handlers(pClient, pNode->firstHandler, pMatchedHandlers);
+			return;
+		}
+
+		levelLen = _aws_iot_mqtt_topic_trie_level_len(&pTopicName[pos], (uint16_t) (topicNameLen - pos));
+		if(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE != pNode->plusChild) {
+			_aws_iot_mqtt_topic_trie_match_from(pClient, pNode->plusChild, pTopicName, pos + levelLen + 1,
+												topicNameLen, pMatchedHandlers);
+		}
+
+		nodeIndex = _aws_iot_mqtt_topic_trie_find_child(pClient, nodeIndex, &pTopicName[pos], levelLen);
+		pos += levelLen + 1;
+	}
+}
+
+/**
+ * @brief Reset the topic trie to hold no subscriptions
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_topic_trie_init(AWS_IoT_Client *pClient) {
+	uint32_t i;
+	TopicTrieNode *pRoot = &(pClient->clientData.topicTrieNodes[TOPIC_TRIE_ROOT]);
+
+	for(i = 0; i < AWS_IOT_MQTT_TOPIC_TRIE_INDEX_SIZE; ++i) {
+		pClient->clientData.topicTrieIndex[i] = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	}
+
+	/* Chain the free nodes through plusChild */
+	for(i = TOPIC_TRIE_ROOT + 1; i < AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES; ++i) {
+		pClient->clientData.topicTrieNodes[i].pLevel = NULL;
+		pClient->clientData.topicTrieNodes[i].plusChild = (uint16_t) (i + 1);
+	}
+	pClient->clientData.topicTrieNodes[AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES - 1].plusChild =
+			AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pClient->clientData.topicTrieFreeNode = TOPIC_TRIE_ROOT + 1;
+	pClient->clientData.topicTrieFreeCount = AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES - 1;
+
+	pRoot->pLevel = NULL;
+	pRoot->levelLen = 0;
+	pRoot->hash = 0;
+	pRoot->parent = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pRoot->plusChild = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pRoot->refCount = 0;
+	pRoot->firstHandler = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pRoot->firstHashHandler = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+}
+
+/**
+ * @brief Check the topic trie has enough free nodes to add a topic filter
+ *
+ * Counts every level as new, so a filter that shares levels with existing
+ * subscriptions may be refused while the pool is nearly full.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicFilter Topic filter to be added
+ * @param topicFilterLen Length of the topic filter
+ *
+ * @return true if the filter can be added
+ */
+bool aws_iot_mqtt_internal_topic_trie_has_room(AWS_IoT_Client *pClient, const char *pTopicFilter,
+											   uint16_t topicFilterLen) {
+	uint32_t levels = 1;
+	uint16_t i;
+
+	topicFilterLen = _aws_iot_mqtt_topic_trie_filter_len(pTopicFilter, topicFilterLen);
+	for(i = 0; i < topicFilterLen; i++) {
+		if('/' == pTopicFilter[i]) {
+			levels++;
+		}
+	}
+
+	if(_aws_iot_mqtt_topic_trie_is_hash_filter(pTopicFilter, topicFilterLen)) {
+		/* '#' is attached to the node before it */
+		levels--;
+	}
+
+	return levels <= pClient->clientData.topicTrieFreeCount;
+}
+
+/**
+ * @brief Add the topic filter of a message handler to the topic trie
+ *
+ * The filter is stored in the handler entry before this is called.
+ * aws_iot_mqtt_internal_topic_trie_has_room must have returned true for the filter.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param handlerIndex Index of the handler in messageHandlers
+ */
+void aws_iot_mqtt_internal_topic_trie_insert(AWS_IoT_Client *pClient, uint16_t handlerIndex) {
+	MessageHandlers *pHandler = &(pClient->clientData.messageHandlers[handlerIndex]);
+	const char *pTopicFilter = pHandler->topicName;
+	uint16_t topicFilterLen = _aws_iot_mqtt_topic_trie_filter_len(pTopicFilter, pHandler->topicNameLen);
+	bool isHashFilter = _aws_iot_mqtt_topic_trie_is_hash_filter(pTopicFilter, topicFilterLen);
+	bool hasLevels = true;
+	uint16_t nodeIndex = TOPIC_TRIE_ROOT;
+	uint16_t childIndex, levelLen;
+	uint32_t pos = 0;
+	TopicTrieNode *pNode;
+
+	if(isHashFilter) {
+		/* Only the levels before the trailing '#' get nodes */
+		hasLevels = (1 < topicFilterLen);
+		topicFilterLen = (uint16_t) (hasLevels ? topicFilterLen - 2 : 0);
+	}
+
+	while(hasLevels && pos <= topicFilterLen) {
+		levelLen = _aws_iot_mqtt_topic_trie_level_len(&pTopicFilter[pos], (uint16_t) (topicFilterLen - pos));
+		pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+
+		if(1 == levelLen && '+' == pTopicFilter[pos]) {
+			childIndex = pNode->plusChild;
+			if(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE == childIndex) {
+				childIndex = _aws_iot_mqtt_topic_trie_alloc_node(pClient, nodeIndex, &pTopicFilter[pos], levelLen);
+				pNode->plusChild = childIndex;
+			}
+		} else {
+			childIndex = _aws_iot_mqtt_topic_trie_find_child(pClient, nodeIndex, &pTopicFilter[pos], levelLen);
+			if(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE == childIndex) {
+				childIndex = _aws_iot_mqtt_topic_trie_alloc_node(pClient, nodeIndex, &pTopicFilter[pos], levelLen);
+				_aws_iot_mqtt_topic_trie_index_add(pClient, childIndex);
+			}
+		}
+
+		nodeIndex = childIndex;
+		pos += levelLen + 1;
+	}
+
+	pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+	pHandler->topicTrieNode = nodeIndex;
+	if(isHashFilter) {
+		pHandler->topicTrieNextHandler = pNode->firstHashHandler;
+		pNode->firstHashHandler = handlerIndex;
+	} else {
+		pHandler->topicTrieNextHandler = pNode->firstHandler;
+		pNode->firstHandler = handlerIndex;
+	}
+	pNode->refCount++;
+}
+
+/**
+ * @brief Remove the topic filter of a message handler from the topic trie
+ *
+ * Called before the handler entry is cleared.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param handlerIndex Index of the handler in messageHandlers
+ */
+void aws_iot_mqtt_internal_topic_trie_remove(AWS_IoT_Client *pClient, uint16_t handlerIndex) {
+	MessageHandlers *pHandler = &(pClient->clientData.messageHandlers[handlerIndex]);
+	uint16_t nodeIndex = pHandler->topicTrieNode;
+	TopicTrieNode *pNode = &(pClient->clientData.topicTrieNodes[nodeIndex]);
+	uint16_t *pLink;
+
+	if(_aws_iot_mqtt_topic_trie_is_hash_filter(pHandler->topicName,
+											   _aws_iot_mqtt_topic_trie_filter_len(pHandler->topicName,
+																				   pHandler->topicNameLen))) {
+		pLink = &(pNode->firstHashHandler);
+	} else {
+		pLink = &(pNode->firstHandler);
+	}
+
+	while(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE != *pLink && handlerIndex != *pLink) {
+		pLink = &(pClient->clientData.messageHandlers[*pLink].topicTrieNextHandler);
+	}
+	if(AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE == *pLink) {
+		/* Not in the trie */
+		return;
+	}
+	*pLink = pHandler->topicTrieNextHandler;
+	pHandler->topicTrieNextHandler = AWS_IOT_MQTT_TOPIC_TRIE_NO_NODE;
+	pNode->refCount--;
+
+	_aws_iot_mqtt_topic_trie_release_nodes(pClient, nodeIndex);
+
+	/* Find the deepest node of this filter that is still in use */
+	while(TOPIC_TRIE_ROOT != nodeIndex && NULL == pClient->clientData.topicTrieNodes[nodeIndex].pLevel) {
+		nodeIndex = pClient->clientData.topicTrieNodes[nodeIndex].parent;
+	}
+	_aws_iot_mqtt_topic_trie_rebind_levels(pClient, nodeIndex, handlerIndex);
+}
+
+/**
+ * @brief Find the message handlers subscribed to a topic
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic name of the received message
+ * @param topicNameLen Length of the topic name
+ * @param pMatchedHandlers Bit set of messageHandlers indexes, the bits of the matching handlers are set
+ */
+void aws_iot_mqtt_internal_topic_trie_match(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+											uint32_t *pMatchedHandlers) {
+	_aws_iot_mqtt_topic_trie_match_from(pClient, TOPIC_TRIE_ROOT, pTopicName, 0, topicNameLen, pMatchedHandlers);
+}
+
+#ifdef __cplusplus
+}
+#endif
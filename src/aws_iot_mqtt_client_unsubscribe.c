@@ -60,8 +60,6 @@ static IoT_Error_t _aws_iot_mqtt_serialize_unsubscribe(unsigned char *pTxBuf, si
 	unsigned char *ptr = pTxBuf;
 	uint32_t i = 0;
 	uint32_t rem_len = 2; /* packetId */
-	IoT_Error_t rc;
-	MQTTHeader header = {0};
 
 	IOT_FUNC_ENTRY;
 
@@ -73,11 +71,7 @@ static IoT_Error_t _aws_iot_mqtt_serialize_unsubscribe(unsigned char *pTxBuf, si
 		IOT_FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
 	}
 
-	rc = aws_iot_mqtt_internal_init_header(&header, UNSUBSCRIBE, QOS1, dup, 0);
-	if(SUCCESS != rc) {
-		IOT_FUNC_EXIT_RC(rc);
-	}
-	aws_iot_mqtt_internal_write_char(&ptr, header.byte); /* write header */
+	aws_iot_mqtt_internal_write_char(&ptr, MQTT_FIXED_HEADER_BYTE(UNSUBSCRIBE, QOS1, dup, 0)); /* write header */
 
 	ptr += aws_iot_mqtt_internal_write_len_to_buffer(ptr, rem_len); /* write remaining length */
 
@@ -186,6 +180,7 @@ static IoT_Error_t _aws_iot_mqtt_internal_unsubscribe(AWS_IoT_Client *pClient, c
 	for(i = 0; i < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++i) {
 		if(pClient->clientData.messageHandlers[i].topicName != NULL &&
 		   (strcmp(pClient->clientData.messageHandlers[i].topicName, pTopicFilter) == 0)) {
+			aws_iot_mqtt_internal_topic_trie_remove(pClient, (uint16_t) i);
 			pClient->clientData.messageHandlers[i].topicName = NULL;
 			/* We don't want to break here, in case the same topic is registered
              * with 2 callbacks. Unlikely scenario */
@@ -48,6 +48,7 @@ static void _aws_iot_mqtt_force_client_disconnect(AWS_IoT_Client *pClient) {
 	pClient->clientStatus.clientState = CLIENT_STATE_DISCONNECTED_ERROR;
 	pClient->networkStack.disconnect(&(pClient->networkStack));
 	pClient->networkStack.destroy(&(pClient->networkStack));
+	aws_iot_mqtt_internal_flush_inflight_publishes(pClient, NETWORK_DISCONNECTED_ERROR);
 }
 
 static IoT_Error_t _aws_iot_mqtt_handle_disconnect(AWS_IoT_Client *pClient) {
@@ -76,7 +77,9 @@ static IoT_Error_t _aws_iot_mqtt_handle_reconnect(AWS_IoT_Client *pClient) {
 
 	IOT_FUNC_ENTRY;
 
-	if(!has_timer_expired(&(pClient->reconnectDelayTimer))) {
+	/* A handshake that waits for the socket is resumed right away, the timer only paces new attempts */
+	if(!aws_iot_mqtt_timer_has_expired(pClient, &(pClient->reconnectDelayTimer))
+	   && !pClient->clientStatus.isNetworkConnectInProgress) {
 		/* Timer has not expired. Not time to attempt reconnect yet.
 		 * Return attempting reconnect */
 		IOT_FUNC_EXIT_RC(NETWORK_ATTEMPTING_RECONNECT);
@@ -90,6 +93,7 @@ static IoT_Error_t _aws_iot_mqtt_handle_reconnect(AWS_IoT_Client *pClient) {
 	if(NETWORK_PHYSICAL_LAYER_CONNECTED == rc) {
 		rc = aws_iot_mqtt_attempt_reconnect(pClient);
 		if(NETWORK_RECONNECTED == rc) {
+			aws_iot_mqtt_timer_stop(pClient, &(pClient->reconnectDelayTimer));
 			rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_IDLE,
 											   CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS);
 			if(SUCCESS != rc) {
@@ -97,6 +101,10 @@ static IoT_Error_t _aws_iot_mqtt_handle_reconnect(AWS_IoT_Client *pClient) {
 			}
 			IOT_FUNC_EXIT_RC(NETWORK_RECONNECTED);
 		}
+		if(NETWORK_SSL_WANT_READ == rc || NETWORK_SSL_WANT_WRITE == rc) {
+			/* Still backs off, so a handshake that never progresses runs into the reconnect time out */
+			rc = NETWORK_ATTEMPTING_RECONNECT;
+		}
 	}
 
 	pClient->clientData.currentReconnectWaitInterval *= 2;
@@ -104,7 +112,7 @@ static IoT_Error_t _aws_iot_mqtt_handle_reconnect(AWS_IoT_Client *pClient) {
 	if(AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL < pClient->clientData.currentReconnectWaitInterval) {
 		IOT_FUNC_EXIT_RC(NETWORK_RECONNECT_TIMED_OUT_ERROR);
 	}
-	countdown_ms(&(pClient->reconnectDelayTimer), pClient->clientData.currentReconnectWaitInterval);
+	aws_iot_mqtt_timer_start(pClient, &(pClient->reconnectDelayTimer), pClient->clientData.currentReconnectWaitInterval);
 	IOT_FUNC_EXIT_RC(rc);
 }
 
@@ -123,7 +131,7 @@ static IoT_Error_t _aws_iot_mqtt_keep_alive(AWS_IoT_Client *pClient) {
 		IOT_FUNC_EXIT_RC(SUCCESS);
 	}
 
-	if(!has_timer_expired(&pClient->pingTimer)) {
+	if(!aws_iot_mqtt_timer_has_expired(pClient, &(pClient->pingTimer))) {
 		IOT_FUNC_EXIT_RC(SUCCESS);
 	}
 
@@ -153,11 +161,103 @@ static IoT_Error_t _aws_iot_mqtt_keep_alive(AWS_IoT_Client *pClient) {
 
 	pClient->clientStatus.isPingOutstanding = true;
 	/* start a timer to wait for PINGRESP from server */
-	countdown_sec(&pClient->pingTimer, pClient->clientData.keepAliveInterval);
+	aws_iot_mqtt_timer_start(pClient, &(pClient->pingTimer), pClient->clientData.keepAliveInterval * 1000);
 
 	IOT_FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Check whether received data is waiting in the read buffer
+ *
+ * Packets that arrived together with the last one are framed out of the read buffer
+ * without touching the network, so they do not make the socket readable again.
+ * A full buffer may also mean the network layer holds more decrypted data.
+ */
+static bool _aws_iot_mqtt_internal_has_buffered_data(AWS_IoT_Client *pClient) {
+	ClientData *pData = &(pClient->clientData);
+
+	/* Only data following a packet that was just handled counts. A partial packet left behind by
+	 * a non-blocking read needs the socket to become readable again */
+	return 0 < pData->readBufPacketLen
+		   && (pData->readBufDataLen > pData->readBufPacketLen || pData->readBufDataLen == pData->readBufSize);
+}
+
+/**
+ * @brief Do one round of the work due for the client
+ *
+ * One pass of the yield loop: attempt a reconnect when one is pending, otherwise read at
+ * most one packet and handle keepalive and in-flight publish timeouts.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTimer Timer for the network operations
+ * @param isReadable Read from the network. If false only data already buffered is processed
+ * @param pIsDone Set when the caller should stop, the returned code is final
+ *
+ * @return An IoT Error Type defining successful/failed client processing
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_yield_once(AWS_IoT_Client *pClient, Timer *pTimer, bool isReadable,
+													 bool *pIsDone) {
+	IoT_Error_t yieldRc = SUCCESS;
+	uint8_t packet_type;
+	ClientState clientState;
+
+	*pIsDone = false;
+
+	aws_iot_mqtt_run_timers(pClient);
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if(CLIENT_STATE_PENDING_RECONNECT == clientState) {
+		if(AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL < pClient->clientData.currentReconnectWaitInterval) {
+			*pIsDone = true;
+			return NETWORK_RECONNECT_TIMED_OUT_ERROR;
+		}
+		/* Network reconnect attempted, the caller checks its timer before doing anything else */
+		return _aws_iot_mqtt_handle_reconnect(pClient);
+	}
+
+	if(isReadable || _aws_iot_mqtt_internal_has_buffered_data(pClient)) {
+		yieldRc = aws_iot_mqtt_internal_cycle_read(pClient, pTimer, &packet_type);
+	}
+	if(SUCCESS == yieldRc) {
+		aws_iot_mqtt_internal_expire_inflight_publishes(pClient);
+		yieldRc = _aws_iot_mqtt_keep_alive(pClient);
+	} else {
+		// SSL read and write errors are terminal, connection must be closed and retried
+		if(NETWORK_SSL_READ_ERROR == yieldRc || NETWORK_SSL_READ_TIMEOUT_ERROR == yieldRc
+			|| NETWORK_SSL_WRITE_ERROR == yieldRc || NETWORK_SSL_WRITE_TIMEOUT_ERROR == yieldRc) {
+			yieldRc = _aws_iot_mqtt_handle_disconnect(pClient);
+		}
+	}
+
+	if(NETWORK_DISCONNECTED_ERROR == yieldRc) {
+		pClient->clientData.counterNetworkDisconnected++;
+		countdown_ms(&(pClient->reconnectLatencyTimer), AWS_IOT_MQTT_RECONNECT_LATENCY_TIMER_MS);
+		pClient->clientStatus.isReconnectLatencyTimed = true;
+		aws_iot_mqtt_internal_flush_inflight_publishes(pClient, NETWORK_DISCONNECTED_ERROR);
+		if(1 == pClient->clientStatus.isAutoReconnectEnabled) {
+			yieldRc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_DISCONNECTED_ERROR,
+													CLIENT_STATE_PENDING_RECONNECT);
+			if(SUCCESS != yieldRc) {
+				*pIsDone = true;
+				return yieldRc;
+			}
+
+			pClient->clientData.currentReconnectWaitInterval = AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL;
+			aws_iot_mqtt_timer_start(pClient, &(pClient->reconnectDelayTimer), pClient->clientData.currentReconnectWaitInterval);
+			/* Depending on timer values, it is possible that yield timer has expired
+			 * Set to rc to attempting reconnect to inform client that autoreconnect
+			 * attempt has started */
+			yieldRc = NETWORK_ATTEMPTING_RECONNECT;
+		} else {
+			*pIsDone = true;
+		}
+	} else if(SUCCESS != yieldRc) {
+		*pIsDone = true;
+	}
+
+	return yieldRc;
+}
+
 /**
  * @brief Yield to the MQTT client
  *
@@ -179,9 +279,7 @@ static IoT_Error_t _aws_iot_mqtt_keep_alive(AWS_IoT_Client *pClient) {
  */
 static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms) {
 	IoT_Error_t yieldRc = SUCCESS;
-
-	uint8_t packet_type;
-	ClientState clientState;
+	bool isDone = false;
 	Timer timer;
 	init_timer(&timer);
 	countdown_ms(&timer, timeout_ms);
@@ -190,53 +288,63 @@ static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_
 
 	// evaluate timeout at the end of the loop to make sure the actual yield runs at least once
 	do {
-		clientState = aws_iot_mqtt_get_client_state(pClient);
-		if(CLIENT_STATE_PENDING_RECONNECT == clientState) {
-			if(AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL < pClient->clientData.currentReconnectWaitInterval) {
-				yieldRc = NETWORK_RECONNECT_TIMED_OUT_ERROR;
-				break;
-			}
-			yieldRc = _aws_iot_mqtt_handle_reconnect(pClient);
-			/* Network reconnect attempted, check if yield timer expired before
-			 * doing anything else */
-			continue;
+		yieldRc = _aws_iot_mqtt_internal_yield_once(pClient, &timer, true, &isDone);
+	} while(!isDone && !has_timer_expired(&timer));
+
+	IOT_FUNC_EXIT_RC(yieldRc);
+}
+
+/**
+ * @brief Validate the client state and mark a yield as in progress
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return SUCCESS if the yield work can proceed, the error to return from the yield otherwise
+ */
+static IoT_Error_t _aws_iot_mqtt_yield_begin(AWS_IoT_Client *pClient) {
+	ClientState clientState;
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	/* Check if network was manually disconnected */
+	if(CLIENT_STATE_DISCONNECTED_MANUALLY == clientState) {
+		return NETWORK_MANUALLY_DISCONNECTED;
+	}
+
+	/* If we are in the pending reconnect state, skip other checks.
+	 * Pending reconnect state is only set when auto-reconnect is enabled */
+	if(CLIENT_STATE_PENDING_RECONNECT != clientState) {
+		/* Check if network is disconnected and auto-reconnect is not enabled */
+		if(!aws_iot_mqtt_is_client_connected(pClient)) {
+			return NETWORK_DISCONNECTED_ERROR;
 		}
 
-		yieldRc = aws_iot_mqtt_internal_cycle_read(pClient, &timer, &packet_type);
-		if(SUCCESS == yieldRc) {
-			yieldRc = _aws_iot_mqtt_keep_alive(pClient);
-		} else {
-			// SSL read and write errors are terminal, connection must be closed and retried
-			if(NETWORK_SSL_READ_ERROR == yieldRc || NETWORK_SSL_READ_TIMEOUT_ERROR == yieldRc
-				|| NETWORK_SSL_WRITE_ERROR == yieldRc || NETWORK_SSL_WRITE_TIMEOUT_ERROR == yieldRc) {
-				yieldRc = _aws_iot_mqtt_handle_disconnect(pClient);
-			}
+		/* Check if client is idle, if not another operation is in progress and we should return */
+		if(CLIENT_STATE_CONNECTED_IDLE != clientState) {
+			return MQTT_CLIENT_NOT_IDLE_ERROR;
 		}
 
-		if(NETWORK_DISCONNECTED_ERROR == yieldRc) {
-			pClient->clientData.counterNetworkDisconnected++;
-			if(1 == pClient->clientStatus.isAutoReconnectEnabled) {
-				yieldRc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_DISCONNECTED_ERROR,
-														CLIENT_STATE_PENDING_RECONNECT);
-				if(SUCCESS != yieldRc) {
-					IOT_FUNC_EXIT_RC(yieldRc);
-				}
-
-				pClient->clientData.currentReconnectWaitInterval = AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL;
-				countdown_ms(&(pClient->reconnectDelayTimer), pClient->clientData.currentReconnectWaitInterval);
-				/* Depending on timer values, it is possible that yield timer has expired
-				 * Set to rc to attempting reconnect to inform client that autoreconnect
-				 * attempt has started */
-				yieldRc = NETWORK_ATTEMPTING_RECONNECT;
-			} else {
-				break;
-			}
-		} else if(SUCCESS != yieldRc) {
-			break;
+		return aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_IDLE,
+											 CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS);
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Return the client to idle after the yield work, unless the connection was lost
+ */
+static IoT_Error_t _aws_iot_mqtt_yield_end(AWS_IoT_Client *pClient, IoT_Error_t yieldRc) {
+	IoT_Error_t rc;
+
+	if(NETWORK_DISCONNECTED_ERROR != yieldRc && NETWORK_ATTEMPTING_RECONNECT != yieldRc) {
+		rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS,
+										   CLIENT_STATE_CONNECTED_IDLE);
+		if(SUCCESS == yieldRc && SUCCESS != rc) {
+			yieldRc = rc;
 		}
-	} while(!has_timer_expired(&timer));
+	}
 
-	IOT_FUNC_EXIT_RC(yieldRc);
+	return yieldRc;
 }
 
 /**
@@ -260,51 +368,103 @@ static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_
  */
 IoT_Error_t aws_iot_mqtt_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms) {
 	IoT_Error_t rc, yieldRc;
-	ClientState clientState;
 
 	if(NULL == pClient || 0 == timeout_ms) {
 		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	clientState = aws_iot_mqtt_get_client_state(pClient);
-	/* Check if network was manually disconnected */
-	if(CLIENT_STATE_DISCONNECTED_MANUALLY == clientState) {
-		IOT_FUNC_EXIT_RC(NETWORK_MANUALLY_DISCONNECTED);
+	rc = _aws_iot_mqtt_yield_begin(pClient);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
 	}
 
-	/* If we are in the pending reconnect state, skip other checks.
-	 * Pending reconnect state is only set when auto-reconnect is enabled */
-	if(CLIENT_STATE_PENDING_RECONNECT != clientState) {
-		/* Check if network is disconnected and auto-reconnect is not enabled */
-		if(!aws_iot_mqtt_is_client_connected(pClient)) {
-			IOT_FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
-		}
+	yieldRc = _aws_iot_mqtt_internal_yield(pClient, timeout_ms);
 
-		/* Check if client is idle, if not another operation is in progress and we should return */
-		if(CLIENT_STATE_CONNECTED_IDLE != clientState) {
-			IOT_FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
-		}
+	yieldRc = _aws_iot_mqtt_yield_end(pClient, yieldRc);
 
-		rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_IDLE,
-										   CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS);
-		if(SUCCESS != rc) {
-			IOT_FUNC_EXIT_RC(rc);
-		}
-	}
+	IOT_FUNC_EXIT_RC(yieldRc);
+}
 
-	yieldRc = _aws_iot_mqtt_internal_yield(pClient, timeout_ms);
+/**
+ * @brief Do the work that is due for the client without waiting
+ *
+ * Called by event loops that wait on many clients at once. The loop calls this when the
+ * socket of the client is readable or when the time given by aws_iot_mqtt_get_service_timeout_ms
+ * has passed. Everything that has arrived is processed, keepalive, reconnect and in-flight
+ * publish timers are handled, then the call returns.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param isReadable The socket of the client is readable
+ *
+ * @return An IoT Error Type defining successful/failed client processing, same as for yield.
+ */
+IoT_Error_t aws_iot_mqtt_service(AWS_IoT_Client *pClient, bool isReadable) {
+	IoT_Error_t rc, yieldRc;
+	bool isDone = false;
+	Timer timer;
 
-	if(NETWORK_DISCONNECTED_ERROR != yieldRc && NETWORK_ATTEMPTING_RECONNECT != yieldRc) {
-		rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS,
-										   CLIENT_STATE_CONNECTED_IDLE);
-		if(SUCCESS == yieldRc && SUCCESS != rc) {
-			yieldRc = rc;
-		}
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
+	rc = _aws_iot_mqtt_yield_begin(pClient);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	/* bounds network operations only, the loop stops once nothing is buffered */
+	init_timer(&timer);
+	countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
+
+	do {
+		yieldRc = _aws_iot_mqtt_internal_yield_once(pClient, &timer, isReadable, &isDone);
+		/* the socket has been drained by the first read, whatever is left is buffered */
+		isReadable = false;
+	} while(SUCCESS == yieldRc && !isDone && _aws_iot_mqtt_internal_has_buffered_data(pClient));
+
+	yieldRc = _aws_iot_mqtt_yield_end(pClient, yieldRc);
+
 	IOT_FUNC_EXIT_RC(yieldRc);
 }
 
+/**
+ * @brief Time until the client has timer driven work to do
+ *
+ * Covers every deadline on the timer wheel of the client, the keepalive ping, a pending
+ * reconnect attempt and the acknowledgement timeouts of in-flight publishes and shadow actions.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return Milliseconds until aws_iot_mqtt_service should be called even if no data
+ *         arrives, 0 if it is due now, UINT32_MAX if there is nothing to wait for.
+ */
+uint32_t aws_iot_mqtt_get_service_timeout_ms(AWS_IoT_Client *pClient) {
+	ClientState clientState;
+
+	if(NULL == pClient) {
+		return UINT32_MAX;
+	}
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if(CLIENT_STATE_PENDING_RECONNECT == clientState) {
+		return aws_iot_mqtt_timer_left_ms(pClient, &(pClient->reconnectDelayTimer));
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		return UINT32_MAX;
+	}
+
+	/* A keepalive deadline already taken off the wheel still has its ping to send */
+	if(0 != pClient->clientData.keepAliveInterval
+	   && aws_iot_mqtt_timer_has_expired(pClient, &(pClient->pingTimer))) {
+		return 0;
+	}
+
+	return aws_iot_mqtt_get_next_timer_ms(pClient);
+}
+
 #ifdef __cplusplus
 }
 #endif
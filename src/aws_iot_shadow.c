@@ -33,28 +33,43 @@ extern "C" {
 #include "aws_iot_shadow_records.h"
 
 const ShadowInitParameters_t ShadowInitParametersDefault = {(char *) AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, NULL, NULL,
-															NULL, false, NULL};
+															NULL, false, NULL, NULL, NULL};
 
-const ShadowConnectParameters_t ShadowConnectParametersDefault = {0, "", "", 0};
+const ShadowConnectParameters_t ShadowConnectParametersDefault = {0, "", "", 0, NULL, false};
+
+const ShadowUpdateQueueParameters_t ShadowUpdateQueueParametersDefault = {1000, 0, 1, 1000, NULL, NULL, 4, true};
 
 void aws_iot_shadow_reset_last_received_version(void) {
-	shadowJsonVersionNum = 0;
+	getDefaultShadowClient()->jsonVersionNum = 0;
 }
 
 uint32_t aws_iot_shadow_get_last_received_version(void) {
-	return shadowJsonVersionNum;
+	return getDefaultShadowClient()->jsonVersionNum;
 }
 
 void aws_iot_shadow_enable_discard_old_delta_msgs(void) {
-	shadowDiscardOldDeltaFlag = true;
+	getDefaultShadowClient()->isDiscardOldDeltaEnabled = true;
 }
 
 void aws_iot_shadow_disable_discard_old_delta_msgs(void) {
-	shadowDiscardOldDeltaFlag = false;
+	getDefaultShadowClient()->isDiscardOldDeltaEnabled = false;
+}
+
+void aws_iot_shadow_reset_client_last_received_version(AWS_IoT_Client *pClient) {
+	getShadowClient(pClient)->jsonVersionNum = 0;
+}
+
+uint32_t aws_iot_shadow_get_client_last_received_version(AWS_IoT_Client *pClient) {
+	return getShadowClient(pClient)->jsonVersionNum;
+}
+
+void aws_iot_shadow_set_client_discard_old_delta_msgs(AWS_IoT_Client *pClient, bool isDiscardEnabled) {
+	getShadowClient(pClient)->isDiscardOldDeltaEnabled = isDiscardEnabled;
 }
 
 IoT_Error_t aws_iot_shadow_init(AWS_IoT_Client *pClient, ShadowInitParameters_t *pParams) {
 	IoT_Error_t rc;
+	ShadowClient *pShadow;
 
 	IOT_FUNC_ENTRY;
 
@@ -80,17 +95,32 @@ IoT_Error_t aws_iot_shadow_init(AWS_IoT_Client *pClient, ShadowInitParameters_t
 		IOT_FUNC_EXIT_RC(rc);
 	}
 
-	resetClientTokenSequenceNum();
-	aws_iot_shadow_reset_last_received_version();
-	initDeltaTokens();
+	pShadow = (NULL != pParams->pShadowClient) ? pParams->pShadowClient : getDefaultShadowClient();
+	pClient->pShadowClient = pShadow;
+	pShadow->pMqttClient = NULL;
+	pShadow->jsonVersionNum = 0;
+	pShadow->isDiscardOldDeltaEnabled = true;
+	pShadow->pReportCaches = NULL;
+	pShadow->pUpdateQueues = NULL;
+	initDeltaTokens(pShadow);
+
+	/* Every session numbers its own client tokens, they start with its client id once it connects */
+	pShadow->mqttClientID[0] = '\0';
+	pShadow->clientTokenNum = 0;
+#ifdef _ENABLE_THREAD_SUPPORT_
+	rc = aws_iot_thread_mutex_init(&(pShadow->clientTokenLock));
+#endif
 
-	IOT_FUNC_EXIT_RC(SUCCESS);
+	IOT_FUNC_EXIT_RC(rc);
 }
 
 IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParameters_t *pParams) {
 	IoT_Error_t rc = SUCCESS;
 	char deleteAcceptedTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	uint16_t deleteAcceptedTopicLen;
+	const ShadowActions_t ackActions[] = {SHADOW_GET, SHADOW_UPDATE};
+	uint32_t i;
+	ShadowClient *pShadow;
 
 	IOT_FUNC_ENTRY;
 
@@ -98,8 +128,9 @@ IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParamet
 		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	snprintf(myThingName, MAX_SIZE_OF_THING_NAME, "%s", pParams->pMyThingName);
-	snprintf(mqttClientID, MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES, "%s", pParams->pMqttClientId);
+	pShadow = getShadowClient(pClient);
+	snprintf(pShadow->myThingName, MAX_SIZE_OF_THING_NAME, "%s", pParams->pMyThingName);
+	snprintf(pShadow->mqttClientID, MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES, "%s", pParams->pMqttClientId);
 
 	IoT_Client_Connect_Params ConnectParams = iotClientConnectParamsDefault;
 	ConnectParams.keepAliveIntervalInSec = pParams->keepAliveIntervalInSec;
@@ -114,15 +145,24 @@ IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParamet
 	rc = aws_iot_mqtt_connect(pClient, &ConnectParams);
 
 	if(SUCCESS == rc) {
-		initializeRecords(pClient);
+		initializeRecords(pShadow, pClient);
+	}
+
+	if(SUCCESS == rc && pParams->isAckSubscribeOnConnect) {
+		/* Kept for the whole connection, so the first action on the thing finds them settled */
+		for(i = 0; i < sizeof(ackActions) / sizeof(ackActions[0]) && SUCCESS == rc; i++) {
+			if(!isSubscriptionPresent(pShadow, pShadow->myThingName, ackActions[i])) {
+				rc = subscribeToShadowActionAcks(pShadow, pShadow->myThingName, ackActions[i], true);
+			}
+		}
 	}
 
 	if(NULL != pParams->deleteActionHandler) {
 		snprintf(deleteAcceptedTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES,
-				 "$aws/things/%s/shadow/delete/accepted", myThingName);
+				 "$aws/things/%s/shadow/delete/accepted", pShadow->myThingName);
 		deleteAcceptedTopicLen = (uint16_t) strlen(deleteAcceptedTopic);
 		rc = aws_iot_mqtt_subscribe(pClient, deleteAcceptedTopic, deleteAcceptedTopicLen, QOS1,
-									pParams->deleteActionHandler, (void *) myThingName);
+									pParams->deleteActionHandler, (void *) pShadow->myThingName);
 	}
 
 	IOT_FUNC_EXIT_RC(rc);
@@ -137,15 +177,19 @@ IoT_Error_t aws_iot_shadow_register_delta(AWS_IoT_Client *pMqttClient, jsonStruc
 		return MQTT_CONNECTION_ERROR;
 	}
 
-	return registerJsonTokenOnDelta(pStruct);
+	return registerJsonTokenOnDelta(getShadowClient(pMqttClient), pStruct);
 }
 
+static void flushDueUpdateQueues(AWS_IoT_Client *pClient);
+
 IoT_Error_t aws_iot_shadow_yield(AWS_IoT_Client *pClient, uint32_t timeout) {
 	if(NULL == pClient) {
 		return NULL_VALUE_ERROR;
 	}
 
-	HandleExpiredResponseCallbacks();
+	flushDueUpdateQueues(pClient);
+	PublishDeferredActions(getShadowClient(pClient));
+	HandleExpiredResponseCallbacks(getShadowClient(pClient));
 	return aws_iot_mqtt_yield(pClient, timeout);
 }
 
@@ -166,12 +210,343 @@ IoT_Error_t aws_iot_shadow_update(AWS_IoT_Client *pClient, const char *pThingNam
 		IOT_FUNC_EXIT_RC(MQTT_CONNECTION_ERROR);
 	}
 
-	rc = aws_iot_shadow_internal_action(pThingName, SHADOW_UPDATE, pJsonString, callback, pContextData,
+	rc = aws_iot_shadow_internal_action(pClient, pThingName, SHADOW_UPDATE, pJsonString, callback, pContextData,
+										timeout_seconds, isPersistentSubscribe);
+
+	IOT_FUNC_EXIT_RC(rc);
+}
+
+IoT_Error_t aws_iot_shadow_report_cache_init(AWS_IoT_Client *pClient, ShadowReportCache_t *pCache,
+											 const char *pThingName, ShadowReportedField_t *pFields,
+											 uint8_t fieldCount) {
+	uint8_t i;
+
+	if(NULL == pClient || NULL == pCache || NULL == pThingName || (NULL == pFields && 0 != fieldCount)) {
+		return NULL_VALUE_ERROR;
+	}
+
+	for(i = 0; i < fieldCount; i++) {
+		if(NULL == pFields[i].pStruct || NULL == pFields[i].pStruct->pKey || NULL == pFields[i].pStruct->pData) {
+			return NULL_VALUE_ERROR;
+		}
+		pFields[i].isAcknowledged = false;
+	}
+
+	pCache->pThingName = pThingName;
+	pCache->pFields = pFields;
+	pCache->fieldCount = fieldCount;
+	registerReportCache(getShadowClient(pClient), pCache);
+
+	return SUCCESS;
+}
+
+/* Numbers as they are read back from the document, floating point values are sent with six decimals */
+static double reportedNumber(const jsonStruct_t *pStruct) {
+	double value;
+	uint64_t scaled;
+
+	switch(pStruct->type) {
+		case SHADOW_JSON_INT32:
+			return *(const int32_t *) pStruct->pData;
+		case SHADOW_JSON_INT16:
+			return *(const int16_t *) pStruct->pData;
+		case SHADOW_JSON_INT8:
+			return *(const int8_t *) pStruct->pData;
+		case SHADOW_JSON_UINT32:
+			return *(const uint32_t *) pStruct->pData;
+		case SHADOW_JSON_UINT16:
+			return *(const uint16_t *) pStruct->pData;
+		case SHADOW_JSON_UINT8:
+			return *(const uint8_t *) pStruct->pData;
+		case SHADOW_JSON_FLOAT:
+			value = *(const float *) pStruct->pData;
+			break;
+		case SHADOW_JSON_DOUBLE:
+			value = *(const double *) pStruct->pData;
+			break;
+		case SHADOW_JSON_BOOL:
+			return *(const bool *) pStruct->pData ? 1 : 0;
+		default:
+			return 0;
+	}
+
+	if(roundToMicros((value < 0) ? -value : value, &scaled)) {
+		value = (value < 0) ? -((double) scaled / 1000000.0) : (double) scaled / 1000000.0;
+	}
+	return value;
+}
+
+static bool isReportedFieldChanged(const ShadowReportedField_t *pField) {
+	const jsonStruct_t *pStruct = pField->pStruct;
+	double difference;
+
+	if(!pField->isAcknowledged) {
+		return true;
+	}
+
+	if(SHADOW_JSON_STRING == pStruct->type || SHADOW_JSON_OBJECT == pStruct->type) {
+		return pField->acknowledgedHash != hashJsonKey((const char *) pStruct->pData, strlen((const char *) pStruct->pData));
+	}
+
+	difference = reportedNumber(pStruct) - pField->acknowledgedNumber;
+	if(difference < 0) {
+		difference = -difference;
+	}
+	if(SHADOW_JSON_BOOL == pStruct->type) {
+		return difference != 0;
+	}
+	return difference > pField->deadband;
+}
+
+/* Keeps the update/accepted and update/rejected subscriptions of a report without a callback */
+static void reportAckIgnored(const char *pThingName, ShadowActions_t action, Shadow_Ack_Status_t status,
+							 const char *pReceivedJsonDocument, void *pContextData) {
+	IOT_UNUSED(pThingName);
+	IOT_UNUSED(action);
+	IOT_UNUSED(status);
+	IOT_UNUSED(pReceivedJsonDocument);
+	IOT_UNUSED(pContextData);
+}
+
+IoT_Error_t aws_iot_shadow_report(AWS_IoT_Client *pClient, ShadowReportCache_t *pCache, char *pJsonBuffer,
+								  size_t jsonBufferLen, fpActionCallback_t callback, void *pContextData,
+								  uint8_t timeout_seconds, bool isPersistentSubscribe) {
+	ShadowJsonBuilder_t builder;
+	IoT_Error_t rc;
+	uint8_t changedCount = 0;
+	uint8_t i;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pCache || NULL == pJsonBuffer) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		IOT_FUNC_EXIT_RC(MQTT_CONNECTION_ERROR);
+	}
+
+	aws_iot_shadow_json_builder_init(&builder, pJsonBuffer, jsonBufferLen);
+	builder.pShadowClient = getShadowClient(pClient);
+	aws_iot_shadow_json_builder_begin_object(&builder, "reported");
+	for(i = 0; i < pCache->fieldCount; i++) {
+		if(isReportedFieldChanged(&(pCache->pFields[i]))) {
+			aws_iot_shadow_json_builder_add(&builder, pCache->pFields[i].pStruct);
+			changedCount++;
+		}
+	}
+
+	if(0 == changedCount) {
+		IOT_FUNC_EXIT_RC(SHADOW_NOTHING_TO_REPORT);
+	}
+
+	rc = aws_iot_shadow_json_builder_finalize(&builder);
+	if(SUCCESS != rc) {
+		IOT_FUNC_EXIT_RC(rc);
+	}
+
+	rc = aws_iot_shadow_internal_action(pClient, pCache->pThingName, SHADOW_UPDATE, pJsonBuffer,
+										(NULL != callback) ? callback : reportAckIgnored, pContextData,
 										timeout_seconds, isPersistentSubscribe);
 
 	IOT_FUNC_EXIT_RC(rc);
 }
 
+IoT_Error_t aws_iot_shadow_update_queue_init(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue,
+											 const char *pThingName, ShadowQueuedField_t *pFields,
+											 uint8_t maxFieldCount, const ShadowUpdateQueueParameters_t *pParams) {
+	if(NULL == pClient || NULL == pQueue || NULL == pThingName || NULL == pFields) {
+		return NULL_VALUE_ERROR;
+	}
+
+	if(0 == maxFieldCount) {
+		return FAILURE;
+	}
+
+	pQueue->pThingName = pThingName;
+	pQueue->params = (NULL != pParams) ? *pParams : ShadowUpdateQueueParametersDefault;
+	if(0 == pQueue->params.flushFieldCount || maxFieldCount < pQueue->params.flushFieldCount) {
+		pQueue->params.flushFieldCount = maxFieldCount;
+	}
+	if(0 == pQueue->params.burstSize) {
+		pQueue->params.burstSize = 1;
+	}
+	pQueue->pFields = pFields;
+	pQueue->maxFieldCount = maxFieldCount;
+	pQueue->fieldCount = 0;
+	pQueue->tokens = pQueue->params.burstSize;
+	registerUpdateQueue(pClient, pQueue);
+
+	return SUCCESS;
+}
+
+/* Token bucket of the queue. The refill timer runs until the bucket is full again, a token is credited for every
+ * whole refillInterval_ms that passed, however long the queue was idle. */
+static void refillUpdateTokens(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue) {
+	uint32_t left_ms, missingTokens;
+
+	if(pQueue->tokens == pQueue->params.burstSize) {
+		return;
+	}
+
+	left_ms = aws_iot_mqtt_timer_left_ms(pClient, &(pQueue->refillTimer));
+	missingTokens = 0;
+	if(0 < pQueue->params.refillInterval_ms) {
+		missingTokens = (left_ms + pQueue->params.refillInterval_ms - 1) / pQueue->params.refillInterval_ms;
+	}
+	if(missingTokens < pQueue->params.burstSize) {
+		pQueue->tokens = (uint8_t) (pQueue->params.burstSize - missingTokens);
+	}
+}
+
+/* Takes a token, the bucket is full again one refillInterval_ms later than it would have been */
+static void takeUpdateToken(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue) {
+	uint32_t left_ms = 0;
+
+	if(pQueue->tokens < pQueue->params.burstSize) {
+		left_ms = aws_iot_mqtt_timer_left_ms(pClient, &(pQueue->refillTimer));
+	}
+	aws_iot_mqtt_timer_start(pClient, &(pQueue->refillTimer), left_ms + pQueue->params.refillInterval_ms);
+	pQueue->tokens--;
+}
+
+static void addQueuedFields(ShadowJsonBuilder_t *pBuilder, const ShadowUpdateQueue_t *pQueue, bool isDesired) {
+	bool isOpen = false;
+	uint8_t i;
+
+	for(i = 0; i < pQueue->fieldCount; i++) {
+		if(pQueue->pFields[i].isDesired == isDesired) {
+			if(!isOpen) {
+				aws_iot_shadow_json_builder_begin_object(pBuilder, isDesired ? "desired" : "reported");
+				isOpen = true;
+			}
+			aws_iot_shadow_json_builder_add(pBuilder, pQueue->pFields[i].pStruct);
+		}
+	}
+	if(isOpen) {
+		aws_iot_shadow_json_builder_end_object(pBuilder);
+	}
+}
+
+static IoT_Error_t sendUpdateQueue(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue) {
+	char updateJson[AWS_IOT_MQTT_TX_BUF_LEN];
+	ShadowJsonBuilder_t builder;
+	IoT_Error_t rc;
+
+	if(0 == pQueue->fieldCount) {
+		return SHADOW_NOTHING_TO_REPORT;
+	}
+
+	refillUpdateTokens(pClient, pQueue);
+	if(0 == pQueue->tokens) {
+		return SHADOW_UPDATE_RATE_LIMITED;
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		return MQTT_CONNECTION_ERROR;
+	}
+
+	aws_iot_shadow_json_builder_init(&builder, updateJson, sizeof(updateJson));
+	builder.pShadowClient = getShadowClient(pClient);
+	addQueuedFields(&builder, pQueue, false);
+	addQueuedFields(&builder, pQueue, true);
+	rc = aws_iot_shadow_json_builder_finalize(&builder);
+	if(SUCCESS != rc) {
+		/* These fields can never be sent together, keeping them would block the queue */
+		pQueue->fieldCount = 0;
+		aws_iot_mqtt_timer_stop(pClient, &(pQueue->flushTimer));
+		return rc;
+	}
+
+	rc = aws_iot_shadow_internal_action(pClient, pQueue->pThingName, SHADOW_UPDATE, updateJson, pQueue->params.callback,
+										pQueue->params.pContextData, pQueue->params.timeout_seconds,
+										pQueue->params.isPersistentSubscribe);
+	if(SUCCESS != rc) {
+		return rc;
+	}
+
+	pQueue->fieldCount = 0;
+	aws_iot_mqtt_timer_stop(pClient, &(pQueue->flushTimer));
+	takeUpdateToken(pClient, pQueue);
+
+	return SUCCESS;
+}
+
+static IoT_Error_t queueField(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue, jsonStruct_t *pStruct,
+							  bool isDesired) {
+	IoT_Error_t rc;
+	uint8_t i;
+
+	if(NULL == pClient || NULL == pQueue || NULL == pStruct || NULL == pStruct->pKey || NULL == pStruct->pData) {
+		return NULL_VALUE_ERROR;
+	}
+
+	for(i = 0; i < pQueue->fieldCount; i++) {
+		if(pQueue->pFields[i].isDesired == isDesired && 0 == strcmp(pQueue->pFields[i].pStruct->pKey, pStruct->pKey)) {
+			pQueue->pFields[i].pStruct = pStruct;
+			return SUCCESS;
+		}
+	}
+
+	if(pQueue->fieldCount == pQueue->maxFieldCount) {
+		rc = sendUpdateQueue(pClient, pQueue);
+		if(SHADOW_UPDATE_RATE_LIMITED == rc) {
+			return SHADOW_UPDATE_QUEUE_FULL_ERROR;
+		}
+		if(SUCCESS != rc) {
+			return rc;
+		}
+	}
+
+	if(0 == pQueue->fieldCount) {
+		aws_iot_mqtt_timer_start(pClient, &(pQueue->flushTimer), pQueue->params.flushInterval_ms);
+	}
+	pQueue->pFields[pQueue->fieldCount].pStruct = pStruct;
+	pQueue->pFields[pQueue->fieldCount].isDesired = isDesired;
+	pQueue->fieldCount++;
+
+	if(pQueue->fieldCount < pQueue->params.flushFieldCount) {
+		return SUCCESS;
+	}
+	return sendUpdateQueue(pClient, pQueue);
+}
+
+IoT_Error_t aws_iot_shadow_queue_reported(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue, jsonStruct_t *pStruct) {
+	return queueField(pClient, pQueue, pStruct, false);
+}
+
+IoT_Error_t aws_iot_shadow_queue_desired(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue, jsonStruct_t *pStruct) {
+	return queueField(pClient, pQueue, pStruct, true);
+}
+
+IoT_Error_t aws_iot_shadow_update_queue_flush(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue) {
+	if(NULL == pClient || NULL == pQueue) {
+		return NULL_VALUE_ERROR;
+	}
+
+	return sendUpdateQueue(pClient, pQueue);
+}
+
+/* Called from every yield, fields that could not be sent earlier are tried again */
+static void flushDueUpdateQueues(AWS_IoT_Client *pClient) {
+	ShadowUpdateQueue_t *pQueue;
+	IoT_Error_t rc;
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		return;
+	}
+
+	for(pQueue = getShadowClient(pClient)->pUpdateQueues; NULL != pQueue; pQueue = pQueue->pNext) {
+		if(0 < pQueue->fieldCount && (pQueue->params.flushFieldCount <= pQueue->fieldCount
+									  || aws_iot_mqtt_timer_has_expired(pClient, &(pQueue->flushTimer)))) {
+			rc = sendUpdateQueue(pClient, pQueue);
+			if(SUCCESS != rc && SHADOW_UPDATE_RATE_LIMITED != rc) {
+				IOT_ERROR("Shadow update queue flush failed, rc %d", rc);
+			}
+		}
+	}
+}
+
 IoT_Error_t aws_iot_shadow_delete(AWS_IoT_Client *pClient, const char *pThingName, fpActionCallback_t callback,
 								  void *pContextData, uint8_t timeout_seconds, bool isPersistentSubscribe) {
 	char deleteRequestJsonBuf[MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE];
@@ -187,9 +562,9 @@ IoT_Error_t aws_iot_shadow_delete(AWS_IoT_Client *pClient, const char *pThingNam
 		IOT_FUNC_EXIT_RC(MQTT_CONNECTION_ERROR);
 	}
 
-	aws_iot_shadow_internal_delete_request_json(deleteRequestJsonBuf);
-	rc = aws_iot_shadow_internal_action(pThingName, SHADOW_DELETE, deleteRequestJsonBuf, callback, pContextData,
-										timeout_seconds, isPersistentSubscribe);
+	aws_iot_shadow_internal_client_token_json(getShadowClient(pClient), deleteRequestJsonBuf);
+	rc = aws_iot_shadow_internal_action(pClient, pThingName, SHADOW_DELETE, deleteRequestJsonBuf, callback,
+										pContextData, timeout_seconds, isPersistentSubscribe);
 
 	IOT_FUNC_EXIT_RC(rc);
 }
@@ -209,12 +584,43 @@ IoT_Error_t aws_iot_shadow_get(AWS_IoT_Client *pClient, const char *pThingName,
 		IOT_FUNC_EXIT_RC(MQTT_CONNECTION_ERROR);
 	}
 
-	aws_iot_shadow_internal_get_request_json(getRequestJsonBuf);
-	rc = aws_iot_shadow_internal_action(pThingName, SHADOW_GET, getRequestJsonBuf, callback, pContextData,
+	aws_iot_shadow_internal_client_token_json(getShadowClient(pClient), getRequestJsonBuf);
+	rc = aws_iot_shadow_internal_action(pClient, pThingName, SHADOW_GET, getRequestJsonBuf, callback, pContextData,
 										timeout_seconds, isPersistentSubscribe);
 	IOT_FUNC_EXIT_RC(rc);
 }
 
+IoT_Error_t aws_iot_shadow_get_many(AWS_IoT_Client *pClient, const char *const *pThingNames, uint16_t thingCount,
+									fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+									uint16_t *pRequestedCount) {
+	IoT_Error_t rc;
+	uint16_t i;
+
+	IOT_FUNC_ENTRY;
+
+	if(NULL != pRequestedCount) {
+		*pRequestedCount = 0;
+	}
+
+	if(NULL == pClient || NULL == pThingNames || NULL == callback) {
+		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	for(i = 0; i < thingCount; i++) {
+		if(NULL == pThingNames[i]) {
+			IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
+		}
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		IOT_FUNC_EXIT_RC(MQTT_CONNECTION_ERROR);
+	}
+
+	rc = aws_iot_shadow_internal_bulk_get(pClient, pThingNames, thingCount, callback, pContextData, timeout_seconds,
+										  pRequestedCount);
+	IOT_FUNC_EXIT_RC(rc);
+}
+
 IoT_Error_t aws_iot_shadow_set_autoreconnect_status(AWS_IoT_Client *pClient, bool newStatus) {
 	return aws_iot_mqtt_autoreconnect_set_status(pClient, newStatus);
 }
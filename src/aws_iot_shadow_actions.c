@@ -24,52 +24,113 @@ extern "C" {
 
 #include "aws_iot_shadow_actions.h"
 
+#include <string.h>
+#include <stdio.h>
+
 #include "aws_iot_log.h"
 #include "aws_iot_shadow_json.h"
 #include "aws_iot_shadow_records.h"
 #include "aws_iot_config.h"
 
-IoT_Error_t aws_iot_shadow_internal_action(const char *pThingName, ShadowActions_t action,
+IoT_Error_t aws_iot_shadow_internal_action(AWS_IoT_Client *pClient, const char *pThingName, ShadowActions_t action,
 										   const char *pJsonDocumentToBeSent, fpActionCallback_t callback,
 										   void *pCallbackContext, uint32_t timeout_seconds, bool isSticky) {
 	IoT_Error_t ret_val = SUCCESS;
 	bool isClientTokenPresent = false;
 	bool isAckWaitListFree = false;
-	uint8_t indexAckWaitList;
+	bool isPublishDeferred = false;
+	uint16_t indexAckWaitList;
 	char extractedClientToken[MAX_SIZE_CLIENT_ID_WITH_SEQUENCE];
+	int32_t tokenCount;
+	ShadowClient *pShadow;
 
 	IOT_FUNC_ENTRY;
 
-	if(NULL == pThingName || NULL == pJsonDocumentToBeSent) {
+	if(NULL == pClient || NULL == pThingName || NULL == pJsonDocumentToBeSent) {
 		IOT_FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	isClientTokenPresent = extractClientToken(pJsonDocumentToBeSent, extractedClientToken);
+	pShadow = getShadowClient(pClient);
+
+	isClientTokenPresent = isJsonValidAndParse(pJsonDocumentToBeSent, strlen(pJsonDocumentToBeSent),
+											   &(pShadow->jsonParser), &tokenCount)
+						   && extractClientToken(pJsonDocumentToBeSent, &(pShadow->jsonParser), extractedClientToken);
 
 	if(isClientTokenPresent && (NULL != callback)) {
-		if(getNextFreeIndexOfAckWaitList(&indexAckWaitList)) {
+		if(getNextFreeIndexOfAckWaitList(pShadow, &indexAckWaitList)) {
 			isAckWaitListFree = true;
 		}
 
 		if(isAckWaitListFree) {
-			if(!isSubscriptionPresent(pThingName, action)) {
-				ret_val = subscribeToShadowActionAcks(pThingName, action, isSticky);
+			if(!isSubscriptionPresent(pShadow, pThingName, action)) {
+				ret_val = subscribeToShadowActionAcks(pShadow, pThingName, action, isSticky);
 			} else {
-				incrementSubscriptionCnt(pThingName, action, isSticky);
+				incrementSubscriptionCnt(pShadow, pThingName, action, isSticky);
 			}
+			/* A document too large to keep is sent right away, it does not fit a publish either */
+			isPublishDeferred = (SUCCESS == ret_val) && !isSubscriptionSettled(pShadow, pThingName, action)
+								&& strlen(pJsonDocumentToBeSent) < AWS_IOT_MQTT_TX_BUF_LEN;
 		}
 		else {
 			ret_val = FAILURE;
 		}
 	}
 
-	if(SUCCESS == ret_val) {
-		ret_val = publishToShadowAction(pThingName, action, pJsonDocumentToBeSent);
+	if(SUCCESS == ret_val && !isPublishDeferred) {
+		ret_val = publishToShadowAction(pShadow, pThingName, action, pJsonDocumentToBeSent);
 	}
 
 	if(isClientTokenPresent && (NULL != callback) && (SUCCESS == ret_val) && isAckWaitListFree) {
-		addToAckWaitList(indexAckWaitList, pThingName, action, extractedClientToken, callback, pCallbackContext,
-						 timeout_seconds);
+		addToAckWaitList(pShadow, indexAckWaitList, pThingName, action, extractedClientToken, callback,
+						 pCallbackContext, timeout_seconds, isPublishDeferred ? pJsonDocumentToBeSent : NULL, false);
+	} else if(isAckWaitListFree) {
+		releaseAckWaitListIndex(pShadow, indexAckWaitList);
+	}
+
+	IOT_FUNC_EXIT_RC(ret_val);
+}
+
+IoT_Error_t aws_iot_shadow_internal_bulk_get(AWS_IoT_Client *pClient, const char *const *pThingNames,
+											 uint16_t thingCount, fpActionCallback_t callback, void *pCallbackContext,
+											 uint32_t timeout_seconds, uint16_t *pRequestedCount) {
+	IoT_Error_t ret_val;
+	bool isPublishDeferred;
+	uint16_t indexAckWaitList;
+	uint16_t requested;
+	char clientToken[MAX_SIZE_CLIENT_ID_WITH_SEQUENCE];
+	char getRequestJson[MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE];
+	ShadowClient *pShadow;
+
+	IOT_FUNC_ENTRY;
+
+	pShadow = getShadowClient(pClient);
+
+	ret_val = subscribeToBulkGetAcks(pShadow);
+
+	/* Requests are published back to back, none of them waits for the response to another */
+	for(requested = 0; SUCCESS == ret_val && requested < thingCount; requested++) {
+		if(!getNextFreeIndexOfAckWaitList(pShadow, &indexAckWaitList)) {
+			ret_val = FAILURE;
+			break;
+		}
+
+		ret_val = aws_iot_shadow_internal_fill_with_client_token(pShadow, clientToken, sizeof(clientToken));
+		snprintf(getRequestJson, sizeof(getRequestJson), "{\"clientToken\":\"%s\"}", clientToken);
+		isPublishDeferred = !isSubscriptionSettled(pShadow, pThingNames[requested], SHADOW_GET);
+		if(SUCCESS == ret_val && !isPublishDeferred) {
+			ret_val = publishToShadowAction(pShadow, pThingNames[requested], SHADOW_GET, getRequestJson);
+		}
+
+		if(SUCCESS != ret_val) {
+			releaseAckWaitListIndex(pShadow, indexAckWaitList);
+			break;
+		}
+		addToAckWaitList(pShadow, indexAckWaitList, pThingNames[requested], SHADOW_GET, clientToken, callback,
+						 pCallbackContext, timeout_seconds, isPublishDeferred ? getRequestJson : NULL, true);
+	}
+
+	if(NULL != pRequestedCount) {
+		*pRequestedCount = requested;
 	}
 
 	IOT_FUNC_EXIT_RC(ret_val);
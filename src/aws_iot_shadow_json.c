@@ -31,36 +31,37 @@ extern "C" {
 
 #include <string.h>
 #include <stdbool.h>
+#include <math.h>
 
 #include "aws_iot_json_utils.h"
 #include "aws_iot_log.h"
 #include "aws_iot_shadow_key.h"
+#include "aws_iot_shadow_interface.h"
+#include "aws_iot_shadow_records.h"
 #include "aws_iot_config.h"
 
-extern char mqttClientID[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES];
+/* Written by aws_iot_finalize_json_document in place of the comma left by the last section */
+#define FINALIZE_PREFIX "}, \"" SHADOW_CLIENT_TOKEN_STRING "\":"
 
-static uint32_t clientTokenNum = 0;
+int32_t FillWithClientTokenSize(ShadowClient *pShadow, char *pBufferToBeUpdatedWithClientToken,
+								size_t maxSizeOfJsonDocument);
 
-//helper functions
-static IoT_Error_t convertDataToString(char *pStringBuffer, size_t maxSizoStringBuffer, JsonPrimitiveType type,
-									   void *pData);
-
-void resetClientTokenSequenceNum(void) {
-	clientTokenNum = 0;
-}
-
-static void emptyJsonWithClientToken(char *pJsonDocument) {
+static void emptyJsonWithClientToken(ShadowClient *pShadow, char *pJsonDocument) {
 	sprintf(pJsonDocument, "{\"clientToken\":\"");
-	FillWithClientToken(pJsonDocument + strlen(pJsonDocument));
+	FillWithClientToken(pShadow, pJsonDocument + strlen(pJsonDocument));
 	sprintf(pJsonDocument + strlen(pJsonDocument), "\"}");
 }
 
 void aws_iot_shadow_internal_get_request_json(char *pJsonDocument) {
-	emptyJsonWithClientToken(pJsonDocument);
+	emptyJsonWithClientToken(getDefaultShadowClient(), pJsonDocument);
 }
 
 void aws_iot_shadow_internal_delete_request_json(char *pJsonDocument) {
-	emptyJsonWithClientToken(pJsonDocument);
+	emptyJsonWithClientToken(getDefaultShadowClient(), pJsonDocument);
+}
+
+void aws_iot_shadow_internal_client_token_json(ShadowClient *pShadow, char *pJsonDocument) {
+	emptyJsonWithClientToken(pShadow, pJsonDocument);
 }
 
 static inline IoT_Error_t checkReturnValueOfSnPrintf(int32_t snPrintfReturn, size_t maxSizeOfJsonDocument) {
@@ -72,284 +73,676 @@ static inline IoT_Error_t checkReturnValueOfSnPrintf(int32_t snPrintfReturn, siz
 	return SUCCESS;
 }
 
-IoT_Error_t aws_iot_shadow_init_json_document(char *pJsonDocument, size_t maxSizeOfJsonDocument) {
+/* Copies as much of the data as fits, like snprintf, and keeps the buffer null terminated */
+static void builderWrite(ShadowJsonBuilder_t *pBuilder, const char *pData, size_t dataLen) {
+	size_t room;
 
-	IoT_Error_t ret_val = SUCCESS;
-	int32_t snPrintfReturn = 0;
+	if(SUCCESS != pBuilder->status) {
+		return;
+	}
 
-	if(pJsonDocument == NULL) {
-		return NULL_VALUE_ERROR;
+	room = pBuilder->bufferLen - pBuilder->length - 1;
+	if(dataLen > room) {
+		dataLen = room;
+		pBuilder->status = SHADOW_JSON_BUFFER_TRUNCATED;
 	}
-	snPrintfReturn = snprintf(pJsonDocument, maxSizeOfJsonDocument, "{\"state\":{");
+	memcpy(pBuilder->pBuffer + pBuilder->length, pData, dataLen);
+	pBuilder->length += dataLen;
+	pBuilder->pBuffer[pBuilder->length] = '\0';
+}
 
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, maxSizeOfJsonDocument);
+static void builderWriteSnPrintfResult(ShadowJsonBuilder_t *pBuilder, int32_t snPrintfReturn) {
+	size_t room = pBuilder->bufferLen - pBuilder->length;
 
-	return ret_val;
+	pBuilder->status = checkReturnValueOfSnPrintf(snPrintfReturn, room);
+	if(SUCCESS == pBuilder->status) {
+		pBuilder->length += (size_t) snPrintfReturn;
+	} else if(SHADOW_JSON_BUFFER_TRUNCATED == pBuilder->status) {
+		pBuilder->length += room - 1;
+	} else {
+		pBuilder->pBuffer[pBuilder->length] = '\0';
+	}
+}
 
+/* Digits are written backwards, ending just before pEnd */
+static char *formatUnsigned(char *pEnd, uint64_t value) {
+	do {
+		*--pEnd = (char) ('0' + (value % 10));
+		value /= 10;
+	} while(value != 0);
+
+	return pEnd;
 }
 
-IoT_Error_t aws_iot_shadow_add_desired(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
-	IoT_Error_t ret_val = SUCCESS;
-	size_t tempSize = 0;
-	int8_t i;
-	size_t remSizeOfJsonBuffer = maxSizeOfJsonDocument;
-	int32_t snPrintfReturn = 0;
-	va_list pArgs;
-	jsonStruct_t *pTemporary = NULL;
-	va_start(pArgs, count);
+static void builderWriteInteger(ShadowJsonBuilder_t *pBuilder, bool isNegative, uint32_t magnitude) {
+	char digits[12];
+	char *pDigits = formatUnsigned(digits + sizeof(digits), magnitude);
 
-	if(pJsonDocument == NULL) {
+	if(isNegative) {
+		*--pDigits = '-';
+	}
+	builderWrite(pBuilder, pDigits, (size_t) (digits + sizeof(digits) - pDigits));
+}
+
+static void builderWriteSigned(ShadowJsonBuilder_t *pBuilder, int32_t value) {
+	builderWriteInteger(pBuilder, value < 0, (value < 0) ? 0u - (uint32_t) value : (uint32_t) value);
+}
+
+bool roundToMicros(double magnitude, uint64_t *pScaled) {
+	double scaled, error, high, low, split, fraction, halfwayDistance;
+	uint64_t integer;
+
+	if(!(magnitude < SHADOW_JSON_MAX_MICROS_MAGNITUDE)) {
+		return false;
+	}
+
+	/* scaled + error is exactly magnitude * 1e6, split into halves of 26 bits (Dekker) */
+	scaled = magnitude * 1000000.0;
+	split = 134217729.0 * magnitude;
+	high = split - (split - magnitude);
+	low = magnitude - high;
+	error = (high * 1000000.0 - scaled) + low * 1000000.0;
+
+	/* Round to nearest like "%f", ties to even, the sign of the distance to the halfway point is exact */
+	integer = (uint64_t) scaled;
+	fraction = scaled - (double) integer;
+	halfwayDistance = (fraction - 0.5) + error;
+	if(0 < halfwayDistance || (0 == halfwayDistance && 0 != (integer & 1u))) {
+		integer++;
+	}
+
+	*pScaled = integer;
+	return true;
+}
+
+/* Same output as "%f", large values, infinities and NaN are left to snprintf */
+static void builderWriteDouble(ShadowJsonBuilder_t *pBuilder, double value) {
+	char digits[24];
+	char *pDigits = digits + sizeof(digits);
+	uint64_t scaled;
+	uint32_t fraction;
+	uint8_t i;
+
+	if(!roundToMicros((value < 0) ? -value : value, &scaled)) {
+		if(SUCCESS == pBuilder->status) {
+			builderWriteSnPrintfResult(pBuilder, snprintf(pBuilder->pBuffer + pBuilder->length,
+														  pBuilder->bufferLen - pBuilder->length, "%f", value));
+		}
+		return;
+	}
+
+	fraction = (uint32_t) (scaled % 1000000);
+	for(i = 0; i < 6; i++) {
+		*--pDigits = (char) ('0' + (fraction % 10));
+		fraction /= 10;
+	}
+	*--pDigits = '.';
+	pDigits = formatUnsigned(pDigits, scaled / 1000000);
+	if(signbit(value)) {
+		*--pDigits = '-';
+	}
+	builderWrite(pBuilder, pDigits, (size_t) (digits + sizeof(digits) - pDigits));
+}
+
+/* Separates the value from the previous one and writes its key when it goes in an object */
+static IoT_Error_t builderBeginValue(ShadowJsonBuilder_t *pBuilder, const char *pKey) {
+	bool isInObject;
+
+	if(SUCCESS != pBuilder->status || 0 == pBuilder->depth) {
+		return pBuilder->status;
+	}
+
+	isInObject = ('}' == pBuilder->closing[pBuilder->depth - 1]);
+	if(isInObject && NULL == pKey) {
+		pBuilder->status = NULL_VALUE_ERROR;
+		return pBuilder->status;
+	}
+
+	if(pBuilder->hasValue[pBuilder->depth - 1]) {
+		builderWrite(pBuilder, ",", 1);
+	}
+	pBuilder->hasValue[pBuilder->depth - 1] = true;
+
+	if(isInObject) {
+		builderWrite(pBuilder, "\"", 1);
+		builderWrite(pBuilder, pKey, strlen(pKey));
+		builderWrite(pBuilder, "\":", 2);
+	}
+
+	return pBuilder->status;
+}
+
+static IoT_Error_t builderOpen(ShadowJsonBuilder_t *pBuilder, const char *pKey, char opening, char closing) {
+	if(NULL == pBuilder) {
 		return NULL_VALUE_ERROR;
 	}
+	if(SUCCESS == pBuilder->status && pBuilder->depth >= SHADOW_JSON_BUILDER_MAX_DEPTH) {
+		pBuilder->status = SHADOW_JSON_ERROR;
+	}
+	if(SUCCESS != builderBeginValue(pBuilder, pKey)) {
+		return pBuilder->status;
+	}
+
+	builderWrite(pBuilder, &opening, 1);
+	pBuilder->closing[pBuilder->depth] = closing;
+	pBuilder->hasValue[pBuilder->depth] = false;
+	pBuilder->depth++;
+
+	return pBuilder->status;
+}
 
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
+static IoT_Error_t builderClose(ShadowJsonBuilder_t *pBuilder, char closing) {
+	if(NULL == pBuilder) {
+		return NULL_VALUE_ERROR;
+	}
+	if(SUCCESS == pBuilder->status && (0 == pBuilder->depth || closing != pBuilder->closing[pBuilder->depth - 1])) {
+		pBuilder->status = SHADOW_JSON_ERROR;
+	}
+	if(SUCCESS != pBuilder->status) {
+		return pBuilder->status;
+	}
+
+	builderWrite(pBuilder, &closing, 1);
+	pBuilder->depth--;
+
+	return pBuilder->status;
+}
+
+static void builderAttach(ShadowJsonBuilder_t *pBuilder, char *pBuffer, size_t bufferLen, size_t length) {
+	pBuilder->pBuffer = pBuffer;
+	pBuilder->bufferLen = bufferLen;
+	pBuilder->length = length;
+	pBuilder->depth = 0;
+	pBuilder->status = SUCCESS;
+	pBuilder->pShadowClient = NULL;
+}
+
+IoT_Error_t aws_iot_shadow_json_builder_init(ShadowJsonBuilder_t *pBuilder, char *pBuffer, size_t bufferLen) {
+	if(NULL == pBuilder || NULL == pBuffer) {
+		return NULL_VALUE_ERROR;
+	}
+	if(0 == bufferLen) {
 		return SHADOW_JSON_ERROR;
 	}
-	remSizeOfJsonBuffer = tempSize;
 
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"desired\":{");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+	builderAttach(pBuilder, pBuffer, bufferLen, 0);
+	pBuffer[0] = '\0';
+	builderOpen(pBuilder, NULL, '{', '}');
+	return builderOpen(pBuilder, "state", '{', '}');
+}
+
+IoT_Error_t aws_iot_shadow_json_builder_begin_object(ShadowJsonBuilder_t *pBuilder, const char *pKey) {
+	return builderOpen(pBuilder, pKey, '{', '}');
+}
+
+IoT_Error_t aws_iot_shadow_json_builder_end_object(ShadowJsonBuilder_t *pBuilder) {
+	return builderClose(pBuilder, '}');
+}
+
+IoT_Error_t aws_iot_shadow_json_builder_begin_array(ShadowJsonBuilder_t *pBuilder, const char *pKey) {
+	return builderOpen(pBuilder, pKey, '[', ']');
+}
+
+IoT_Error_t aws_iot_shadow_json_builder_end_array(ShadowJsonBuilder_t *pBuilder) {
+	return builderClose(pBuilder, ']');
+}
 
-	if(ret_val != SUCCESS) {
-		return ret_val;
+IoT_Error_t aws_iot_shadow_json_builder_add_value(ShadowJsonBuilder_t *pBuilder, const char *pKey,
+												  JsonPrimitiveType type, const void *pData) {
+	if(NULL == pBuilder) {
+		return NULL_VALUE_ERROR;
+	}
+	if(SUCCESS == pBuilder->status && NULL == pData) {
+		pBuilder->status = NULL_VALUE_ERROR;
+	}
+	if(SUCCESS != builderBeginValue(pBuilder, pKey)) {
+		return pBuilder->status;
 	}
 
-	for(i = 0; i < count; i++) {
-		tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-		if(tempSize <= 1) {
-			return SHADOW_JSON_ERROR;
-		}
-		remSizeOfJsonBuffer = tempSize;
-		pTemporary = va_arg (pArgs, jsonStruct_t *);
-		if(pTemporary != NULL) {
-			snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"%s\":",
-									  pTemporary->pKey);
-			ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-			if(ret_val != SUCCESS) {
-				return ret_val;
-			}
-			if(pTemporary->pKey != NULL && pTemporary->pData != NULL) {
-				ret_val = convertDataToString(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer,
-											  pTemporary->type, pTemporary->pData);
-			} else {
-				return NULL_VALUE_ERROR;
-			}
-			if(ret_val != SUCCESS) {
-				return ret_val;
-			}
+	if(type == SHADOW_JSON_INT32) {
+		builderWriteSigned(pBuilder, *(const int32_t *) pData);
+	} else if(type == SHADOW_JSON_INT16) {
+		builderWriteSigned(pBuilder, *(const int16_t *) pData);
+	} else if(type == SHADOW_JSON_INT8) {
+		builderWriteSigned(pBuilder, *(const int8_t *) pData);
+	} else if(type == SHADOW_JSON_UINT32) {
+		builderWriteInteger(pBuilder, false, *(const uint32_t *) pData);
+	} else if(type == SHADOW_JSON_UINT16) {
+		builderWriteInteger(pBuilder, false, *(const uint16_t *) pData);
+	} else if(type == SHADOW_JSON_UINT8) {
+		builderWriteInteger(pBuilder, false, *(const uint8_t *) pData);
+	} else if(type == SHADOW_JSON_DOUBLE) {
+		builderWriteDouble(pBuilder, *(const double *) pData);
+	} else if(type == SHADOW_JSON_FLOAT) {
+		builderWriteDouble(pBuilder, *(const float *) pData);
+	} else if(type == SHADOW_JSON_BOOL) {
+		if(*(const bool *) pData) {
+			builderWrite(pBuilder, "true", 4);
 		} else {
-			return NULL_VALUE_ERROR;
+			builderWrite(pBuilder, "false", 5);
 		}
+	} else if(type == SHADOW_JSON_STRING) {
+		builderWrite(pBuilder, "\"", 1);
+		builderWrite(pBuilder, (const char *) pData, strlen((const char *) pData));
+		builderWrite(pBuilder, "\"", 1);
+	} else if(type == SHADOW_JSON_OBJECT) {
+		builderWrite(pBuilder, (const char *) pData, strlen((const char *) pData));
 	}
 
-	va_end(pArgs);
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument) - 1, remSizeOfJsonBuffer, "},");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-	return ret_val;
+	return pBuilder->status;
 }
 
-IoT_Error_t aws_iot_shadow_add_reported(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
-	IoT_Error_t ret_val = SUCCESS;
+IoT_Error_t aws_iot_shadow_json_builder_add(ShadowJsonBuilder_t *pBuilder, const jsonStruct_t *pStruct) {
+	if(NULL == pBuilder) {
+		return NULL_VALUE_ERROR;
+	}
+	if(NULL == pStruct) {
+		if(SUCCESS == pBuilder->status) {
+			pBuilder->status = NULL_VALUE_ERROR;
+		}
+		return pBuilder->status;
+	}
+	return aws_iot_shadow_json_builder_add_value(pBuilder, pStruct->pKey, pStruct->type, pStruct->pData);
+}
 
-	int8_t i;
-	size_t remSizeOfJsonBuffer = maxSizeOfJsonDocument;
-	int32_t snPrintfReturn = 0;
-	size_t tempSize = 0;
-	jsonStruct_t *pTemporary;
-	va_list pArgs;
-	va_start(pArgs, count);
+static void builderWriteClientToken(ShadowJsonBuilder_t *pBuilder) {
+	builderWrite(pBuilder, "\"", 1);
+	if(SUCCESS == pBuilder->status) {
+		builderWriteSnPrintfResult(pBuilder, FillWithClientTokenSize((NULL != pBuilder->pShadowClient)
+																	 ? pBuilder->pShadowClient
+																	 : getDefaultShadowClient(),
+																	 pBuilder->pBuffer + pBuilder->length,
+																	 pBuilder->bufferLen - pBuilder->length));
+	}
+	builderWrite(pBuilder, "\"}", 2);
+}
 
-	if(pJsonDocument == NULL) {
+IoT_Error_t aws_iot_shadow_json_builder_finalize(ShadowJsonBuilder_t *pBuilder) {
+	if(NULL == pBuilder) {
 		return NULL_VALUE_ERROR;
 	}
 
+	while(SUCCESS == pBuilder->status && pBuilder->depth > 1) {
+		builderClose(pBuilder, pBuilder->closing[pBuilder->depth - 1]);
+	}
+	if(SUCCESS != builderBeginValue(pBuilder, SHADOW_CLIENT_TOKEN_STRING)) {
+		return pBuilder->status;
+	}
+	pBuilder->depth = 0;
+	builderWriteClientToken(pBuilder);
 
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
-		return SHADOW_JSON_ERROR;
+	return pBuilder->status;
+}
+
+IoT_Error_t aws_iot_shadow_init_json_document(char *pJsonDocument, size_t maxSizeOfJsonDocument) {
+	ShadowJsonBuilder_t builder;
+
+	if(pJsonDocument == NULL) {
+		return NULL_VALUE_ERROR;
+	}
+	if(0 == maxSizeOfJsonDocument) {
+		return SHADOW_JSON_BUFFER_TRUNCATED;
 	}
-	remSizeOfJsonBuffer = tempSize;
 
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"reported\":{");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+	builderAttach(&builder, pJsonDocument, maxSizeOfJsonDocument, 0);
+	builderWrite(&builder, "{\"state\":{", 10);
+	return builder.status;
+}
+
+/* Appends "<pSectionName>":{...}, after the null terminated document, the comma is removed by the next section */
+static IoT_Error_t addSection(char *pJsonDocument, size_t maxSizeOfJsonDocument, const char *pSectionName,
+							  uint8_t count, va_list pArgs) {
+	ShadowJsonBuilder_t builder;
+	size_t length;
+	uint8_t i;
 
-	if(ret_val != SUCCESS) {
-		return ret_val;
+	if(pJsonDocument == NULL) {
+		return NULL_VALUE_ERROR;
 	}
 
-	for(i = 0; i < count; i++) {
-		tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-		if(tempSize <= 1) {
-			return SHADOW_JSON_ERROR;
-		}
-		remSizeOfJsonBuffer = tempSize;
-
-		pTemporary = va_arg (pArgs, jsonStruct_t *);
-		if(pTemporary != NULL) {
-			snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"%s\":",
-									  pTemporary->pKey);
-			ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-			if(ret_val != SUCCESS) {
-				return ret_val;
-			}
-			if(pTemporary->pKey != NULL && pTemporary->pData != NULL) {
-				ret_val = convertDataToString(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer,
-											  pTemporary->type, pTemporary->pData);
-			} else {
-				return NULL_VALUE_ERROR;
-			}
-			if(ret_val != SUCCESS) {
-				return ret_val;
-			}
-		} else {
-			return NULL_VALUE_ERROR;
-		}
+	length = strlen(pJsonDocument);
+	if(maxSizeOfJsonDocument - length <= 1) {
+		return SHADOW_JSON_ERROR;
+	}
+
+	builderAttach(&builder, pJsonDocument, maxSizeOfJsonDocument, length);
+	builderWrite(&builder, "\"", 1);
+	builderWrite(&builder, pSectionName, strlen(pSectionName));
+	builderWrite(&builder, "\":", 2);
+	builderOpen(&builder, NULL, '{', '}');
+	for(i = 0; i < count && SUCCESS == builder.status; i++) {
+		aws_iot_shadow_json_builder_add(&builder, va_arg(pArgs, jsonStruct_t *));
 	}
+	builderClose(&builder, '}');
+	builderWrite(&builder, ",", 1);
 
+	return builder.status;
+}
+
+IoT_Error_t aws_iot_shadow_add_desired(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
+	IoT_Error_t ret_val;
+	va_list pArgs;
+
+	va_start(pArgs, count);
+	ret_val = addSection(pJsonDocument, maxSizeOfJsonDocument, "desired", count, pArgs);
 	va_end(pArgs);
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument) - 1, remSizeOfJsonBuffer, "},");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+
 	return ret_val;
 }
 
+IoT_Error_t aws_iot_shadow_add_reported(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
+	IoT_Error_t ret_val;
+	va_list pArgs;
+
+	va_start(pArgs, count);
+	ret_val = addSection(pJsonDocument, maxSizeOfJsonDocument, "reported", count, pArgs);
+	va_end(pArgs);
+
+	return ret_val;
+}
+
+/* Sessions used from several threads take their sequence numbers one at a time */
+static uint32_t nextClientTokenNum(ShadowClient *pShadow) {
+	uint32_t clientTokenNum;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_lock(&(pShadow->clientTokenLock));
+#endif
+	clientTokenNum = pShadow->clientTokenNum++;
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_unlock(&(pShadow->clientTokenLock));
+#endif
+
+	return clientTokenNum;
+}
 
-int32_t FillWithClientTokenSize(char *pBufferToBeUpdatedWithClientToken, size_t maxSizeOfJsonDocument) {
+int32_t FillWithClientTokenSize(ShadowClient *pShadow, char *pBufferToBeUpdatedWithClientToken,
+								size_t maxSizeOfJsonDocument) {
 	int32_t snPrintfReturn;
-	snPrintfReturn = snprintf(pBufferToBeUpdatedWithClientToken, maxSizeOfJsonDocument, "%s-%d", mqttClientID,
-							  clientTokenNum++);
+	snPrintfReturn = snprintf(pBufferToBeUpdatedWithClientToken, maxSizeOfJsonDocument, "%s-%" PRIu32,
+							  pShadow->mqttClientID, nextClientTokenNum(pShadow));
 
 	return snPrintfReturn;
 }
 
+IoT_Error_t aws_iot_shadow_internal_fill_with_client_token(ShadowClient *pShadow, char *pBuffer, size_t bufferLen) {
+	return checkReturnValueOfSnPrintf(FillWithClientTokenSize(pShadow, pBuffer, bufferLen), bufferLen);
+}
+
 IoT_Error_t aws_iot_fill_with_client_token(char *pBufferToBeUpdatedWithClientToken, size_t maxSizeOfJsonDocument) {
 
 	int32_t snPrintfRet = 0;
-	snPrintfRet = FillWithClientTokenSize(pBufferToBeUpdatedWithClientToken, maxSizeOfJsonDocument);
+	snPrintfRet = FillWithClientTokenSize(getDefaultShadowClient(), pBufferToBeUpdatedWithClientToken,
+										  maxSizeOfJsonDocument);
 	return checkReturnValueOfSnPrintf(snPrintfRet, maxSizeOfJsonDocument);
 
 }
 
 IoT_Error_t aws_iot_finalize_json_document(char *pJsonDocument, size_t maxSizeOfJsonDocument) {
-	size_t remSizeOfJsonBuffer = maxSizeOfJsonDocument;
-	int32_t snPrintfReturn = 0;
-	size_t tempSize = 0;
-	IoT_Error_t ret_val = SUCCESS;
+	ShadowJsonBuilder_t builder;
+	size_t length;
 
 	if(pJsonDocument == NULL) {
 		return NULL_VALUE_ERROR;
 	}
 
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
+	length = strlen(pJsonDocument);
+	if(maxSizeOfJsonDocument - length <= 1) {
 		return SHADOW_JSON_ERROR;
 	}
-	remSizeOfJsonBuffer = tempSize;
 
-	// strlen(ShadowTxBuffer) - 1 is to ensure we remove the last ,(comma) that was added
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument) - 1, remSizeOfJsonBuffer, "}, \"%s\":\"",
-							  SHADOW_CLIENT_TOKEN_STRING);
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-
-	if(ret_val != SUCCESS) {
-		return ret_val;
+	if(length > 0 && ',' == pJsonDocument[length - 1]) {
+		length--;
 	}
-	// refactor this XXX repeated code
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
-		return SHADOW_JSON_ERROR;
-	}
-	remSizeOfJsonBuffer = tempSize;
-
+	builderAttach(&builder, pJsonDocument, maxSizeOfJsonDocument, length);
+	builderWrite(&builder, FINALIZE_PREFIX, sizeof(FINALIZE_PREFIX) - 1);
+	builderWriteClientToken(&builder);
 
-	snPrintfReturn = FillWithClientTokenSize(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer);
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+	return builder.status;
+}
 
-	if(ret_val != SUCCESS) {
-		return ret_val;
-	}
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
-		return SHADOW_JSON_ERROR;
-	}
-	remSizeOfJsonBuffer = tempSize;
+void FillWithClientToken(ShadowClient *pShadow, char *pBufferToBeUpdatedWithClientToken) {
+	sprintf(pBufferToBeUpdatedWithClientToken, "%s-%" PRIu32, pShadow->mqttClientID, nextClientTokenNum(pShadow));
+}
 
+static bool isTokenEqual(const char *pJsonDocument, const jsmntok_t *pToken, const char *pKey, size_t keyLen) {
+	return (size_t) (pToken->end - pToken->start) == keyLen
+		   && 0 == strncmp(pJsonDocument + pToken->start, pKey, keyLen);
+}
 
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"}");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+/* FNV-1a, the same hash is taken of registered delta keys and of the keys in received documents */
+static uint32_t extendJsonKeyHash(uint32_t hash, const char *pKey, size_t keyLen) {
+	size_t i;
 
-	return ret_val;
+	for(i = 0; i < keyLen; i++) {
+		hash ^= (uint8_t) pKey[i];
+		hash *= 16777619u;
+	}
+	return hash;
 }
 
-void FillWithClientToken(char *pBufferToBeUpdatedWithClientToken) {
-	sprintf(pBufferToBeUpdatedWithClientToken, "%s-%d", mqttClientID, clientTokenNum++);
+uint32_t hashJsonKey(const char *pKey, size_t keyLen) {
+	return extendJsonKeyHash(2166136261u, pKey, keyLen);
 }
 
-static IoT_Error_t convertDataToString(char *pStringBuffer, size_t maxSizoStringBuffer, JsonPrimitiveType type,
-									   void *pData) {
-	int32_t snPrintfReturn = 0;
-	IoT_Error_t ret_val = SUCCESS;
+/**
+ * @brief Object the key being looked at is nested in
+ */
+typedef struct {
+	int32_t keyIndex;   ///< Key token the object is the value of
+	int32_t end;        ///< End of the object in the document
+	uint32_t pathHash;  ///< hashJsonKey of the dotted path down to the key
+} JsonPathLevel_t;
+
+/* Compares the keys enclosing the key token, outermost first, followed by the key itself with a dotted path */
+static bool isTokenPathEqual(const char *pJsonDocument, const jsmntok_t *pTokens, const JsonPathLevel_t *pLevels,
+							 uint32_t depth, const jsmntok_t *pKeyToken, const char *pPath, size_t pathLen) {
+	const jsmntok_t *pSegment;
+	size_t segmentLen;
+	size_t offset = 0;
+	uint32_t level;
+
+	for(level = 0; level <= depth; level++) {
+		pSegment = (level < depth) ? &(pTokens[pLevels[level].keyIndex]) : pKeyToken;
+		segmentLen = (size_t) (pSegment->end - pSegment->start);
+		if(offset + segmentLen > pathLen
+		   || 0 != strncmp(pPath + offset, pJsonDocument + pSegment->start, segmentLen)) {
+			return false;
+		}
+		offset += segmentLen;
+		if(level < depth) {
+			if(offset >= pathLen || '.' != pPath[offset]) {
+				return false;
+			}
+			offset++;
+		}
+	}
 
-	if(maxSizoStringBuffer == 0) {
-		return SHADOW_JSON_ERROR;
+	return offset == pathLen;
+}
+
+static void matchDeltaKeys(const char *pJsonDocument, ShadowJsonParser_t *pParser, const DeltaKeyIndex_t *pDeltaKeys,
+						   int32_t keyIndex, uint32_t hash, const JsonPathLevel_t *pLevels, uint32_t depth,
+						   bool isPath) {
+	const JsonTokenTable_t *pEntry;
+	const jsmntok_t *pToken = &(pParser->tokens[keyIndex]);
+	int16_t k;
+
+	/* A key registered more than once matches every one of its entries */
+	for(k = pDeltaKeys->buckets[hash & (SHADOW_DELTA_KEY_HASH_BUCKETS - 1)]; -1 != k; k = pEntry->nextInBucket) {
+		pEntry = &(pDeltaKeys->entries[k]);
+		if(-1 != pParser->keyValueIndex[k] || pEntry->isFree || pEntry->isPath != isPath || pEntry->keyHash != hash) {
+			continue;
+		}
+		if(isPath ? isTokenPathEqual(pJsonDocument, pParser->tokens, pLevels, depth, pToken, pEntry->pKey,
+									 pEntry->keyLen)
+				  : isTokenEqual(pJsonDocument, pToken, pEntry->pKey, pEntry->keyLen)) {
+			pParser->keyValueIndex[k] = keyIndex + 1;
+		}
 	}
+}
 
-	if(type == SHADOW_JSON_INT32) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%" PRIi32",", *(int32_t *) (pData));
-	} else if(type == SHADOW_JSON_INT16) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%" PRIi16",", *(int16_t *) (pData));
-	} else if(type == SHADOW_JSON_INT8) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%" PRIi8",", *(int8_t *) (pData));
-	} else if(type == SHADOW_JSON_UINT32) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%" PRIu32",", *(uint32_t *) (pData));
-	} else if(type == SHADOW_JSON_UINT16) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%" PRIu16",", *(uint16_t *) (pData));
-	} else if(type == SHADOW_JSON_UINT8) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%" PRIu8",", *(uint8_t *) (pData));
-	} else if(type == SHADOW_JSON_DOUBLE) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%f,", *(double *) (pData));
-	} else if(type == SHADOW_JSON_FLOAT) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%f,", *(float *) (pData));
-	} else if(type == SHADOW_JSON_BOOL) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%s,", *(bool *) (pData) ? "true" : "false");
-	} else if(type == SHADOW_JSON_STRING) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "\"%s\",", (char *) (pData));
+/* One walk over the tokens finds the values of every key looked up later on */
+static void indexJsonKeys(const char *pJsonDocument, ShadowJsonParser_t *pParser, int32_t tokenCount,
+						  const DeltaKeyIndex_t *pDeltaKeys) {
+	JsonPathLevel_t levels[SHADOW_DELTA_MAX_PATH_DEPTH];
+	uint32_t depth = 0;
+	int32_t unaddressableEnd = 0;
+	int32_t i;
+	int16_t k;
+	uint32_t hash;
+	uint32_t pathHash;
+	jsmntok_t *pToken;
+	jsmntok_t *pValue;
+
+	pParser->versionIndex = -1;
+	pParser->clientTokenIndex = -1;
+	pParser->keyCount = (NULL != pDeltaKeys) ? pDeltaKeys->count : 0;
+	for(k = 0; k < (int16_t) pParser->keyCount; k++) {
+		pParser->keyValueIndex[k] = -1;
 	}
 
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, maxSizoStringBuffer);
+	for(i = 1; i < tokenCount - 1; i++) {
+		pToken = &(pParser->tokens[i]);
+		/* Tokens are in document order, so the objects ending before this one are left */
+		while(depth > 0 && pToken->start >= levels[depth - 1].end) {
+			depth--;
+		}
 
-	return ret_val;
-}
+		/* Keys are the strings followed by a value */
+		if(JSMN_STRING != pToken->type || 0 == pToken->size) {
+			continue;
+		}
+
+		if(-1 == pParser->versionIndex
+		   && isTokenEqual(pJsonDocument, pToken, SHADOW_VERSION_STRING, sizeof(SHADOW_VERSION_STRING) - 1)) {
+			pParser->versionIndex = i + 1;
+		} else if(-1 == pParser->clientTokenIndex
+				  && isTokenEqual(pJsonDocument, pToken, SHADOW_CLIENT_TOKEN_STRING,
+								  sizeof(SHADOW_CLIENT_TOKEN_STRING) - 1)) {
+			pParser->clientTokenIndex = i + 1;
+		}
+
+		if(0 == pParser->keyCount) {
+			continue;
+		}
+
+		hash = hashJsonKey(pJsonDocument + pToken->start, (size_t) (pToken->end - pToken->start));
+		matchDeltaKeys(pJsonDocument, pParser, pDeltaKeys, i, hash, levels, depth, false);
+
+		/* Keys inside arrays, or nested deeper than a path can reach, have no path */
+		if(pToken->start < unaddressableEnd) {
+			continue;
+		}
+
+		pathHash = hash;
+		if(depth > 0) {
+			pathHash = extendJsonKeyHash(levels[depth - 1].pathHash, ".", 1);
+			pathHash = extendJsonKeyHash(pathHash, pJsonDocument + pToken->start,
+										 (size_t) (pToken->end - pToken->start));
+			matchDeltaKeys(pJsonDocument, pParser, pDeltaKeys, i, pathHash, levels, depth, true);
+		}
 
-static jsmn_parser shadowJsonParser;
-static jsmntok_t jsonTokenStruct[MAX_JSON_TOKEN_EXPECTED];
+		pValue = &(pParser->tokens[i + 1]);
+		if(JSMN_OBJECT == pValue->type && depth < SHADOW_DELTA_MAX_PATH_DEPTH) {
+			levels[depth].keyIndex = i;
+			levels[depth].end = pValue->end;
+			levels[depth].pathHash = pathHash;
+			depth++;
+		} else if(JSMN_OBJECT == pValue->type || JSMN_ARRAY == pValue->type) {
+			unaddressableEnd = pValue->end;
+		}
+	}
+}
 
-bool isJsonValidAndParse(const char *pJsonDocument, void *pJsonHandler, int32_t *pTokenCount) {
+static int32_t parseJsonObject(const char *pJsonDocument, size_t jsonDocumentLen, ShadowJsonParser_t *pParser,
+							   const DeltaKeyIndex_t *pDeltaKeys) {
 	int32_t tokenCount;
-	(void)pJsonHandler;
 
-	jsmn_init(&shadowJsonParser);
+	jsmn_init(&(pParser->parser));
 
-	tokenCount = jsmn_parse(&shadowJsonParser, pJsonDocument, strlen(pJsonDocument), jsonTokenStruct,
-							sizeof(jsonTokenStruct) / sizeof(jsonTokenStruct[0]));
+	tokenCount = jsmn_parse(&(pParser->parser), pJsonDocument, jsonDocumentLen, pParser->tokens,
+							sizeof(pParser->tokens) / sizeof(pParser->tokens[0]));
 
 	if(tokenCount < 0) {
 		IOT_WARN("Failed to parse JSON: %d\n", tokenCount);
-		return false;
+		return -1;
 	}
 
 	/* Assume the top-level element is an object */
-	if(tokenCount < 1 || jsonTokenStruct[0].type != JSMN_OBJECT) {
+	if(tokenCount < 1 || pParser->tokens[0].type != JSMN_OBJECT) {
+		return -1;
+	}
+
+	indexJsonKeys(pJsonDocument, pParser, tokenCount, pDeltaKeys);
+
+	return tokenCount;
+}
+
+bool isJsonValidAndParse(const char *pJsonDocument, size_t jsonDocumentLen, void *pJsonHandler,
+						 int32_t *pTokenCount) {
+	return isDeltaJsonValidAndParse(pJsonDocument, jsonDocumentLen, pJsonHandler, NULL, pTokenCount);
+}
+
+bool isDeltaJsonValidAndParse(const char *pJsonDocument, size_t jsonDocumentLen, void *pJsonHandler,
+							  const DeltaKeyIndex_t *pDeltaKeys, int32_t *pTokenCount) {
+	int32_t tokenCount;
+
+	tokenCount = parseJsonObject(pJsonDocument, jsonDocumentLen, (ShadowJsonParser_t *) pJsonHandler, pDeltaKeys);
+	if(tokenCount < 0) {
 		IOT_WARN("Top Level is not an object\n");
 		return false;
 	}
 
-	pJsonHandler = (void *) jsonTokenStruct;
 	*pTokenCount = tokenCount;
 
 	return true;
 }
 
+int32_t skipJsonValue(void *pJsonHandler, int32_t tokenCount, int32_t valueIndex) {
+	ShadowJsonParser_t *pParser = (ShadowJsonParser_t *) pJsonHandler;
+	int32_t valueEnd = pParser->tokens[valueIndex].end;
+	int32_t i;
+
+	/* Tokens nested in the value start before it ends */
+	i = valueIndex + 1;
+	while(i < tokenCount && pParser->tokens[i].start < valueEnd) {
+		i++;
+	}
+	return i;
+}
+
+static int32_t findObjectMember(const char *pJsonDocument, ShadowJsonParser_t *pParser, int32_t tokenCount,
+								int32_t objectIndex, const char *pKey) {
+	int32_t i = objectIndex + 1;
+	size_t keyLen = strlen(pKey);
+
+	while(i + 1 < tokenCount && pParser->tokens[i].start < pParser->tokens[objectIndex].end) {
+		if(isTokenEqual(pJsonDocument, &(pParser->tokens[i]), pKey, keyLen)) {
+			return i + 1;
+		}
+		i = skipJsonValue(pParser, tokenCount, i + 1);
+	}
+	return -1;
+}
+
+int32_t findReportedStateObject(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount) {
+	ShadowJsonParser_t *pParser = (ShadowJsonParser_t *) pJsonHandler;
+	int32_t stateIndex;
+	int32_t reportedIndex;
+
+	stateIndex = findObjectMember(pJsonDocument, pParser, tokenCount, 0, "state");
+	if(-1 == stateIndex || JSMN_OBJECT != pParser->tokens[stateIndex].type) {
+		return -1;
+	}
+
+	reportedIndex = findObjectMember(pJsonDocument, pParser, tokenCount, stateIndex, "reported");
+	if(-1 == reportedIndex || JSMN_OBJECT != pParser->tokens[reportedIndex].type) {
+		return -1;
+	}
+	return reportedIndex;
+}
+
 static IoT_Error_t UpdateValueIfNoObject(const char *pJsonString, jsonStruct_t *pDataStruct, jsmntok_t token) {
 	IoT_Error_t ret_val = SUCCESS;
 	if(pDataStruct->type == SHADOW_JSON_BOOL) {
@@ -375,93 +768,51 @@ static IoT_Error_t UpdateValueIfNoObject(const char *pJsonString, jsonStruct_t *
 	return ret_val;
 }
 
-bool isJsonKeyMatchingAndUpdateValue(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount,
-									 jsonStruct_t *pDataStruct, uint32_t *pDataLength, int32_t *pDataPosition) {
-	int32_t i;
-	uint32_t dataLength;
+bool isDeltaKeyPresentAndUpdateValue(const char *pJsonDocument, void *pJsonHandler, uint32_t keyIndex,
+									  jsonStruct_t *pDataStruct, uint32_t *pDataLength, int32_t *pDataPosition) {
+	ShadowJsonParser_t *pParser = (ShadowJsonParser_t *) pJsonHandler;
 	jsmntok_t dataToken;
 
-	for(i = 1; i < tokenCount; i++) {
-		if(jsoneq(pJsonDocument, &(jsonTokenStruct[i]), pDataStruct->pKey) == 0) {
-			dataToken = jsonTokenStruct[i + 1];
-			dataLength = (uint32_t) (dataToken.end - dataToken.start);
-			UpdateValueIfNoObject(pJsonDocument, pDataStruct, dataToken);
-			*pDataPosition = dataToken.start;
-			*pDataLength = dataLength;
-			return true;
-		}
-	}
-	return false;
-}
-
-bool isReceivedJsonValid(const char *pJsonDocument) {
-	int32_t tokenCount;
-
-	jsmn_init(&shadowJsonParser);
-
-	tokenCount = jsmn_parse(&shadowJsonParser, pJsonDocument, strlen(pJsonDocument), jsonTokenStruct,
-							sizeof(jsonTokenStruct) / sizeof(jsonTokenStruct[0]));
-
-	if(tokenCount < 0) {
-		IOT_WARN("Failed to parse JSON: %d\n", tokenCount);
-		return false;
-	}
-
-	/* Assume the top-level element is an object */
-	if(tokenCount < 1 || jsonTokenStruct[0].type != JSMN_OBJECT) {
+	if(keyIndex >= pParser->keyCount || -1 == pParser->keyValueIndex[keyIndex]) {
 		return false;
 	}
 
+	dataToken = pParser->tokens[pParser->keyValueIndex[keyIndex]];
+	UpdateValueIfNoObject(pJsonDocument, pDataStruct, dataToken);
+	*pDataPosition = dataToken.start;
+	*pDataLength = (uint32_t) (dataToken.end - dataToken.start);
 	return true;
 }
 
-bool extractClientToken(const char *pJsonDocument, char *pExtractedClientToken) {
-	int32_t tokenCount, i;
-	uint8_t length;
-	jsmntok_t ClientJsonToken;
-	jsmn_init(&shadowJsonParser);
-
-	tokenCount = jsmn_parse(&shadowJsonParser, pJsonDocument, strlen(pJsonDocument), jsonTokenStruct,
-							sizeof(jsonTokenStruct) / sizeof(jsonTokenStruct[0]));
+bool isReceivedJsonValid(const char *pJsonDocument, void *pJsonHandler) {
+	return parseJsonObject(pJsonDocument, strlen(pJsonDocument), (ShadowJsonParser_t *) pJsonHandler, NULL) >= 0;
+}
 
-	if(tokenCount < 0) {
-		IOT_WARN("Failed to parse JSON: %d\n", tokenCount);
-		return false;
-	}
+bool extractClientToken(const char *pJsonDocument, void *pJsonHandler, char *pExtractedClientToken) {
+	ShadowJsonParser_t *pParser = (ShadowJsonParser_t *) pJsonHandler;
+	jsmntok_t ClientJsonToken;
+	uint8_t length;
 
-	/* Assume the top-level element is an object */
-	if(tokenCount < 1 || jsonTokenStruct[0].type != JSMN_OBJECT) {
+	if(-1 == pParser->clientTokenIndex) {
 		return false;
 	}
 
-	for(i = 1; i < tokenCount; i++) {
-		if(jsoneq(pJsonDocument, &jsonTokenStruct[i], SHADOW_CLIENT_TOKEN_STRING) == 0) {
-			ClientJsonToken = jsonTokenStruct[i + 1];
-			length = (uint8_t) (ClientJsonToken.end - ClientJsonToken.start);
-			strncpy(pExtractedClientToken, pJsonDocument + ClientJsonToken.start, length);
-			pExtractedClientToken[length] = '\0';
-			return true;
-		}
-	}
-
-	return false;
+	ClientJsonToken = pParser->tokens[pParser->clientTokenIndex];
+	length = (uint8_t) (ClientJsonToken.end - ClientJsonToken.start);
+	strncpy(pExtractedClientToken, pJsonDocument + ClientJsonToken.start, length);
+	pExtractedClientToken[length] = '\0';
+	return true;
 }
 
-bool extractVersionNumber(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount, uint32_t *pVersionNumber) {
-	int32_t i;
-	IoT_Error_t ret_val = SUCCESS;
-
-	IOT_UNUSED(pJsonHandler);
+bool extractVersionNumber(const char *pJsonDocument, void *pJsonHandler, uint32_t *pVersionNumber) {
+	ShadowJsonParser_t *pParser = (ShadowJsonParser_t *) pJsonHandler;
 
-	for(i = 1; i < tokenCount; i++) {
-		if(jsoneq(pJsonDocument, &(jsonTokenStruct[i]), SHADOW_VERSION_STRING) == 0) {
-			ret_val = parseUnsignedInteger32Value(pVersionNumber, pJsonDocument, &jsonTokenStruct[i + 1]);
-			if(ret_val == SUCCESS) {
-				return true;
-			}
-		}
+	if(-1 == pParser->versionIndex) {
+		return false;
 	}
-	return false;
+
+	return SUCCESS == parseUnsignedInteger32Value(pVersionNumber, pJsonDocument,
+												  &(pParser->tokens[pParser->versionIndex]));
 }
 
 #ifdef __cplusplus
@@ -26,6 +26,7 @@ extern "C" {
 
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 
 #include "timer_interface.h"
 #include "aws_iot_json_utils.h"
@@ -33,54 +34,15 @@ extern "C" {
 #include "aws_iot_shadow_json.h"
 #include "aws_iot_config.h"
 
-typedef struct {
-	char clientTokenID[MAX_SIZE_CLIENT_ID_WITH_SEQUENCE];
-	char thingName[MAX_SIZE_OF_THING_NAME];
-	ShadowActions_t action;
-	fpActionCallback_t callback;
-	void *pCallbackContext;
-	bool isFree;
-	Timer timer;
-} ToBeReceivedAckRecord_t;
-
-typedef struct {
-	const char *pKey;
-	void *pStruct;
-	jsonStructCallback_t callback;
-	bool isFree;
-} JsonTokenTable_t;
-
-typedef struct {
-	char Topic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
-	uint8_t count;
-	bool isFree;
-	bool isSticky;
-} SubscriptionRecord_t;
-
 typedef enum {
 	SHADOW_ACCEPTED, SHADOW_REJECTED, SHADOW_ACTION
 } ShadowAckTopicTypes_t;
 
-ToBeReceivedAckRecord_t AckWaitList[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
-
-AWS_IoT_Client *pMqttClient;
-
-char myThingName[MAX_SIZE_OF_THING_NAME];
-char mqttClientID[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES];
-
-char shadowDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
-
-#define MAX_TOPICS_AT_ANY_GIVEN_TIME 2*MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME
-SubscriptionRecord_t SubscriptionList[MAX_TOPICS_AT_ANY_GIVEN_TIME];
-
-#define SUBSCRIBE_SETTLING_TIME 2
-char shadowRxBuf[SHADOW_MAX_SIZE_OF_RX_BUFFER];
+/* Responses to the gets of aws_iot_shadow_get_many, for every thing */
+#define SHADOW_BULK_GET_ACK_TOPIC "$aws/things/+/shadow/get/+"
 
-static JsonTokenTable_t tokenTable[MAX_JSON_TOKEN_EXPECTED];
-static uint32_t tokenTableIndex = 0;
-static bool deltaTopicSubscribedFlag = false;
-uint32_t shadowJsonVersionNum = 0;
-bool shadowDiscardOldDeltaFlag = true;
+/* Used by shadow clients initialized without a ShadowClient of their own */
+static ShadowClient defaultShadowClient;
 
 // local helper functions
 static void AckStatusCallback(AWS_IoT_Client *pClient, char *topicName,
@@ -92,48 +54,216 @@ static void shadow_delta_callback(AWS_IoT_Client *pClient, char *topicName,
 static void topicNameFromThingAndAction(char *pTopic, const char *pThingName, ShadowActions_t action,
 										ShadowAckTopicTypes_t ackType);
 
-static int16_t getNextFreeIndexOfSubscriptionList(void);
+static int16_t getNextFreeIndexOfSubscriptionList(ShadowClient *pShadow);
+
+static void unsubscribeFromAcceptedAndRejected(ShadowClient *pShadow, uint16_t index);
+
+static int16_t findAckByClientToken(ShadowClient *pShadow, const char *pClientToken);
+
+static void removeAckFromClientTokenIndex(ShadowClient *pShadow, uint16_t index);
+
+static void ackTimerExpired(IoT_Timer_Wheel_Entry *pEntry, void *pData);
+
+ShadowClient *getDefaultShadowClient(void) {
+	return &defaultShadowClient;
+}
 
-static void unsubscribeFromAcceptedAndRejected(uint8_t index);
+ShadowClient *getShadowClient(AWS_IoT_Client *pClient) {
+	if(NULL != pClient && NULL != pClient->pShadowClient) {
+		return pClient->pShadowClient;
+	}
+	return &defaultShadowClient;
+}
 
-void initDeltaTokens(void) {
+void initDeltaTokens(ShadowClient *pShadow) {
 	uint32_t i;
 	for(i = 0; i < MAX_JSON_TOKEN_EXPECTED; i++) {
-		tokenTable[i].isFree = true;
+		pShadow->deltaKeys.entries[i].isFree = true;
+	}
+	for(i = 0; i < SHADOW_DELTA_KEY_HASH_BUCKETS; i++) {
+		pShadow->deltaKeys.buckets[i] = -1;
 	}
-	tokenTableIndex = 0;
-	deltaTopicSubscribedFlag = false;
+	pShadow->deltaKeys.count = 0;
+	pShadow->isDeltaTopicSubscribed = false;
 }
 
-IoT_Error_t registerJsonTokenOnDelta(jsonStruct_t *pStruct) {
+IoT_Error_t registerJsonTokenOnDelta(ShadowClient *pShadow, jsonStruct_t *pStruct) {
 
 	IoT_Error_t rc = SUCCESS;
+	DeltaKeyIndex_t *pKeys = &(pShadow->deltaKeys);
+	JsonTokenTable_t *pEntry;
+	uint32_t bucket;
+	uint32_t pathDepth = 0;
+	size_t keyLen = strlen(pStruct->pKey);
+	size_t i;
+
+	for(i = 0; i < keyLen; i++) {
+		if('.' == pStruct->pKey[i]) {
+			pathDepth++;
+		}
+	}
+	if(pathDepth > SHADOW_DELTA_MAX_PATH_DEPTH) {
+		return FAILURE;
+	}
 
-	if(!deltaTopicSubscribedFlag) {
-		snprintf(shadowDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, "$aws/things/%s/shadow/update/delta", myThingName);
-		rc = aws_iot_mqtt_subscribe(pMqttClient, shadowDeltaTopic, (uint16_t) strlen(shadowDeltaTopic), QOS0,
-									shadow_delta_callback, NULL);
-		deltaTopicSubscribedFlag = true;
+	if(!pShadow->isDeltaTopicSubscribed) {
+		snprintf(pShadow->shadowDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, "$aws/things/%s/shadow/update/delta",
+				 pShadow->myThingName);
+		rc = aws_iot_mqtt_subscribe(pShadow->pMqttClient, pShadow->shadowDeltaTopic,
+									(uint16_t) strlen(pShadow->shadowDeltaTopic), QOS0, shadow_delta_callback, pShadow);
+		pShadow->isDeltaTopicSubscribed = true;
 	}
 
-	if(tokenTableIndex >= MAX_JSON_TOKEN_EXPECTED) {
+	if(pKeys->count >= MAX_JSON_TOKEN_EXPECTED) {
 		return FAILURE;
 	}
 
-	tokenTable[tokenTableIndex].pKey = pStruct->pKey;
-	tokenTable[tokenTableIndex].callback = pStruct->cb;
-	tokenTable[tokenTableIndex].pStruct = pStruct;
-	tokenTable[tokenTableIndex].isFree = false;
-	tokenTableIndex++;
+	pEntry = &(pKeys->entries[pKeys->count]);
+	pEntry->pKey = pStruct->pKey;
+	pEntry->keyLen = keyLen;
+	pEntry->keyHash = hashJsonKey(pEntry->pKey, pEntry->keyLen);
+	pEntry->callback = pStruct->cb;
+	pEntry->pStruct = pStruct;
+	pEntry->isFree = false;
+	pEntry->isPath = (pathDepth > 0);
+
+	bucket = pEntry->keyHash & (SHADOW_DELTA_KEY_HASH_BUCKETS - 1);
+	pEntry->nextInBucket = pKeys->buckets[bucket];
+	pKeys->buckets[bucket] = (int16_t) pKeys->count;
+	pKeys->count++;
 
 	return rc;
 }
 
-static int16_t getNextFreeIndexOfSubscriptionList(void) {
+void registerReportCache(ShadowClient *pShadow, ShadowReportCache_t *pCache) {
+	ShadowReportCache_t *pCurrent;
+
+	for(pCurrent = pShadow->pReportCaches; NULL != pCurrent; pCurrent = pCurrent->pNext) {
+		if(pCurrent == pCache) {
+			return;
+		}
+	}
+	pCache->pNext = pShadow->pReportCaches;
+	pShadow->pReportCaches = pCache;
+}
+
+void registerUpdateQueue(AWS_IoT_Client *pClient, ShadowUpdateQueue_t *pQueue) {
+	ShadowClient *pShadow = getShadowClient(pClient);
+	ShadowUpdateQueue_t *pCurrent;
+
+	for(pCurrent = pShadow->pUpdateQueues; NULL != pCurrent; pCurrent = pCurrent->pNext) {
+		if(pCurrent == pQueue) {
+			/* Started again, its deadlines may still be scheduled */
+			aws_iot_mqtt_timer_stop(pClient, &(pQueue->flushTimer));
+			aws_iot_mqtt_timer_stop(pClient, &(pQueue->refillTimer));
+			break;
+		}
+	}
+	if(NULL == pCurrent) {
+		pQueue->pNext = pShadow->pUpdateQueues;
+		pShadow->pUpdateQueues = pQueue;
+	}
+	aws_iot_timer_wheel_init_entry(&(pQueue->flushTimer), NULL, NULL);
+	aws_iot_timer_wheel_init_entry(&(pQueue->refillTimer), NULL, NULL);
+}
+
+/* Takes the value of a field from state.reported, a value of another type or null leaves it unknown */
+static void acknowledgeReportedField(ShadowReportedField_t *pField, const char *pPayload, jsmntok_t *pValue) {
+	bool boolValue;
+
+	pField->isAcknowledged = false;
+	if(pField->pStruct->type == SHADOW_JSON_BOOL) {
+		if(SUCCESS == parseBooleanValue(&boolValue, pPayload, pValue)) {
+			pField->acknowledgedNumber = boolValue ? 1 : 0;
+			pField->isAcknowledged = true;
+		}
+	} else if(pField->pStruct->type == SHADOW_JSON_STRING) {
+		if(JSMN_STRING == pValue->type) {
+			pField->acknowledgedHash = hashJsonKey(pPayload + pValue->start, (size_t) (pValue->end - pValue->start));
+			pField->isAcknowledged = true;
+		}
+	} else if(pField->pStruct->type == SHADOW_JSON_OBJECT) {
+		pField->acknowledgedHash = hashJsonKey(pPayload + pValue->start, (size_t) (pValue->end - pValue->start));
+		pField->isAcknowledged = true;
+	} else if(SUCCESS == parseDoubleValue(&(pField->acknowledgedNumber), pPayload, pValue)) {
+		pField->isAcknowledged = true;
+	}
+}
+
+/* Accepted documents of get hold the whole reported state, those of update the fields that were updated */
+static void updateReportCache(ShadowReportCache_t *pCache, ShadowActions_t action, const char *pPayload,
+							  ShadowJsonParser_t *pParser, int32_t tokenCount) {
+	ShadowReportedField_t *pField;
+	jsmntok_t *pKey;
+	int32_t reportedIndex = -1;
+	int32_t i;
+	uint8_t f;
+
+	if(SHADOW_DELETE != action) {
+		reportedIndex = findReportedStateObject(pPayload, pParser, tokenCount);
+	}
+
+	if(SHADOW_UPDATE != action) {
+		for(f = 0; f < pCache->fieldCount; f++) {
+			pCache->pFields[f].isAcknowledged = false;
+		}
+	}
+
+	if(-1 == reportedIndex) {
+		return;
+	}
+
+	i = reportedIndex + 1;
+	while(i + 1 < tokenCount && pParser->tokens[i].start < pParser->tokens[reportedIndex].end) {
+		pKey = &(pParser->tokens[i]);
+		for(f = 0; f < pCache->fieldCount; f++) {
+			pField = &(pCache->pFields[f]);
+			if(strlen(pField->pStruct->pKey) == (size_t) (pKey->end - pKey->start)
+			   && 0 == strncmp(pPayload + pKey->start, pField->pStruct->pKey, (size_t) (pKey->end - pKey->start))) {
+				acknowledgeReportedField(pField, pPayload, &(pParser->tokens[i + 1]));
+			}
+		}
+		i = skipJsonValue(pParser, tokenCount, i + 1);
+	}
+}
+
+/* Topics are $aws/things/<thing name>/shadow/<action>/accepted */
+static void updateReportCaches(ShadowClient *pShadow, const char *pTopicName, uint16_t topicNameLen,
+							   const char *pPayload, int32_t tokenCount) {
+	static const char topicPrefix[] = "$aws/things/";
+	static const char *const acceptedSuffixes[] = {"/shadow/get/accepted", "/shadow/update/accepted",
+												   "/shadow/delete/accepted"};
+	static const ShadowActions_t acceptedActions[] = {SHADOW_GET, SHADOW_UPDATE, SHADOW_DELETE};
+	ShadowReportCache_t *pCache;
+	size_t thingNameLen;
+	size_t suffixLen;
+	uint8_t a;
+
+	if(topicNameLen <= sizeof(topicPrefix) - 1 || 0 != strncmp(pTopicName, topicPrefix, sizeof(topicPrefix) - 1)) {
+		return;
+	}
+
+	for(pCache = pShadow->pReportCaches; NULL != pCache; pCache = pCache->pNext) {
+		thingNameLen = strlen(pCache->pThingName);
+		if(sizeof(topicPrefix) - 1 + thingNameLen >= topicNameLen
+		   || 0 != strncmp(pTopicName + sizeof(topicPrefix) - 1, pCache->pThingName, thingNameLen)) {
+			continue;
+		}
+		suffixLen = topicNameLen - (sizeof(topicPrefix) - 1 + thingNameLen);
+		for(a = 0; a < sizeof(acceptedActions) / sizeof(acceptedActions[0]); a++) {
+			if(strlen(acceptedSuffixes[a]) == suffixLen
+			   && 0 == strncmp(pTopicName + topicNameLen - suffixLen, acceptedSuffixes[a], suffixLen)) {
+				updateReportCache(pCache, acceptedActions[a], pPayload, &(pShadow->jsonParser), tokenCount);
+			}
+		}
+	}
+}
+
+static int16_t getNextFreeIndexOfSubscriptionList(ShadowClient *pShadow) {
 	uint8_t i;
 	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(SubscriptionList[i].isFree) {
-			SubscriptionList[i].isFree = false;
+		if(pShadow->subscriptionList[i].isFree) {
+			pShadow->subscriptionList[i].isFree = false;
 			return i;
 		}
 	}
@@ -168,78 +298,132 @@ static void topicNameFromThingAndAction(char *pTopic, const char *pThingName, Sh
 	}
 }
 
-static bool isAckForMyThingName(const char *pTopicName) {
-	if(strstr(pTopicName, myThingName) != NULL &&
-	   ((strstr(pTopicName, "get/accepted") != NULL) || (strstr(pTopicName, "update/accepted") != NULL) ||
-		(strstr(pTopicName, "delta") != NULL))) {
-		return true;
-	}
-	return false;
+static bool isTopicEndingWith(const char *pTopicName, uint16_t topicNameLen, const char *pSuffix) {
+	size_t suffixLen = strlen(pSuffix);
+
+	return topicNameLen >= suffixLen && 0 == strncmp(pTopicName + topicNameLen - suffixLen, pSuffix, suffixLen);
 }
 
-static void AckStatusCallback(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
-							  IoT_Publish_Message_Params *params, void *pData) {
-	int32_t tokenCount;
-	uint8_t i;
-	void *pJsonHandler = NULL;
-	char temporaryClientToken[MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE];
+/* Only $aws/things/<my thing name>/shadow/... counts, wildcard subscriptions also deliver other things' responses */
+static bool isAckForMyThingName(ShadowClient *pShadow, const char *pTopicName, uint16_t topicNameLen) {
+	static const char topicPrefix[] = "$aws/things/";
+	static const char shadowInfix[] = "/shadow/";
+	size_t thingNameLen = strlen(pShadow->myThingName);
+	size_t prefixLen = sizeof(topicPrefix) - 1 + thingNameLen + sizeof(shadowInfix) - 1;
+
+	if(topicNameLen <= prefixLen || 0 != strncmp(pTopicName, topicPrefix, sizeof(topicPrefix) - 1)
+	   || 0 != strncmp(pTopicName + sizeof(topicPrefix) - 1, pShadow->myThingName, thingNameLen)
+	   || 0 != strncmp(pTopicName + sizeof(topicPrefix) - 1 + thingNameLen, shadowInfix, sizeof(shadowInfix) - 1)) {
+		return false;
+	}
 
+	return isTopicEndingWith(pTopicName, topicNameLen, "/get/accepted")
+		   || isTopicEndingWith(pTopicName, topicNameLen, "/update/accepted")
+		   || isTopicEndingWith(pTopicName, topicNameLen, "/update/delta");
+}
+
+/*
+ * Buffer the document is handed to the action callback in, as a string. Larger acks than rxBuf only
+ * arrive when the MQTT read buffer grew for them, they get a buffer from the client's allocator
+ * for the duration of the callback. NULL if the document can not be copied.
+ */
+static char *acquireAckDocumentBuffer(AWS_IoT_Client *pClient, ShadowClient *pShadow, size_t payloadLen) {
+	if(payloadLen < SHADOW_MAX_SIZE_OF_RX_BUFFER) {
+		return pShadow->rxBuf;
+	}
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	return (char *) pClient->clientData.pBufferAllocate(payloadLen + 1, pClient->clientData.pBufferAllocatorData);
+#else
 	IOT_UNUSED(pClient);
-	IOT_UNUSED(topicNameLen);
-	IOT_UNUSED(pData);
+	return NULL;
+#endif
+}
 
-	if(params->payloadLen > SHADOW_MAX_SIZE_OF_RX_BUFFER) {
-		IOT_WARN("Payload larger than RX Buffer");
-		return;
+static void releaseAckDocumentBuffer(AWS_IoT_Client *pClient, ShadowClient *pShadow, char *pDocument,
+									 size_t payloadLen) {
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	if(pDocument != pShadow->rxBuf) {
+		pClient->clientData.pBufferFree(pDocument, payloadLen + 1, pClient->clientData.pBufferAllocatorData);
 	}
+#else
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pShadow);
+	IOT_UNUSED(pDocument);
+	IOT_UNUSED(payloadLen);
+#endif
+}
 
-	memcpy(shadowRxBuf, params->payload, params->payloadLen);
-	shadowRxBuf[params->payloadLen] = '\0';    // jsmn_parse relies on a string
+static void AckStatusCallback(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+							  IoT_Publish_Message_Params *params, void *pData) {
+	int32_t tokenCount;
+	int16_t index;
+	ShadowClient *pShadow = (ShadowClient *) pData;
+	void *pJsonHandler = &(pShadow->jsonParser);
+	const char *pPayload = (const char *) params->payload;
+	char temporaryClientToken[MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE];
+	Shadow_Ack_Status_t status;
+	ToBeReceivedAckRecord_t *pRecord;
+	char *pDocument;
 
-	if(!isJsonValidAndParse(shadowRxBuf, pJsonHandler, &tokenCount)) {
+	/* Parsed where it was received, whatever its size. It is only copied for the callback, which gets a string */
+	if(!isJsonValidAndParse(pPayload, params->payloadLen, pJsonHandler, &tokenCount)) {
 		IOT_WARN("Received JSON is not valid");
 		return;
 	}
 
-	if(isAckForMyThingName(topicName)) {
+	updateReportCaches(pShadow, topicName, topicNameLen, pPayload, tokenCount);
+
+	if(isAckForMyThingName(pShadow, topicName, topicNameLen)) {
 		uint32_t tempVersionNumber = 0;
-		if(extractVersionNumber(shadowRxBuf, pJsonHandler, tokenCount, &tempVersionNumber)) {
-			if(tempVersionNumber > shadowJsonVersionNum) {
-				shadowJsonVersionNum = tempVersionNumber;
+		if(extractVersionNumber(pPayload, pJsonHandler, &tempVersionNumber)) {
+			if(tempVersionNumber > pShadow->jsonVersionNum) {
+				pShadow->jsonVersionNum = tempVersionNumber;
 			}
 		}
 	}
 
-	if(extractClientToken(shadowRxBuf, temporaryClientToken)) {
-		for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-			if(!AckWaitList[i].isFree) {
-				if(strcmp(AckWaitList[i].clientTokenID, temporaryClientToken) == 0) {
-					Shadow_Ack_Status_t status;
-					if(strstr(topicName, "accepted") != NULL) {
-						status = SHADOW_ACK_ACCEPTED;
-					} else if(strstr(topicName, "rejected") != NULL) {
-						status = SHADOW_ACK_REJECTED;
-					}
-					if(status == SHADOW_ACK_ACCEPTED || status == SHADOW_ACK_REJECTED) {
-						if(AckWaitList[i].callback != NULL) {
-							AckWaitList[i].callback(AckWaitList[i].thingName, AckWaitList[i].action, status,
-													shadowRxBuf, AckWaitList[i].pCallbackContext);
-						}
-						unsubscribeFromAcceptedAndRejected(i);
-						AckWaitList[i].isFree = true;
-						return;
-					}
-				}
-			}
+	if(!extractClientToken(pPayload, pJsonHandler, temporaryClientToken)) {
+		return;
+	}
+
+	index = findAckByClientToken(pShadow, temporaryClientToken);
+	if(0 > index) {
+		return;
+	}
+
+	/* Checked at the end, responses on the wildcard topics can come for any thing name */
+	if(isTopicEndingWith(topicName, topicNameLen, "/accepted")) {
+		status = SHADOW_ACK_ACCEPTED;
+	} else if(isTopicEndingWith(topicName, topicNameLen, "/rejected")) {
+		status = SHADOW_ACK_REJECTED;
+	} else {
+		return;
+	}
+
+	pRecord = &(pShadow->ackWaitList[index]);
+	if(pRecord->callback != NULL) {
+		pDocument = acquireAckDocumentBuffer(pClient, pShadow, params->payloadLen);
+		if(NULL == pDocument) {
+			/* left to time out, as if it had not arrived */
+			IOT_WARN("Payload larger than RX Buffer");
+			return;
 		}
+		memcpy(pDocument, pPayload, params->payloadLen);
+		pDocument[params->payloadLen] = '\0';
+		pRecord->callback(pRecord->thingName, pRecord->action, status, pDocument, pRecord->pCallbackContext);
+		releaseAckDocumentBuffer(pClient, pShadow, pDocument, params->payloadLen);
 	}
+	removeAckFromClientTokenIndex(pShadow, (uint16_t) index);
+	unsubscribeFromAcceptedAndRejected(pShadow, (uint16_t) index);
+	aws_iot_mqtt_timer_stop(pShadow->pMqttClient, &(pRecord->timer));
+	releaseAckWaitListIndex(pShadow, (uint16_t) index);
 }
 
-static int16_t findIndexOfSubscriptionList(const char *pTopic) {
+static int16_t findIndexOfSubscriptionList(ShadowClient *pShadow, const char *pTopic) {
 	uint8_t i;
 	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(!SubscriptionList[i].isFree) {
-			if((strcmp(pTopic, SubscriptionList[i].Topic) == 0)) {
+		if(!pShadow->subscriptionList[i].isFree) {
+			if((strcmp(pTopic, pShadow->subscriptionList[i].Topic) == 0)) {
 				return i;
 			}
 		}
@@ -247,7 +431,7 @@ static int16_t findIndexOfSubscriptionList(const char *pTopic) {
 	return -1;
 }
 
-static void unsubscribeFromAcceptedAndRejected(uint8_t index) {
+static void unsubscribeFromAcceptedAndRejected(ShadowClient *pShadow, uint16_t index) {
 
 	char TemporaryTopicNameAccepted[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	char TemporaryTopicNameRejected[MAX_SHADOW_TOPIC_LENGTH_BYTES];
@@ -255,53 +439,75 @@ static void unsubscribeFromAcceptedAndRejected(uint8_t index) {
 
 	int16_t indexSubList;
 
-	topicNameFromThingAndAction(TemporaryTopicNameAccepted, AckWaitList[index].thingName, AckWaitList[index].action,
-								SHADOW_ACCEPTED);
-	topicNameFromThingAndAction(TemporaryTopicNameRejected, AckWaitList[index].thingName, AckWaitList[index].action,
-								SHADOW_REJECTED);
+	/* The wildcard topics of bulk gets stay subscribed */
+	if(pShadow->ackWaitList[index].isWildcardAck) {
+		return;
+	}
+
+	topicNameFromThingAndAction(TemporaryTopicNameAccepted, pShadow->ackWaitList[index].thingName,
+								pShadow->ackWaitList[index].action, SHADOW_ACCEPTED);
+	topicNameFromThingAndAction(TemporaryTopicNameRejected, pShadow->ackWaitList[index].thingName,
+								pShadow->ackWaitList[index].action, SHADOW_REJECTED);
 
-	indexSubList = findIndexOfSubscriptionList(TemporaryTopicNameAccepted);
+	indexSubList = findIndexOfSubscriptionList(pShadow, TemporaryTopicNameAccepted);
 	if((indexSubList >= 0)) {
-		if(!SubscriptionList[indexSubList].isSticky && (SubscriptionList[indexSubList].count == 1)) {
-			ret_val = aws_iot_mqtt_unsubscribe(pMqttClient, TemporaryTopicNameAccepted,
+		if(!pShadow->subscriptionList[indexSubList].isSticky && (pShadow->subscriptionList[indexSubList].count == 1)) {
+			ret_val = aws_iot_mqtt_unsubscribe(pShadow->pMqttClient, TemporaryTopicNameAccepted,
 											   (uint16_t) strlen(TemporaryTopicNameAccepted));
 			if(ret_val == SUCCESS) {
-				SubscriptionList[indexSubList].isFree = true;
+				pShadow->subscriptionList[indexSubList].isFree = true;
 			}
-		} else if(SubscriptionList[indexSubList].count > 1) {
-			SubscriptionList[indexSubList].count--;
+		} else if(pShadow->subscriptionList[indexSubList].count > 1) {
+			pShadow->subscriptionList[indexSubList].count--;
 		}
 	}
 
-	indexSubList = findIndexOfSubscriptionList(TemporaryTopicNameRejected);
+	indexSubList = findIndexOfSubscriptionList(pShadow, TemporaryTopicNameRejected);
 	if((indexSubList >= 0)) {
-		if(!SubscriptionList[indexSubList].isSticky && (SubscriptionList[indexSubList].count == 1)) {
-			ret_val = aws_iot_mqtt_unsubscribe(pMqttClient, TemporaryTopicNameRejected,
+		if(!pShadow->subscriptionList[indexSubList].isSticky && (pShadow->subscriptionList[indexSubList].count == 1)) {
+			ret_val = aws_iot_mqtt_unsubscribe(pShadow->pMqttClient, TemporaryTopicNameRejected,
 											   (uint16_t) strlen(TemporaryTopicNameRejected));
 			if(ret_val == SUCCESS) {
-				SubscriptionList[indexSubList].isFree = true;
+				pShadow->subscriptionList[indexSubList].isFree = true;
 			}
-		} else if(SubscriptionList[indexSubList].count > 1) {
-			SubscriptionList[indexSubList].count--;
+		} else if(pShadow->subscriptionList[indexSubList].count > 1) {
+			pShadow->subscriptionList[indexSubList].count--;
 		}
 	}
 }
 
-void initializeRecords(AWS_IoT_Client *pClient) {
-	uint8_t i;
+void initializeRecords(ShadowClient *pShadow, AWS_IoT_Client *pClient) {
+	uint32_t i;
 	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-		AckWaitList[i].isFree = true;
+		if(NULL != pShadow->pMqttClient) {
+			aws_iot_mqtt_timer_stop(pShadow->pMqttClient, &(pShadow->ackWaitList[i].timer));
+		}
+		aws_iot_timer_wheel_init_entry(&(pShadow->ackWaitList[i].timer), ackTimerExpired, pShadow);
+		pShadow->ackWaitList[i].isFree = true;
+		pShadow->ackWaitList[i].isExpired = false;
+		pShadow->ackWaitList[i].nextFree = (i + 1 < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME) ? (int16_t) (i + 1) : -1;
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+		pShadow->ackWaitList[i].isPublishDeferred = false;
+#endif
 	}
+	pShadow->freeAckHead = 0;
+	for(i = 0; i < SHADOW_ACK_TOKEN_HASH_SLOTS; i++) {
+		pShadow->ackTokenSlots[i] = -1;
+	}
+	pShadow->expiredAckCount = 0;
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	pShadow->deferredPublishCount = 0;
+#endif
 	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		SubscriptionList[i].isFree = true;
-		SubscriptionList[i].count = 0;
-		SubscriptionList[i].isSticky = false;
+		pShadow->subscriptionList[i].isFree = true;
+		pShadow->subscriptionList[i].count = 0;
+		pShadow->subscriptionList[i].isSticky = false;
 	}
 
-	pMqttClient = pClient;
+	pShadow->pMqttClient = pClient;
 }
 
-bool isSubscriptionPresent(const char *pThingName, ShadowActions_t action) {
+bool isSubscriptionPresent(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action) {
 
 	uint8_t i = 0;
 	bool isAcceptedPresent = false;
@@ -313,10 +519,10 @@ bool isSubscriptionPresent(const char *pThingName, ShadowActions_t action) {
 	topicNameFromThingAndAction(TemporaryTopicNameRejected, pThingName, action, SHADOW_REJECTED);
 
 	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(!SubscriptionList[i].isFree) {
-			if((strcmp(TemporaryTopicNameAccepted, SubscriptionList[i].Topic) == 0)) {
+		if(!pShadow->subscriptionList[i].isFree) {
+			if((strcmp(TemporaryTopicNameAccepted, pShadow->subscriptionList[i].Topic) == 0)) {
 				isAcceptedPresent = true;
-			} else if((strcmp(TemporaryTopicNameRejected, SubscriptionList[i].Topic) == 0)) {
+			} else if((strcmp(TemporaryTopicNameRejected, pShadow->subscriptionList[i].Topic) == 0)) {
 				isRejectedPresent = true;
 			}
 		}
@@ -329,59 +535,97 @@ bool isSubscriptionPresent(const char *pThingName, ShadowActions_t action) {
 	return false;
 }
 
-IoT_Error_t subscribeToShadowActionAcks(const char *pThingName, ShadowActions_t action, bool isSticky) {
+IoT_Error_t subscribeToShadowActionAcks(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action,
+										bool isSticky) {
 	IoT_Error_t ret_val = SUCCESS;
 
 	bool clearBothEntriesFromList = true;
 	int16_t indexAcceptedSubList = 0;
 	int16_t indexRejectedSubList = 0;
-	Timer subSettlingtimer;
-	indexAcceptedSubList = getNextFreeIndexOfSubscriptionList();
-	indexRejectedSubList = getNextFreeIndexOfSubscriptionList();
+	indexAcceptedSubList = getNextFreeIndexOfSubscriptionList(pShadow);
+	indexRejectedSubList = getNextFreeIndexOfSubscriptionList(pShadow);
 
 	if(indexAcceptedSubList >= 0 && indexRejectedSubList >= 0) {
-		topicNameFromThingAndAction(SubscriptionList[indexAcceptedSubList].Topic, pThingName, action, SHADOW_ACCEPTED);
-		ret_val = aws_iot_mqtt_subscribe(pMqttClient, SubscriptionList[indexAcceptedSubList].Topic,
-										 (uint16_t) strlen(SubscriptionList[indexAcceptedSubList].Topic), QOS0,
-										 AckStatusCallback, NULL);
+		topicNameFromThingAndAction(pShadow->subscriptionList[indexAcceptedSubList].Topic, pThingName, action,
+									SHADOW_ACCEPTED);
+		ret_val = aws_iot_mqtt_subscribe(pShadow->pMqttClient,
+										 pShadow->subscriptionList[indexAcceptedSubList].Topic,
+										 (uint16_t) strlen(pShadow->subscriptionList[indexAcceptedSubList].Topic), QOS0,
+										 AckStatusCallback, pShadow);
 		if(ret_val == SUCCESS) {
-			SubscriptionList[indexAcceptedSubList].count = 1;
-			SubscriptionList[indexAcceptedSubList].isSticky = isSticky;
-			topicNameFromThingAndAction(SubscriptionList[indexRejectedSubList].Topic, pThingName, action,
+			pShadow->subscriptionList[indexAcceptedSubList].count = 1;
+			pShadow->subscriptionList[indexAcceptedSubList].isSticky = isSticky;
+			topicNameFromThingAndAction(pShadow->subscriptionList[indexRejectedSubList].Topic, pThingName, action,
 										SHADOW_REJECTED);
-			ret_val = aws_iot_mqtt_subscribe(pMqttClient, SubscriptionList[indexRejectedSubList].Topic,
-											 (uint16_t) strlen(SubscriptionList[indexRejectedSubList].Topic), QOS0,
-											 AckStatusCallback, NULL);
+			ret_val = aws_iot_mqtt_subscribe(pShadow->pMqttClient,
+											 pShadow->subscriptionList[indexRejectedSubList].Topic,
+											 (uint16_t) strlen(pShadow->subscriptionList[indexRejectedSubList].Topic),
+											 QOS0, AckStatusCallback, pShadow);
 			if(ret_val == SUCCESS) {
-				SubscriptionList[indexRejectedSubList].count = 1;
-				SubscriptionList[indexRejectedSubList].isSticky = isSticky;
+				pShadow->subscriptionList[indexRejectedSubList].count = 1;
+				pShadow->subscriptionList[indexRejectedSubList].isSticky = isSticky;
 				clearBothEntriesFromList = false;
-
-				// wait for SUBSCRIBE_SETTLING_TIME seconds to let the subscription take effect
-				init_timer(&subSettlingtimer);
-				countdown_sec(&subSettlingtimer, SUBSCRIBE_SETTLING_TIME);
-				while(!has_timer_expired(&subSettlingtimer));
-
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+				/* Requests using the new subscriptions are deferred until they had time to take effect */
+				init_timer(&(pShadow->subscriptionList[indexAcceptedSubList].settlingTimer));
+				countdown_ms(&(pShadow->subscriptionList[indexAcceptedSubList].settlingTimer),
+							 SHADOW_SUBSCRIBE_SETTLING_TIME_MS);
+				pShadow->subscriptionList[indexRejectedSubList].settlingTimer =
+						pShadow->subscriptionList[indexAcceptedSubList].settlingTimer;
+#endif
 			}
 		}
 	}
 
 	if(clearBothEntriesFromList) {
 		if(indexAcceptedSubList >= 0) {
-			SubscriptionList[indexAcceptedSubList].isFree = true;
+			pShadow->subscriptionList[indexAcceptedSubList].isFree = true;
 		} else if(indexRejectedSubList >= 0) {
-			SubscriptionList[indexRejectedSubList].isFree = true;
+			pShadow->subscriptionList[indexRejectedSubList].isFree = true;
 		}
-		if(SubscriptionList[indexAcceptedSubList].count == 1) {
-			aws_iot_mqtt_unsubscribe(pMqttClient, SubscriptionList[indexAcceptedSubList].Topic,
-									 (uint16_t) strlen(SubscriptionList[indexAcceptedSubList].Topic));
+		if(pShadow->subscriptionList[indexAcceptedSubList].count == 1) {
+			aws_iot_mqtt_unsubscribe(pShadow->pMqttClient, pShadow->subscriptionList[indexAcceptedSubList].Topic,
+									 (uint16_t) strlen(pShadow->subscriptionList[indexAcceptedSubList].Topic));
 		}
 	}
 
 	return ret_val;
 }
 
-void incrementSubscriptionCnt(const char *pThingName, ShadowActions_t action, bool isSticky) {
+IoT_Error_t subscribeToBulkGetAcks(ShadowClient *pShadow) {
+	IoT_Error_t ret_val;
+	int16_t indexSubList;
+
+	if(0 <= findIndexOfSubscriptionList(pShadow, SHADOW_BULK_GET_ACK_TOPIC)) {
+		return SUCCESS;
+	}
+
+	indexSubList = getNextFreeIndexOfSubscriptionList(pShadow);
+	if(0 > indexSubList) {
+		return FAILURE;
+	}
+
+	snprintf(pShadow->subscriptionList[indexSubList].Topic, MAX_SHADOW_TOPIC_LENGTH_BYTES, "%s",
+			 SHADOW_BULK_GET_ACK_TOPIC);
+	ret_val = aws_iot_mqtt_subscribe(pShadow->pMqttClient, pShadow->subscriptionList[indexSubList].Topic,
+									 (uint16_t) strlen(pShadow->subscriptionList[indexSubList].Topic), QOS0,
+									 AckStatusCallback, pShadow);
+	if(SUCCESS != ret_val) {
+		pShadow->subscriptionList[indexSubList].isFree = true;
+		return ret_val;
+	}
+
+	pShadow->subscriptionList[indexSubList].count = 1;
+	pShadow->subscriptionList[indexSubList].isSticky = true;
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	init_timer(&(pShadow->subscriptionList[indexSubList].settlingTimer));
+	countdown_ms(&(pShadow->subscriptionList[indexSubList].settlingTimer), SHADOW_SUBSCRIBE_SETTLING_TIME_MS);
+#endif
+
+	return SUCCESS;
+}
+
+void incrementSubscriptionCnt(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action, bool isSticky) {
 	char TemporaryTopicNameAccepted[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	char TemporaryTopicNameRejected[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	uint8_t i;
@@ -389,17 +633,42 @@ void incrementSubscriptionCnt(const char *pThingName, ShadowActions_t action, bo
 	topicNameFromThingAndAction(TemporaryTopicNameRejected, pThingName, action, SHADOW_REJECTED);
 
 	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(!SubscriptionList[i].isFree) {
-			if((strcmp(TemporaryTopicNameAccepted, SubscriptionList[i].Topic) == 0)
-			   || (strcmp(TemporaryTopicNameRejected, SubscriptionList[i].Topic) == 0)) {
-				SubscriptionList[i].count++;
-				SubscriptionList[i].isSticky = isSticky;
+		if(!pShadow->subscriptionList[i].isFree) {
+			if((strcmp(TemporaryTopicNameAccepted, pShadow->subscriptionList[i].Topic) == 0)
+			   || (strcmp(TemporaryTopicNameRejected, pShadow->subscriptionList[i].Topic) == 0)) {
+				pShadow->subscriptionList[i].count++;
+				pShadow->subscriptionList[i].isSticky = isSticky;
 			}
 		}
 	}
 }
 
-IoT_Error_t publishToShadowAction(const char *pThingName, ShadowActions_t action, const char *pJsonDocumentToBeSent) {
+bool isSubscriptionSettled(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action) {
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	char TemporaryTopicNameAccepted[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	int16_t indexSubList;
+
+	/* Both topics are subscribed together and share the settling time */
+	topicNameFromThingAndAction(TemporaryTopicNameAccepted, pThingName, action, SHADOW_ACCEPTED);
+	indexSubList = findIndexOfSubscriptionList(pShadow, TemporaryTopicNameAccepted);
+	if(indexSubList < 0 && SHADOW_GET == action) {
+		/* Bulk gets have no topics of their own */
+		indexSubList = findIndexOfSubscriptionList(pShadow, SHADOW_BULK_GET_ACK_TOPIC);
+	}
+	if(indexSubList >= 0 && !has_timer_expired(&(pShadow->subscriptionList[indexSubList].settlingTimer))) {
+		return false;
+	}
+#else
+	IOT_UNUSED(pShadow);
+	IOT_UNUSED(pThingName);
+	IOT_UNUSED(action);
+#endif
+
+	return true;
+}
+
+IoT_Error_t publishToShadowAction(ShadowClient *pShadow, const char *pThingName, ShadowActions_t action,
+								  const char *pJsonDocumentToBeSent) {
 	IoT_Error_t ret_val = SUCCESS;
 	char TemporaryTopicName[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	IoT_Publish_Message_Params msgParams;
@@ -413,64 +682,196 @@ IoT_Error_t publishToShadowAction(const char *pThingName, ShadowActions_t action
 	msgParams.qos = QOS0;
 	msgParams.payloadLen = strlen(pJsonDocumentToBeSent);
 	msgParams.payload = (char *) pJsonDocumentToBeSent;
-	ret_val = aws_iot_mqtt_publish(pMqttClient, TemporaryTopicName, (uint16_t) strlen(TemporaryTopicName), &msgParams);
+	ret_val = aws_iot_mqtt_publish(pShadow->pMqttClient, TemporaryTopicName, (uint16_t) strlen(TemporaryTopicName),
+								   &msgParams);
 
 	return ret_val;
 }
 
-bool getNextFreeIndexOfAckWaitList(uint8_t *pIndex) {
-	uint8_t i;
-	bool rc = false;
-
-	if(NULL == pIndex) {
+/* Takes the first record off the free list, addToAckWaitList fills it in or releaseAckWaitListIndex gives it back */
+bool getNextFreeIndexOfAckWaitList(ShadowClient *pShadow, uint16_t *pIndex) {
+	if(NULL == pIndex || 0 > pShadow->freeAckHead) {
 		return false;
 	}
 
-	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-		if(AckWaitList[i].isFree) {
-			*pIndex = i;
-			rc = true;
+	*pIndex = (uint16_t) pShadow->freeAckHead;
+	pShadow->freeAckHead = pShadow->ackWaitList[*pIndex].nextFree;
+
+	return true;
+}
+
+void releaseAckWaitListIndex(ShadowClient *pShadow, uint16_t indexAckWaitList) {
+	pShadow->ackWaitList[indexAckWaitList].isFree = true;
+	pShadow->ackWaitList[indexAckWaitList].nextFree = pShadow->freeAckHead;
+	pShadow->freeAckHead = (int16_t) indexAckWaitList;
+}
+
+/* Linear probing from the slot the hash selects, an empty slot ends the search */
+static int16_t findAckByClientToken(ShadowClient *pShadow, const char *pClientToken) {
+	uint32_t hash = hashJsonKey(pClientToken, strlen(pClientToken));
+	uint32_t slot = hash % SHADOW_ACK_TOKEN_HASH_SLOTS;
+	uint32_t probes;
+	int16_t index;
+
+	for(probes = 0; probes < SHADOW_ACK_TOKEN_HASH_SLOTS; probes++) {
+		index = pShadow->ackTokenSlots[slot];
+		if(0 > index) {
 			break;
 		}
+		if(pShadow->ackWaitList[index].clientTokenHash == hash
+		   && 0 == strcmp(pShadow->ackWaitList[index].clientTokenID, pClientToken)) {
+			return index;
+		}
+		slot = (slot + 1) % SHADOW_ACK_TOKEN_HASH_SLOTS;
 	}
 
-	return rc;
+	return -1;
+}
+
+static void addAckToClientTokenIndex(ShadowClient *pShadow, uint16_t index) {
+	uint32_t slot = pShadow->ackWaitList[index].clientTokenHash % SHADOW_ACK_TOKEN_HASH_SLOTS;
+	uint32_t probes;
+
+	for(probes = 0; probes < SHADOW_ACK_TOKEN_HASH_SLOTS; probes++) {
+		if(0 > pShadow->ackTokenSlots[slot]) {
+			pShadow->ackTokenSlots[slot] = (int16_t) index;
+			return;
+		}
+		slot = (slot + 1) % SHADOW_ACK_TOKEN_HASH_SLOTS;
+	}
+}
+
+/* Records probed past the removed one are moved back into the gap, so no slot is left marked as deleted */
+static void removeAckFromClientTokenIndex(ShadowClient *pShadow, uint16_t index) {
+	uint32_t hole = pShadow->ackWaitList[index].clientTokenHash % SHADOW_ACK_TOKEN_HASH_SLOTS;
+	uint32_t next;
+	uint32_t home;
+	uint32_t probes;
+
+	for(probes = 0; pShadow->ackTokenSlots[hole] != (int16_t) index; probes++) {
+		if(0 > pShadow->ackTokenSlots[hole] || SHADOW_ACK_TOKEN_HASH_SLOTS == probes) {
+			return;
+		}
+		hole = (hole + 1) % SHADOW_ACK_TOKEN_HASH_SLOTS;
+	}
+
+	next = (hole + 1) % SHADOW_ACK_TOKEN_HASH_SLOTS;
+	while(0 <= pShadow->ackTokenSlots[next] && next != hole) {
+		home = pShadow->ackWaitList[pShadow->ackTokenSlots[next]].clientTokenHash % SHADOW_ACK_TOKEN_HASH_SLOTS;
+		/* A record stays where it is if its home slot lies after the hole, up to where it is */
+		if((next > hole) ? (home <= hole || home > next) : (home <= hole && home > next)) {
+			pShadow->ackTokenSlots[hole] = pShadow->ackTokenSlots[next];
+			hole = next;
+		}
+		next = (next + 1) % SHADOW_ACK_TOKEN_HASH_SLOTS;
+	}
+	pShadow->ackTokenSlots[hole] = -1;
 }
 
-void addToAckWaitList(uint8_t indexAckWaitList, const char *pThingName, ShadowActions_t action,
+void addToAckWaitList(ShadowClient *pShadow, uint16_t indexAckWaitList, const char *pThingName, ShadowActions_t action,
 					  const char *pExtractedClientToken, fpActionCallback_t callback, void *pCallbackContext,
-					  uint32_t timeout_seconds) {
-	AckWaitList[indexAckWaitList].callback = callback;
-	strncpy(AckWaitList[indexAckWaitList].clientTokenID, pExtractedClientToken, MAX_SIZE_CLIENT_ID_WITH_SEQUENCE);
-	strncpy(AckWaitList[indexAckWaitList].thingName, pThingName, MAX_SIZE_OF_THING_NAME);
-	AckWaitList[indexAckWaitList].pCallbackContext = pCallbackContext;
-	AckWaitList[indexAckWaitList].action = action;
-	init_timer(&(AckWaitList[indexAckWaitList].timer));
-	countdown_sec(&(AckWaitList[indexAckWaitList].timer), timeout_seconds);
-	AckWaitList[indexAckWaitList].isFree = false;
-}
-
-void HandleExpiredResponseCallbacks(void) {
-	uint8_t i;
-	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-		if(!AckWaitList[i].isFree) {
-			if(has_timer_expired(&(AckWaitList[i].timer))) {
-				if(AckWaitList[i].callback != NULL) {
-					AckWaitList[i].callback(AckWaitList[i].thingName, AckWaitList[i].action, SHADOW_ACK_TIMEOUT,
-											shadowRxBuf, AckWaitList[i].pCallbackContext);
-				}
-				AckWaitList[i].isFree = true;
-				unsubscribeFromAcceptedAndRejected(i);
+					  uint32_t timeout_seconds, const char *pDeferredDocument, bool isWildcardAck) {
+	ToBeReceivedAckRecord_t *pRecord = &(pShadow->ackWaitList[indexAckWaitList]);
+
+	pRecord->callback = callback;
+	strncpy(pRecord->clientTokenID, pExtractedClientToken, MAX_SIZE_CLIENT_ID_WITH_SEQUENCE);
+	pRecord->clientTokenHash = hashJsonKey(pRecord->clientTokenID, strlen(pRecord->clientTokenID));
+	strncpy(pRecord->thingName, pThingName, MAX_SIZE_OF_THING_NAME);
+	pRecord->pCallbackContext = pCallbackContext;
+	pRecord->action = action;
+	pRecord->isWildcardAck = isWildcardAck;
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	if(NULL != pDeferredDocument) {
+		/* Sent from yield once the subscriptions settled, the timeout covers the wait */
+		snprintf(pRecord->deferredDocument, AWS_IOT_MQTT_TX_BUF_LEN, "%s", pDeferredDocument);
+		pRecord->isPublishDeferred = true;
+		pShadow->deferredPublishCount++;
+	}
+#else
+	IOT_UNUSED(pDeferredDocument);
+#endif
+	aws_iot_mqtt_timer_start(pShadow->pMqttClient, &(pRecord->timer), timeout_seconds * 1000);
+	pRecord->isFree = false;
+	addAckToClientTokenIndex(pShadow, indexAckWaitList);
+}
+
+void PublishDeferredActions(ShadowClient *pShadow) {
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+	IoT_Error_t ret_val;
+	uint16_t i;
+
+	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME && 0 < pShadow->deferredPublishCount; i++) {
+		if(!pShadow->ackWaitList[i].isFree && pShadow->ackWaitList[i].isPublishDeferred
+		   && isSubscriptionSettled(pShadow, pShadow->ackWaitList[i].thingName, pShadow->ackWaitList[i].action)) {
+			pShadow->ackWaitList[i].isPublishDeferred = false;
+			pShadow->deferredPublishCount--;
+			ret_val = publishToShadowAction(pShadow, pShadow->ackWaitList[i].thingName, pShadow->ackWaitList[i].action,
+											pShadow->ackWaitList[i].deferredDocument);
+			if(SUCCESS != ret_val) {
+				/* No response can arrive, the callback is told once the record times out */
+				IOT_ERROR("Deferred shadow action publish failed, rc %d", ret_val);
 			}
 		}
 	}
+#else
+	IOT_UNUSED(pShadow);
+#endif
+}
+
+/* Called by the timer wheel of the client, the timeout callback runs later from HandleExpiredResponseCallbacks */
+static void ackTimerExpired(IoT_Timer_Wheel_Entry *pEntry, void *pData) {
+	ShadowClient *pShadow = (ShadowClient *) pData;
+	ToBeReceivedAckRecord_t *pRecord;
+
+	pRecord = (ToBeReceivedAckRecord_t *) ((char *) pEntry - offsetof(ToBeReceivedAckRecord_t, timer));
+
+	/* A record waiting to be handled is checked again then, even if its timer was restarted */
+	if(!pRecord->isExpired) {
+		pRecord->isExpired = true;
+		pShadow->expiredAckIndex[pShadow->expiredAckCount++] = (uint16_t) (pRecord - pShadow->ackWaitList);
+	}
+}
+
+void HandleExpiredResponseCallbacks(ShadowClient *pShadow) {
+	uint16_t i;
+	ToBeReceivedAckRecord_t *pRecord;
+
+	if(NULL == pShadow->pMqttClient) {
+		return;
+	}
+
+	aws_iot_mqtt_run_timers(pShadow->pMqttClient);
+
+	while(0 < pShadow->expiredAckCount) {
+		i = pShadow->expiredAckIndex[--pShadow->expiredAckCount];
+		pRecord = &(pShadow->ackWaitList[i]);
+		pRecord->isExpired = false;
+		if(!pRecord->isFree && aws_iot_mqtt_timer_has_expired(pShadow->pMqttClient, &(pRecord->timer))) {
+			if(pRecord->callback != NULL) {
+				pRecord->callback(pRecord->thingName, pRecord->action, SHADOW_ACK_TIMEOUT, pShadow->rxBuf,
+								  pRecord->pCallbackContext);
+			}
+#if SHADOW_SUBSCRIBE_SETTLING_TIME_MS > 0
+			if(pRecord->isPublishDeferred) {
+				pRecord->isPublishDeferred = false;
+				pShadow->deferredPublishCount--;
+			}
+#endif
+			removeAckFromClientTokenIndex(pShadow, i);
+			unsubscribeFromAcceptedAndRejected(pShadow, i);
+			releaseAckWaitListIndex(pShadow, i);
+		}
+	}
 }
 
 static void shadow_delta_callback(AWS_IoT_Client *pClient, char *topicName,
 								  uint16_t topicNameLen, IoT_Publish_Message_Params *params, void *pData) {
 	int32_t tokenCount;
 	uint32_t i = 0;
-	void *pJsonHandler = NULL;
+	ShadowClient *pShadow = (ShadowClient *) pData;
+	void *pJsonHandler = &(pShadow->jsonParser);
+	const char *pPayload = (const char *) params->payload;
+	JsonTokenTable_t *pEntry;
 	int32_t DataPosition;
 	uint32_t dataLength;
 	uint32_t tempVersionNumber = 0;
@@ -480,40 +881,33 @@ static void shadow_delta_callback(AWS_IoT_Client *pClient, char *topicName,
 	IOT_UNUSED(pClient);
 	IOT_UNUSED(topicName);
 	IOT_UNUSED(topicNameLen);
-	IOT_UNUSED(pData);
-
-	if(params->payloadLen > SHADOW_MAX_SIZE_OF_RX_BUFFER) {
-		IOT_WARN("Payload larger than RX Buffer");
-		return;
-	}
-
-	memcpy(shadowRxBuf, params->payload, params->payloadLen);
-	shadowRxBuf[params->payloadLen] = '\0';    // jsmn_parse relies on a string
 
-	if(!isJsonValidAndParse(shadowRxBuf, pJsonHandler, &tokenCount)) {
+	/* Parsed where it was received, the values handed to the callbacks point into the payload */
+	if(!isDeltaJsonValidAndParse(pPayload, params->payloadLen, pJsonHandler, &(pShadow->deltaKeys), &tokenCount)) {
 		IOT_WARN("Received JSON is not valid");
 		return;
 	}
 
-	if(shadowDiscardOldDeltaFlag) {
-		if(extractVersionNumber(shadowRxBuf, pJsonHandler, tokenCount, &tempVersionNumber)) {
-			if(tempVersionNumber > shadowJsonVersionNum) {
-				shadowJsonVersionNum = tempVersionNumber;
+	if(pShadow->isDiscardOldDeltaEnabled) {
+		if(extractVersionNumber(pPayload, pJsonHandler, &tempVersionNumber)) {
+			if(tempVersionNumber > pShadow->jsonVersionNum) {
+				pShadow->jsonVersionNum = tempVersionNumber;
 			} else {
 				IOT_WARN("Old Delta Message received - Ignoring rx: %d local: %d", tempVersionNumber,
-						 shadowJsonVersionNum);
+						 pShadow->jsonVersionNum);
 				return;
 			}
 		}
 	}
 
-	for(i = 0; i < tokenTableIndex; i++) {
-		if(!tokenTable[i].isFree) {
-			if(isJsonKeyMatchingAndUpdateValue(shadowRxBuf, pJsonHandler, tokenCount,
-											   (jsonStruct_t *) tokenTable[i].pStruct, &dataLength, &DataPosition)) {
-				if(tokenTable[i].callback != NULL) {
-					tokenTable[i].callback(shadowRxBuf + DataPosition, dataLength,
-										   (jsonStruct_t *) tokenTable[i].pStruct);
+	/* The parse found the value of every key, callbacks still run in the order the keys were registered */
+	for(i = 0; i < pShadow->deltaKeys.count; i++) {
+		pEntry = &(pShadow->deltaKeys.entries[i]);
+		if(!pEntry->isFree) {
+			if(isDeltaKeyPresentAndUpdateValue(pPayload, pJsonHandler, i, (jsonStruct_t *) pEntry->pStruct,
+											   &dataLength, &DataPosition)) {
+				if(pEntry->callback != NULL) {
+					pEntry->callback(pPayload + DataPosition, dataLength, (jsonStruct_t *) pEntry->pStruct);
 				}
 			}
 		}
@@ -0,0 +1,392 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_timer_wheel.c
+ * @brief Hierarchical timer wheel holding the deadlines of one client
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "aws_iot_timer_wheel.h"
+
+#define AWS_IOT_TIMER_WHEEL_SLOT_MASK (AWS_IOT_TIMER_WHEEL_SLOTS - 1u)
+/* Deadlines further away are parked in the last slot of the top level and placed again when it turns */
+#define AWS_IOT_TIMER_WHEEL_SPAN_MS (1u << (AWS_IOT_TIMER_WHEEL_SLOT_BITS * AWS_IOT_TIMER_WHEEL_LEVELS))
+/* Levels that pExpiring and pDue entries are marked with */
+#define AWS_IOT_TIMER_WHEEL_EXPIRING_LEVEL AWS_IOT_TIMER_WHEEL_LEVELS
+#define AWS_IOT_TIMER_WHEEL_DUE_LEVEL (AWS_IOT_TIMER_WHEEL_LEVELS + 1u)
+/* The epoch timer is restarted once half of it is used up */
+#define AWS_IOT_TIMER_WHEEL_EPOCH_MS 0x7FFFFFFFu
+
+static const uint8_t timerWheelBitIndex[64] = {
+	0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4, 62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+	63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11, 46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+};
+
+/**
+ * @brief Index of the lowest set bit, bits must not be 0
+ */
+static uint32_t _aws_iot_timer_wheel_lowest_bit(uint64_t bits) {
+	return timerWheelBitIndex[((bits & (~bits + 1u)) * 0x03F79D71B4CB0A89ULL) >> 58];
+}
+
+/**
+ * @brief Distance from slot start to the first occupied slot, going round the level once
+ */
+static uint32_t _aws_iot_timer_wheel_next_slot_distance(uint64_t bits, uint32_t start) {
+	if(0 != start) {
+		bits = (bits >> start) | (bits << (AWS_IOT_TIMER_WHEEL_SLOTS - start));
+	}
+	return _aws_iot_timer_wheel_lowest_bit(bits);
+}
+
+/**
+ * @brief Bring wheel time up to date from the epoch timer
+ */
+static uint32_t _aws_iot_timer_wheel_update_now(IoT_Timer_Wheel *pWheel) {
+	uint32_t left = left_ms(&(pWheel->epochTimer));
+
+	pWheel->nowMs += pWheel->epochLeftMs - left;
+	pWheel->epochLeftMs = left;
+	if(left < AWS_IOT_TIMER_WHEEL_EPOCH_MS / 2) {
+		countdown_ms(&(pWheel->epochTimer), AWS_IOT_TIMER_WHEEL_EPOCH_MS);
+		pWheel->epochLeftMs = AWS_IOT_TIMER_WHEEL_EPOCH_MS;
+	}
+
+	return pWheel->nowMs;
+}
+
+static IoT_Timer_Wheel_Entry **_aws_iot_timer_wheel_list_of(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntry) {
+	if(AWS_IOT_TIMER_WHEEL_EXPIRING_LEVEL == pEntry->level) {
+		return &(pWheel->pExpiring);
+	}
+	if(AWS_IOT_TIMER_WHEEL_DUE_LEVEL == pEntry->level) {
+		return &(pWheel->pDue);
+	}
+	return &(pWheel->pSlots[pEntry->level][pEntry->slot]);
+}
+
+static void _aws_iot_timer_wheel_unlink(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntry) {
+	IoT_Timer_Wheel_Entry **ppHead = _aws_iot_timer_wheel_list_of(pWheel, pEntry);
+
+	if(NULL != pEntry->pPrev) {
+		pEntry->pPrev->pNext = pEntry->pNext;
+	} else {
+		*ppHead = pEntry->pNext;
+	}
+	if(NULL != pEntry->pNext) {
+		pEntry->pNext->pPrev = pEntry->pPrev;
+	}
+	if(NULL == *ppHead && AWS_IOT_TIMER_WHEEL_LEVELS > pEntry->level) {
+		pWheel->occupiedSlots[pEntry->level] &= ~((uint64_t) 1u << pEntry->slot);
+	}
+	pEntry->pNext = NULL;
+	pEntry->pPrev = NULL;
+}
+
+static void _aws_iot_timer_wheel_push(IoT_Timer_Wheel_Entry **ppHead, IoT_Timer_Wheel_Entry *pEntry) {
+	pEntry->pPrev = NULL;
+	pEntry->pNext = *ppHead;
+	if(NULL != *ppHead) {
+		(*ppHead)->pPrev = pEntry;
+	}
+	*ppHead = pEntry;
+}
+
+/**
+ * @brief Place an entry in the slot for its deadline, relative to the next tick to be expired
+ */
+static void _aws_iot_timer_wheel_link(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntry) {
+	uint32_t expiry = pEntry->expiryMs;
+	uint32_t delta = expiry - pWheel->currentTick;
+	uint8_t level = 0;
+
+	if(0 > (int32_t) delta) {
+		/* its slot was expired already, the next run expires it first */
+		pEntry->level = AWS_IOT_TIMER_WHEEL_DUE_LEVEL;
+		_aws_iot_timer_wheel_push(&(pWheel->pDue), pEntry);
+		return;
+	}
+
+	if(AWS_IOT_TIMER_WHEEL_SPAN_MS <= delta) {
+		delta = AWS_IOT_TIMER_WHEEL_SPAN_MS - 1u;
+		expiry = pWheel->currentTick + delta;
+	}
+
+	while((delta >> (AWS_IOT_TIMER_WHEEL_SLOT_BITS * (level + 1u))) != 0) {
+		level++;
+	}
+
+	pEntry->level = level;
+	pEntry->slot = (uint8_t) ((expiry >> (AWS_IOT_TIMER_WHEEL_SLOT_BITS * level)) & AWS_IOT_TIMER_WHEEL_SLOT_MASK);
+	_aws_iot_timer_wheel_push(&(pWheel->pSlots[level][pEntry->slot]), pEntry);
+	pWheel->occupiedSlots[level] |= (uint64_t) 1u << pEntry->slot;
+}
+
+/**
+ * @brief Move the entries of the upper level slots that start at this tick down the wheel
+ *
+ * Called when the lowest level starts a new turn. A level is only looked at when every
+ * level below it starts a new turn as well.
+ */
+static void _aws_iot_timer_wheel_cascade(IoT_Timer_Wheel *pWheel) {
+	IoT_Timer_Wheel_Entry *pEntry;
+	uint32_t level, slot;
+
+	for(level = 1; level < AWS_IOT_TIMER_WHEEL_LEVELS; level++) {
+		slot = (pWheel->currentTick >> (AWS_IOT_TIMER_WHEEL_SLOT_BITS * level)) & AWS_IOT_TIMER_WHEEL_SLOT_MASK;
+		pEntry = pWheel->pSlots[level][slot];
+		pWheel->pSlots[level][slot] = NULL;
+		pWheel->occupiedSlots[level] &= ~((uint64_t) 1u << slot);
+		while(NULL != pEntry) {
+			IoT_Timer_Wheel_Entry *pNext = pEntry->pNext;
+			_aws_iot_timer_wheel_link(pWheel, pEntry);
+			pEntry = pNext;
+		}
+		if(0 != slot) {
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Next tick after the current one that has to be visited
+ *
+ * That is the next occupied slot of the lowest level, or the start of its next turn. Turns
+ * of the upper levels that have nothing to move down are skipped.
+ */
+static uint32_t _aws_iot_timer_wheel_next_tick(IoT_Timer_Wheel *pWheel) {
+	uint32_t tick = pWheel->currentTick;
+	uint32_t slot = tick & AWS_IOT_TIMER_WHEEL_SLOT_MASK;
+	uint64_t bits;
+	uint32_t level, span;
+
+	if(0 == slot) {
+		return tick;
+	}
+
+	bits = pWheel->occupiedSlots[0] >> slot;
+	if(0 != bits) {
+		return tick + _aws_iot_timer_wheel_lowest_bit(bits);
+	}
+
+	level = 1;
+	if(0 == pWheel->occupiedSlots[0]) {
+		while(level < AWS_IOT_TIMER_WHEEL_LEVELS && 0 == pWheel->occupiedSlots[level]) {
+			level++;
+		}
+	}
+	span = (level < AWS_IOT_TIMER_WHEEL_LEVELS) ? (1u << (AWS_IOT_TIMER_WHEEL_SLOT_BITS * level))
+											   : AWS_IOT_TIMER_WHEEL_SPAN_MS;
+
+	return (tick | (span - 1u)) + 1u;
+}
+
+void aws_iot_timer_wheel_init(IoT_Timer_Wheel *pWheel) {
+	memset(pWheel->pSlots, 0, sizeof(pWheel->pSlots));
+	memset(pWheel->occupiedSlots, 0, sizeof(pWheel->occupiedSlots));
+	pWheel->pDue = NULL;
+	pWheel->pExpiring = NULL;
+	init_timer(&(pWheel->epochTimer));
+	countdown_ms(&(pWheel->epochTimer), AWS_IOT_TIMER_WHEEL_EPOCH_MS);
+	pWheel->epochLeftMs = AWS_IOT_TIMER_WHEEL_EPOCH_MS;
+	pWheel->nowMs = 0;
+	pWheel->currentTick = 0;
+	pWheel->entryCount = 0;
+
+	/* Entries left marked with the previous generation of this wheel are no longer scheduled, 0 marks none */
+	pWheel->generation++;
+	if(0 == pWheel->generation) {
+		pWheel->generation++;
+	}
+}
+
+void aws_iot_timer_wheel_init_entry(IoT_Timer_Wheel_Entry *pEntry, pTimerWheelHandler_t pHandler, void *pHandlerData) {
+	pEntry->pNext = NULL;
+	pEntry->pPrev = NULL;
+	pEntry->expiryMs = 0;
+	pEntry->wheelGeneration = 0;
+	pEntry->level = 0;
+	pEntry->slot = 0;
+	pEntry->pHandler = pHandler;
+	pEntry->pHandlerData = pHandlerData;
+}
+
+bool aws_iot_timer_wheel_is_scheduled(const IoT_Timer_Wheel *pWheel, const IoT_Timer_Wheel_Entry *pEntry) {
+	return pWheel->generation == pEntry->wheelGeneration;
+}
+
+void aws_iot_timer_wheel_cancel(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntry) {
+	if(!aws_iot_timer_wheel_is_scheduled(pWheel, pEntry)) {
+		return;
+	}
+
+	_aws_iot_timer_wheel_unlink(pWheel, pEntry);
+	pEntry->wheelGeneration = 0;
+	pWheel->entryCount--;
+}
+
+void aws_iot_timer_wheel_schedule(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntry, uint32_t timeout_ms) {
+	aws_iot_timer_wheel_cancel(pWheel, pEntry);
+
+	if(AWS_IOT_TIMER_WHEEL_MAX_TIMEOUT_MS < timeout_ms) {
+		timeout_ms = AWS_IOT_TIMER_WHEEL_MAX_TIMEOUT_MS;
+	}
+
+	pEntry->expiryMs = _aws_iot_timer_wheel_update_now(pWheel) + timeout_ms;
+	pEntry->wheelGeneration = pWheel->generation;
+	_aws_iot_timer_wheel_link(pWheel, pEntry);
+	pWheel->entryCount++;
+}
+
+uint32_t aws_iot_timer_wheel_left_ms(IoT_Timer_Wheel *pWheel, const IoT_Timer_Wheel_Entry *pEntry) {
+	int32_t left;
+
+	if(!aws_iot_timer_wheel_is_scheduled(pWheel, pEntry)) {
+		return 0;
+	}
+
+	left = (int32_t) (pEntry->expiryMs - _aws_iot_timer_wheel_update_now(pWheel));
+	return (0 < left) ? (uint32_t) left : 0;
+}
+
+bool aws_iot_timer_wheel_has_expired(IoT_Timer_Wheel *pWheel, const IoT_Timer_Wheel_Entry *pEntry) {
+	return 0 == aws_iot_timer_wheel_left_ms(pWheel, pEntry);
+}
+
+/**
+ * @brief Remove a list of entries taken off the wheel and call their handlers
+ */
+static uint32_t _aws_iot_timer_wheel_expire(IoT_Timer_Wheel *pWheel, IoT_Timer_Wheel_Entry *pEntries) {
+	IoT_Timer_Wheel_Entry *pEntry;
+	uint32_t expiredCount = 0;
+
+	pWheel->pExpiring = pEntries;
+	for(pEntry = pEntries; NULL != pEntry; pEntry = pEntry->pNext) {
+		pEntry->level = AWS_IOT_TIMER_WHEEL_EXPIRING_LEVEL;
+	}
+
+	/* A handler may cancel other expiring entries, so they are taken off the list one by one */
+	while(NULL != pWheel->pExpiring) {
+		pEntry = pWheel->pExpiring;
+		_aws_iot_timer_wheel_unlink(pWheel, pEntry);
+		pEntry->wheelGeneration = 0;
+		pWheel->entryCount--;
+		expiredCount++;
+		if(NULL != pEntry->pHandler) {
+			pEntry->pHandler(pEntry, pEntry->pHandlerData);
+		}
+	}
+
+	return expiredCount;
+}
+
+uint32_t aws_iot_timer_wheel_run(IoT_Timer_Wheel *pWheel) {
+	IoT_Timer_Wheel_Entry *pEntries;
+	uint32_t now, slot, nextTick;
+	uint32_t expiredCount;
+
+	now = _aws_iot_timer_wheel_update_now(pWheel);
+
+	/* Entries a handler schedules while this runs are due at the earliest with the next run */
+	pEntries = pWheel->pDue;
+	pWheel->pDue = NULL;
+	expiredCount = _aws_iot_timer_wheel_expire(pWheel, pEntries);
+
+	while(0 <= (int32_t) (now - pWheel->currentTick)) {
+		slot = pWheel->currentTick & AWS_IOT_TIMER_WHEEL_SLOT_MASK;
+		if(0 == slot) {
+			_aws_iot_timer_wheel_cascade(pWheel);
+		}
+
+		pEntries = pWheel->pSlots[0][slot];
+		pWheel->pSlots[0][slot] = NULL;
+		pWheel->occupiedSlots[0] &= ~((uint64_t) 1u << slot);
+		pWheel->currentTick++;
+		expiredCount += _aws_iot_timer_wheel_expire(pWheel, pEntries);
+
+		nextTick = _aws_iot_timer_wheel_next_tick(pWheel);
+		if(0 < (int32_t) (nextTick - now)) {
+			/* nothing else is due by now and no turn starts on the way there */
+			nextTick = now + 1u;
+		}
+		pWheel->currentTick = nextTick;
+	}
+
+	return expiredCount;
+}
+
+uint32_t aws_iot_timer_wheel_get_next_timeout_ms(IoT_Timer_Wheel *pWheel) {
+	uint32_t now, tick, slot, level, shift, start, distance, candidate;
+	uint32_t next = 0;
+	bool isNextFound = false;
+	bool isTurnPending;
+
+	if(0 == pWheel->entryCount) {
+		return UINT32_MAX;
+	}
+
+	now = _aws_iot_timer_wheel_update_now(pWheel);
+	tick = pWheel->currentTick;
+
+	if(NULL != pWheel->pDue) {
+		return 0;
+	}
+
+	/* Lowest level, deadlines are exact */
+	if(0 != pWheel->occupiedSlots[0]) {
+		slot = tick & AWS_IOT_TIMER_WHEEL_SLOT_MASK;
+		distance = _aws_iot_timer_wheel_next_slot_distance(pWheel->occupiedSlots[0], slot);
+		next = tick + distance;
+		isNextFound = true;
+	}
+
+	/* Upper levels, a slot is due when it moves down, at the start of its range */
+	for(level = 1; level < AWS_IOT_TIMER_WHEEL_LEVELS; level++) {
+		if(0 == pWheel->occupiedSlots[level]) {
+			continue;
+		}
+		shift = AWS_IOT_TIMER_WHEEL_SLOT_BITS * level;
+		slot = (tick >> shift) & AWS_IOT_TIMER_WHEEL_SLOT_MASK;
+		/* At the very start of its range the current slot has not moved down yet */
+		isTurnPending = 0 == (tick & ((1u << shift) - 1u));
+		start = isTurnPending ? slot : ((slot + 1u) & AWS_IOT_TIMER_WHEEL_SLOT_MASK);
+		distance = _aws_iot_timer_wheel_next_slot_distance(pWheel->occupiedSlots[level], start);
+		if(!isTurnPending) {
+			distance++;
+		}
+		candidate = ((tick >> shift) << shift) + (distance << shift);
+		if(!isNextFound || (candidate - tick) < (next - tick)) {
+			next = candidate;
+			isNextFound = true;
+		}
+	}
+
+	if(!isNextFound || 0 >= (int32_t) (next - now)) {
+		/* only entries whose handler is running right now are left */
+		return 0;
+	}
+
+	return next - now;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_common.h
+ * @brief Benchmark common header
+ */
+
+#ifndef TESTS_BENCHMARK_COMMON_H_
+#define TESTS_BENCHMARK_COMMON_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "aws_iot_mqtt_client_interface.h"
+#include "aws_iot_log.h"
+
+/**
+ * @brief Monotonic time in nanoseconds, used to time benchmark loops
+ */
+uint64_t aws_iot_benchmark_get_time_ns(void);
+
+/**
+ * @brief Initialize a client and connect it over the mock TLS layer
+ */
+IoT_Error_t aws_iot_benchmark_connect_client(AWS_IoT_Client *pClient);
+
+/**
+ * @brief Subscribe over the mock TLS layer, the SUBACK is injected before the call
+ */
+IoT_Error_t aws_iot_benchmark_subscribe(AWS_IoT_Client *pClient, const char *pTopicFilter,
+										pApplicationHandler_t pHandler, void *pData);
+
+/**
+ * @brief Place raw bytes in the mock TLS receive buffer
+ */
+void aws_iot_benchmark_set_rx_data(const unsigned char *pData, size_t len);
+
+/**
+ * @brief Serialize an incoming QoS0 PUBLISH the way a broker would send it
+ *
+ * @return Number of bytes written to pBuf
+ */
+size_t aws_iot_benchmark_encode_publish(unsigned char *pBuf, const char *pTopic, const char *pPayload);
+
+int aws_iot_benchmark_rx_framing(void);
+int aws_iot_benchmark_topic_match(void);
+int aws_iot_benchmark_buffer_memory(void);
+int aws_iot_benchmark_event_loop(void);
+int aws_iot_benchmark_timer(void);
+int aws_iot_benchmark_json_numbers(void);
+int aws_iot_benchmark_mqtt_serialize(void);
+
+#endif /* TESTS_BENCHMARK_COMMON_H_ */
@@ -0,0 +1,170 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_buffer_memory.c
+ * @brief Buffer memory benchmark, compares pooled buffers with fixed buffers sized for the largest message
+ *
+ * A set of clients is initialized and the memory their read and write buffers take from the
+ * shared pool is reported. One client then receives a message larger than its initial read
+ * buffer, which has to be delivered, and the peak and steady state usage are reported.
+ */
+
+#include "aws_iot_benchmark_common.h"
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#define BUFFER_MEMORY_CLIENTS 32
+#define BUFFER_MEMORY_ITERATIONS 20000
+#define BUFFER_MEMORY_TOPIC "bench/buffer/topic"
+/* Larger than AWS_IOT_MQTT_RX_BUF_LEN, small enough for the mock TLS buffer */
+#define BUFFER_MEMORY_LARGE_PAYLOAD_LEN 900
+
+static AWS_IoT_Client clients[BUFFER_MEMORY_CLIENTS];
+static size_t deliveredPayloadLen;
+
+static void buffer_memory_callback_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+										   IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(pData);
+
+	deliveredPayloadLen = params->payloadLen;
+}
+
+/* Receives one packet and lets the client read once more, which returns a grown read buffer */
+static IoT_Error_t buffer_memory_receive(AWS_IoT_Client *pClient, const unsigned char *pPacket, size_t packetLen) {
+	uint8_t packetType = 0;
+	IoT_Error_t rc = SUCCESS;
+	Timer timer;
+
+	init_timer(&timer);
+	countdown_sec(&timer, 60);
+
+	aws_iot_benchmark_set_rx_data(pPacket, packetLen);
+	deliveredPayloadLen = 0;
+	while(0 == deliveredPayloadLen && SUCCESS == rc) {
+		rc = aws_iot_mqtt_internal_cycle_read(pClient, &timer, &packetType);
+	}
+	if(SUCCESS == rc) {
+		rc = aws_iot_mqtt_internal_cycle_read(pClient, &timer, &packetType);
+	}
+
+	return rc;
+}
+
+static int buffer_memory_time_receive(AWS_IoT_Client *pClient, const char *pLabel, const char *pPayload) {
+	static unsigned char packet[BUFFER_MEMORY_LARGE_PAYLOAD_LEN + 64];
+	size_t packetLen;
+	uint32_t i;
+	uint64_t start, elapsed;
+	IoT_Error_t rc = SUCCESS;
+
+	packetLen = aws_iot_benchmark_encode_publish(packet, BUFFER_MEMORY_TOPIC, pPayload);
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < BUFFER_MEMORY_ITERATIONS && SUCCESS == rc; i++) {
+		rc = buffer_memory_receive(pClient, packet, packetLen);
+	}
+	elapsed = aws_iot_benchmark_get_time_ns() - start;
+
+	if(SUCCESS != rc) {
+		printf("  %s : receive failed, rc %d\n", pLabel, rc);
+		return rc;
+	}
+	if(strlen(pPayload) != deliveredPayloadLen) {
+		printf("  %s : delivered %u payload bytes instead of %u\n", pLabel, (unsigned int) deliveredPayloadLen,
+			   (unsigned int) strlen(pPayload));
+		return FAILURE;
+	}
+
+	printf("  %s : %8.1f ns/message\n", pLabel, (double) elapsed / BUFFER_MEMORY_ITERATIONS);
+
+	return 0;
+}
+
+int aws_iot_benchmark_buffer_memory(void) {
+	static char largePayload[BUFFER_MEMORY_LARGE_PAYLOAD_LEN + 1];
+	IoT_Buffer_Pool_Usage poolUsage;
+	size_t bytesInUseBefore;
+	IoT_Buffer_Usage bufferUsage;
+	size_t fixedBytesPerClient;
+	uint32_t i;
+	int rc = SUCCESS;
+
+	/* Clients of the other benchmarks may still hold buffers */
+	aws_iot_mqtt_get_buffer_pool_usage(&poolUsage);
+	bytesInUseBefore = poolUsage.bytesInUse;
+
+	for(i = 0; i < BUFFER_MEMORY_CLIENTS && SUCCESS == rc; i++) {
+		rc = aws_iot_benchmark_connect_client(&clients[i]);
+	}
+	if(SUCCESS != rc) {
+		printf("  connect failed, rc %d\n", rc);
+		return rc;
+	}
+
+	rc = aws_iot_benchmark_subscribe(&clients[0], BUFFER_MEMORY_TOPIC, buffer_memory_callback_handler, NULL);
+	if(SUCCESS != rc) {
+		printf("  subscribe failed, rc %d\n", rc);
+		return rc;
+	}
+
+	/* Without the pool every client needs buffers for the largest message it may see */
+	fixedBytesPerClient = AWS_IOT_MQTT_TX_BUF_MAX_LEN + AWS_IOT_MQTT_RX_BUF_MAX_LEN;
+	aws_iot_mqtt_get_buffer_pool_usage(&poolUsage);
+	printf("  %u clients : %6u buffer bytes/client pooled, %6u bytes/client with fixed buffers\n",
+		   BUFFER_MEMORY_CLIENTS,
+		   (unsigned int) ((poolUsage.bytesInUse - bytesInUseBefore) / BUFFER_MEMORY_CLIENTS),
+		   (unsigned int) fixedBytesPerClient);
+
+	rc = buffer_memory_time_receive(&clients[0], "small message", "{\"temperature\":21.5}");
+	if(0 != rc) {
+		return rc;
+	}
+
+	memset(largePayload, 'x', BUFFER_MEMORY_LARGE_PAYLOAD_LEN);
+	largePayload[BUFFER_MEMORY_LARGE_PAYLOAD_LEN] = '\0';
+	rc = buffer_memory_time_receive(&clients[0], "large message", largePayload);
+	if(0 != rc) {
+		return rc;
+	}
+
+	aws_iot_mqtt_get_buffer_usage(&clients[0], &bufferUsage);
+	printf("  read buffer : %6u bytes peak, %6u bytes steady state\n", (unsigned int) bufferUsage.peakReadBufSize,
+		   (unsigned int) bufferUsage.readBufSize);
+
+	aws_iot_mqtt_get_buffer_pool_usage(&poolUsage);
+	printf("  pool : %6u bytes in use, %6u bytes held, %6u bytes peak held\n", (unsigned int) poolUsage.bytesInUse,
+		   (unsigned int) poolUsage.bytesHeld, (unsigned int) poolUsage.peakBytesHeld);
+
+	aws_iot_mqtt_buffer_pool_trim();
+	aws_iot_mqtt_get_buffer_pool_usage(&poolUsage);
+	printf("  pool after trim : %6u bytes held\n", (unsigned int) poolUsage.bytesHeld);
+
+	for(i = 0; i < BUFFER_MEMORY_CLIENTS; i++) {
+		aws_iot_mqtt_disconnect(&clients[i]);
+		aws_iot_mqtt_free(&clients[i]);
+	}
+
+	aws_iot_mqtt_get_buffer_pool_usage(&poolUsage);
+	if(bytesInUseBefore != poolUsage.bytesInUse) {
+		printf("  %u bytes still in use after all clients were released\n",
+			   (unsigned int) (poolUsage.bytesInUse - bytesInUseBefore));
+		return FAILURE;
+	}
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_common.c
+ * @brief Helpers shared by the benchmarks
+ */
+
+#include <time.h>
+#include "aws_iot_benchmark_common.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+
+uint64_t aws_iot_benchmark_get_time_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t) now.tv_sec * 1000000000ULL) + (uint64_t) now.tv_nsec;
+}
+
+void aws_iot_benchmark_set_rx_data(const unsigned char *pData, size_t len) {
+	if(len > RxBuffer.BufMaxSize) {
+		len = RxBuffer.BufMaxSize;
+	}
+	memcpy(RxBuffer.pBuffer, pData, len);
+	RxBuffer.len = len;
+	RxBuffer.NoMsgFlag = false;
+	RxBuffer.expiry_time.tv_sec = 0;
+	RxBuffer.expiry_time.tv_usec = 0;
+	RxIndex = 0;
+}
+
+IoT_Error_t aws_iot_benchmark_connect_client(AWS_IoT_Client *pClient) {
+	IoT_Client_Init_Params initParams = iotClientInitParamsDefault;
+	IoT_Client_Connect_Params connectParams = iotClientConnectParamsDefault;
+	unsigned char connack[] = {0x20, 0x02, 0x00, 0x00};
+	IoT_Error_t rc;
+
+	initParams.pHostURL = AWS_IOT_MQTT_HOST;
+	initParams.port = AWS_IOT_MQTT_PORT;
+	initParams.pRootCALocation = AWS_IOT_ROOT_CA_FILENAME;
+	initParams.pDeviceCertLocation = AWS_IOT_CERTIFICATE_FILENAME;
+	initParams.pDevicePrivateKeyLocation = AWS_IOT_PRIVATE_KEY_FILENAME;
+	initParams.mqttCommandTimeout_ms = 2000;
+	initParams.tlsHandshakeTimeout_ms = 5000;
+	initParams.isSSLHostnameVerify = true;
+	initParams.enableAutoReconnect = false;
+
+	rc = aws_iot_mqtt_init(pClient, &initParams);
+	if(SUCCESS != rc) {
+		return rc;
+	}
+
+	connectParams.keepAliveIntervalInSec = 600;
+	connectParams.isCleanSession = true;
+	connectParams.MQTTVersion = MQTT_3_1_1;
+	connectParams.pClientID = AWS_IOT_MQTT_CLIENT_ID;
+	connectParams.clientIDLen = (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID);
+	connectParams.isWillMsgPresent = false;
+
+	aws_iot_benchmark_set_rx_data(connack, sizeof(connack));
+	return aws_iot_mqtt_connect(pClient, &connectParams);
+}
+
+IoT_Error_t aws_iot_benchmark_subscribe(AWS_IoT_Client *pClient, const char *pTopicFilter,
+										pApplicationHandler_t pHandler, void *pData) {
+	unsigned char suback[] = {0x90, 0x03, 0x00, 0x01, 0x00};
+
+	aws_iot_benchmark_set_rx_data(suback, sizeof(suback));
+	return aws_iot_mqtt_subscribe(pClient, (char *) pTopicFilter, (uint16_t) strlen(pTopicFilter), QOS0, pHandler,
+								  pData);
+}
+
+size_t aws_iot_benchmark_encode_publish(unsigned char *pBuf, const char *pTopic, const char *pPayload) {
+	size_t topicLen = strlen(pTopic);
+	size_t payloadLen = strlen(pPayload);
+	size_t remLen = 2 + topicLen + payloadLen;
+	size_t len = 0;
+
+	pBuf[len++] = 0x30;
+	do {
+		unsigned char encodedByte = (unsigned char) (remLen % 128);
+		remLen /= 128;
+		if(remLen > 0) {
+			encodedByte |= 0x80;
+		}
+		pBuf[len++] = encodedByte;
+	} while(remLen > 0);
+
+	pBuf[len++] = (unsigned char) (topicLen >> 8);
+	pBuf[len++] = (unsigned char) (topicLen & 0xFF);
+	memcpy(pBuf + len, pTopic, topicLen);
+	len += topicLen;
+	memcpy(pBuf + len, pPayload, payloadLen);
+	len += payloadLen;
+
+	return len;
+}
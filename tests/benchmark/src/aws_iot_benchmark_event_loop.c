@@ -0,0 +1,199 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_event_loop.c
+ * @brief Event loop benchmark, compares one thread polling every client with yield to the epoll event loop
+ *
+ * A set of connected clients is driven from a single thread, first by calling yield on each
+ * client in turn and then by the event loop. For both the CPU time used while no data arrives
+ * and the time from a message arriving for one client until it is delivered are reported.
+ * The mock TLS layer gives every client an eventfd that stands in for its socket.
+ */
+
+#include <time.h>
+#include <sys/eventfd.h>
+
+#include "aws_iot_benchmark_common.h"
+#include "aws_iot_mqtt_client_reactor.h"
+
+#define EVENT_LOOP_CLIENTS 128
+#define EVENT_LOOP_POLL_MESSAGES 20
+#define EVENT_LOOP_REACTOR_MESSAGES 20000
+#define EVENT_LOOP_IDLE_MS 200
+#define EVENT_LOOP_TOPIC "bench/loop/topic"
+
+static AWS_IoT_Client clients[EVENT_LOOP_CLIENTS];
+static IoT_Reactor_Client reactorClients[EVENT_LOOP_CLIENTS];
+static IoT_Reactor reactor;
+static uint32_t deliveredCount;
+static unsigned char packet[128];
+static size_t packetLen;
+
+static void event_loop_callback_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+										IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(params);
+	IOT_UNUSED(pData);
+
+	deliveredCount++;
+}
+
+static uint64_t event_loop_get_cpu_time_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+	return ((uint64_t) now.tv_sec * 1000000000ULL) + (uint64_t) now.tv_nsec;
+}
+
+/* A message arrives on the socket of one client */
+static void event_loop_send(uint32_t index) {
+	int socket = -1;
+
+	aws_iot_benchmark_set_rx_data(packet, packetLen);
+	clients[index].networkStack.getSocket(&(clients[index].networkStack), &socket);
+	eventfd_write(socket, 1);
+}
+
+static void event_loop_report(const char *pLabel, uint64_t idleCpu, uint64_t idleWall, uint64_t latency,
+							  uint32_t messages, uint32_t wakeups) {
+	printf("  %s : %5.1f%% CPU while idle, %10.1f us/message delivery latency, %8.1f loop iterations/message\n",
+		   pLabel, 100.0 * (double) idleCpu / (double) idleWall, (double) latency / messages / 1000.0,
+		   (double) wakeups / messages);
+}
+
+/* One thread calls yield on each client in turn, the way a single thread serves many clients today */
+static int event_loop_poll_clients(void) {
+	uint64_t start, cpuStart, idleWall, idleCpu, latency;
+	uint32_t next = 0, yields = 0, expected, m;
+	IoT_Error_t rc = SUCCESS;
+
+	start = aws_iot_benchmark_get_time_ns();
+	cpuStart = event_loop_get_cpu_time_ns();
+	do {
+		rc = aws_iot_mqtt_yield(&clients[next], 1);
+		next = (next + 1) % EVENT_LOOP_CLIENTS;
+		idleWall = aws_iot_benchmark_get_time_ns() - start;
+	} while(SUCCESS == rc && idleWall < EVENT_LOOP_IDLE_MS * 1000000ULL);
+	idleCpu = event_loop_get_cpu_time_ns() - cpuStart;
+
+	latency = 0;
+	for(m = 0; m < EVENT_LOOP_POLL_MESSAGES && SUCCESS == rc; m++) {
+		expected = deliveredCount + 1;
+		event_loop_send((m * 37) % EVENT_LOOP_CLIENTS);
+		start = aws_iot_benchmark_get_time_ns();
+		while(deliveredCount < expected && SUCCESS == rc) {
+			rc = aws_iot_mqtt_yield(&clients[next], 1);
+			next = (next + 1) % EVENT_LOOP_CLIENTS;
+			yields++;
+		}
+		latency += aws_iot_benchmark_get_time_ns() - start;
+	}
+
+	if(SUCCESS != rc) {
+		printf("  polling : yield failed, rc %d\n", rc);
+		return rc;
+	}
+
+	event_loop_report("polling   ", idleCpu, idleWall, latency, EVENT_LOOP_POLL_MESSAGES, yields);
+
+	return 0;
+}
+
+static int event_loop_run_reactor(void) {
+	uint64_t start, cpuStart, idleWall, idleCpu, latency;
+	uint32_t expected, m, wakeups;
+	IoT_Error_t rc = SUCCESS;
+
+	start = aws_iot_benchmark_get_time_ns();
+	cpuStart = event_loop_get_cpu_time_ns();
+	do {
+		rc = aws_iot_mqtt_reactor_run_once(&reactor, EVENT_LOOP_IDLE_MS);
+		idleWall = aws_iot_benchmark_get_time_ns() - start;
+	} while(SUCCESS == rc && idleWall < EVENT_LOOP_IDLE_MS * 1000000ULL);
+	idleCpu = event_loop_get_cpu_time_ns() - cpuStart;
+
+	latency = 0;
+	wakeups = reactor.wakeupCount;
+	for(m = 0; m < EVENT_LOOP_REACTOR_MESSAGES && SUCCESS == rc; m++) {
+		expected = deliveredCount + 1;
+		event_loop_send((m * 37) % EVENT_LOOP_CLIENTS);
+		start = aws_iot_benchmark_get_time_ns();
+		while(deliveredCount < expected && SUCCESS == rc) {
+			rc = aws_iot_mqtt_reactor_run_once(&reactor, 100);
+		}
+		latency += aws_iot_benchmark_get_time_ns() - start;
+	}
+	wakeups = reactor.wakeupCount - wakeups;
+
+	if(SUCCESS != rc) {
+		printf("  event loop : run failed, rc %d\n", rc);
+		return rc;
+	}
+
+	event_loop_report("event loop", idleCpu, idleWall, latency, EVENT_LOOP_REACTOR_MESSAGES, wakeups);
+
+	return 0;
+}
+
+int aws_iot_benchmark_event_loop(void) {
+	uint32_t i;
+	int socket;
+	int rc = SUCCESS;
+
+	packetLen = aws_iot_benchmark_encode_publish(packet, EVENT_LOOP_TOPIC, "{\"temperature\":21.5}");
+
+	for(i = 0; i < EVENT_LOOP_CLIENTS && SUCCESS == rc; i++) {
+		rc = aws_iot_benchmark_connect_client(&clients[i]);
+		if(SUCCESS == rc) {
+			rc = aws_iot_benchmark_subscribe(&clients[i], EVENT_LOOP_TOPIC, event_loop_callback_handler, NULL);
+		}
+		if(SUCCESS == rc) {
+			/* from here on the mock only hands data to a client whose socket was signalled */
+			rc = clients[i].networkStack.getSocket(&(clients[i].networkStack), &socket);
+		}
+	}
+	if(SUCCESS != rc) {
+		printf("  client setup failed, rc %d\n", rc);
+		return rc;
+	}
+
+	printf("  %u clients, one thread\n", EVENT_LOOP_CLIENTS);
+
+	rc = event_loop_poll_clients();
+	if(0 != rc) {
+		return rc;
+	}
+
+	rc = aws_iot_mqtt_reactor_init(&reactor, reactorClients, EVENT_LOOP_CLIENTS);
+	for(i = 0; i < EVENT_LOOP_CLIENTS && SUCCESS == rc; i++) {
+		rc = aws_iot_mqtt_reactor_add(&reactor, &clients[i]);
+	}
+	if(SUCCESS != rc) {
+		printf("  event loop setup failed, rc %d\n", rc);
+		return rc;
+	}
+
+	rc = event_loop_run_reactor();
+
+	aws_iot_mqtt_reactor_destroy(&reactor);
+	for(i = 0; i < EVENT_LOOP_CLIENTS; i++) {
+		aws_iot_mqtt_disconnect(&clients[i]);
+		aws_iot_mqtt_free(&clients[i]);
+	}
+
+	return rc;
+}
@@ -0,0 +1,154 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_json_numbers.c
+ * @brief JSON number benchmark, compares the number parsers of aws_iot_json_utils.c with sscanf
+ *
+ * The numbers of a shadow delta document, sensor readings with and without a fraction and
+ * counters, are parsed over and over by the sscanf based parsers used before and by the
+ * current ones. Both have to agree on every value.
+ */
+
+#include <inttypes.h>
+
+#include "aws_iot_benchmark_common.h"
+#include "aws_iot_json_utils.h"
+
+#define JSON_NUMBERS_ITERATIONS 200000
+#define JSON_NUMBERS_MAX_TOKENS 64
+
+static const char deltaDocument[] = "{\"version\":18234,\"timestamp\":1650026412,\"state\":{"
+		"\"temperature\":23.5,\"humidity\":41.25,\"pressure\":1013.2,\"co2\":612,\"rssi\":-67,"
+		"\"battery\":87,\"voltage\":3.712,\"latitude\":47.620422,\"longitude\":-122.349358,"
+		"\"uptime\":345600,\"fanSpeed\":1200,\"setpoint\":21.0,\"errors\":0,\"offset\":-0.25},"
+		"\"metadata\":{\"temperature\":{\"timestamp\":1650026412},\"fanSpeed\":{\"timestamp\":1650026401}}}";
+
+static jsmntok_t tokens[JSON_NUMBERS_MAX_TOKENS];
+static jsmntok_t *pIntegerTokens[JSON_NUMBERS_MAX_TOKENS];
+static jsmntok_t *pRealTokens[JSON_NUMBERS_MAX_TOKENS];
+static uint32_t integerCount;
+static uint32_t realCount;
+
+/* The parsers used before, sscanf on a null terminated copy of the token */
+static IoT_Error_t sscanf_parse_int32(int32_t *i, const char *jsonString, jsmntok_t *token) {
+	char numBuf[64];
+	size_t len = (size_t) (token->end - token->start);
+
+	memcpy(numBuf, jsonString + token->start, len);
+	numBuf[len] = '\0';
+	return (1 == sscanf(numBuf, "%" SCNi32, i)) ? SUCCESS : JSON_PARSE_ERROR;
+}
+
+static IoT_Error_t sscanf_parse_double(double *d, const char *jsonString, jsmntok_t *token) {
+	char numBuf[64];
+	size_t len = (size_t) (token->end - token->start);
+
+	memcpy(numBuf, jsonString + token->start, len);
+	numBuf[len] = '\0';
+	return (1 == sscanf(numBuf, "%lf", d)) ? SUCCESS : JSON_PARSE_ERROR;
+}
+
+static void json_numbers_report(const char *pLabel, uint64_t elapsed, uint32_t count) {
+	printf("  %s : %6.1f ns/number\n", pLabel, (double) elapsed / ((double) JSON_NUMBERS_ITERATIONS * count));
+}
+
+int aws_iot_benchmark_json_numbers(void) {
+	jsmn_parser parser;
+	int32_t tokenCount;
+	int32_t intValue, expectedInt;
+	double realValue, expectedReal;
+	volatile double sink = 0;
+	uint64_t start;
+	uint32_t i, n;
+	int32_t t;
+
+	jsmn_init(&parser);
+	tokenCount = jsmn_parse(&parser, deltaDocument, strlen(deltaDocument), tokens, JSON_NUMBERS_MAX_TOKENS);
+	if(tokenCount < 0) {
+		printf("  delta document did not parse: %d\n", tokenCount);
+		return FAILURE;
+	}
+
+	integerCount = 0;
+	realCount = 0;
+	for(t = 0; t < tokenCount; t++) {
+		if(JSMN_PRIMITIVE != tokens[t].type) {
+			continue;
+		}
+		if(NULL != memchr(deltaDocument + tokens[t].start, '.', (size_t) (tokens[t].end - tokens[t].start))) {
+			pRealTokens[realCount++] = &tokens[t];
+		} else {
+			pIntegerTokens[integerCount++] = &tokens[t];
+		}
+	}
+
+	for(n = 0; n < integerCount; n++) {
+		if(SUCCESS != parseInteger32Value(&intValue, deltaDocument, pIntegerTokens[n])
+		   || SUCCESS != sscanf_parse_int32(&expectedInt, deltaDocument, pIntegerTokens[n]) || intValue != expectedInt) {
+			printf("  integer %d parsed differently from sscanf\n", n);
+			return FAILURE;
+		}
+	}
+	for(n = 0; n < realCount; n++) {
+		if(SUCCESS != parseDoubleValue(&realValue, deltaDocument, pRealTokens[n])
+		   || SUCCESS != sscanf_parse_double(&expectedReal, deltaDocument, pRealTokens[n])
+		   || realValue != expectedReal) {
+			printf("  real number %d parsed differently from sscanf\n", n);
+			return FAILURE;
+		}
+	}
+	printf("  %u integers and %u numbers with a fraction in a %u byte delta document\n", integerCount, realCount,
+		   (unsigned int) strlen(deltaDocument));
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < JSON_NUMBERS_ITERATIONS; i++) {
+		for(n = 0; n < integerCount; n++) {
+			sscanf_parse_int32(&intValue, deltaDocument, pIntegerTokens[n]);
+			sink += intValue;
+		}
+	}
+	json_numbers_report("integers, sscanf         ", aws_iot_benchmark_get_time_ns() - start, integerCount);
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < JSON_NUMBERS_ITERATIONS; i++) {
+		for(n = 0; n < integerCount; n++) {
+			parseInteger32Value(&intValue, deltaDocument, pIntegerTokens[n]);
+			sink += intValue;
+		}
+	}
+	json_numbers_report("integers, bounded parser ", aws_iot_benchmark_get_time_ns() - start, integerCount);
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < JSON_NUMBERS_ITERATIONS; i++) {
+		for(n = 0; n < realCount; n++) {
+			sscanf_parse_double(&realValue, deltaDocument, pRealTokens[n]);
+			sink += realValue;
+		}
+	}
+	json_numbers_report("fractions, sscanf        ", aws_iot_benchmark_get_time_ns() - start, realCount);
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < JSON_NUMBERS_ITERATIONS; i++) {
+		for(n = 0; n < realCount; n++) {
+			parseDoubleValue(&realValue, deltaDocument, pRealTokens[n]);
+			sink += realValue;
+		}
+	}
+	json_numbers_report("fractions, bounded parser", aws_iot_benchmark_get_time_ns() - start, realCount);
+
+	IOT_UNUSED(sink);
+	return 0;
+}
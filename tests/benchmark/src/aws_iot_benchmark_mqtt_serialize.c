@@ -0,0 +1,362 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_mqtt_serialize.c
+ * @brief MQTT serialization benchmark, compares the packet header encoding used before with the current one
+ *
+ * The fixed header and remaining length of every packet type are encoded with the switch based
+ * init_header and the division loop used before and with the current table and branch-light
+ * encoder, which have to produce the same bytes. The ack, ping and disconnect serializers are
+ * timed on their own, and the header of a publish is serialized as before, with a header prepared
+ * for every message, with one header prepared by aws_iot_mqtt_init_publish_header and reused, and
+ * patched in the buffer of a publish prepared by aws_iot_mqtt_prepare_publish.
+ */
+
+#include "aws_iot_benchmark_common.h"
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#define MQTT_SERIALIZE_ITERATIONS 1000000
+#define MQTT_SERIALIZE_BUF_LEN 16
+#define MQTT_SERIALIZE_TOPIC_BUF_LEN 64
+#define MQTT_SERIALIZE_PAYLOAD_LEN 200
+
+typedef struct {
+	const char *pName;
+	MessageTypes type;
+	QoS qos;
+	uint32_t remainingLength;
+} SerializedPacket;
+
+/* Every packet type with the QoS bits it is sent with and a typical remaining length */
+static const SerializedPacket packets[] = {
+	{"CONNECT    ", CONNECT, QOS0, 60},
+	{"CONNACK    ", CONNACK, QOS0, 2},
+	{"PUBLISH    ", PUBLISH, QOS1, 300},
+	{"PUBACK     ", PUBACK, QOS0, 2},
+	{"PUBREC     ", PUBREC, QOS0, 2},
+	{"PUBREL     ", PUBREL, QOS1, 2},
+	{"PUBCOMP    ", PUBCOMP, QOS0, 2},
+	{"SUBSCRIBE  ", SUBSCRIBE, QOS1, 40},
+	{"SUBACK     ", SUBACK, QOS0, 3},
+	{"UNSUBSCRIBE", UNSUBSCRIBE, QOS1, 40},
+	{"UNSUBACK   ", UNSUBACK, QOS0, 2},
+	{"PINGREQ    ", PINGREQ, QOS0, 0},
+	{"PINGRESP   ", PINGRESP, QOS0, 0},
+	{"DISCONNECT ", DISCONNECT, QOS0, 0},
+};
+
+#define SERIALIZED_PACKET_COUNT (sizeof(packets) / sizeof(packets[0]))
+
+static const uint32_t remainingLengths[] = {0, 1, 2, 127, 128, 300, 16383, 16384, 2097151, 2097152, 268435455};
+
+/* The header encoding used before, noinline like the library functions it is compared with */
+static __attribute__((noinline)) IoT_Error_t previous_init_header(MQTTHeader *pHeader, MessageTypes message_type,
+																  QoS qos, uint8_t dup, uint8_t retained) {
+	if(NULL == pHeader) {
+		return NULL_VALUE_ERROR;
+	}
+
+	pHeader->byte = 0;
+	switch(message_type) {
+		case CONNECT:
+			pHeader->bits.type = 0x01;
+			break;
+		case CONNACK:
+			pHeader->bits.type = 0x02;
+			break;
+		case PUBLISH:
+			pHeader->bits.type = 0x03;
+			break;
+		case PUBACK:
+			pHeader->bits.type = 0x04;
+			break;
+		case PUBREC:
+			pHeader->bits.type = 0x05;
+			break;
+		case PUBREL:
+			pHeader->bits.type = 0x06;
+			break;
+		case PUBCOMP:
+			pHeader->bits.type = 0x07;
+			break;
+		case SUBSCRIBE:
+			pHeader->bits.type = 0x08;
+			break;
+		case SUBACK:
+			pHeader->bits.type = 0x09;
+			break;
+		case UNSUBSCRIBE:
+			pHeader->bits.type = 0x0A;
+			break;
+		case UNSUBACK:
+			pHeader->bits.type = 0x0B;
+			break;
+		case PINGREQ:
+			pHeader->bits.type = 0x0C;
+			break;
+		case PINGRESP:
+			pHeader->bits.type = 0x0D;
+			break;
+		case DISCONNECT:
+			pHeader->bits.type = 0x0E;
+			break;
+		default:
+			return FAILURE;
+	}
+
+	pHeader->bits.dup = (1 == dup) ? 0x01 : 0x00;
+	switch(qos) {
+		case QOS1:
+			pHeader->bits.qos = 0x01;
+			break;
+		default:
+			pHeader->bits.qos = 0x00;
+			break;
+	}
+	pHeader->bits.retain = (1 == retained) ? 0x01 : 0x00;
+
+	return SUCCESS;
+}
+
+static __attribute__((noinline)) size_t previous_write_len_to_buffer(unsigned char *buf, uint32_t length) {
+	size_t outLen = 0;
+	unsigned char encodedByte;
+
+	do {
+		encodedByte = (unsigned char) (length % 128);
+		length /= 128;
+		if(length > 0) {
+			encodedByte |= 0x80;
+		}
+		buf[outLen++] = encodedByte;
+	} while(length > 0);
+
+	return outLen;
+}
+
+static int mqtt_serialize_check(void) {
+	unsigned char previous[MQTT_SERIALIZE_BUF_LEN], current[MQTT_SERIALIZE_BUF_LEN];
+	MQTTHeader previousHeader, currentHeader;
+	size_t previousLen, currentLen, n;
+	uint32_t type, flags, length;
+
+	for(type = CONNECT; type <= DISCONNECT; type++) {
+		for(flags = 0; flags < 8; flags++) {
+			previous_init_header(&previousHeader, (MessageTypes) type, (QoS) (flags & 1), (uint8_t) ((flags >> 1) & 1),
+								 (uint8_t) (flags >> 2));
+			aws_iot_mqtt_internal_init_header(&currentHeader, (MessageTypes) type, (QoS) (flags & 1),
+											  (uint8_t) ((flags >> 1) & 1), (uint8_t) (flags >> 2));
+			if(previousHeader.byte != currentHeader.byte) {
+				printf("  header of packet type %u with flags %u differs\n", type, flags);
+				return FAILURE;
+			}
+		}
+	}
+
+	for(n = 0; n < sizeof(remainingLengths) / sizeof(remainingLengths[0]) + 100000; n++) {
+		length = (n < sizeof(remainingLengths) / sizeof(remainingLengths[0])) ? remainingLengths[n]
+																			  : (uint32_t) (n * 2683) % 268435456;
+		previousLen = previous_write_len_to_buffer(previous, length);
+		currentLen = aws_iot_mqtt_internal_write_len_to_buffer(current, length);
+		if(previousLen != currentLen || 0 != memcmp(previous, current, currentLen)) {
+			printf("  remaining length %u encoded differently\n", length);
+			return FAILURE;
+		}
+	}
+
+	return SUCCESS;
+}
+
+static int mqtt_serialize_headers(void) {
+	unsigned char buf[MQTT_SERIALIZE_BUF_LEN];
+	MQTTHeader header;
+	volatile size_t sink = 0;
+	uint64_t start, previousTime;
+	uint32_t i, p;
+
+	for(p = 0; p < SERIALIZED_PACKET_COUNT; p++) {
+		start = aws_iot_benchmark_get_time_ns();
+		for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+			previous_init_header(&header, packets[p].type, packets[p].qos, 0, 0);
+			buf[0] = header.byte;
+			sink += previous_write_len_to_buffer(buf + 1, packets[p].remainingLength) + buf[0];
+		}
+		previousTime = aws_iot_benchmark_get_time_ns() - start;
+
+		start = aws_iot_benchmark_get_time_ns();
+		for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+			aws_iot_mqtt_internal_init_header(&header, packets[p].type, packets[p].qos, 0, 0);
+			buf[0] = header.byte;
+			sink += aws_iot_mqtt_internal_write_len_to_buffer(buf + 1, packets[p].remainingLength) + buf[0];
+		}
+		printf("  %s header : switch %5.1f ns, table %5.1f ns\n", packets[p].pName,
+			   (double) previousTime / MQTT_SERIALIZE_ITERATIONS,
+			   (double) (aws_iot_benchmark_get_time_ns() - start) / MQTT_SERIALIZE_ITERATIONS);
+	}
+
+	IOT_UNUSED(sink);
+	return SUCCESS;
+}
+
+static int mqtt_serialize_packets(void) {
+	static const MessageTypes ackTypes[] = {PUBACK, PUBREC, PUBREL, PUBCOMP};
+	static const MessageTypes zeroTypes[] = {PINGREQ, DISCONNECT};
+	unsigned char buf[MQTT_SERIALIZE_BUF_LEN];
+	volatile size_t sink = 0;
+	uint32_t serializedLen;
+	size_t zeroLen;
+	uint64_t start;
+	uint32_t i, t;
+
+	for(t = 0; t < sizeof(ackTypes) / sizeof(ackTypes[0]); t++) {
+		start = aws_iot_benchmark_get_time_ns();
+		for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+			aws_iot_mqtt_internal_serialize_ack(buf, sizeof(buf), ackTypes[t], 0, (uint16_t) i, &serializedLen);
+			sink += serializedLen;
+		}
+		printf("  %s packet : %5.1f ns\n", packets[ackTypes[t] - 1].pName,
+			   (double) (aws_iot_benchmark_get_time_ns() - start) / MQTT_SERIALIZE_ITERATIONS);
+	}
+
+	for(t = 0; t < sizeof(zeroTypes) / sizeof(zeroTypes[0]); t++) {
+		start = aws_iot_benchmark_get_time_ns();
+		for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+			aws_iot_mqtt_internal_serialize_zero(buf, sizeof(buf), zeroTypes[t], &zeroLen);
+			sink += zeroLen;
+		}
+		printf("  %s packet : %5.1f ns\n", packets[zeroTypes[t] - 1].pName,
+			   (double) (aws_iot_benchmark_get_time_ns() - start) / MQTT_SERIALIZE_ITERATIONS);
+	}
+
+	IOT_UNUSED(sink);
+	return SUCCESS;
+}
+
+/* The publish header serialization used before, the fixed header is worked out for every message */
+static __attribute__((noinline)) size_t previous_serialize_publish_header(unsigned char *buf, QoS qos,
+																		  uint16_t packetId, const char *pTopicName,
+																		  uint16_t topicNameLen, size_t payloadLen) {
+	unsigned char *ptr = buf;
+	uint32_t rem_len = (uint32_t) (topicNameLen + payloadLen + 2);
+	MQTTHeader header = {0};
+
+	if(qos > 0) {
+		rem_len += 2;
+	}
+	previous_init_header(&header, PUBLISH, qos, 0, 0);
+	aws_iot_mqtt_internal_write_char(&ptr, header.byte);
+	ptr += previous_write_len_to_buffer(ptr, rem_len);
+	aws_iot_mqtt_internal_write_utf8_string(&ptr, pTopicName, topicNameLen);
+	if(qos > 0) {
+		aws_iot_mqtt_internal_write_uint_16(&ptr, packetId);
+	}
+
+	return (size_t) (ptr - buf);
+}
+
+static int mqtt_serialize_publishes(void) {
+	static const char topic[] = "$aws/things/benchmarkThing/shadow/update";
+	unsigned char previous[MQTT_SERIALIZE_TOPIC_BUF_LEN], current[MQTT_SERIALIZE_TOPIC_BUF_LEN];
+	unsigned char prepared[AWS_IOT_MQTT_PREPARED_PUBLISH_LEN(sizeof(topic) - 1)];
+	uint16_t topicLen = (uint16_t) strlen(topic);
+	IoT_Publish_Message_Params params = {0};
+	const unsigned char *pPacketHeader;
+	IoT_Publish_Header header;
+	volatile size_t sink = 0;
+	uint32_t serializedLen = 0;
+	size_t previousLen;
+	uint64_t start;
+	uint32_t i;
+
+	params.qos = QOS1;
+	previousLen = previous_serialize_publish_header(previous, QOS1, 7, topic, topicLen, MQTT_SERIALIZE_PAYLOAD_LEN);
+	aws_iot_mqtt_init_publish_header(&header, topic, topicLen, QOS1, 0);
+	aws_iot_mqtt_internal_serialize_publish_header(current, sizeof(current), &header, 0, 7,
+												   MQTT_SERIALIZE_PAYLOAD_LEN, &serializedLen);
+	if(previousLen != serializedLen || 0 != memcmp(previous, current, previousLen)) {
+		printf("  publish header serialized differently\n");
+		return FAILURE;
+	}
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+		sink += previous_serialize_publish_header(previous, QOS1, (uint16_t) i, topic, topicLen,
+												  MQTT_SERIALIZE_PAYLOAD_LEN);
+	}
+	printf("  PUBLISH     header, %u byte topic, before           : %5.1f ns\n", topicLen,
+		   (double) (aws_iot_benchmark_get_time_ns() - start) / MQTT_SERIALIZE_ITERATIONS);
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+		aws_iot_mqtt_init_publish_header(&header, topic, topicLen, QOS1, 0);
+		aws_iot_mqtt_internal_serialize_publish_header(current, sizeof(current), &header, 0, (uint16_t) i,
+													   MQTT_SERIALIZE_PAYLOAD_LEN, &serializedLen);
+		sink += serializedLen;
+	}
+	printf("  PUBLISH     header, %u byte topic, header per call  : %5.1f ns\n", topicLen,
+		   (double) (aws_iot_benchmark_get_time_ns() - start) / MQTT_SERIALIZE_ITERATIONS);
+
+	aws_iot_mqtt_init_publish_header(&header, topic, topicLen, QOS1, 0);
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+		aws_iot_mqtt_internal_serialize_publish_header(current, sizeof(current), &header, 0, (uint16_t) i,
+													   MQTT_SERIALIZE_PAYLOAD_LEN, &serializedLen);
+		sink += serializedLen;
+	}
+	printf("  PUBLISH     header, %u byte topic, prepared header  : %5.1f ns\n", topicLen,
+		   (double) (aws_iot_benchmark_get_time_ns() - start) / MQTT_SERIALIZE_ITERATIONS);
+
+	previousLen = previous_serialize_publish_header(previous, QOS1, 7, topic, topicLen, MQTT_SERIALIZE_PAYLOAD_LEN);
+	aws_iot_mqtt_prepare_publish(&header, prepared, sizeof(prepared), topic, topicLen, &params);
+	pPacketHeader = aws_iot_mqtt_internal_patch_prepared_publish(&header, 0, 7, MQTT_SERIALIZE_PAYLOAD_LEN,
+																 &serializedLen);
+	if(previousLen != serializedLen || 0 != memcmp(previous, pPacketHeader, previousLen)) {
+		printf("  prepared publish header serialized differently\n");
+		return FAILURE;
+	}
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < MQTT_SERIALIZE_ITERATIONS; i++) {
+		pPacketHeader = aws_iot_mqtt_internal_patch_prepared_publish(&header, 0, (uint16_t) i,
+																	 MQTT_SERIALIZE_PAYLOAD_LEN, &serializedLen);
+		sink += serializedLen + pPacketHeader[0];
+	}
+	printf("  PUBLISH     header, %u byte topic, prepared publish : %5.1f ns\n", topicLen,
+		   (double) (aws_iot_benchmark_get_time_ns() - start) / MQTT_SERIALIZE_ITERATIONS);
+
+	IOT_UNUSED(sink);
+	return SUCCESS;
+}
+
+int aws_iot_benchmark_mqtt_serialize(void) {
+	int rc;
+
+	rc = mqtt_serialize_check();
+	if(SUCCESS != rc) {
+		return rc;
+	}
+	printf("  header bytes and remaining lengths encoded as before\n");
+
+	rc = mqtt_serialize_headers();
+	if(SUCCESS == rc) {
+		rc = mqtt_serialize_packets();
+	}
+	if(SUCCESS == rc) {
+		rc = mqtt_serialize_publishes();
+	}
+
+	return rc;
+}
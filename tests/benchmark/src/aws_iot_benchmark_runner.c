@@ -0,0 +1,52 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_runner.c
+ * @brief Benchmark runner
+ */
+
+#include "aws_iot_benchmark_common.h"
+
+typedef struct {
+	const char *pName;
+	int (*pRun)(void);
+} BenchmarkSuite;
+
+static const BenchmarkSuite benchmarkSuites[] = {
+	{"MQTT receive framing", aws_iot_benchmark_rx_framing},
+	{"MQTT subscription lookup", aws_iot_benchmark_topic_match},
+	{"MQTT buffer memory", aws_iot_benchmark_buffer_memory},
+	{"MQTT event loop", aws_iot_benchmark_event_loop},
+	{"Timer checks", aws_iot_benchmark_timer},
+	{"JSON number parsing", aws_iot_benchmark_json_numbers},
+	{"MQTT serialization", aws_iot_benchmark_mqtt_serialize},
+};
+
+int main() {
+	size_t i;
+	int rc = 0;
+
+	for(i = 0; i < sizeof(benchmarkSuites) / sizeof(benchmarkSuites[0]); i++) {
+		printf("\n*** %s ***\n", benchmarkSuites[i].pName);
+		rc = benchmarkSuites[i].pRun();
+		if(0 != rc) {
+			printf("*** %s FAILED! RC : %d ***\n", benchmarkSuites[i].pName, rc);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_rx_framing.c
+ * @brief Receive path benchmark, counts network reads needed per incoming packet
+ *
+ * A batch of small PUBLISH packets is placed in the mock TLS buffer, the same way
+ * several packets arrive together in one TLS record. The client then frames them
+ * and the mock counts how many read calls were made.
+ */
+
+#include "aws_iot_benchmark_common.h"
+#include "aws_iot_mqtt_client_common_internal.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+
+#define RX_FRAMING_ITERATIONS 20000
+#define RX_FRAMING_TOPIC "bench/rx/topic"
+#define RX_FRAMING_PAYLOAD "{\"temperature\":21.5}"
+
+static uint32_t deliveredCount;
+
+static void rx_framing_callback_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+										IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(params);
+	IOT_UNUSED(pData);
+
+	deliveredCount++;
+}
+
+static int rx_framing_run_batch(AWS_IoT_Client *pClient, uint32_t batchSize) {
+	unsigned char batch[AWS_IOT_MQTT_RX_BUF_LEN];
+	size_t packetLen = 0, batchLen = 0;
+	uint32_t i, totalPackets = 0;
+	uint64_t start, elapsed;
+	uint8_t packetType = 0;
+	IoT_Error_t rc = SUCCESS;
+	Timer timer;
+
+	for(i = 0; i < batchSize; i++) {
+		packetLen = aws_iot_benchmark_encode_publish(batch + batchLen, RX_FRAMING_TOPIC, RX_FRAMING_PAYLOAD);
+		batchLen += packetLen;
+	}
+
+	init_timer(&timer);
+	countdown_sec(&timer, 60);
+
+	RxReadCallCount = 0;
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < RX_FRAMING_ITERATIONS && SUCCESS == rc; i++) {
+		aws_iot_benchmark_set_rx_data(batch, batchLen);
+		deliveredCount = 0;
+		while(deliveredCount < batchSize && SUCCESS == rc) {
+			rc = aws_iot_mqtt_internal_cycle_read(pClient, &timer, &packetType);
+		}
+		totalPackets += deliveredCount;
+	}
+	elapsed = aws_iot_benchmark_get_time_ns() - start;
+
+	if(SUCCESS != rc) {
+		printf("  batch of %2u : cycle read failed, rc %d\n", batchSize, rc);
+		return rc;
+	}
+
+	/* Per-byte framing reads the fixed header, each remaining length byte and then the body separately */
+	printf("  batch of %2u : %6.3f reads/packet (per-byte framing: %u), %8.1f ns/packet\n", batchSize,
+		   (double) RxReadCallCount / totalPackets, (unsigned int) (1 + (packetLen - 2 > 127 ? 2 : 1) + 1),
+		   (double) elapsed / totalPackets);
+
+	return 0;
+}
+
+int aws_iot_benchmark_rx_framing(void) {
+	static const uint32_t batchSizes[] = {1, 4, 8, 12};
+	AWS_IoT_Client client;
+	size_t i;
+	int rc;
+
+	rc = aws_iot_benchmark_connect_client(&client);
+	if(SUCCESS != rc) {
+		printf("  connect failed, rc %d\n", rc);
+		return rc;
+	}
+
+	rc = aws_iot_benchmark_subscribe(&client, RX_FRAMING_TOPIC, rx_framing_callback_handler, NULL);
+	if(SUCCESS != rc) {
+		printf("  subscribe failed, rc %d\n", rc);
+		return rc;
+	}
+
+	for(i = 0; i < sizeof(batchSizes) / sizeof(batchSizes[0]) && 0 == rc; i++) {
+		rc = rx_framing_run_batch(&client, batchSizes[i]);
+	}
+
+	return rc;
+}
@@ -0,0 +1,119 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_timer.c
+ * @brief Timer benchmark, compares the cost of timer checks
+ *
+ * A set of timers, the size of the in-flight and ack lists of a client, is checked over and
+ * over. The gettimeofday based check the Linux timer used before is timed next to the monotonic
+ * timer, with and without a timer batch, and a check on the coarse monotonic clock.
+ */
+
+#include <time.h>
+#include <sys/time.h>
+
+#include "aws_iot_benchmark_common.h"
+
+#define TIMER_TIMERS 16
+#define TIMER_ITERATIONS 1000000
+
+static Timer timers[TIMER_TIMERS];
+static struct timeval wallEndTimes[TIMER_TIMERS];
+static struct timespec coarseEndTimes[TIMER_TIMERS];
+static uint32_t expiredCount;
+
+/* The check of the previous timer implementation, on the wall clock */
+static bool timer_wall_clock_expired(struct timeval *pEndTime) {
+	struct timeval now, res;
+	gettimeofday(&now, NULL);
+	timersub(pEndTime, &now, &res);
+	return res.tv_sec < 0 || (res.tv_sec == 0 && res.tv_usec <= 0);
+}
+
+static bool timer_coarse_clock_expired(struct timespec *pEndTime) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+	return now.tv_sec > pEndTime->tv_sec || (now.tv_sec == pEndTime->tv_sec && now.tv_nsec >= pEndTime->tv_nsec);
+}
+
+static void timer_report(const char *pLabel, uint64_t elapsed) {
+	printf("  %s : %6.1f ns/check, %7.1f M checks/s\n", pLabel, (double) elapsed / (TIMER_ITERATIONS * TIMER_TIMERS),
+		   (double) TIMER_ITERATIONS * TIMER_TIMERS * 1000.0 / (double) elapsed);
+}
+
+int aws_iot_benchmark_timer(void) {
+	struct timeval now;
+	uint64_t start, elapsed;
+	uint32_t i, t;
+
+	gettimeofday(&now, NULL);
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &coarseEndTimes[0]);
+	for(t = 0; t < TIMER_TIMERS; t++) {
+		init_timer(&timers[t]);
+		countdown_sec(&timers[t], 60);
+		wallEndTimes[t] = now;
+		wallEndTimes[t].tv_sec += 60;
+		coarseEndTimes[t] = coarseEndTimes[0];
+		coarseEndTimes[t].tv_sec += 60;
+	}
+
+	expiredCount = 0;
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < TIMER_ITERATIONS; i++) {
+		for(t = 0; t < TIMER_TIMERS; t++) {
+			expiredCount += timer_wall_clock_expired(&wallEndTimes[t]);
+		}
+	}
+	elapsed = aws_iot_benchmark_get_time_ns() - start;
+	timer_report("gettimeofday          ", elapsed);
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < TIMER_ITERATIONS; i++) {
+		for(t = 0; t < TIMER_TIMERS; t++) {
+			expiredCount += has_timer_expired(&timers[t]);
+		}
+	}
+	elapsed = aws_iot_benchmark_get_time_ns() - start;
+	timer_report("monotonic             ", elapsed);
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < TIMER_ITERATIONS; i++) {
+		for(t = 0; t < TIMER_TIMERS; t++) {
+			expiredCount += timer_coarse_clock_expired(&coarseEndTimes[t]);
+		}
+	}
+	elapsed = aws_iot_benchmark_get_time_ns() - start;
+	timer_report("monotonic coarse      ", elapsed);
+
+	/* the clock is read once per pass over the timers, the way the event loop scans its clients */
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < TIMER_ITERATIONS; i++) {
+		begin_timer_batch();
+		for(t = 0; t < TIMER_TIMERS; t++) {
+			expiredCount += has_timer_expired(&timers[t]);
+		}
+		end_timer_batch();
+	}
+	elapsed = aws_iot_benchmark_get_time_ns() - start;
+	timer_report("monotonic, timer batch", elapsed);
+
+	if(0 != expiredCount) {
+		printf("  %u checks found a 60 s timer expired\n", expiredCount);
+		return FAILURE;
+	}
+
+	return 0;
+}
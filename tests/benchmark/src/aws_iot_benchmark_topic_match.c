@@ -0,0 +1,196 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_benchmark_topic_match.c
+ * @brief Subscription lookup benchmark, topic trie against a scan of all topic filters
+ *
+ * The client is subscribed to 10, 100 and 1000 topic filters, a mix of exact
+ * filters and filters with '+' and '#'. The same set of incoming topics is then
+ * looked up with the topic trie and with the linear scan the client used before.
+ */
+
+#include "aws_iot_benchmark_common.h"
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#define TOPIC_MATCH_LOOKUPS 20000
+#define TOPIC_MATCH_FILTER_LEN 48
+#define TOPIC_MATCH_NUM_TOPICS 8
+
+static AWS_IoT_Client topicMatchClient;
+static char topicFilters[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS][TOPIC_MATCH_FILTER_LEN];
+
+static void topic_match_callback_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+										 IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(params);
+	IOT_UNUSED(pData);
+}
+
+/* The matcher the client ran against every topic filter before the topic trie */
+static char topic_match_is_topic_matched(char *pTopicFilter, char *pTopicName, uint16_t topicNameLen) {
+	char *curf, *curn, *curn_end;
+
+	if(NULL == pTopicFilter || NULL == pTopicName) {
+		return 0;
+	}
+
+	curf = pTopicFilter;
+	curn = pTopicName;
+	curn_end = curn + topicNameLen;
+
+	while(*curf && (curn < curn_end)) {
+		if(*curn == '/' && *curf != '/') {
+			break;
+		}
+		if(*curf != '+' && *curf != '#' && *curf != *curn) {
+			break;
+		}
+		if(*curf == '+') {
+			char *nextpos = curn + 1;
+			while(nextpos < curn_end && *nextpos != '/')
+				nextpos = ++curn + 1;
+		} else if(*curf == '#') {
+			curn = curn_end - 1;
+		}
+
+		curf++;
+		curn++;
+	};
+
+	return (curn == curn_end) && (*curf == '\0');
+}
+
+/* Only the slots in use are scanned, so the result depends on the number of filters and not the table size */
+static uint32_t topic_match_linear(AWS_IoT_Client *pClient, uint32_t filterCount, char *pTopicName,
+								   uint16_t topicNameLen) {
+	uint32_t itr, matched = 0;
+	MessageHandlers *pHandler;
+
+	for(itr = 0; itr < filterCount; ++itr) {
+		pHandler = &(pClient->clientData.messageHandlers[itr]);
+		if(NULL != pHandler->topicName) {
+			if(((topicNameLen == pHandler->topicNameLen)
+				&& (strncmp(pTopicName, (char *) pHandler->topicName, topicNameLen) == 0))
+			   || topic_match_is_topic_matched((char *) pHandler->topicName, pTopicName, topicNameLen)) {
+				matched++;
+			}
+		}
+	}
+
+	return matched;
+}
+
+static uint32_t topic_match_trie(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen) {
+	uint32_t matchedHandlers[AWS_IOT_MQTT_HANDLER_BITSET_WORDS];
+	uint32_t word, bits, matched = 0;
+
+	memset(matchedHandlers, 0, sizeof(matchedHandlers));
+	aws_iot_mqtt_internal_topic_trie_match(pClient, pTopicName, topicNameLen, matchedHandlers);
+
+	for(word = 0; word < AWS_IOT_MQTT_HANDLER_BITSET_WORDS; ++word) {
+		for(bits = matchedHandlers[word]; 0 != bits; bits &= bits - 1) {
+			matched++;
+		}
+	}
+
+	return matched;
+}
+
+static int topic_match_run(uint32_t filterCount) {
+	static char topics[TOPIC_MATCH_NUM_TOPICS][TOPIC_MATCH_FILTER_LEN];
+	uint16_t topicLens[TOPIC_MATCH_NUM_TOPICS];
+	uint32_t i, linearMatches = 0, trieMatches = 0;
+	uint64_t start, linearNs, trieNs;
+	IoT_Error_t rc;
+
+	rc = aws_iot_benchmark_connect_client(&topicMatchClient);
+	if(SUCCESS != rc) {
+		printf("  connect failed, rc %d\n", rc);
+		return rc;
+	}
+
+	/* Device filters, every fourth one takes any metric, and one wildcard filter per region */
+	for(i = 0; i < filterCount; i++) {
+		if(0 == i % 100) {
+			snprintf(topicFilters[i], TOPIC_MATCH_FILTER_LEN, "fleet/region%u/#", (unsigned int) ((i / 100) % 8));
+		} else if(0 == i % 4) {
+			snprintf(topicFilters[i], TOPIC_MATCH_FILTER_LEN, "fleet/region%u/dev%u/+", (unsigned int) (i % 8),
+					 (unsigned int) i);
+		} else {
+			snprintf(topicFilters[i], TOPIC_MATCH_FILTER_LEN, "fleet/region%u/dev%u/telemetry", (unsigned int) (i % 8),
+					 (unsigned int) i);
+		}
+		rc = aws_iot_benchmark_subscribe(&topicMatchClient, topicFilters[i], topic_match_callback_handler, NULL);
+		if(SUCCESS != rc) {
+			printf("  subscribe %u failed, rc %d\n", (unsigned int) i, rc);
+			return rc;
+		}
+	}
+
+	/* Topics matching the first and last subscriptions, and topics matching none */
+	for(i = 0; i < TOPIC_MATCH_NUM_TOPICS; i++) {
+		uint32_t device = (i % 2) ? filterCount - 1 - i : i + 1;
+		snprintf(topics[i], TOPIC_MATCH_FILTER_LEN, "fleet/region%u/dev%u/%s", (unsigned int) (device % 8),
+				 (unsigned int) (i < 6 ? device : device + filterCount), (i % 3) ? "telemetry" : "status");
+		topicLens[i] = (uint16_t) strlen(topics[i]);
+	}
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < TOPIC_MATCH_LOOKUPS; i++) {
+		linearMatches += topic_match_linear(&topicMatchClient, filterCount, topics[i % TOPIC_MATCH_NUM_TOPICS],
+											topicLens[i % TOPIC_MATCH_NUM_TOPICS]);
+	}
+	linearNs = aws_iot_benchmark_get_time_ns() - start;
+
+	start = aws_iot_benchmark_get_time_ns();
+	for(i = 0; i < TOPIC_MATCH_LOOKUPS; i++) {
+		trieMatches += topic_match_trie(&topicMatchClient, topics[i % TOPIC_MATCH_NUM_TOPICS],
+										topicLens[i % TOPIC_MATCH_NUM_TOPICS]);
+	}
+	trieNs = aws_iot_benchmark_get_time_ns() - start;
+
+	if(linearMatches != trieMatches) {
+		printf("  %4u filters : trie found %u matches, linear scan %u\n", (unsigned int) filterCount,
+			   (unsigned int) trieMatches, (unsigned int) linearMatches);
+		return FAILURE;
+	}
+
+	printf("  %4u filters : linear scan %8.1f ns/lookup, trie %6.1f ns/lookup (%u trie nodes, %.2f matches/lookup)\n",
+		   (unsigned int) filterCount, (double) linearNs / TOPIC_MATCH_LOOKUPS, (double) trieNs / TOPIC_MATCH_LOOKUPS,
+		   (unsigned int) (AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES - topicMatchClient.clientData.topicTrieFreeCount),
+		   (double) linearMatches / TOPIC_MATCH_LOOKUPS);
+
+	return 0;
+}
+
+int aws_iot_benchmark_topic_match(void) {
+	static const uint32_t filterCounts[] = {10, 100, 1000};
+	size_t i;
+	int rc = 0;
+
+	for(i = 0; i < sizeof(filterCounts) / sizeof(filterCounts[0]) && 0 == rc; i++) {
+		if(filterCounts[i] > AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS) {
+			printf("  %4u filters : skipped, AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS is %u\n",
+				   (unsigned int) filterCounts[i], (unsigned int) AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS);
+			continue;
+		}
+		rc = topic_match_run(filterCounts[i]);
+	}
+
+	return rc;
+}
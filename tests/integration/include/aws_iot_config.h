@@ -28,9 +28,15 @@
 // =================================================
 
 // MQTT PubSub
-#define AWS_IOT_MQTT_TX_BUF_LEN 512				///< Any time a message is sent out through the MQTT layer. The message is copied into this buffer anytime a publish is done. This will also be used in the case of Thing Shadow
+#define AWS_IOT_MQTT_TX_BUF_LEN 512				///< Any time a message is sent out through the MQTT layer. The message is copied into this buffer anytime a publish is done, except for the payload when the network layer provides writev. This will also be used in the case of Thing Shadow
+#define AWS_IOT_MQTT_TX_BUF_MAX_LEN 16384 ///< With _ENABLE_DYNAMIC_BUFFERS_ the write buffer starts at AWS_IOT_MQTT_TX_BUF_LEN and grows for larger messages up to this size
 #define AWS_IOT_MQTT_RX_BUF_LEN 512				///< Any message that comes into the device should be less than this buffer size. If a received message is bigger than this buffer size the message will be dropped.
+#define AWS_IOT_MQTT_RX_BUF_MAX_LEN 16384 ///< With _ENABLE_DYNAMIC_BUFFERS_ the read buffer starts at AWS_IOT_MQTT_RX_BUF_LEN and grows for larger messages up to this size
 #define AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS 5	///< Maximum number of topic filters the MQTT client can handle at any given time. This should be increased appropriately when using Thing Shadow
+#define AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES 40 ///< Maximum number of topic levels used by the subscribed topic filters, each distinct level takes one node and one node is used as the root. Increase with the number or depth of subscriptions
+#define AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES 5 ///< Maximum number of QoS1 messages sent with aws_iot_mqtt_publish_async that can wait for a PUBACK at any given time
+#define AWS_IOT_MQTT_REACTOR_MAX_EVENTS 64 ///< With _ENABLE_EPOLL_REACTOR_, maximum number of ready sockets the event loop handles per wakeup
+#define AWS_IOT_MQTT_REACTOR_MAX_SCAN_INTERVAL_MS 1000 ///< With _ENABLE_EPOLL_REACTOR_, longest time the event loop goes without checking the timers of all clients
 
 // Thing Shadow specific configs
 #define SHADOW_MAX_SIZE_OF_RX_BUFFER AWS_IOT_MQTT_RX_BUF_LEN+1						///< Maximum size of the SHADOW buffer to store the received Shadow message
@@ -39,6 +45,7 @@
 #define MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE MAX_SIZE_CLIENT_ID_WITH_SEQUENCE + 20	///< This is size of the the total clientToken key and value pair in the JSON
 #define MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME 10										///< At Any given time we will wait for this many responses. This will correlate to the rate at which the shadow actions are requested
 #define MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME 10									///< We could perform shadow action on any thing Name and this is maximum Thing Names we can act on at any given time
+#define SHADOW_SUBSCRIBE_SETTLING_TIME_MS 2000 ///< Grace period after the SUBACK of the accepted and rejected topics of an action before the first request using them is published from yield. 2000 keeps the wait of earlier versions, 0 publishes right away
 #define MAX_JSON_TOKEN_EXPECTED 120													///< These are the max tokens that is expected to be in the Shadow JSON document. Include the metadata that gets published
 #define MAX_SHADOW_TOPIC_LENGTH_WITHOUT_THINGNAME 60								///< All shadow actions have to be published or subscribed to a topic which is of the format $aws/things/{thingName}/shadow/update/accepted. This refers to the size of the topic without the Thing Name
 #define MAX_SIZE_OF_THING_NAME 20													///< The Thing Name should not be bigger than this value. Modify this if the Thing Name needs to be bigger
@@ -34,8 +34,14 @@
 
 // MQTT PubSub
 #define AWS_IOT_MQTT_TX_BUF_LEN 512
+#define AWS_IOT_MQTT_TX_BUF_MAX_LEN 16384
 #define AWS_IOT_MQTT_RX_BUF_LEN 512
+#define AWS_IOT_MQTT_RX_BUF_MAX_LEN 16384
 #define AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS 5
+#define AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES 40
+#define AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES 5
+#define AWS_IOT_MQTT_REACTOR_MAX_EVENTS 64
+#define AWS_IOT_MQTT_REACTOR_MAX_SCAN_INTERVAL_MS 1000
 
 // Thing Shadow specific configs
 #define SHADOW_MAX_SIZE_OF_RX_BUFFER 512
@@ -45,6 +51,7 @@
 #define MAX_SIZE_OF_THINGNAME 30
 #define MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME 10
 #define MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME 10
+#define SHADOW_SUBSCRIBE_SETTLING_TIME_MS 0
 #define MAX_JSON_TOKEN_EXPECTED 120
 #define MAX_SHADOW_TOPIC_LENGTH_WITHOUT_THINGNAME 60
 #define MAX_SIZE_OF_THING_NAME 20
@@ -54,6 +54,8 @@ void setTLSRxBufferForConnack(IoT_Client_Connect_Params *params, unsigned char s
 
 void setTLSRxBufferForPuback(void);
 
+void setTLSRxBufferForPubacks(const uint16_t *pPacketIds, size_t count);
+
 void setTLSRxBufferForSuback(char *topicName, size_t topicNameLen, QoS qos, IoT_Publish_Message_Params params);
 
 void setTLSRxBufferForDoubleSuback(char *topicName, size_t topicNameLen, QoS qos, IoT_Publish_Message_Params params);
@@ -32,3 +32,6 @@ TEST_GROUP_C_WRAPPER(CommonTests, NullClientSetAutoreconnect)
 TEST_GROUP_C_WRAPPER(CommonTests, UnexpectedAckFiltering)
 TEST_GROUP_C_WRAPPER(CommonTests, BigMQTTRxMessageIgnore)
 TEST_GROUP_C_WRAPPER(CommonTests, BigMQTTRxMessageReadNextMessage)
+TEST_GROUP_C_WRAPPER(CommonTests, MultipleMessagesFromSingleNetworkRead)
+TEST_GROUP_C_WRAPPER(CommonTests, TimerWheelExpiresPassedDeadlines)
+TEST_GROUP_C_WRAPPER(CommonTests, TimerWheelRestartFromHandler)
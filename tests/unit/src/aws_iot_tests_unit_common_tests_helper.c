@@ -25,6 +25,7 @@
 #include "aws_iot_mqtt_client_interface.h"
 #include "aws_iot_log.h"
 #include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
 
 static IoT_Client_Init_Params initParams;
 static IoT_Client_Connect_Params connectParams;
@@ -37,6 +38,22 @@ char cPayload[100];
 
 char cbBuffer[AWS_IOT_MQTT_TX_BUF_LEN + 2];
 
+static uint32_t callbackCount;
+static uint32_t readCallsAtLastCallback;
+
+static void iot_tests_unit_common_counting_callback_handler(AWS_IoT_Client *pClient, char *topicName,
+															uint16_t topicNameLen, IoT_Publish_Message_Params *params,
+															void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(params);
+	IOT_UNUSED(pData);
+
+	callbackCount++;
+	readCallsAtLastCallback = RxReadCallCount;
+}
+
 static void iot_tests_unit_common_subscribe_callback_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen, IoT_Publish_Message_Params *params,
 				   void *pData) {
 	char *tmp = params->payload;
@@ -184,3 +201,110 @@ TEST_C(CommonTests, BigMQTTRxMessageReadNextMessage) {
 	CHECK_EQUAL_C_INT(rc, SUCCESS);
 	CHECK_EQUAL_C_STRING("XXX", cbBuffer);
 }
+
+/**
+ *
+ * Several small packets arriving together should be framed out of a single network read.
+ */
+TEST_C(CommonTests, MultipleMessagesFromSingleNetworkRead) {
+	size_t packetLen = 0;
+	uint32_t i = 0;
+	IoT_Error_t rc = FAILURE;
+
+	IOT_DEBUG("\n-->Running CommonTests - Frame multiple messages from one network read \n");
+
+	setTLSRxBufferForSuback("batchTest/topic1", 16, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "batchTest/topic1", 16, QOS0,
+								iot_tests_unit_common_counting_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferWithMsgOnSubscribedTopic("batchTest/topic1", 16, QOS0, testPubMsgParams, "batch");
+	packetLen = RxBuffer.len;
+	for(i = 1; i < 3; i++) {
+		memcpy(RxBuffer.pBuffer + (i * packetLen), RxBuffer.pBuffer, packetLen);
+	}
+	RxBuffer.len = 3 * packetLen;
+
+	callbackCount = 0;
+	RxReadCallCount = 0;
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(3, callbackCount);
+	CHECK_EQUAL_C_INT(1, readCallsAtLastCallback);
+}
+
+static uint32_t timerWheelHandlerCount;
+
+static void iot_tests_unit_common_timer_wheel_handler(IoT_Timer_Wheel_Entry *pEntry, void *pData) {
+	IOT_UNUSED(pEntry);
+	IOT_UNUSED(pData);
+	timerWheelHandlerCount++;
+}
+
+static void iot_tests_unit_common_timer_wheel_restart_handler(IoT_Timer_Wheel_Entry *pEntry, void *pData) {
+	timerWheelHandlerCount++;
+	aws_iot_timer_wheel_schedule((IoT_Timer_Wheel *) pData, pEntry, 60000);
+}
+
+/**
+ *
+ * Only deadlines that passed expire, the next timeout follows the earliest remaining deadline.
+ */
+TEST_C(CommonTests, TimerWheelExpiresPassedDeadlines) {
+	IoT_Timer_Wheel wheel;
+	IoT_Timer_Wheel_Entry entries[3];
+	uint32_t i;
+
+	IOT_DEBUG("\n-->Running CommonTests - Timer wheel expires passed deadlines \n");
+
+	aws_iot_timer_wheel_init(&wheel);
+	for(i = 0; i < 3; i++) {
+		aws_iot_timer_wheel_init_entry(&entries[i], iot_tests_unit_common_timer_wheel_handler, NULL);
+		CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_has_expired(&wheel, &entries[i]));
+	}
+	CHECK_C(UINT32_MAX == aws_iot_timer_wheel_get_next_timeout_ms(&wheel));
+
+	aws_iot_timer_wheel_schedule(&wheel, &entries[0], 0);
+	aws_iot_timer_wheel_schedule(&wheel, &entries[1], 60000);
+	aws_iot_timer_wheel_schedule(&wheel, &entries[2], 3600000);
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_get_next_timeout_ms(&wheel));
+
+	timerWheelHandlerCount = 0;
+	CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_run(&wheel));
+	CHECK_EQUAL_C_INT(1, timerWheelHandlerCount);
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_is_scheduled(&wheel, &entries[0]));
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_has_expired(&wheel, &entries[1]));
+	CHECK_C(0 < aws_iot_timer_wheel_get_next_timeout_ms(&wheel));
+	CHECK_C(60000 >= aws_iot_timer_wheel_get_next_timeout_ms(&wheel));
+	CHECK_C(3599000 < aws_iot_timer_wheel_left_ms(&wheel, &entries[2]));
+
+	aws_iot_timer_wheel_cancel(&wheel, &entries[1]);
+	aws_iot_timer_wheel_cancel(&wheel, &entries[2]);
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_run(&wheel));
+	CHECK_C(UINT32_MAX == aws_iot_timer_wheel_get_next_timeout_ms(&wheel));
+}
+
+/**
+ *
+ * A handler can restart the deadline that expired, entries are not scheduled after the wheel is initialized again.
+ */
+TEST_C(CommonTests, TimerWheelRestartFromHandler) {
+	IoT_Timer_Wheel wheel;
+	IoT_Timer_Wheel_Entry entry;
+
+	IOT_DEBUG("\n-->Running CommonTests - Timer wheel deadline restarted from its handler \n");
+
+	aws_iot_timer_wheel_init(&wheel);
+	aws_iot_timer_wheel_init_entry(&entry, iot_tests_unit_common_timer_wheel_restart_handler, &wheel);
+	aws_iot_timer_wheel_schedule(&wheel, &entry, 0);
+
+	timerWheelHandlerCount = 0;
+	CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_run(&wheel));
+	CHECK_EQUAL_C_INT(1, timerWheelHandlerCount);
+	CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_is_scheduled(&wheel, &entry));
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_run(&wheel));
+
+	aws_iot_timer_wheel_init(&wheel);
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_is_scheduled(&wheel, &entry));
+	CHECK_C(UINT32_MAX == aws_iot_timer_wheel_get_next_timeout_ms(&wheel));
+}
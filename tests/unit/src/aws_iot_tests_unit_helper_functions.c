@@ -162,6 +162,22 @@ void setTLSRxBufferForPuback(void) {
 	RxBuffer.NoMsgFlag = false;
 }
 
+void setTLSRxBufferForPubacks(const uint16_t *pPacketIds, size_t count) {
+	size_t i;
+
+	RxBuffer.NoMsgFlag = true;
+	RxBuffer.len = count * PUBACK_PACKET_SIZE;
+	RxIndex = 0;
+
+	for(i = 0; i < count; i++) {
+		RxBuffer.pBuffer[i * PUBACK_PACKET_SIZE] = (unsigned char) (0x40);
+		RxBuffer.pBuffer[i * PUBACK_PACKET_SIZE + 1] = (unsigned char) (0x02);
+		RxBuffer.pBuffer[i * PUBACK_PACKET_SIZE + 2] = (unsigned char) (pPacketIds[i] >> 8);
+		RxBuffer.pBuffer[i * PUBACK_PACKET_SIZE + 3] = (unsigned char) (pPacketIds[i] & 0xFF);
+	}
+	RxBuffer.NoMsgFlag = false;
+}
+
 void setTLSRxBufferForSubFail(void) {
 	RxBuffer.NoMsgFlag = false;
 	RxBuffer.pBuffer[0] = (unsigned char) (0x90);
@@ -250,6 +266,7 @@ void ResetTLSBuffer(void) {
 	}
 
 	RxIndex = 0;
+	RxWouldBlockIndex = 0;
 	RxBuffer.expiry_time.tv_sec = 0;
 	RxBuffer.expiry_time.tv_usec = 0;
 	TxBuffer.len = 0;
@@ -306,7 +323,7 @@ void setTLSRxBufferWithMsgOnSubscribedTopic(char *topicName, size_t topicNameLen
 		RxBuffer.pBuffer[payloadStartLoc + i] = (unsigned char) pMsg[i];
 	}
 
-	RxBuffer.len = VariableLen + PayloadLen + 2; // 2 for fixed header
+	RxBuffer.len = VarHeaderStartLoc + 1 + VariableLen + PayloadLen; // header byte plus the remaining length bytes
 	RxIndex = 0;
 	//printBuffer(RxBuffer.pBuffer, RxBuffer.len);
 }
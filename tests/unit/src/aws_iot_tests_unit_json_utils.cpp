@@ -88,3 +88,7 @@ TEST_GROUP_C_WRAPPER(JsonUtils, ParseUnsignedInteger8bitLargeInteger)
 TEST_GROUP_C_WRAPPER(JsonUtils, ParseUnsignedInteger8bitErrorOnNegativeInteger)
 TEST_GROUP_C_WRAPPER(JsonUtils, ParseUnsignedInteger8bitErrorOnBoolean)
 TEST_GROUP_C_WRAPPER(JsonUtils, ParseUnsignedInteger8bitErrorOnString)
+TEST_GROUP_C_WRAPPER(JsonUtils, ParseDoubleExponent)
+TEST_GROUP_C_WRAPPER(JsonUtils, ParseIntegerErrorOnFraction)
+TEST_GROUP_C_WRAPPER(JsonUtils, ParseInteger16bitErrorOnOverflow)
+TEST_GROUP_C_WRAPPER(JsonUtils, ParseUnsignedInteger8bitErrorOnOverflow)
@@ -808,3 +808,60 @@ TEST_C(JsonUtils, ParseUnsignedInteger8bitErrorOnString) {
 	CHECK_EQUAL_C_INT(3, r);
 	CHECK_EQUAL_C_INT(JSON_PARSE_ERROR, rc);
 }
+
+TEST_C(JsonUtils, ParseDoubleExponent) {
+	int r;
+	const char *json = "{\"x\":1.5e-3}";
+	double parsedValue;
+
+	IOT_DEBUG("\n-->Running Json Utils Tests - Parse double with an exponent \n");
+
+	r = jsmn_parse(&test_parser, json, strlen(json), t, sizeof(t) / sizeof(t[0]));
+	rc = parseDoubleValue(&parsedValue, json, t + 2);
+
+	CHECK_EQUAL_C_INT(3, r);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_REAL(1.5e-3, parsedValue, 0.0);
+}
+
+TEST_C(JsonUtils, ParseIntegerErrorOnFraction) {
+	int r;
+	const char *json = "{\"x\":7.5}";
+	int32_t parsedValue;
+
+	IOT_DEBUG("\n-->Running Json Utils Tests - Parse 32 bit integer with a fraction \n");
+
+	r = jsmn_parse(&test_parser, json, strlen(json), t, sizeof(t) / sizeof(t[0]));
+	rc = parseInteger32Value(&parsedValue, json, t + 2);
+
+	CHECK_EQUAL_C_INT(3, r);
+	CHECK_EQUAL_C_INT(JSON_PARSE_ERROR, rc);
+}
+
+TEST_C(JsonUtils, ParseInteger16bitErrorOnOverflow) {
+	int r;
+	const char *json = "{\"x\":32768}";
+	int16_t parsedValue;
+
+	IOT_DEBUG("\n-->Running Json Utils Tests - Parse 16 bit integer out of range \n");
+
+	r = jsmn_parse(&test_parser, json, strlen(json), t, sizeof(t) / sizeof(t[0]));
+	rc = parseInteger16Value(&parsedValue, json, t + 2);
+
+	CHECK_EQUAL_C_INT(3, r);
+	CHECK_EQUAL_C_INT(JSON_PARSE_ERROR, rc);
+}
+
+TEST_C(JsonUtils, ParseUnsignedInteger8bitErrorOnOverflow) {
+	int r;
+	const char *json = "{\"x\":256}";
+	uint8_t parsedValue;
+
+	IOT_DEBUG("\n-->Running Json Utils Tests - Parse 8 bit unsigned integer out of range \n");
+
+	r = jsmn_parse(&test_parser, json, strlen(json), t, sizeof(t) / sizeof(t[0]));
+	rc = parseUnsignedInteger8Value(&parsedValue, json, t + 2);
+
+	CHECK_EQUAL_C_INT(3, r);
+	CHECK_EQUAL_C_INT(JSON_PARSE_ERROR, rc);
+}
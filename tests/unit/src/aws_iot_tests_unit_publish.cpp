@@ -46,3 +46,22 @@ TEST_GROUP_C_WRAPPER(PublishTests, publishQoS1Success10msDelayedPuback)
 TEST_GROUP_C_WRAPPER(PublishTests, publishQoS0NoPubackSuccess)
 /* E:10 - Publish with QoS1 send success, Puback received */
 TEST_GROUP_C_WRAPPER(PublishTests, publishQoS1Success)
+/* E:11 - Async publish QoS1, Pubacks received out of order */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1OutOfOrderPubacks)
+/* E:12 - Async publish QoS1 with in-flight window full */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1WindowFull)
+/* E:13 - Async publish QoS1, Puback not received before command timeout */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1PubackTimeout)
+/* E:14 - Async publish QoS0 completes immediately */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS0Success)
+/* E:15 - Publish QoS0 larger than the write buffer, payload sent from the application buffer */
+TEST_GROUP_C_WRAPPER(PublishTests, publishQoS0LargerThanTxBuffer)
+/* E:16 - Publish QoS0 larger than the write buffer, network layer without vectored write */
+TEST_GROUP_C_WRAPPER(PublishTests, publishQoS0LargerThanTxBufferNoWritev)
+/* E:17 - Publish with a prepared header sends the same packets as publish on the topic */
+TEST_GROUP_C_WRAPPER(PublishTests, publishWithPreparedHeader)
+/* E:18 - Prepared publish patches its serialized header and sends the same packets as publish on the topic */
+TEST_GROUP_C_WRAPPER(PublishTests, publishPrepared)
+/* E:19 - Payload above the MQTT maximum remaining length is rejected before anything is sent */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAboveMaxRemainingLength)
+TEST_GROUP_C_WRAPPER(PublishTests, initAgainReleasesBuffers)
@@ -24,6 +24,7 @@
 
 #include "aws_iot_mqtt_client_interface.h"
 #include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
 #include "aws_iot_log.h"
 
 static IoT_Client_Init_Params initParams;
@@ -35,6 +36,21 @@ static uint16_t subTopicLen = 8;
 static AWS_IoT_Client iotClient;
 char cPayload[100];
 
+static uint16_t completedPacketIds[AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES + 1];
+static IoT_Error_t completedResults[AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES + 1];
+static uint32_t completedCount;
+
+static void iot_tests_unit_publish_complete_handler(AWS_IoT_Client *pClient, uint16_t packetId,
+													IoT_Error_t result, void *pClientData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pClientData);
+	if(completedCount < AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES + 1) {
+		completedPacketIds[completedCount] = packetId;
+		completedResults[completedCount] = result;
+	}
+	completedCount++;
+}
+
 TEST_GROUP_C_SETUP(PublishTests) {
 	IoT_Error_t rc = SUCCESS;
 	ResetTLSBuffer();
@@ -55,6 +71,7 @@ TEST_GROUP_C_SETUP(PublishTests) {
 	testPubMsgParams.payload = (void *) cPayload;
 	testPubMsgParams.payloadLen = strlen(cPayload);
 
+	completedCount = 0;
 	ResetTLSBuffer();
 }
 
@@ -203,3 +220,346 @@ TEST_C(PublishTests, publishQoS1Success) {
 
 	IOT_DEBUG("-->Success - E:10 - Publish with QoS1 send success, Puback received \n");
 }
+
+/* E:11 - Async publish QoS1, Pubacks received out of order */
+TEST_C(PublishTests, publishAsyncQoS1OutOfOrderPubacks) {
+	IoT_Error_t rc = SUCCESS;
+	uint16_t packetIds[3];
+	uint16_t pubackIds[3];
+	uint32_t i;
+
+	IOT_DEBUG("-->Running Publish Tests - E:11 - Async publish QoS1, Pubacks received out of order \n");
+
+	for(i = 0; i < 3; i++) {
+		rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+										iot_tests_unit_publish_complete_handler, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+		packetIds[i] = testPubMsgParams.id;
+	}
+	CHECK_EQUAL_C_INT(0, completedCount);
+	CHECK_EQUAL_C_INT(3, iotClient.clientData.inflightPublishCount);
+
+	pubackIds[0] = packetIds[2];
+	pubackIds[1] = packetIds[0];
+	pubackIds[2] = packetIds[1];
+	setTLSRxBufferForPubacks(pubackIds, 3);
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(3, completedCount);
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.inflightPublishCount);
+	for(i = 0; i < 3; i++) {
+		CHECK_EQUAL_C_INT(pubackIds[i], completedPacketIds[i]);
+		CHECK_EQUAL_C_INT(SUCCESS, completedResults[i]);
+	}
+
+	IOT_DEBUG("-->Success - E:11 - Async publish QoS1, Pubacks received out of order \n");
+}
+
+/* E:12 - Async publish QoS1 with in-flight window full */
+TEST_C(PublishTests, publishAsyncQoS1WindowFull) {
+	IoT_Error_t rc = SUCCESS;
+	uint32_t i;
+
+	IOT_DEBUG("-->Running Publish Tests - E:12 - Async publish QoS1 with in-flight window full \n");
+
+	for(i = 0; i < AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES; i++) {
+		rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+										iot_tests_unit_publish_complete_handler, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR, rc);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_NUM_INFLIGHT_PUBLISHES, iotClient.clientData.inflightPublishCount);
+
+	/* QoS0 messages don't take up the window */
+	testPubMsgParams.qos = QOS0;
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, completedCount);
+
+	IOT_DEBUG("-->Success - E:12 - Async publish QoS1 with in-flight window full \n");
+}
+
+/* E:13 - Async publish QoS1, Puback not received before command timeout */
+TEST_C(PublishTests, publishAsyncQoS1PubackTimeout) {
+	IoT_Error_t rc = SUCCESS;
+
+	IOT_DEBUG("-->Running Publish Tests - E:13 - Async publish QoS1, Puback not received before command timeout \n");
+
+	iotClient.clientData.commandTimeoutMs = 20;
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, completedCount);
+	CHECK_EQUAL_C_INT(testPubMsgParams.id, completedPacketIds[0]);
+	CHECK_EQUAL_C_INT(MQTT_REQUEST_TIMEOUT_ERROR, completedResults[0]);
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.inflightPublishCount);
+
+	IOT_DEBUG("-->Success - E:13 - Async publish QoS1, Puback not received before command timeout \n");
+}
+
+/* E:14 - Async publish QoS0 completes immediately */
+TEST_C(PublishTests, publishAsyncQoS0Success) {
+	IoT_Error_t rc = SUCCESS;
+
+	IOT_DEBUG("-->Running Publish Tests - E:14 - Async publish QoS0 completes immediately \n");
+
+	testPubMsgParams.qos = QOS0;
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, completedCount);
+	CHECK_EQUAL_C_INT(SUCCESS, completedResults[0]);
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.inflightPublishCount);
+
+	IOT_DEBUG("-->Success - E:14 - Async publish QoS0 completes immediately \n");
+}
+
+/* E:15 - Publish QoS0 larger than the write buffer, payload sent from the application buffer */
+TEST_C(PublishTests, publishQoS0LargerThanTxBuffer) {
+	IoT_Error_t rc = SUCCESS;
+	IoT_Buffer_Usage bufferUsage;
+	static char largePayload[AWS_IOT_MQTT_TX_BUF_LEN + 100];
+
+	IOT_DEBUG("-->Running Publish Tests - E:15 - Publish QoS0 larger than the write buffer \n");
+
+	memset(largePayload, 'x', sizeof(largePayload));
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.payload = (void *) largePayload;
+	testPubMsgParams.payloadLen = sizeof(largePayload);
+
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* fixed header with 2 remaining length bytes, topic and payload */
+	CHECK_EQUAL_C_INT(3 + 2 + subTopicLen + sizeof(largePayload), TxBuffer.len);
+	CHECK_EQUAL_C_INT(0, memcmp(largePayload, TxBuffer.pBuffer + TxBuffer.len - sizeof(largePayload),
+								sizeof(largePayload)));
+
+	/* only the header went through the write buffer */
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_get_buffer_usage(&iotClient, &bufferUsage));
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_get_buffer_usage(&iotClient, NULL));
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_TX_BUF_LEN, bufferUsage.writeBufSize);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_TX_BUF_LEN, bufferUsage.peakWriteBufSize);
+
+	IOT_DEBUG("-->Success - E:15 - Publish QoS0 larger than the write buffer \n");
+}
+
+/* E:16 - Publish QoS0 larger than the write buffer, network layer without vectored write */
+TEST_C(PublishTests, publishQoS0LargerThanTxBufferNoWritev) {
+	IoT_Error_t rc = SUCCESS;
+	IoT_Buffer_Usage bufferUsage;
+	static char largePayload[AWS_IOT_MQTT_TX_BUF_LEN + 100];
+
+	IOT_DEBUG("-->Running Publish Tests - E:16 - Publish QoS0 larger than the write buffer without vectored write \n");
+
+	memset(largePayload, 'x', sizeof(largePayload));
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.payload = (void *) largePayload;
+	testPubMsgParams.payloadLen = sizeof(largePayload);
+
+	iotClient.networkStack.writev = NULL;
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_get_buffer_usage(&iotClient, &bufferUsage));
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_TX_BUF_LEN, bufferUsage.writeBufSize);
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* the write buffer grows for the packet and returns to its initial size */
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_C(sizeof(largePayload) < bufferUsage.peakWriteBufSize);
+	CHECK_C(sizeof(largePayload) < TxBuffer.len);
+#else
+	CHECK_EQUAL_C_INT(MQTT_TX_BUFFER_TOO_SHORT_ERROR, rc);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_TX_BUF_LEN, bufferUsage.peakWriteBufSize);
+#endif
+
+	IOT_DEBUG("-->Success - E:16 - Publish QoS0 larger than the write buffer without vectored write \n");
+}
+
+/* E:17 - Publish with a prepared header sends the same packets as publish on the topic */
+TEST_C(PublishTests, publishWithPreparedHeader) {
+	IoT_Error_t rc = SUCCESS;
+	IoT_Publish_Header header;
+	unsigned char expected[64];
+	size_t expectedLen;
+	uint16_t packetId;
+
+	IOT_DEBUG("-->Running Publish Tests - E:17 - Publish with a prepared header \n");
+
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_init_publish_header(&header, NULL, subTopicLen, QOS0, 0));
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_publish_with_header(&iotClient, NULL, "x", 1));
+
+	/* QoS0 retained, byte for byte the packet of aws_iot_mqtt_publish */
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.isRetained = 1;
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	expectedLen = TxBuffer.len;
+	memcpy(expected, TxBuffer.pBuffer, expectedLen);
+	CHECK_EQUAL_C_INT(0x31, expected[0]);
+
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_init_publish_header(&header, subTopic, subTopicLen, QOS0, 1));
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload, testPubMsgParams.payloadLen);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(expectedLen, TxBuffer.len);
+	CHECK_EQUAL_C_INT(0, memcmp(expected, TxBuffer.pBuffer, expectedLen));
+
+	/* QoS1, the header is reused with a new packet id for every message */
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_init_publish_header(&header, subTopic, subTopicLen, QOS1, 0));
+	setTLSRxBufferForPuback();
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload, testPubMsgParams.payloadLen);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0x32, TxBuffer.pBuffer[0]);
+	CHECK_EQUAL_C_INT(expectedLen + 2, TxBuffer.len);
+	packetId = (uint16_t) ((TxBuffer.pBuffer[4 + subTopicLen] << 8) | TxBuffer.pBuffer[5 + subTopicLen]);
+
+	setTLSRxBufferForPuback();
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload, testPubMsgParams.payloadLen);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(expectedLen + 2, TxBuffer.len);
+	CHECK_EQUAL_C_INT(packetId + 1,
+					  (uint16_t) ((TxBuffer.pBuffer[4 + subTopicLen] << 8) | TxBuffer.pBuffer[5 + subTopicLen]));
+	CHECK_EQUAL_C_INT(0, memcmp(expected + 4 + subTopicLen, TxBuffer.pBuffer + 6 + subTopicLen,
+								expectedLen - 4 - subTopicLen));
+
+	IOT_DEBUG("-->Success - E:17 - Publish with a prepared header \n");
+}
+
+/* E:18 - Prepared publish patches its serialized header and sends the same packets as publish on the topic */
+TEST_C(PublishTests, publishPrepared) {
+	IoT_Error_t rc = SUCCESS;
+	IoT_Publish_Header header;
+	unsigned char prepared[AWS_IOT_MQTT_PREPARED_PUBLISH_LEN(8)];
+	unsigned char expected[64];
+	static char largePayload[200];
+	size_t expectedLen;
+	uint16_t packetId;
+
+	IOT_DEBUG("-->Running Publish Tests - E:18 - Prepared publish \n");
+
+	CHECK_EQUAL_C_INT(MQTT_TX_BUFFER_TOO_SHORT_ERROR,
+					  aws_iot_mqtt_prepare_publish(&header, prepared, sizeof(prepared) - 1, subTopic, subTopicLen,
+												   &testPubMsgParams));
+
+	/* QoS0, byte for byte the packet of aws_iot_mqtt_publish, sent from the prepared buffer */
+	testPubMsgParams.qos = QOS0;
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	expectedLen = TxBuffer.len;
+	memcpy(expected, TxBuffer.pBuffer, expectedLen);
+
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_prepare_publish(&header, prepared, sizeof(prepared), subTopic, subTopicLen,
+															&testPubMsgParams));
+	memset(iotClient.clientData.writeBuf, 0, iotClient.clientData.writeBufSize);
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload, testPubMsgParams.payloadLen);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(expectedLen, TxBuffer.len);
+	CHECK_EQUAL_C_INT(0, memcmp(expected, TxBuffer.pBuffer, expectedLen));
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.writeBuf[0]);
+
+	/* a payload needing two remaining length bytes moves the fixed header in front of them */
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, largePayload, sizeof(largePayload));
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(3 + 2 + subTopicLen + sizeof(largePayload), TxBuffer.len);
+	CHECK_EQUAL_C_INT(0x30, TxBuffer.pBuffer[0]);
+	CHECK_EQUAL_C_INT(0x80 | ((2 + subTopicLen + sizeof(largePayload)) & 0x7F), TxBuffer.pBuffer[1]);
+	CHECK_EQUAL_C_INT((2 + subTopicLen + sizeof(largePayload)) >> 7, TxBuffer.pBuffer[2]);
+	CHECK_EQUAL_C_INT(0, memcmp(expected + 2, TxBuffer.pBuffer + 3, 2 + subTopicLen));
+
+	/* QoS1, the packet id is patched for every message */
+	testPubMsgParams.qos = QOS1;
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_prepare_publish(&header, prepared, sizeof(prepared), subTopic, subTopicLen,
+															&testPubMsgParams));
+	setTLSRxBufferForPuback();
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload, testPubMsgParams.payloadLen);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0x32, TxBuffer.pBuffer[0]);
+	CHECK_EQUAL_C_INT(expectedLen + 2, TxBuffer.len);
+	packetId = (uint16_t) ((TxBuffer.pBuffer[4 + subTopicLen] << 8) | TxBuffer.pBuffer[5 + subTopicLen]);
+
+	setTLSRxBufferForPuback();
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload, testPubMsgParams.payloadLen);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(packetId + 1,
+					  (uint16_t) ((TxBuffer.pBuffer[4 + subTopicLen] << 8) | TxBuffer.pBuffer[5 + subTopicLen]));
+	CHECK_EQUAL_C_INT(0, memcmp(expected + 4 + subTopicLen, TxBuffer.pBuffer + 6 + subTopicLen,
+								expectedLen - 4 - subTopicLen));
+
+	/* without a vectored write the packet is serialized into the write buffer as usual */
+	iotClient.networkStack.writev = NULL;
+	setTLSRxBufferForPuback();
+	rc = aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload, testPubMsgParams.payloadLen);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(expectedLen + 2, TxBuffer.len);
+	CHECK_EQUAL_C_INT(0x32, iotClient.clientData.writeBuf[0]);
+
+	IOT_DEBUG("-->Success - E:18 - Prepared publish \n");
+}
+
+/* E:19 - Payload above the MQTT maximum remaining length is rejected before anything is sent */
+TEST_C(PublishTests, publishAboveMaxRemainingLength) {
+	IoT_Publish_Header header;
+	unsigned char prepared[AWS_IOT_MQTT_PREPARED_PUBLISH_LEN(8)];
+	size_t maxPayloadLen;
+	uint8_t pass;
+
+	IOT_DEBUG("-->Running Publish Tests - E:19 - Payload above the MQTT maximum remaining length \n");
+
+	testPubMsgParams.qos = QOS0;
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_prepare_publish(&header, prepared, sizeof(prepared), subTopic, subTopicLen,
+															&testPubMsgParams));
+	/* the payload is never read, its length alone is too long */
+	maxPayloadLen = 268435455u - header.variableHeaderLen;
+
+	/* once with the vectored write and prepared header, once through the copy into the write buffer */
+	for(pass = 0; pass < 2; pass++) {
+		if(1 == pass) {
+			iotClient.networkStack.writev = NULL;
+		}
+		ResetTLSBuffer();
+
+		testPubMsgParams.payloadLen = maxPayloadLen + 1;
+		CHECK_EQUAL_C_INT(MQTT_TX_BUFFER_TOO_SHORT_ERROR,
+						  aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams));
+		CHECK_EQUAL_C_INT(MQTT_TX_BUFFER_TOO_SHORT_ERROR,
+						  aws_iot_mqtt_publish_with_header(&iotClient, &header, testPubMsgParams.payload,
+														   maxPayloadLen + 1));
+		CHECK_EQUAL_C_INT(MQTT_TX_BUFFER_TOO_SHORT_ERROR,
+						  aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams, NULL, NULL));
+		CHECK_EQUAL_C_INT(0, TxBuffer.len);
+	}
+
+	IOT_DEBUG("-->Success - E:19 - Payload above the MQTT maximum remaining length \n");
+}
+
+/* E:20 - Initializing the client again releases the buffers of the earlier initialization */
+TEST_C(PublishTests, initAgainReleasesBuffers) {
+	IoT_Error_t rc = SUCCESS;
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	IoT_Buffer_Pool_Usage poolUsageBefore;
+	IoT_Buffer_Pool_Usage poolUsageAfter;
+#endif
+
+	IOT_DEBUG("-->Running Publish Tests - E:20 - Init again releases the buffers of the earlier init \n");
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	aws_iot_mqtt_get_buffer_pool_usage(&poolUsageBefore);
+#endif
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	aws_iot_mqtt_get_buffer_pool_usage(&poolUsageAfter);
+	CHECK_EQUAL_C_INT(poolUsageBefore.bytesInUse, poolUsageAfter.bytesInUse);
+#endif
+
+	IOT_DEBUG("-->Success - E:20 - Init again releases the buffers of the earlier init \n");
+}
@@ -46,3 +46,13 @@ TEST_GROUP_C_WRAPPER(ShadowActionTests, ACKWaitingMoreThanAllowed)
 TEST_GROUP_C_WRAPPER(ShadowActionTests, InboundDataTooBigForBuffer)
 TEST_GROUP_C_WRAPPER(ShadowActionTests, NoClientTokenForShadowAction)
 TEST_GROUP_C_WRAPPER(ShadowActionTests, NoCallbackForShadowAction)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, AcksSubscribedOnConnect)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, TwoShadowClientsKeepSeparateState)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, ReportSendsOnlyChangedFields)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, UpdateQueueMergesFieldsAndLimitsRate)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, UpdateQueueBurstRefillsAfterIdle)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, ShadowClientsNumberTheirOwnClientTokens)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, AcksMatchedByClientTokenInAnyOrder)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, GetManyThingsOverWildcardTopics)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, VersionOnlyTakenFromOwnThingName)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, AckLargerThanRxBuffer)
@@ -111,7 +111,7 @@ static void actionCallback(const char *pThingName, ShadowActions_t action, Shado
 	actionRx = action;
 	ackStatusRx = status;
 	if(SHADOW_ACK_TIMEOUT != status) {
-		strcpy(jsonFullDocument, pReceivedJsonDocument);
+		snprintf(jsonFullDocument, sizeof(jsonFullDocument), "%s", pReceivedJsonDocument);
 	}
 }
 
@@ -124,8 +124,8 @@ TEST_C(ShadowActionTests, GetTheFullJSONDocument) {
 	IOT_DEBUG("-->Running Shadow Action Tests - Get full json document \n");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	ResetTLSBuffer();
@@ -152,8 +152,8 @@ TEST_C(ShadowActionTests, DeleteTheJSONDocument) {
 	IOT_DEBUG("-->Running Shadow Action Tests - Delete json document \n");
 
 	aws_iot_shadow_internal_delete_request_json(deleteRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_DELETE, deleteRequestJson, actionCallback,
-											 NULL, 4, false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_DELETE, deleteRequestJson,
+											 actionCallback, NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	params.payloadLen = strlen(TEST_JSON_RESPONSE_DELETE_DOCUMENT);
@@ -215,8 +215,8 @@ TEST_C(ShadowActionTests, UpdateTheJSONDocument) {
 			AWS_IOT_MQTT_CLIENT_ID);
 	CHECK_EQUAL_C_STRING(expectedUpdateRequestJson, updateRequestJson);
 
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_UPDATE, updateRequestJson, actionCallback,
-											 NULL, 4, false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_UPDATE, updateRequestJson,
+											 actionCallback, NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	ResetTLSBuffer();
@@ -244,8 +244,8 @@ TEST_C(ShadowActionTests, GetTheFullJSONDocumentTimeout) {
 	IOT_DEBUG("-->Running Shadow Action Tests - Get full json document timeout \n");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	sleep(4 + 1);
@@ -282,8 +282,8 @@ TEST_C(ShadowActionTests, SubscribeToAcceptedRejectedOnGet) {
 	snprintf(SecondLastSubscribeMessage, secondLastSubscribeMsgLen, "No Message");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	CHECK_EQUAL_C_STRING(GET_REJECTED_TOPIC, LastSubscribeMessage);
@@ -314,8 +314,8 @@ TEST_C(ShadowActionTests, UnSubscribeToAcceptedRejectedOnGetResponse) {
 	snprintf(SecondLastSubscribeMessage, secondLastSubscribeMsgLen, "No Message");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	params.payloadLen = strlen(TEST_JSON_RESPONSE_FULL_DOCUMENT);
@@ -347,8 +347,8 @@ TEST_C(ShadowActionTests, UnSubscribeToAcceptedRejectedOnGetTimeout) {
 	snprintf(SecondLastSubscribeMessage, secondLastSubscribeMsgLen, "No Message");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	sleep(4 + 1);
@@ -384,8 +384,8 @@ TEST_C(ShadowActionTests, UnSubscribeToAcceptedRejectedOnGetTimeoutWithSticky) {
 	snprintf(SecondLastSubscribeMessage, secondLastSubscribeMsgLen, "No Message");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 true);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, true);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	sleep(4 + 1);
@@ -420,8 +420,8 @@ TEST_C(ShadowActionTests, GetVersionFromAckStatus) {
 	snprintf(jsonFullDocument, 200, "timeout");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 true);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, true);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	ResetTLSBuffer();
@@ -461,8 +461,8 @@ TEST_C(ShadowActionTests, WrongTokenInGetResponse) {
 	snprintf(jsonFullDocument, 200, "timeout");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	sleep(4 + 1);
@@ -494,8 +494,8 @@ TEST_C(ShadowActionTests, NoTokenInGetResponse) {
 	snprintf(jsonFullDocument, 200, "timeout");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	sleep(4 + 1);
@@ -525,8 +525,8 @@ TEST_C(ShadowActionTests, InvalidInboundJSONInGetResponse) {
 	snprintf(jsonFullDocument, 200, "NOT_VISITED");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	params.payloadLen = strlen("{\"state\":{{");
@@ -553,8 +553,8 @@ TEST_C(ShadowActionTests, AcceptedSubFailsGetRequest) {
 
 	ResetTLSBuffer();
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(MQTT_REQUEST_TIMEOUT_ERROR, ret_val); // Should never subscribe and publish
 
 	ResetTLSBuffer();
@@ -587,8 +587,8 @@ TEST_C(ShadowActionTests, RejectedSubFailsGetRequest) {
 	ResetTLSBuffer();
 	setTLSRxBufferForSuback(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params);
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(MQTT_REQUEST_TIMEOUT_ERROR, ret_val); // Should never subscribe and publish
 
 	ResetTLSBuffer();
@@ -614,8 +614,8 @@ TEST_C(ShadowActionTests, PublishFailsGetRequest) {
 	ResetTLSBuffer();
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(MQTT_REQUEST_TIMEOUT_ERROR, ret_val); // Should never subscribe and publish
 
 	ResetTLSBuffer();
@@ -645,8 +645,8 @@ TEST_C(ShadowActionTests, StickyNonStickyNeverConflict) {
 	snprintf(SecondLastSubscribeMessage, secondLastSubscribeMsgLen, "No Message");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 true);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, true);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	params.payloadLen = strlen(TEST_JSON_RESPONSE_FULL_DOCUMENT);
@@ -668,8 +668,8 @@ TEST_C(ShadowActionTests, StickyNonStickyNeverConflict) {
 
 	// Non-sticky shadow get, same thing name. Should never unsub since they are sticky
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	ResetTLSBuffer();
@@ -701,59 +701,59 @@ TEST_C(ShadowActionTests, ACKWaitingMoreThanAllowed) {
 
 	// 1st
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 2nd
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 3rd
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 4th
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 5th
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 6th
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 7th
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 8th
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 9th
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 10th
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 	// 11th
 	// Should return some error code, since we are running out of ACK space
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL,
-											 100, false); // 100 sec to timeout
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 100, false); // 100 sec to timeout);
 	CHECK_EQUAL_C_INT(FAILURE, ret_val);
 
 	IOT_DEBUG("-->Success - Ack waiting more than allowed wait time \n");
@@ -771,8 +771,8 @@ TEST_C(ShadowActionTests, InboundDataTooBigForBuffer) {
 	snprintf(jsonFullDocument, 200, "NOT_VISITED");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	params.payloadLen = strlen(JSON_SIZE_OVERFLOW);
@@ -781,8 +781,15 @@ TEST_C(ShadowActionTests, InboundDataTooBigForBuffer) {
 	setTLSRxBufferWithMsgOnSubscribedTopic(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params,
 										   params.payload);
 	ret_val = aws_iot_shadow_yield(&client, 200);
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* the read buffer grows to fit it, so the ack reaches the callback */
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(SHADOW_ACK_ACCEPTED, ackStatusRx);
+	CHECK_EQUAL_C_INT(0, strncmp(JSON_SIZE_OVERFLOW, jsonFullDocument, sizeof(jsonFullDocument) - 1));
+#else
 	CHECK_EQUAL_C_INT(MQTT_RX_BUFFER_TOO_SHORT_ERROR, ret_val);
 	CHECK_EQUAL_C_STRING("NOT_VISITED", jsonFullDocument);
+#endif
 
 	IOT_DEBUG("-->Success - Inbound data too big for buffer \n");
 }
@@ -803,8 +810,8 @@ TEST_C(ShadowActionTests, NoClientTokenForShadowAction) {
 	snprintf(getRequestJson, 120, "{}");
 	snprintf(jsonFullDocument, 200, "NOT_VISITED");
 
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback, NULL, 4,
-											 false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	params.payloadLen = strlen(TEST_JSON_RESPONSE_NO_TOKEN);
@@ -844,7 +851,7 @@ TEST_C(ShadowActionTests, NoCallbackForShadowAction) {
 	snprintf(jsonFullDocument, 200, "NOT_VISITED");
 
 	aws_iot_shadow_internal_get_request_json(getRequestJson);
-	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, NULL, NULL, 4, false);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, NULL, NULL, 4, false);
 	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
 
 	params.payloadLen = strlen(TEST_JSON_RESPONSE_FULL_DOCUMENT);
@@ -868,3 +875,650 @@ TEST_C(ShadowActionTests, NoCallbackForShadowAction) {
 
 	IOT_DEBUG("-->Success - No callback for shadow action");
 }
+
+TEST_C(ShadowActionTests, AcksSubscribedOnConnect) {
+	IoT_Error_t ret_val = SUCCESS;
+	char getRequestJson[120];
+	const unsigned char suback[] = {0x90, 0x03, 0x00, 0x02, QOS0};
+	size_t connackLen;
+	uint32_t i;
+
+	uint8_t firstByte, secondByte;
+	uint16_t topicNameLen;
+	char topicName[128] = "test";
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Subscribe to accepted and rejected topics while connecting \n");
+
+	ret_val = aws_iot_shadow_disconnect(&client);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	/* CONNACK followed by the SUBACKs for get and update */
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	connackLen = RxBuffer.len;
+	for(i = 0; i < 4; i++) {
+		memcpy(RxBuffer.pBuffer + connackLen + (i * sizeof(suback)), suback, sizeof(suback));
+	}
+	RxBuffer.len = connackLen + (4 * sizeof(suback));
+
+	shadowConnectParams.isAckSubscribeOnConnect = true;
+	ret_val = aws_iot_shadow_connect(&client, &shadowConnectParams);
+	shadowConnectParams.isAckSubscribeOnConnect = false;
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_STRING(UPDATE_REJECTED_TOPIC, LastSubscribeMessage);
+
+	lastSubscribeMsgLen = 11;
+	snprintf(LastSubscribeMessage, lastSubscribeMsgLen, "No Message");
+
+	aws_iot_shadow_internal_get_request_json(getRequestJson);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, false);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// The first action uses the subscriptions made while connecting
+	CHECK_EQUAL_C_STRING("No Message", LastSubscribeMessage);
+
+	firstByte = (uint8_t)(TxBuffer.pBuffer[2]);
+	secondByte = (uint8_t)(TxBuffer.pBuffer[3]);
+	topicNameLen = (uint16_t) (secondByte + (256 * firstByte));
+
+	snprintf(topicName, topicNameLen + 1u, "%s", &(TxBuffer.pBuffer[4])); // Added one for null character
+
+	CHECK_EQUAL_C_STRING(GET_PUB_TOPIC, topicName);
+
+	IOT_DEBUG("-->Success - Subscribe to accepted and rejected topics while connecting \n");
+}
+
+TEST_C(ShadowActionTests, TwoShadowClientsKeepSeparateState) {
+	IoT_Error_t ret_val = SUCCESS;
+	char getRequestJson[120];
+	char topic[120];
+	static AWS_IoT_Client secondClient;
+	static ShadowClient secondShadowClient;
+	ShadowInitParameters_t secondInitParams = shadowInitParams;
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Two shadow clients keep separate state \n");
+
+	aws_iot_shadow_internal_get_request_json(getRequestJson);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, actionCallback,
+											 NULL, 4, true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	secondInitParams.pShadowClient = &secondShadowClient;
+	ret_val = aws_iot_shadow_init(&secondClient, &secondInitParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	ret_val = aws_iot_shadow_connect(&secondClient, &shadowConnectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// The second client has no subscriptions yet, even though the first one holds the same topics
+	lastSubscribeMsgLen = 11;
+	snprintf(LastSubscribeMessage, lastSubscribeMsgLen, "No Message");
+	topicNameFromThingAndAction(topic, AWS_IOT_MY_THING_NAME, SHADOW_GET);
+	setTLSRxBufferForDoubleSuback(topic, strlen(topic), QOS1, testPubMsgParams);
+	aws_iot_shadow_internal_get_request_json(getRequestJson);
+	ret_val = aws_iot_shadow_internal_action(&secondClient, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson,
+											 actionCallback, NULL, 4, true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_STRING(GET_REJECTED_TOPIC, LastSubscribeMessage);
+
+	// The response to the first request only updates the first client
+	ResetTLSBuffer();
+	params.payload = TEST_JSON_RESPONSE_FULL_DOCUMENT_WITH_VERSION(7);
+	params.payloadLen = strlen(params.payload);
+	params.qos = QOS0;
+	setTLSRxBufferWithMsgOnSubscribedTopic(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params,
+										   params.payload);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(SHADOW_ACK_ACCEPTED, ackStatusRx);
+
+	CHECK_C(7u == aws_iot_shadow_get_last_received_version());
+	CHECK_C(7u == aws_iot_shadow_get_client_last_received_version(&client));
+	CHECK_C(0u == aws_iot_shadow_get_client_last_received_version(&secondClient));
+
+	ret_val = aws_iot_shadow_disconnect(&secondClient);
+	IOT_UNUSED(ret_val);
+
+	IOT_DEBUG("-->Success - Two shadow clients keep separate state \n");
+}
+
+#define TEST_JSON_REPORT_ACCEPTED "{\"state\":{\"reported\":{\"temp\":20,\"on\":true}},\"version\":3," \
+	"\"clientToken\":\"" AWS_IOT_MQTT_CLIENT_ID "-0\"}"
+
+TEST_C(ShadowActionTests, ReportSendsOnlyChangedFields) {
+	IoT_Error_t ret_val = SUCCESS;
+	char reportJson[SIZE_OF_UPDATE_DOCUMENT];
+	char expectedReportJson[SIZE_OF_UPDATE_DOCUMENT];
+	int32_t temp = 20;
+	bool on = true;
+	jsonStruct_t tempHandler;
+	jsonStruct_t onHandler;
+	ShadowReportedField_t fields[2];
+	static ShadowReportCache_t cache;
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Report sends only changed fields \n");
+
+	tempHandler.cb = NULL;
+	tempHandler.pData = &temp;
+	tempHandler.pKey = "temp";
+	tempHandler.type = SHADOW_JSON_INT32;
+
+	onHandler.cb = NULL;
+	onHandler.pData = &on;
+	onHandler.pKey = "on";
+	onHandler.type = SHADOW_JSON_BOOL;
+
+	fields[0].pStruct = &tempHandler;
+	fields[0].deadband = 2.0;
+	fields[1].pStruct = &onHandler;
+	fields[1].deadband = 0.0;
+
+	ret_val = aws_iot_shadow_report_cache_init(&client, &cache, AWS_IOT_MY_THING_NAME, fields, 2);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// Nothing has been acknowledged yet, so every field is sent
+	ret_val = aws_iot_shadow_report(&client, &cache, reportJson, SIZE_OF_UPDATE_DOCUMENT, actionCallback, NULL, 4,
+									true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	snprintf(expectedReportJson, SIZE_OF_UPDATE_DOCUMENT,
+			 "{\"state\":{\"reported\":{\"temp\":20,\"on\":true}},\"clientToken\":\"%s-0\"}", AWS_IOT_MQTT_CLIENT_ID);
+	CHECK_EQUAL_C_STRING(expectedReportJson, reportJson);
+
+	ResetTLSBuffer();
+	params.payload = TEST_JSON_REPORT_ACCEPTED;
+	params.payloadLen = strlen(params.payload);
+	params.qos = QOS0;
+	setTLSRxBufferWithMsgOnSubscribedTopic(UPDATE_ACCEPTED_TOPIC, strlen(UPDATE_ACCEPTED_TOPIC), QOS0, params,
+										   params.payload);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(SHADOW_ACK_ACCEPTED, ackStatusRx);
+
+	// Once acknowledged, changes inside the deadband are not reported
+	ret_val = aws_iot_shadow_report(&client, &cache, reportJson, SIZE_OF_UPDATE_DOCUMENT, actionCallback, NULL, 4,
+									true);
+	CHECK_EQUAL_C_INT(SHADOW_NOTHING_TO_REPORT, ret_val);
+	temp = 21;
+	ret_val = aws_iot_shadow_report(&client, &cache, reportJson, SIZE_OF_UPDATE_DOCUMENT, actionCallback, NULL, 4,
+									true);
+	CHECK_EQUAL_C_INT(SHADOW_NOTHING_TO_REPORT, ret_val);
+
+	temp = 23;
+	ret_val = aws_iot_shadow_report(&client, &cache, reportJson, SIZE_OF_UPDATE_DOCUMENT, actionCallback, NULL, 4,
+									true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	snprintf(expectedReportJson, SIZE_OF_UPDATE_DOCUMENT,
+			 "{\"state\":{\"reported\":{\"temp\":23}},\"clientToken\":\"%s-1\"}", AWS_IOT_MQTT_CLIENT_ID);
+	CHECK_EQUAL_C_STRING(expectedReportJson, reportJson);
+
+	IOT_DEBUG("-->Success - Report sends only changed fields \n");
+}
+
+/* Topic and payload of the QoS0 publish written last */
+static void lastPublishSent(char *pTopic, size_t topicSize, char *pPayload, size_t payloadSize) {
+	size_t remainingLen = 0;
+	size_t multiplier = 1;
+	size_t pos = 1;
+	uint16_t topicNameLen;
+
+	do {
+		remainingLen += (TxBuffer.pBuffer[pos] & 127u) * multiplier;
+		multiplier *= 128;
+	} while(TxBuffer.pBuffer[pos++] & 128u);
+
+	topicNameLen = (uint16_t) (TxBuffer.pBuffer[pos + 1] + (256 * TxBuffer.pBuffer[pos]));
+	pos += 2;
+	snprintf(pTopic, topicSize, "%.*s", (int) topicNameLen, (const char *) &(TxBuffer.pBuffer[pos]));
+	snprintf(pPayload, payloadSize, "%.*s", (int) (remainingLen - 2 - topicNameLen),
+			 (const char *) &(TxBuffer.pBuffer[pos + topicNameLen]));
+}
+
+TEST_C(ShadowActionTests, UpdateQueueMergesFieldsAndLimitsRate) {
+	IoT_Error_t ret_val = SUCCESS;
+	char topicName[128];
+	char payload[SIZE_OF_UPDATE_DOCUMENT];
+	char expectedPayload[SIZE_OF_UPDATE_DOCUMENT];
+	int32_t temp = 20;
+	uint8_t humidity = 40;
+	bool on = true;
+	jsonStruct_t tempHandler;
+	jsonStruct_t humidityHandler;
+	jsonStruct_t onHandler;
+	static ShadowQueuedField_t fields[3];
+	static ShadowUpdateQueue_t queue;
+	ShadowUpdateQueueParameters_t queueParams = ShadowUpdateQueueParametersDefault;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Update queue merges fields and limits rate \n");
+
+	tempHandler.cb = NULL;
+	tempHandler.pData = &temp;
+	tempHandler.pKey = "temp";
+	tempHandler.type = SHADOW_JSON_INT32;
+
+	humidityHandler.cb = NULL;
+	humidityHandler.pData = &humidity;
+	humidityHandler.pKey = "humidity";
+	humidityHandler.type = SHADOW_JSON_UINT8;
+
+	onHandler.cb = NULL;
+	onHandler.pData = &on;
+	onHandler.pKey = "on";
+	onHandler.type = SHADOW_JSON_BOOL;
+
+	queueParams.flushInterval_ms = 60000;
+	queueParams.refillInterval_ms = 200;
+	queueParams.burstSize = 1;
+	queueParams.callback = actionCallback;
+	ret_val = aws_iot_shadow_update_queue_init(&client, &queue, AWS_IOT_MY_THING_NAME, fields, 3, &queueParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	ret_val = aws_iot_shadow_update_queue_flush(&client, &queue);
+	CHECK_EQUAL_C_INT(SHADOW_NOTHING_TO_REPORT, ret_val);
+
+	// The same field queued twice is sent once, with its latest value
+	ret_val = aws_iot_shadow_queue_reported(&client, &queue, &tempHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	temp = 21;
+	ret_val = aws_iot_shadow_queue_reported(&client, &queue, &tempHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_queue_desired(&client, &queue, &onHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	ret_val = aws_iot_shadow_update_queue_flush(&client, &queue);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	lastPublishSent(topicName, sizeof(topicName), payload, sizeof(payload));
+	CHECK_EQUAL_C_STRING(UPDATE_PUB_TOPIC, topicName);
+	snprintf(expectedPayload, SIZE_OF_UPDATE_DOCUMENT,
+			 "{\"state\":{\"reported\":{\"temp\":21},\"desired\":{\"on\":true}},\"clientToken\":\"%s-0\"}",
+			 AWS_IOT_MQTT_CLIENT_ID);
+	CHECK_EQUAL_C_STRING(expectedPayload, payload);
+
+	// The only token was used, a full queue waits for the next one
+	temp = 22;
+	on = false;
+	ret_val = aws_iot_shadow_queue_reported(&client, &queue, &tempHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_update_queue_flush(&client, &queue);
+	CHECK_EQUAL_C_INT(SHADOW_UPDATE_RATE_LIMITED, ret_val);
+	ret_val = aws_iot_shadow_queue_reported(&client, &queue, &humidityHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_queue_desired(&client, &queue, &onHandler);
+	CHECK_EQUAL_C_INT(SHADOW_UPDATE_RATE_LIMITED, ret_val);
+	ret_val = aws_iot_shadow_queue_desired(&client, &queue, &tempHandler);
+	CHECK_EQUAL_C_INT(SHADOW_UPDATE_QUEUE_FULL_ERROR, ret_val);
+
+	usleep(300000);
+	ResetTLSBuffer();
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	lastPublishSent(topicName, sizeof(topicName), payload, sizeof(payload));
+	CHECK_EQUAL_C_STRING(UPDATE_PUB_TOPIC, topicName);
+	snprintf(expectedPayload, SIZE_OF_UPDATE_DOCUMENT,
+			 "{\"state\":{\"reported\":{\"temp\":22,\"humidity\":40},\"desired\":{\"on\":false}},\"clientToken\":\"%s-1\"}",
+			 AWS_IOT_MQTT_CLIENT_ID);
+	CHECK_EQUAL_C_STRING(expectedPayload, payload);
+
+	IOT_DEBUG("-->Success - Update queue merges fields and limits rate \n");
+}
+
+TEST_C(ShadowActionTests, UpdateQueueBurstRefillsAfterIdle) {
+	IoT_Error_t ret_val = SUCCESS;
+	int32_t temp = 20;
+	jsonStruct_t tempHandler;
+	uint8_t i;
+	static ShadowQueuedField_t fields[1];
+	static ShadowUpdateQueue_t queue;
+	ShadowUpdateQueueParameters_t queueParams = ShadowUpdateQueueParametersDefault;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Update queue burst refills after idle \n");
+
+	tempHandler.cb = NULL;
+	tempHandler.pData = &temp;
+	tempHandler.pKey = "temp";
+	tempHandler.type = SHADOW_JSON_INT32;
+
+	queueParams.flushInterval_ms = 60000;
+	queueParams.refillInterval_ms = 100;
+	queueParams.burstSize = 3;
+	ret_val = aws_iot_shadow_update_queue_init(&client, &queue, AWS_IOT_MY_THING_NAME, fields, 1, &queueParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// Drain the bucket
+	for(i = 0; i < 3; i++) {
+		temp++;
+		ret_val = aws_iot_shadow_queue_reported(&client, &queue, &tempHandler);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	}
+	temp++;
+	ret_val = aws_iot_shadow_queue_reported(&client, &queue, &tempHandler);
+	CHECK_EQUAL_C_INT(SHADOW_UPDATE_RATE_LIMITED, ret_val);
+
+	// Idle for several intervals, a whole burst can be sent again
+	usleep(450000);
+	ret_val = aws_iot_shadow_update_queue_flush(&client, &queue);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	for(i = 0; i < 2; i++) {
+		temp++;
+		ret_val = aws_iot_shadow_queue_reported(&client, &queue, &tempHandler);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	}
+	temp++;
+	ret_val = aws_iot_shadow_queue_reported(&client, &queue, &tempHandler);
+	CHECK_EQUAL_C_INT(SHADOW_UPDATE_RATE_LIMITED, ret_val);
+
+	IOT_DEBUG("-->Success - Update queue burst refills after idle \n");
+}
+
+#define SECOND_SHADOW_CLIENT_ID "C-SDK_SecondTestClient"
+
+TEST_C(ShadowActionTests, ShadowClientsNumberTheirOwnClientTokens) {
+	IoT_Error_t ret_val = SUCCESS;
+	char topicName[128];
+	char payload[SIZE_OF_UPDATE_DOCUMENT];
+	char topic[120];
+	static AWS_IoT_Client secondClient;
+	static ShadowClient secondShadowClient;
+	ShadowInitParameters_t secondInitParams = shadowInitParams;
+	ShadowConnectParameters_t secondConnectParams = shadowConnectParams;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Shadow clients number their own client tokens \n");
+
+	ret_val = aws_iot_shadow_get(&client, AWS_IOT_MY_THING_NAME, actionCallback, NULL, 4, true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	lastPublishSent(topicName, sizeof(topicName), payload, sizeof(payload));
+	CHECK_EQUAL_C_STRING("{\"clientToken\":\"" AWS_IOT_MQTT_CLIENT_ID "-0\"}", payload);
+
+	secondInitParams.pShadowClient = &secondShadowClient;
+	ret_val = aws_iot_shadow_init(&secondClient, &secondInitParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	secondConnectParams.pMqttClientId = SECOND_SHADOW_CLIENT_ID;
+	secondConnectParams.mqttClientIdLen = (uint16_t) strlen(SECOND_SHADOW_CLIENT_ID);
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	ret_val = aws_iot_shadow_connect(&secondClient, &secondConnectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// The second session starts its own sequence with its own client id
+	topicNameFromThingAndAction(topic, AWS_IOT_MY_THING_NAME, SHADOW_GET);
+	setTLSRxBufferForDoubleSuback(topic, strlen(topic), QOS1, testPubMsgParams);
+	ret_val = aws_iot_shadow_get(&secondClient, AWS_IOT_MY_THING_NAME, actionCallback, NULL, 4, true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	lastPublishSent(topicName, sizeof(topicName), payload, sizeof(payload));
+	CHECK_EQUAL_C_STRING("{\"clientToken\":\"" SECOND_SHADOW_CLIENT_ID "-0\"}", payload);
+
+	ret_val = aws_iot_shadow_get(&client, AWS_IOT_MY_THING_NAME, actionCallback, NULL, 4, true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	lastPublishSent(topicName, sizeof(topicName), payload, sizeof(payload));
+	CHECK_EQUAL_C_STRING("{\"clientToken\":\"" AWS_IOT_MQTT_CLIENT_ID "-1\"}", payload);
+
+	ret_val = aws_iot_shadow_disconnect(&secondClient);
+	IOT_UNUSED(ret_val);
+
+	IOT_DEBUG("-->Success - Shadow clients number their own client tokens \n");
+}
+
+static uint32_t acceptedAckCount;
+
+static void countAcceptedCallback(const char *pThingName, ShadowActions_t action, Shadow_Ack_Status_t status,
+								  const char *pReceivedJsonDocument, void *pContextData) {
+	IOT_UNUSED(pThingName);
+	IOT_UNUSED(action);
+	IOT_UNUSED(pReceivedJsonDocument);
+	if(SHADOW_ACK_ACCEPTED == status) {
+		acceptedAckCount++;
+		*(uint32_t *) pContextData = acceptedAckCount;
+	}
+}
+
+TEST_C(ShadowActionTests, AcksMatchedByClientTokenInAnyOrder) {
+	IoT_Error_t ret_val = SUCCESS;
+	char getRequestJson[120];
+	char response[120];
+	uint32_t acceptedOrder[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
+	uint32_t extraAccepted = 0;
+	IoT_Publish_Message_Params params;
+	int i;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Acks matched by client token in any order \n");
+
+	acceptedAckCount = 0;
+	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
+		acceptedOrder[i] = 0;
+		aws_iot_shadow_internal_get_request_json(getRequestJson);
+		ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson,
+												 countAcceptedCallback, &(acceptedOrder[i]), 100, true);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	}
+	aws_iot_shadow_internal_get_request_json(getRequestJson);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson,
+											 countAcceptedCallback, &extraAccepted, 100, true);
+	CHECK_EQUAL_C_INT(FAILURE, ret_val);
+
+	// A token nobody waits for is ignored
+	params.qos = QOS0;
+	snprintf(response, sizeof(response), "{\"state\":{},\"clientToken\":\"%s-%d\"}", AWS_IOT_MQTT_CLIENT_ID,
+			 MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME + 5);
+	params.payload = response;
+	params.payloadLen = strlen(response);
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params, response);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(0, acceptedAckCount);
+
+	// Responses arrive newest first, each one reaches the request it answers
+	for(i = MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME - 1; i >= 0; i--) {
+		snprintf(response, sizeof(response), "{\"state\":{},\"clientToken\":\"%s-%d\"}", AWS_IOT_MQTT_CLIENT_ID, i);
+		params.payloadLen = strlen(response);
+		ResetTLSBuffer();
+		setTLSRxBufferWithMsgOnSubscribedTopic(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params,
+											   response);
+		ret_val = aws_iot_shadow_yield(&client, 200);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+		CHECK_EQUAL_C_INT(MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME - i, acceptedOrder[i]);
+	}
+
+	// Answered requests gave their records back
+	aws_iot_shadow_internal_get_request_json(getRequestJson);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson,
+											 countAcceptedCallback, &extraAccepted, 100, true);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	IOT_DEBUG("-->Success - Acks matched by client token in any order \n");
+}
+
+#define BULK_GET_ACK_TOPIC "$aws/things/+/shadow/get/+"
+
+static char bulkGetThingRx[3][MAX_SIZE_OF_THING_NAME];
+static Shadow_Ack_Status_t bulkGetStatusRx[3];
+static uint32_t bulkGetResponseCount;
+
+static void bulkGetCallback(const char *pThingName, ShadowActions_t action, Shadow_Ack_Status_t status,
+							const char *pReceivedJsonDocument, void *pContextData) {
+	IOT_UNUSED(action);
+	IOT_UNUSED(pReceivedJsonDocument);
+	IOT_UNUSED(pContextData);
+	if(bulkGetResponseCount < 3) {
+		snprintf(bulkGetThingRx[bulkGetResponseCount], MAX_SIZE_OF_THING_NAME, "%s", pThingName);
+		bulkGetStatusRx[bulkGetResponseCount] = status;
+	}
+	bulkGetResponseCount++;
+}
+
+TEST_C(ShadowActionTests, GetManyThingsOverWildcardTopics) {
+	IoT_Error_t ret_val = SUCCESS;
+	const char *thingNames[] = {"childA", "childB", "childC"};
+	uint16_t requestedCount = 0;
+	char topicName[128];
+	char payload[SIZE_OF_UPDATE_DOCUMENT];
+	char response[120];
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Get many things over wildcard topics \n");
+
+	bulkGetResponseCount = 0;
+	lastSubscribeMsgLen = 11;
+	snprintf(LastSubscribeMessage, lastSubscribeMsgLen, "No Message");
+	ret_val = aws_iot_shadow_get_many(&client, thingNames, 3, bulkGetCallback, NULL, 4, &requestedCount);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(3, requestedCount);
+	CHECK_EQUAL_C_STRING(BULK_GET_ACK_TOPIC, LastSubscribeMessage);
+
+	// All requests went out without waiting for a response
+	lastPublishSent(topicName, sizeof(topicName), payload, sizeof(payload));
+	CHECK_EQUAL_C_STRING("$aws/things/childC/shadow/get", topicName);
+	snprintf(response, sizeof(response), "{\"clientToken\":\"%s-2\"}", AWS_IOT_MQTT_CLIENT_ID);
+	CHECK_EQUAL_C_STRING(response, payload);
+
+	// Responses in any order reach the callback with their thing name
+	params.qos = QOS0;
+	params.payload = response;
+	snprintf(response, sizeof(response), "{\"state\":{},\"clientToken\":\"%s-1\"}", AWS_IOT_MQTT_CLIENT_ID);
+	params.payloadLen = strlen(response);
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic("$aws/things/childB/shadow/get/accepted",
+										   strlen("$aws/things/childB/shadow/get/accepted"), QOS0, params, response);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	snprintf(response, sizeof(response), "{\"code\":404,\"clientToken\":\"%s-0\"}", AWS_IOT_MQTT_CLIENT_ID);
+	params.payloadLen = strlen(response);
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic("$aws/things/childA/shadow/get/rejected",
+										   strlen("$aws/things/childA/shadow/get/rejected"), QOS0, params, response);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	CHECK_EQUAL_C_INT(2, bulkGetResponseCount);
+	CHECK_EQUAL_C_STRING("childB", bulkGetThingRx[0]);
+	CHECK_EQUAL_C_INT(SHADOW_ACK_ACCEPTED, bulkGetStatusRx[0]);
+	CHECK_EQUAL_C_STRING("childA", bulkGetThingRx[1]);
+	CHECK_EQUAL_C_INT(SHADOW_ACK_REJECTED, bulkGetStatusRx[1]);
+
+	// The wildcard subscription is kept for the next batch
+	lastSubscribeMsgLen = 11;
+	snprintf(LastSubscribeMessage, lastSubscribeMsgLen, "No Message");
+	ret_val = aws_iot_shadow_get_many(&client, thingNames, 2, bulkGetCallback, NULL, 4, &requestedCount);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(2, requestedCount);
+	CHECK_EQUAL_C_STRING("No Message", LastSubscribeMessage);
+
+	IOT_DEBUG("-->Success - Get many things over wildcard topics \n");
+}
+
+TEST_C(ShadowActionTests, VersionOnlyTakenFromOwnThingName) {
+	IoT_Error_t ret_val = SUCCESS;
+	const char *thingNames[] = {AWS_IOT_MY_THING_NAME "-child", "gw-" AWS_IOT_MY_THING_NAME, AWS_IOT_MY_THING_NAME};
+	uint16_t requestedCount = 0;
+	char response[120];
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Version only taken from own thing name \n");
+
+	aws_iot_shadow_reset_last_received_version();
+	bulkGetResponseCount = 0;
+	ret_val = aws_iot_shadow_get_many(&client, thingNames, 3, bulkGetCallback, NULL, 4, &requestedCount);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(3, requestedCount);
+
+	params.qos = QOS0;
+	params.payload = response;
+
+	// Thing names containing this thing's name must not move its version
+	snprintf(response, sizeof(response), "{\"state\":{},\"version\":50,\"clientToken\":\"%s-0\"}",
+			 AWS_IOT_MQTT_CLIENT_ID);
+	params.payloadLen = strlen(response);
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic("$aws/things/" AWS_IOT_MY_THING_NAME "-child/shadow/get/accepted",
+										   strlen("$aws/things/" AWS_IOT_MY_THING_NAME "-child/shadow/get/accepted"),
+										   QOS0, params, response);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	snprintf(response, sizeof(response), "{\"state\":{},\"version\":60,\"clientToken\":\"%s-1\"}",
+			 AWS_IOT_MQTT_CLIENT_ID);
+	params.payloadLen = strlen(response);
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic("$aws/things/gw-" AWS_IOT_MY_THING_NAME "/shadow/get/accepted",
+										   strlen("$aws/things/gw-" AWS_IOT_MY_THING_NAME "/shadow/get/accepted"),
+										   QOS0, params, response);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	CHECK_EQUAL_C_INT(2, bulkGetResponseCount);
+	CHECK_C(0u == aws_iot_shadow_get_last_received_version());
+
+	snprintf(response, sizeof(response), "{\"state\":{},\"version\":9,\"clientToken\":\"%s-2\"}",
+			 AWS_IOT_MQTT_CLIENT_ID);
+	params.payloadLen = strlen(response);
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic("$aws/things/" AWS_IOT_MY_THING_NAME "/shadow/get/accepted",
+										   strlen("$aws/things/" AWS_IOT_MY_THING_NAME "/shadow/get/accepted"),
+										   QOS0, params, response);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	CHECK_EQUAL_C_INT(3, bulkGetResponseCount);
+	CHECK_C(9u == aws_iot_shadow_get_last_received_version());
+
+	IOT_DEBUG("-->Success - Version only taken from own thing name \n");
+}
+
+static size_t largeDocumentLenRx;
+
+static void largeDocumentCallback(const char *pThingName, ShadowActions_t action, Shadow_Ack_Status_t status,
+								  const char *pReceivedJsonDocument, void *pContextData) {
+	IOT_UNUSED(pThingName);
+	IOT_UNUSED(action);
+	IOT_UNUSED(pContextData);
+	ackStatusRx = status;
+	if(SHADOW_ACK_TIMEOUT != status) {
+		largeDocumentLenRx = strlen(pReceivedJsonDocument);
+	}
+}
+
+TEST_C(ShadowActionTests, AckLargerThanRxBuffer) {
+	IoT_Error_t ret_val = SUCCESS;
+	char getRequestJson[120];
+	static char response[SHADOW_MAX_SIZE_OF_RX_BUFFER + 200];
+	size_t blobLen;
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Ack larger than the RX buffer \n");
+
+	aws_iot_shadow_internal_get_request_json(getRequestJson);
+	ret_val = aws_iot_shadow_internal_action(&client, AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson,
+											 largeDocumentCallback, NULL, 4, false);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// {"state":{"reported":{"blob":"yyy..."}},"clientToken":"..."} with the token of the request
+	blobLen = sizeof(response) - 1 - strlen("{\"state\":{\"reported\":{\"blob\":\"\"}},") - strlen(getRequestJson + 1);
+	snprintf(response, sizeof(response), "{\"state\":{\"reported\":{\"blob\":\"%*s\"}},%s", (int) blobLen, "",
+			 getRequestJson + 1);
+	memset(response + strlen("{\"state\":{\"reported\":{\"blob\":\""), 'y', blobLen);
+	CHECK_EQUAL_C_INT(sizeof(response) - 1, strlen(response));
+
+	largeDocumentLenRx = 0;
+	ackStatusRx = SHADOW_ACK_TIMEOUT;
+	ResetTLSBuffer();
+	params.payloadLen = strlen(response);
+	params.payload = response;
+	params.qos = QOS0;
+	setTLSRxBufferWithMsgOnSubscribedTopic(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params,
+										   params.payload);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* the callback gets the whole document from a buffer of the client's allocator */
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(SHADOW_ACK_ACCEPTED, ackStatusRx);
+	CHECK_EQUAL_C_INT(strlen(response), largeDocumentLenRx);
+#else
+	/* it does not fit the read buffer and is dropped before it reaches the shadow */
+	CHECK_EQUAL_C_INT(MQTT_RX_BUFFER_TOO_SHORT_ERROR, ret_val);
+	CHECK_EQUAL_C_INT(0, largeDocumentLenRx);
+#endif
+
+	IOT_DEBUG("-->Success - Ack larger than the RX buffer \n");
+}
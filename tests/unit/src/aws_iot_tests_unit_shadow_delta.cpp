@@ -29,5 +29,8 @@ TEST_GROUP_C(ShadowDeltaTest){
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, registerDeltaSuccess)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, registerDeltaInt)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, registerDeltaIntNoCallback)
+TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaSeveralKeysInOneMessage)
+TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaManyRegisteredKeys)
+TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaNestedKeyPaths)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaNestedObject)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaVersionIgnoreOldVersion)
@@ -170,6 +170,163 @@ TEST_C(ShadowDeltaTest, registerDeltaIntNoCallback) {
 	CHECK_EQUAL_C_INT(23, intData);
 }
 
+TEST_C(ShadowDeltaTest, DeltaSeveralKeysInOneMessage) {
+	IoT_Error_t ret_val = SUCCESS;
+	jsonStruct_t windowHandler;
+	jsonStruct_t speedHandler;
+	bool windowOpenData = false;
+	int speedData = 0;
+	char deltaJSONString[] = "{\"state\":{\"delta\":{\"mode\":\"speed\",\"speed\":7,\"window\":true}},\"version\":1}";
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("\n-->Running Shadow Delta Tests - Several keys in one delta message \n");
+
+	windowHandler.cb = genericCallback;
+	windowHandler.pKey = "window";
+	windowHandler.type = SHADOW_JSON_BOOL;
+	windowHandler.pData = &windowOpenData;
+
+	speedHandler.cb = genericCallback;
+	speedHandler.pKey = "speed";
+	speedHandler.type = SHADOW_JSON_INT32;
+	speedHandler.pData = &speedData;
+
+	params.payloadLen = strlen(deltaJSONString);
+	params.payload = deltaJSONString;
+	params.qos = QOS0;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params);
+
+	ret_val = aws_iot_shadow_register_delta(&client, &windowHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_register_delta(&client, &speedHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params, params.payload);
+
+	ret_val = aws_iot_shadow_yield(&client, 3000);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// The "speed" string value is not taken for the key of the same name
+	CHECK_EQUAL_C_INT(7, speedData);
+	CHECK_EQUAL_C_INT(true, windowOpenData);
+	CHECK_C(1u == aws_iot_shadow_get_last_received_version());
+}
+
+TEST_C(ShadowDeltaTest, DeltaManyRegisteredKeys) {
+	IoT_Error_t ret_val = SUCCESS;
+	jsonStruct_t keyHandlers[24];
+	char keyNames[24][8];
+	int32_t keyData[24];
+	char deltaJSONString[] = "{\"state\":{\"delta\":{\"key23\":23,\"key7\":7,\"key0\":0}},\"version\":1}";
+	IoT_Publish_Message_Params params;
+	uint32_t i;
+
+	IOT_DEBUG("\n-->Running Shadow Delta Tests - Delta matched against many registered keys \n");
+
+	params.payloadLen = strlen(deltaJSONString);
+	params.payload = deltaJSONString;
+	params.qos = QOS0;
+
+	for(i = 0; i < 24; i++) {
+		snprintf(keyNames[i], sizeof(keyNames[i]), "key%u", (unsigned int) i);
+		keyData[i] = -1;
+		keyHandlers[i].cb = NULL;
+		keyHandlers[i].pKey = keyNames[i];
+		keyHandlers[i].type = SHADOW_JSON_INT32;
+		keyHandlers[i].pData = &keyData[i];
+
+		ResetTLSBuffer();
+		setTLSRxBufferForSuback(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params);
+		ret_val = aws_iot_shadow_register_delta(&client, &keyHandlers[i]);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	}
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params, params.payload);
+
+	ret_val = aws_iot_shadow_yield(&client, 3000);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	for(i = 0; i < 24; i++) {
+		if(0 == i || 7 == i || 23 == i) {
+			CHECK_EQUAL_C_INT((int) i, keyData[i]);
+		} else {
+			CHECK_EQUAL_C_INT(-1, keyData[i]);
+		}
+	}
+}
+
+TEST_C(ShadowDeltaTest, DeltaNestedKeyPaths) {
+	IoT_Error_t ret_val = SUCCESS;
+	jsonStruct_t kitchenHandler;
+	jsonStruct_t hallHandler;
+	jsonStruct_t garageHandler;
+	jsonStruct_t anyBrightnessHandler;
+	jsonStruct_t tooDeepHandler;
+	int32_t kitchenData = -1;
+	int32_t hallData = -1;
+	int32_t garageData = -1;
+	int32_t anyBrightnessData = -1;
+	char deltaJSONString[] = "{\"state\":{\"delta\":{\"lights\":{\"hall\":{\"brightness\":20},\"doors\":[{\"brightness\":1}],"
+			"\"kitchen\":{\"brightness\":80}}}},\"version\":1}";
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("\n-->Running Shadow Delta Tests - Delta keys registered as nested paths \n");
+
+	kitchenHandler.cb = genericCallback;
+	kitchenHandler.pKey = "state.delta.lights.kitchen.brightness";
+	kitchenHandler.type = SHADOW_JSON_INT32;
+	kitchenHandler.pData = &kitchenData;
+
+	hallHandler = kitchenHandler;
+	hallHandler.pKey = "state.delta.lights.hall.brightness";
+	hallHandler.pData = &hallData;
+
+	garageHandler = kitchenHandler;
+	garageHandler.pKey = "state.delta.lights.garage.brightness";
+	garageHandler.pData = &garageData;
+
+	anyBrightnessHandler = kitchenHandler;
+	anyBrightnessHandler.pKey = "brightness";
+	anyBrightnessHandler.pData = &anyBrightnessData;
+
+	tooDeepHandler = kitchenHandler;
+	tooDeepHandler.pKey = "a.b.c.d.e.f.g.h.i.j";
+
+	params.payloadLen = strlen(deltaJSONString);
+	params.payload = deltaJSONString;
+	params.qos = QOS0;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params);
+
+	ret_val = aws_iot_shadow_register_delta(&client, &kitchenHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_register_delta(&client, &hallHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_register_delta(&client, &garageHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_register_delta(&client, &anyBrightnessHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_register_delta(&client, &tooDeepHandler);
+	CHECK_EQUAL_C_INT(FAILURE, ret_val);
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params, params.payload);
+
+	ret_val = aws_iot_shadow_yield(&client, 3000);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	// Paths only take the field they name, a bare key still takes the first one found at any depth
+	CHECK_EQUAL_C_INT(80, kitchenData);
+	CHECK_EQUAL_C_INT(20, hallData);
+	CHECK_EQUAL_C_INT(-1, garageData);
+	CHECK_EQUAL_C_INT(20, anyBrightnessData);
+}
+
 TEST_C(ShadowDeltaTest, DeltaNestedObject) {
 	IoT_Error_t ret_val = SUCCESS;
 	IoT_Publish_Message_Params params;
@@ -29,3 +29,7 @@ TEST_GROUP_C(ShadowJsonBuilderTests){
 TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, UpdateTheJSONDocumentBuilder)
 TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, PassingNullValue)
 TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, SmallBuffer)
+TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, BuilderNestedObjectsAndArrays)
+TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, BuilderErrorsAreKept)
+TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, BuilderDoublesMatchPrintf)
+TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, PassingNullEntry)
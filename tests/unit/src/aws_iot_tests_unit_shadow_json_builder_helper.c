@@ -18,6 +18,7 @@
  * @brief IoT Client Unit Testing - Shadow JSON Builder Tests Helper
  */
 
+#include <stdio.h>
 #include <string.h>
 #include <CppUTest/TestHarness_c.h>
 #include <aws_iot_shadow_interface.h>
@@ -127,3 +128,120 @@ TEST_C(ShadowJsonBuilderTests, SmallBuffer) {
 	ret_val = aws_iot_finalize_json_document(updateRequestJson, jsonBufSize);
 	CHECK_EQUAL_C_INT(SHADOW_JSON_ERROR, ret_val);
 }
+
+#define TEST_JSON_BUILDER_NESTED_DOCUMENT "{\"state\":{\"reported\":{\"temp\":-42,\"min\":-2147483648,\"count\":200,\"on\":true," \
+	"\"offset\":-0.500000,\"mode\":\"eco\",\"lights\":{\"kitchen\":80},\"levels\":[1,4000000000,{\"x\":-128}]}}," \
+	"\"clientToken\":\"" AWS_IOT_MQTT_CLIENT_ID "-0\"}"
+
+TEST_C(ShadowJsonBuilderTests, BuilderNestedObjectsAndArrays) {
+	IoT_Error_t ret_val;
+	ShadowJsonBuilder_t builder;
+	char updateRequestJson[2 * SIZE_OF_UPFATE_BUF];
+	int32_t temp = -42;
+	int32_t min = INT32_MIN;
+	uint8_t count = 200;
+	bool on = true;
+	double offset = -0.5;
+	int16_t kitchen = 80;
+	uint32_t levels[2] = {1, 4000000000u};
+	int8_t x = -128;
+
+	IOT_DEBUG("\n-->Running Shadow Json Builder Tests - Builder with nested objects and arrays \n");
+
+	ret_val = aws_iot_shadow_json_builder_init(&builder, updateRequestJson, sizeof(updateRequestJson));
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	aws_iot_shadow_json_builder_begin_object(&builder, "reported");
+	aws_iot_shadow_json_builder_add_value(&builder, "temp", SHADOW_JSON_INT32, &temp);
+	aws_iot_shadow_json_builder_add_value(&builder, "min", SHADOW_JSON_INT32, &min);
+	aws_iot_shadow_json_builder_add_value(&builder, "count", SHADOW_JSON_UINT8, &count);
+	aws_iot_shadow_json_builder_add_value(&builder, "on", SHADOW_JSON_BOOL, &on);
+	aws_iot_shadow_json_builder_add_value(&builder, "offset", SHADOW_JSON_DOUBLE, &offset);
+	aws_iot_shadow_json_builder_add_value(&builder, "mode", SHADOW_JSON_STRING, "eco");
+	aws_iot_shadow_json_builder_begin_object(&builder, "lights");
+	aws_iot_shadow_json_builder_add_value(&builder, "kitchen", SHADOW_JSON_INT16, &kitchen);
+	aws_iot_shadow_json_builder_end_object(&builder);
+	aws_iot_shadow_json_builder_begin_array(&builder, "levels");
+	aws_iot_shadow_json_builder_add_value(&builder, NULL, SHADOW_JSON_UINT32, &levels[0]);
+	aws_iot_shadow_json_builder_add_value(&builder, NULL, SHADOW_JSON_UINT32, &levels[1]);
+	aws_iot_shadow_json_builder_begin_object(&builder, NULL);
+	aws_iot_shadow_json_builder_add_value(&builder, "x", SHADOW_JSON_INT8, &x);
+	aws_iot_shadow_json_builder_end_object(&builder);
+	ret_val = aws_iot_shadow_json_builder_end_array(&builder);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	// "reported" is left open, finalize closes it
+	ret_val = aws_iot_shadow_json_builder_finalize(&builder);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	CHECK_EQUAL_C_STRING(TEST_JSON_BUILDER_NESTED_DOCUMENT, updateRequestJson);
+	CHECK_C(strlen(updateRequestJson) == builder.length);
+}
+
+TEST_C(ShadowJsonBuilderTests, BuilderErrorsAreKept) {
+	IoT_Error_t ret_val;
+	ShadowJsonBuilder_t builder;
+	char updateRequestJson[24];
+
+	IOT_DEBUG("\n-->Running Shadow Json Builder Tests - Builder keeps the first error \n");
+
+	ret_val = aws_iot_shadow_json_builder_init(&builder, updateRequestJson, sizeof(updateRequestJson));
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_json_builder_end_array(&builder);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_ERROR, ret_val);
+	ret_val = aws_iot_shadow_json_builder_finalize(&builder);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_ERROR, ret_val);
+
+	ret_val = aws_iot_shadow_json_builder_init(&builder, updateRequestJson, sizeof(updateRequestJson));
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_json_builder_add(&builder, &dataDoubleHandler);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_BUFFER_TRUNCATED, ret_val);
+	ret_val = aws_iot_shadow_json_builder_add(&builder, &dataFloatHandler);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_BUFFER_TRUNCATED, ret_val);
+	ret_val = aws_iot_shadow_json_builder_finalize(&builder);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_BUFFER_TRUNCATED, ret_val);
+	CHECK_C(sizeof(updateRequestJson) - 1 == strlen(updateRequestJson));
+}
+
+TEST_C(ShadowJsonBuilderTests, BuilderDoublesMatchPrintf) {
+	IoT_Error_t ret_val;
+	ShadowJsonBuilder_t builder;
+	char updateRequestJson[2 * SIZE_OF_UPFATE_BUF];
+	char expectedValue[SIZE_OF_UPFATE_BUF + 128];
+	const char *pValue;
+	/* Large values, halfway values that round to even, negative zero and values that round to it */
+	static const double values[] = {911647357936.784302, 4503599627.3704967, 8589934591.999999, 1.0e300, 0.0078125,
+									0.0234375, 2.5e-6, 4.9999999999999998e-07, -0.0, -1.0e-9, -123456.7890125};
+	uint8_t i;
+
+	IOT_DEBUG("\n-->Running Shadow Json Builder Tests - Builder writes doubles like printf \n");
+
+	for(i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		ret_val = aws_iot_shadow_json_builder_init(&builder, updateRequestJson, sizeof(updateRequestJson));
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+		ret_val = aws_iot_shadow_json_builder_add_value(&builder, "v", SHADOW_JSON_DOUBLE, &values[i]);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+		updateRequestJson[builder.length] = '\0';
+
+		snprintf(expectedValue, sizeof(expectedValue), "%f", values[i]);
+		pValue = strstr(updateRequestJson, "\"v\":");
+		CHECK_C(NULL != pValue);
+		CHECK_EQUAL_C_STRING(expectedValue, pValue + 4);
+	}
+}
+
+TEST_C(ShadowJsonBuilderTests, PassingNullEntry) {
+	IoT_Error_t ret_val;
+	char updateRequestJson[SIZE_OF_UPFATE_BUF];
+	size_t jsonBufSize = sizeof(updateRequestJson) / sizeof(updateRequestJson[0]);
+
+	IOT_DEBUG("\n-->Running Shadow Json Builder Tests - Passing a Null entry to Shadow json builder \n");
+
+	ret_val = aws_iot_shadow_init_json_document(updateRequestJson, jsonBufSize);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_add_reported(updateRequestJson, jsonBufSize, 2, &dataDoubleHandler, NULL);
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, ret_val);
+
+	ret_val = aws_iot_shadow_init_json_document(updateRequestJson, jsonBufSize);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_add_desired(updateRequestJson, jsonBufSize, 2, NULL, &dataFloatHandler);
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, ret_val);
+}
@@ -77,3 +77,7 @@ TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicHashkeyMustBeTheLastFail)
 TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicWithPluskeySuccess)
 /* C:22 - Subscribe with '+' as last character in topic name, Success */
 TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicPluskeyComesLastSuccess)
+/* C:23 - Subscribe with overlapping topic filters, all matching handlers called */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeOverlappingFiltersAllMatchingCalled)
+/* C:24 - Unsubscribe a topic filter sharing levels with another subscription */
+TEST_GROUP_C_WRAPPER(SubscribeTests, unsubscribeSharedLevelsOtherFilterStillMatches)
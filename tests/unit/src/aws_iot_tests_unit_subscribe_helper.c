@@ -604,3 +604,81 @@ TEST_C(SubscribeTests, subscribeTopicPluskeyComesLastSuccess) {
 
 	IOT_DEBUG("-->Success - C:22 - Subscribe with '+' as last character in topic name, Success \n");
 }
+/* C:23 - Subscribe with overlapping topic filters, all matching handlers called */
+TEST_C(SubscribeTests, subscribeOverlappingFiltersAllMatchingCalled) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[100] = "New message: overlapping filters";
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:23 - Subscribe with overlapping topic filters, all matching handlers called \n");
+
+	setTLSRxBufferForSuback("sdk/Test/sub", strlen("sdk/Test/sub"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/Test/sub", strlen("sdk/Test/sub"), QOS1,
+								iot_subscribe_callback_handler1, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	setTLSRxBufferForSuback("sdk/+/sub", strlen("sdk/+/sub"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/+/sub", strlen("sdk/+/sub"), QOS1,
+								iot_subscribe_callback_handler2, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	setTLSRxBufferForSuback("sdk/#", strlen("sdk/#"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/#", strlen("sdk/#"), QOS1,
+								iot_subscribe_callback_handler3, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	setTLSRxBufferForSuback("sdk/Test/+/sub", strlen("sdk/Test/+/sub"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/Test/+/sub", strlen("sdk/Test/+/sub"), QOS1,
+								iot_subscribe_callback_handler4, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferWithMsgOnSubscribedTopic("sdk/Test/sub", strlen("sdk/Test/sub"), QOS1, testPubMsgParams,
+										   expectedCallbackString);
+	snprintf(CallbackMsgString1, 100, "NOT_VISITED");
+	snprintf(CallbackMsgString2, 100, "NOT_VISITED");
+	snprintf(CallbackMsgString3, 100, "NOT_VISITED");
+	snprintf(CallbackMsgString4, 100, "NOT_VISITED");
+
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString1);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString2);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString3);
+	CHECK_EQUAL_C_STRING("NOT_VISITED", CallbackMsgString4);
+
+	IOT_DEBUG("-->Success - C:23 - Subscribe with overlapping topic filters, all matching handlers called \n");
+}
+
+/* C:24 - Unsubscribe a topic filter sharing levels with another subscription */
+TEST_C(SubscribeTests, unsubscribeSharedLevelsOtherFilterStillMatches) {
+	IoT_Error_t rc = SUCCESS;
+	char firstTopic[20] = "sdk/Test/first";
+	char secondTopic[20] = "sdk/Test/second";
+	char expectedCallbackString[100] = "New message: shared levels";
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:24 - Unsubscribe a topic filter sharing levels with another subscription \n");
+
+	setTLSRxBufferForSuback(firstTopic, strlen(firstTopic), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, firstTopic, (uint16_t) strlen(firstTopic), QOS1,
+								iot_subscribe_callback_handler1, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	setTLSRxBufferForSuback(secondTopic, strlen(secondTopic), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, secondTopic, (uint16_t) strlen(secondTopic), QOS1,
+								iot_subscribe_callback_handler2, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForUnsuback();
+	rc = aws_iot_mqtt_unsubscribe(&iotClient, firstTopic, (uint16_t) strlen(firstTopic));
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	// The application may reuse the memory of a topic filter once it is unsubscribed
+	memset(firstTopic, 'X', sizeof(firstTopic) - 1);
+
+	setTLSRxBufferWithMsgOnSubscribedTopic(secondTopic, strlen(secondTopic), QOS1, testPubMsgParams,
+										   expectedCallbackString);
+	snprintf(CallbackMsgString1, 100, "NOT_VISITED");
+	snprintf(CallbackMsgString2, 100, "NOT_VISITED");
+
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING("NOT_VISITED", CallbackMsgString1);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString2);
+
+	IOT_DEBUG("-->Success - C:24 - Unsubscribe a topic filter sharing levels with another subscription \n");
+}
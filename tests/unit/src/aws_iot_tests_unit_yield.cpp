@@ -52,3 +52,15 @@ TEST_GROUP_C_WRAPPER(YieldTests, disconnectAutoReconnectSuccess)
 TEST_GROUP_C_WRAPPER(YieldTests, disconnectManualAutoReconnect)
 /* G:12 - Yield, resubscribe to all topics on reconnect */
 TEST_GROUP_C_WRAPPER(YieldTests, resubscribeSuccessfulReconnect)
+/* G:13 - Yield, message larger than the initial read buffer */
+TEST_GROUP_C_WRAPPER(YieldTests, YieldMessageLargerThanRxBuffer)
+/* G:14 - Yield, message larger than the read buffer to a streaming subscriber */
+TEST_GROUP_C_WRAPPER(YieldTests, YieldStreamMessageLargerThanRxBuffer)
+/* G:15 - Service, message delivered without waiting */
+TEST_GROUP_C_WRAPPER(YieldTests, ServiceDeliversMessage)
+/* G:16 - Service, timeout follows the keepalive timer */
+TEST_GROUP_C_WRAPPER(YieldTests, ServiceTimeoutKeepAlive)
+/* G:17 - Service, partial message kept while a non-blocking read would block */
+TEST_GROUP_C_WRAPPER(YieldTests, ServicePartialMessageWouldBlock)
+/* G:18 - Yield, streamed message cut off closes the connection */
+TEST_GROUP_C_WRAPPER(YieldTests, YieldStreamMessageTruncatedDisconnects)
@@ -19,6 +19,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <CppUTest/TestHarness_c.h>
 
@@ -74,6 +75,46 @@ static void iot_tests_unit_yield_test_subscribe_callback_handler(AWS_IoT_Client
 	}
 }
 
+static size_t largeMsgPayloadLen;
+
+static void iot_tests_unit_large_msg_subscribe_callback_handler(AWS_IoT_Client *pClient, char *topicName,
+																uint16_t topicNameLen,
+																IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(pData);
+
+	largeMsgPayloadLen = params->payloadLen;
+}
+
+static size_t streamedChunkCount;
+static size_t streamedPayloadLen;
+static size_t streamedTotalPayloadLen;
+static bool streamedChunksInOrder;
+
+static void iot_tests_unit_streaming_subscribe_callback_handler(AWS_IoT_Client *pClient, char *topicName,
+																uint16_t topicNameLen,
+																IoT_Publish_Message_Params *params, void *pData) {
+	size_t i;
+
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pData);
+
+	if(params->payloadOffset != streamedPayloadLen || 0 != strncmp(subTopic, topicName, topicNameLen)) {
+		streamedChunksInOrder = false;
+	}
+	for(i = 0; i < params->payloadLen; i++) {
+		/* the message string is sent with its terminator */
+		if('y' != ((char *) params->payload)[i] && '\0' != ((char *) params->payload)[i]) {
+			streamedChunksInOrder = false;
+		}
+	}
+	streamedChunkCount++;
+	streamedPayloadLen += params->payloadLen;
+	streamedTotalPayloadLen = params->totalPayloadLen;
+}
+
 void iot_tests_unit_disconnect_handler(AWS_IoT_Client *pClient, void *disconParam) {
 	IOT_UNUSED(pClient);
 	IOT_UNUSED(disconParam);
@@ -293,6 +334,7 @@ TEST_C(YieldTests, disconnectAutoReconnectTimeout) {
 TEST_C(YieldTests, disconnectAutoReconnectSuccess) {
 	IoT_Error_t rc = FAILURE;
 	unsigned char *currPayload = NULL;
+	IoT_Connection_Stats stats;
 
 	IOT_DEBUG("-->Running Yield Tests - G:10 - Yield, disconnected, Auto-reconnect successful \n");
 
@@ -325,6 +367,13 @@ TEST_C(YieldTests, disconnectAutoReconnectSuccess) {
 	CHECK_EQUAL_C_INT(true, aws_iot_mqtt_is_client_connected(&iotClient));
 	CHECK_EQUAL_C_INT(true, dcHandlerInvoked);
 
+	/* the reconnect took at least the 2 second sleep since the disconnect was detected */
+	rc = aws_iot_mqtt_get_connection_stats(&iotClient, &stats);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, stats.reconnectCount);
+	CHECK_C(2000 <= stats.lastReconnectLatencyMs && stats.lastReconnectLatencyMs < 10000);
+	CHECK_EQUAL_C_INT(stats.lastReconnectLatencyMs, stats.maxReconnectLatencyMs);
+
 	IOT_DEBUG("-->Success - G:10 - Yield, disconnected, Auto-reconnect successful \n");
 }
 
@@ -450,3 +499,208 @@ TEST_C(YieldTests, resubscribeSuccessfulReconnect) {
 
 	IOT_DEBUG("-->Success - G:12 - Yield, resubscribe to all topics on reconnect \n");
 }
+
+/* G:13 - Yield, message larger than the initial read buffer */
+TEST_C(YieldTests, YieldMessageLargerThanRxBuffer) {
+	IoT_Error_t rc = SUCCESS;
+	IoT_Buffer_Usage bufferUsage;
+	static char largeMsg[AWS_IOT_MQTT_RX_BUF_LEN + 100];
+
+	IOT_DEBUG("-->Running Yield Tests - G:13 - Yield, message larger than the initial read buffer \n");
+
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, subTopic, subTopicLen, QOS0,
+								iot_tests_unit_large_msg_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	memset(largeMsg, 'y', sizeof(largeMsg) - 1);
+	largeMsg[sizeof(largeMsg) - 1] = '\0';
+	largeMsgPayloadLen = 0;
+	testPubMsgParams.qos = QOS1;
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, largeMsg);
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_get_buffer_usage(&iotClient, &bufferUsage));
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* the read buffer grows for the message and returns to its initial size on the next read */
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(sizeof(largeMsg), largeMsgPayloadLen);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_RX_BUF_LEN, bufferUsage.readBufSize);
+	CHECK_C(sizeof(largeMsg) < bufferUsage.peakReadBufSize);
+#else
+	CHECK_EQUAL_C_INT(0, largeMsgPayloadLen);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_RX_BUF_LEN, bufferUsage.peakReadBufSize);
+#endif
+
+	IOT_DEBUG("-->Success - G:13 - Yield, message larger than the initial read buffer \n");
+}
+
+TEST_C(YieldTests, YieldStreamMessageLargerThanRxBuffer) {
+	IoT_Error_t rc = SUCCESS;
+	static char largeMsg[AWS_IOT_MQTT_RX_BUF_LEN + 300];
+
+	IOT_DEBUG("-->Running Yield Tests - G:14 - Yield, message larger than the read buffer to a streaming subscriber \n");
+
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_streaming(&iotClient, subTopic, subTopicLen, QOS1,
+										  iot_tests_unit_streaming_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	memset(largeMsg, 'y', sizeof(largeMsg) - 1);
+	largeMsg[sizeof(largeMsg) - 1] = '\0';
+	streamedChunkCount = 0;
+	streamedPayloadLen = 0;
+	streamedTotalPayloadLen = 0;
+	streamedChunksInOrder = true;
+	testPubMsgParams.qos = QOS1;
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, largeMsg);
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(true, streamedChunksInOrder);
+	CHECK_EQUAL_C_INT(streamedTotalPayloadLen, streamedPayloadLen);
+	CHECK_C(strlen(largeMsg) <= streamedPayloadLen);
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* the read buffer grows for the message, it is delivered in one piece */
+	CHECK_EQUAL_C_INT(1, streamedChunkCount);
+#else
+	CHECK_C(1 < streamedChunkCount);
+#endif
+	CHECK_EQUAL_C_INT(1, isLastTLSTxMessagePuback());
+
+	IOT_DEBUG("-->Success - G:14 - Yield, message larger than the read buffer to a streaming subscriber \n");
+}
+
+TEST_C(YieldTests, ServiceDeliversMessage) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[] = "0xA5A5A3";
+
+	IOT_DEBUG("-->Running Yield Tests - G:15 - Service, message delivered without waiting \n");
+
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.isRetained = 0;
+	testPubMsgParams.payload = (void *) expectedCallbackString;
+	testPubMsgParams.payloadLen = strlen(expectedCallbackString);
+
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, subTopic, subTopicLen, QOS0,
+								iot_tests_unit_acr_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	memset(CallbackMsgString, 0, sizeof(CallbackMsgString));
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS0, testPubMsgParams, expectedCallbackString);
+
+	rc = aws_iot_mqtt_service(&iotClient, true);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString);
+	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_IDLE, aws_iot_mqtt_get_client_state(&iotClient));
+
+	/* nothing arrived, the call returns without reading */
+	rc = aws_iot_mqtt_service(&iotClient, false);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	IOT_DEBUG("-->Success - G:15 - Service, message delivered without waiting \n");
+}
+
+TEST_C(YieldTests, ServiceTimeoutKeepAlive) {
+	IoT_Error_t rc = SUCCESS;
+	uint32_t timeout_ms;
+
+	IOT_DEBUG("-->Running Yield Tests - G:16 - Service, timeout follows the keepalive timer \n");
+
+	timeout_ms = aws_iot_mqtt_get_service_timeout_ms(&iotClient);
+	CHECK_C(0 < timeout_ms);
+	CHECK_C(timeout_ms <= iotClient.clientData.keepAliveInterval * 1000);
+
+	/* make the ping due instead of waiting for the keepalive interval */
+	ResetTLSBuffer();
+	aws_iot_mqtt_timer_start(&iotClient, &(iotClient.pingTimer), 0);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_service_timeout_ms(&iotClient));
+
+	rc = aws_iot_mqtt_service(&iotClient, false);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, isLastTLSTxMessagePingreq());
+	CHECK_C(0 < aws_iot_mqtt_get_service_timeout_ms(&iotClient));
+
+	IOT_DEBUG("-->Success - G:16 - Service, timeout follows the keepalive timer \n");
+}
+
+TEST_C(YieldTests, ServicePartialMessageWouldBlock) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[] = "0xA5A5A3";
+
+	IOT_DEBUG("-->Running Yield Tests - G:17 - Service, partial message kept while a non-blocking read would block \n");
+
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.isRetained = 0;
+	testPubMsgParams.payload = (void *) expectedCallbackString;
+	testPubMsgParams.payloadLen = strlen(expectedCallbackString);
+
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, subTopic, subTopicLen, QOS0,
+								iot_tests_unit_acr_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	memset(CallbackMsgString, 0, sizeof(CallbackMsgString));
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS0, testPubMsgParams, expectedCallbackString);
+
+	/* only the start of the publish has arrived */
+	RxWouldBlockIndex = 6;
+	rc = aws_iot_mqtt_service(&iotClient, true);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, strlen(CallbackMsgString));
+	CHECK_EQUAL_C_INT(6, iotClient.clientData.readBufDataLen);
+
+	/* the rest arrives and completes the buffered part */
+	RxWouldBlockIndex = 0;
+	rc = aws_iot_mqtt_service(&iotClient, true);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString);
+
+	IOT_DEBUG("-->Success - G:17 - Service, partial message kept while a non-blocking read would block \n");
+}
+
+TEST_C(YieldTests, YieldStreamMessageTruncatedDisconnects) {
+	IoT_Error_t rc = SUCCESS;
+	static char largeMsg[AWS_IOT_MQTT_RX_BUF_LEN + 300];
+
+	IOT_DEBUG("-->Running Yield Tests - G:18 - Yield, streamed message cut off closes the connection \n");
+
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_streaming(&iotClient, subTopic, subTopicLen, QOS1,
+										  iot_tests_unit_streaming_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	memset(largeMsg, 'y', sizeof(largeMsg) - 1);
+	largeMsg[sizeof(largeMsg) - 1] = '\0';
+	streamedChunkCount = 0;
+	streamedPayloadLen = 0;
+	streamedTotalPayloadLen = 0;
+	streamedChunksInOrder = true;
+	testPubMsgParams.qos = QOS1;
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, largeMsg);
+	/* the end of the payload never arrives */
+	RxBuffer.len -= 100;
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+
+#ifdef _ENABLE_DYNAMIC_BUFFERS_
+	/* the read buffer grows for the message, nothing is streamed */
+	IOT_UNUSED(rc);
+	CHECK_EQUAL_C_INT(0, streamedChunkCount);
+#else
+	/* the rest of the packet would be read as the next one, the connection is closed instead */
+	CHECK_EQUAL_C_INT(NETWORK_DISCONNECTED_ERROR, rc);
+	CHECK_EQUAL_C_INT(true, dcHandlerInvoked);
+	CHECK_EQUAL_C_INT(true, streamedChunksInOrder);
+	CHECK_C(0 < streamedChunkCount);
+	CHECK_C(streamedPayloadLen < streamedTotalPayloadLen);
+	CHECK_EQUAL_C_INT(0, isLastTLSTxMessagePuback());
+#endif
+
+	IOT_DEBUG("-->Success - G:18 - Yield, streamed message cut off closes the connection \n");
+}
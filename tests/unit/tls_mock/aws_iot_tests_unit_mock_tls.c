@@ -1,5 +1,8 @@
 #include <string.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <network_interface.h>
 
 #include "network_interface.h"
@@ -27,9 +30,14 @@ IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation, char *pDevice
 	pNetwork->connect = iot_tls_connect;
 	pNetwork->read = iot_tls_read;
 	pNetwork->write = iot_tls_write;
+	pNetwork->writev = iot_tls_writev;
 	pNetwork->disconnect = iot_tls_disconnect;
 	pNetwork->isConnected = iot_tls_is_connected;
 	pNetwork->destroy = iot_tls_destroy;
+	pNetwork->getSocket = iot_tls_get_socket;
+	pNetwork->release = NULL;
+
+	pNetwork->tlsDataParams.eventFd = -1;
 
 	return SUCCESS;
 }
@@ -101,6 +109,23 @@ IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len, Ti
 	return SUCCESS;
 }
 
+IoT_Error_t iot_tls_writev(Network *pNetwork, const NetworkIoVec *pIoVec, size_t ioVecCount, Timer *timer,
+						   size_t *written_len) {
+	static unsigned char gatherBuf[TLSMaxBufferSize];
+	size_t i, len = 0;
+
+	/* Gather into one message so the checks on TxBuffer see the packet as sent */
+	for(i = 0; i < ioVecCount; i++) {
+		if(len + pIoVec[i].len > sizeof(gatherBuf)) {
+			return NETWORK_SSL_WRITE_ERROR;
+		}
+		memcpy(gatherBuf + len, pIoVec[i].pBuffer, pIoVec[i].len);
+		len += pIoVec[i].len;
+	}
+
+	return iot_tls_write(pNetwork, gatherBuf, len, timer, written_len);
+}
+
 static unsigned char isTimerExpired(struct timeval target_time) {
 	unsigned char ret_val = 0;
 	struct timeval now, result;
@@ -117,22 +142,68 @@ static unsigned char isTimerExpired(struct timeval target_time) {
 	return ret_val;
 }
 
+/* With stand-in sockets in use the mock data belongs to the network whose socket was signalled */
+static bool _iot_tls_is_readable(Network *pNetwork) {
+	struct pollfd pollFd;
+
+	if(0 > pNetwork->tlsDataParams.eventFd) {
+		return true;
+	}
+
+	pollFd.fd = pNetwork->tlsDataParams.eventFd;
+	pollFd.events = POLLIN;
+	pollFd.revents = 0;
+
+	return 1 == poll(&pollFd, 1, 0);
+}
+
+/* Once the data is consumed the stand-in socket is no longer readable */
+static void _iot_tls_clear_readable(Network *pNetwork) {
+	eventfd_t value;
+
+	if(0 <= pNetwork->tlsDataParams.eventFd) {
+		(void) eventfd_read(pNetwork->tlsDataParams.eventFd, &value);
+	}
+}
+
 IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len, Timer *pTimer, size_t *read_len) {
-	IOT_UNUSED(pNetwork);
 	IOT_UNUSED(pTimer);
 
+	RxReadCallCount++;
+
 	if(RxIndex > TLSMaxBufferSize - 1) {
 		RxIndex = TLSMaxBufferSize - 1;
 	}
 
 	if(RxBuffer.len <= RxIndex || !isTimerExpired(RxBuffer.expiry_time)) {
+		_iot_tls_clear_readable(pNetwork);
+		return NETWORK_SSL_NOTHING_TO_READ;
+	}
+
+	if(!_iot_tls_is_readable(pNetwork)) {
 		return NETWORK_SSL_NOTHING_TO_READ;
 	}
 
 	if((false == RxBuffer.NoMsgFlag) && (RxIndex < RxBuffer.len)) {
+		/* Behave like a socket, hand out what is available up to len */
+		if(len > RxBuffer.len - RxIndex) {
+			len = RxBuffer.len - RxIndex;
+		}
+		/* Behave like a non-blocking socket that has only received the data up to RxWouldBlockIndex */
+		if(0 < RxWouldBlockIndex) {
+			if(RxIndex >= RxWouldBlockIndex) {
+				return NETWORK_SSL_WANT_READ;
+			}
+			if(len > RxWouldBlockIndex - RxIndex) {
+				len = RxWouldBlockIndex - RxIndex;
+			}
+		}
 		memcpy(pMsg, &(RxBuffer.pBuffer[RxIndex]), len);
 		RxIndex += len;
 		*read_len = len;
+		if(RxBuffer.len <= RxIndex) {
+			_iot_tls_clear_readable(pNetwork);
+		}
 	}
 
 	return SUCCESS;
@@ -144,6 +215,19 @@ IoT_Error_t iot_tls_disconnect(Network *pNetwork) {
 }
 
 IoT_Error_t iot_tls_destroy(Network *pNetwork) {
-	IOT_UNUSED(pNetwork);
+	if(0 <= pNetwork->tlsDataParams.eventFd) {
+		close(pNetwork->tlsDataParams.eventFd);
+		pNetwork->tlsDataParams.eventFd = -1;
+	}
 	return SUCCESS;
 }
+
+IoT_Error_t iot_tls_get_socket(Network *pNetwork, int *pSocket) {
+	/* Created on first use, only event loop tests need it */
+	if(0 > pNetwork->tlsDataParams.eventFd) {
+		pNetwork->tlsDataParams.eventFd = eventfd(0, EFD_NONBLOCK);
+	}
+	*pSocket = pNetwork->tlsDataParams.eventFd;
+
+	return (0 <= *pSocket) ? SUCCESS : FAILURE;
+}
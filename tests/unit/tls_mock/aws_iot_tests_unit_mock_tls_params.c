@@ -31,6 +31,8 @@ TlsBuffer RxBuffer = {.pBuffer = RxBuf,.len = 512, .NoMsgFlag=1, .expiry_time =
 TlsBuffer TxBuffer = {.pBuffer = TxBuf,.len = 512, .NoMsgFlag=1, .expiry_time = {0, 0}, .BufMaxSize = TLSMaxBufferSize};
 
 size_t RxIndex = 0;
+uint32_t RxReadCallCount = 0;
+size_t RxWouldBlockIndex = 0;
 
 char *invalidEndpointFilter;
 char *invalidRootCAPathFilter;
@@ -42,6 +42,8 @@ extern TlsBuffer RxBuffer;
 extern TlsBuffer TxBuffer;
 
 extern size_t RxIndex;
+extern uint32_t RxReadCallCount;
+extern size_t RxWouldBlockIndex;
 extern unsigned char RxBuf[TLSMaxBufferSize];
 extern unsigned char TxBuf[TLSMaxBufferSize];
 extern char LastSubscribeMessage[TLSMaxBufferSize];
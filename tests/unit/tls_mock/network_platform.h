@@ -12,6 +12,7 @@
  */
 typedef struct _TLSDataParams {
 	uint32_t flags;
+	int eventFd;	/* stands in for the socket, readable while the mock has data for this network */
 }TLSDataParams;
 
 #define IOTSDKC_NETWORK_MBEDTLS_PLATFORM_H_H